@@ -0,0 +1,83 @@
+dnl ===================================================================
+dnl   Licensed to the Apache Software Foundation (ASF) under one
+dnl   or more contributor license agreements.  See the NOTICE file
+dnl   distributed with this work for additional information
+dnl   regarding copyright ownership.  The ASF licenses this file
+dnl   to you under the Apache License, Version 2.0 (the
+dnl   "License"); you may not use this file except in compliance
+dnl   with the License.  You may obtain a copy of the License at
+dnl
+dnl     http://www.apache.org/licenses/LICENSE-2.0
+dnl
+dnl   Unless required by applicable law or agreed to in writing,
+dnl   software distributed under the License is distributed on an
+dnl   "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+dnl   KIND, either express or implied.  See the License for the
+dnl   specific language governing permissions and limitations
+dnl   under the License.
+dnl ===================================================================
+dnl
+dnl  SVN_LIB_LZ4
+dnl
+dnl  Check configure options and assign variables related to
+dnl  the LZ4 compression library.
+dnl
+
+AC_DEFUN(SVN_LIB_LZ4,
+[
+  lz4_found=no
+  lz4_prefix="the default locations"
+
+  AC_ARG_WITH(lz4,AS_HELP_STRING([--with-lz4=PREFIX],
+                                 [LZ4 compression library (enables the
+                                  svndiff2 format)]),
+  [
+    if test "$withval" = "yes" ; then
+      AC_CHECK_HEADER(lz4.h, [
+        AC_CHECK_LIB(lz4, LZ4_versionString, [lz4_found="builtin"])
+      ])
+    elif test "$withval" != "no" ; then
+      AC_MSG_NOTICE([lz4 library configuration])
+      lz4_prefix=$withval
+      save_cppflags="$CPPFLAGS"
+      CPPFLAGS="$CPPFLAGS -I$lz4_prefix/include"
+      AC_CHECK_HEADERS(lz4.h,[
+        save_ldflags="$LDFLAGS"
+        LDFLAGS="$LDFLAGS -L$lz4_prefix/lib"
+        AC_CHECK_LIB(lz4, LZ4_versionString, [lz4_found="yes"])
+        LDFLAGS="$save_ldflags"
+      ])
+      CPPFLAGS="$save_cppflags"
+    fi
+
+    if test "$withval" != "no" && test "$lz4_found" = "no"; then
+      AC_MSG_ERROR([[--with-lz4 requested, but lz4 not found at $lz4_prefix]])
+    fi
+  ],
+  [
+    AC_CHECK_HEADER(lz4.h, [
+      AC_CHECK_LIB(lz4, LZ4_versionString, [lz4_found="builtin"])
+    ])
+  ])
+
+  if test "$lz4_found" = "builtin"; then
+    SVN_LZ4_INCLUDES=""
+    SVN_LZ4_LIBS="-llz4"
+  elif test "$lz4_found" = "yes"; then
+    SVN_LZ4_INCLUDES="-I$lz4_prefix/include"
+    SVN_LZ4_LIBS="-llz4"
+    LDFLAGS="$LDFLAGS `SVN_REMOVE_STANDARD_LIB_DIRS(-L$lz4_prefix/lib)`"
+  else
+    AC_MSG_WARN([lz4 not found; svndiff2 (LZ4) support will be disabled])
+    SVN_LZ4_INCLUDES=""
+    SVN_LZ4_LIBS=""
+  fi
+
+  if test "$lz4_found" != "no"; then
+    AC_DEFINE([SVN_HAVE_LZ4], [1],
+              [Defined if LZ4 support for svndiff2 is enabled])
+  fi
+
+  AC_SUBST(SVN_LZ4_INCLUDES)
+  AC_SUBST(SVN_LZ4_LIBS)
+])
@@ -120,6 +120,7 @@ class GenDependenciesBase(gen_base.GeneratorBase):
         'java_sdk',
         'openssl',
         'apr_memcache',
+        'lz4',
 
         # So optional, we don't even have any code to detect them on Windows
         'magic',
@@ -141,6 +142,7 @@ class GenDependenciesBase(gen_base.GeneratorBase):
     self.httpd_path = None
     self.libintl_path = None
     self.zlib_path = 'zlib'
+    self.lz4_path = None
     self.openssl_path = None
     self.jdk_path = None
     self.junit_path = None
@@ -193,6 +195,8 @@ class GenDependenciesBase(gen_base.GeneratorBase):
         self.junit_path = val
       elif opt == '--with-zlib':
         self.zlib_path = val
+      elif opt == '--with-lz4':
+        self.lz4_path = val
       elif opt == '--with-swig':
         self.swig_path = val
       elif opt == '--with-sqlite':
@@ -302,6 +306,7 @@ class GenDependenciesBase(gen_base.GeneratorBase):
     self._find_sqlite(show_warnings)
 
     # Optional dependencies
+    self._find_lz4(show_warnings)
     self._find_httpd(show_warnings)
     self._find_bdb(show_warnings)
     self._find_openssl(show_warnings)
@@ -743,6 +748,54 @@ class GenDependenciesBase(gen_base.GeneratorBase):
                                                 self.zlib_version,
                                                 debug_lib_name=debug_lib_name)
 
+  def _find_lz4(self, show_warnings):
+    "Find the LZ4 library and version"
+
+    minimal_lz4_version = (1, 7, 5)
+
+    if not self.lz4_path:
+      return
+
+    if os.path.isfile(os.path.join(self.lz4_path, 'include', 'lz4.h')):
+      # Install layout
+      inc_dir = os.path.join(self.lz4_path, 'include')
+      lib_dir = os.path.join(self.lz4_path, 'lib')
+    elif os.path.isfile(os.path.join(self.lz4_path, 'lib', 'lz4.h')):
+      # Source layout
+      inc_dir = lib_dir = os.path.join(self.lz4_path, 'lib')
+    else:
+      if show_warnings:
+        print('WARNING: \'lz4.h\' not found')
+        print("Use '--with-lz4' to configure LZ4 location.");
+      return
+
+    # Prefer the static library, just like we do for zlib
+    if os.path.isfile(os.path.join(lib_dir, 'liblz4_static.lib')):
+      lib_name = 'liblz4_static.lib'
+    else:
+      lib_name = 'liblz4.lib'
+
+    txt = open(os.path.join(inc_dir, 'lz4.h')).read()
+
+    version = []
+    for part in ('MAJOR', 'MINOR', 'RELEASE'):
+      vermatch = re.search(r'^\s*#define\s+LZ4_VERSION_%s\s+(\d+)' % part,
+                           txt, re.M)
+      version.append(int(vermatch.group(1)))
+    version = tuple(version)
+    lz4_version = '.'.join(str(v) for v in version)
+
+    if version < minimal_lz4_version:
+      if show_warnings:
+        print('Found LZ4 %s, but >= %s is required. '
+              'svndiff2 support will not be built.\n' %
+              (lz4_version, '.'.join(str(v) for v in minimal_lz4_version)))
+      return
+
+    self._libraries['lz4'] = SVNCommonLibrary('lz4', inc_dir, lib_dir,
+                                              lib_name, lz4_version,
+                                              defines=['SVN_HAVE_LZ4'])
+
   def _find_bdb(self, show_warnings):
     "Find the Berkeley DB library and version"
 
@@ -167,6 +167,10 @@ def _usage_exit(err=None):
   print("           tell Subversion to look for ZLib headers and")
   print("           libs in DIR")
   print("")
+  print("  --with-lz4=DIR")
+  print("           look for the LZ4 headers and libs in DIR;")
+  print("           enables svndiff2 support")
+  print("")
   print("  --with-jdk=DIR")
   print("           look for the java development kit here")
   print("")
@@ -249,6 +253,7 @@ if __name__ == '__main__':
                             'with-libintl=',
                             'with-openssl=',
                             'with-zlib=',
+                            'with-lz4=',
                             'with-jdk=',
                             'with-junit=',
                             'with-swig=',
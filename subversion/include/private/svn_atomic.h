@@ -73,6 +73,37 @@ extern "C" {
  */
 #define svn_atomic_cas(mem, with, cmp) \
     apr_atomic_cas32((mem), (with), (cmp))
+
+/**
+ * Read an #svn_atomic_t from memory with acquire semantics, i.e. no
+ * memory access that follows in program order will be moved before it.
+ * Pair this with an svn_atomic_cas() or svn_atomic_inc() that publishes
+ * the data on the writer side.
+ *
+ * Unlike a no-op svn_atomic_cas(), this does not write to @a mem and
+ * concurrent readers will not contend for it, where the compiler allows.
+ */
+#if defined(__ATOMIC_ACQUIRE)
+#define svn_atomic__read_acquire(mem) \
+    __atomic_load_n((mem), __ATOMIC_ACQUIRE)
+#else
+#define svn_atomic__read_acquire(mem) \
+    apr_atomic_cas32((mem), 0, 0)
+#endif
+
+/**
+ * Like svn_atomic__read_acquire() but also make sure that all loads
+ * preceding it in program order have completed before @a mem is read.
+ * Use this to validate data that has been read optimistically.
+ */
+#if defined(__ATOMIC_ACQUIRE)
+#define svn_atomic__read_fenced(mem) \
+    (__atomic_thread_fence(__ATOMIC_ACQUIRE), \
+     __atomic_load_n((mem), __ATOMIC_ACQUIRE))
+#else
+#define svn_atomic__read_fenced(mem) \
+    apr_atomic_cas32((mem), 0, 0)
+#endif
 /** @} */
 
 /**
@@ -174,6 +174,20 @@ typedef struct svn_cache__info_t
    */
   apr_uint64_t total_entries;
 
+  /** Number of hits on entries in the second cache level, i.e. entries
+   * that have been retained after their first eviction.
+   * May be 0 if that information is not available.
+   */
+  apr_uint64_t l2_hits;
+
+  /** Number of entries that got promoted from the first to the second
+   * cache level and that got dropped instead, respectively.  The ratio
+   * shows how selective the cache's admission policy is.
+   * May be 0 if that information is not available.
+   */
+  apr_uint64_t promotions;
+  apr_uint64_t rejections;
+
   /** Number of index buckets with the given number of entries.
    * Bucket sizes larger than the array will saturate into the
    * highest array index.
@@ -310,6 +324,77 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   svn_boolean_t allow_blocking_writes,
                                   apr_pool_t *result_pool);
 
+/**
+ * Like svn_cache__membuffer_cache_create() but put all cache data,
+ * including the segment locks, into a new shared memory region.  If
+ * @a shm_file is not @c NULL, the region will be backed by that file.
+ * Otherwise, it will be anonymous.  The cache is always thread-safe.
+ *
+ * All processes forked from the current one after this call will share
+ * the cache contents, e.g. the worker processes of a pre-forking server.
+ * Unrelated processes cannot attach to the region because the cache
+ * structures contain absolute addresses.
+ *
+ * Keys of shared caches will always be stored in full because the short
+ * key prefix optimization uses process-local state.  If a process dies
+ * while holding a segment lock, the next process waiting for that lock
+ * will break it.  Segments that were being modified at that time will
+ * be cleared.
+ *
+ * The shared memory region will be registered with @a result_pool.  If the
+ * platform does not support shared memory, return
+ * #SVN_ERR_UNSUPPORTED_FEATURE.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         svn_boolean_t allow_blocking_writes,
+                                         const char *shm_file,
+                                         apr_pool_t *result_pool);
+
+/**
+ * Admission policies for membuffer caches.  They decide which of the
+ * entries that get evicted from the first cache level will be retained
+ * in the second level.
+ *
+ * @since New in 1.10.
+ */
+typedef enum svn_cache__admission_policy_t
+{
+  /** Weigh the hit counts and priorities of the entries involved.
+   * This is the default. */
+  svn_cache__admission_hits = 0,
+
+  /** In addition, track recent access frequencies of all keys looked up
+   * in the cache (TinyLFU).  Entries will only be retained if they have
+   * been requested more often than the ones they would replace.  This
+   * protects frequently used data against large sequential scans such
+   * as a full repository verification or export.  It costs about 4
+   * bytes per cache entry. */
+  svn_cache__admission_tinylfu
+} svn_cache__admission_policy_t;
+
+/**
+ * Select the admission @a policy for all segments of the membuffer
+ * @a cache.  Additional data structures required by the policy will be
+ * allocated in @a result_pool, which must outlive @a cache.  This may be
+ * called at any time but entries already in the cache are not affected.
+ *
+ * For shared memory caches, call this before forking.  Every process
+ * will then track access frequencies on its own.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_cache__membuffer_set_admission_policy(
+  svn_membuffer_t *cache,
+  svn_cache__admission_policy_t policy,
+  apr_pool_t *result_pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -554,6 +639,64 @@ svn_cache__format_info(const svn_cache__info_t *info,
 struct svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void);
 
+/**
+ * Allocate the process-global (singleton) membuffer cache in shared memory
+ * using the current cache config, such that all processes subsequently
+ * forked from this one share its contents.  See
+ * svn_cache__membuffer_cache_create_shared() for @a shm_file and the
+ * limitations of shared caches.
+ *
+ * This must be called before svn_cache__get_global_membuffer_cache() and
+ * before forking.  If the global cache has already been created, this is
+ * a no-op.  Like svn_cache_config_set(), it is not thread-safe.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_cache__create_shared_global_membuffer_cache(const char *shm_file);
+
+/**
+ * Select the admission @a policy for the process-global (singleton)
+ * membuffer cache.  This must be called before the global cache gets
+ * created, i.e. before svn_cache__get_global_membuffer_cache() and
+ * svn_cache__create_shared_global_membuffer_cache().  Like
+ * svn_cache_config_set(), it is not thread-safe.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_cache__set_global_admission_policy(svn_cache__admission_policy_t policy);
+
+/**
+ * Restore the contents of the process-global (singleton) membuffer cache
+ * from the snapshot file at @a path, creating the cache if necessary.
+ * Set @a *loaded to TRUE if any data has been restored.  See
+ * svn_cache__membuffer_cache_load() for the conditions under which the
+ * file will be ignored.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_cache__load_global_membuffer_cache(svn_boolean_t *loaded,
+                                       const char *path,
+                                       apr_pool_t *scratch_pool);
+
+/**
+ * Write a snapshot of the process-global (singleton) membuffer cache to
+ * the file at @a path such that a later server instance may restore it
+ * using svn_cache__load_global_membuffer_cache().  This is a no-op if
+ * the global cache has not been created.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_cache__save_global_membuffer_cache(const char *path,
+                                       apr_pool_t *scratch_pool);
+
 /**
  * Return total access and size stats over all membuffer caches as they
  * share the underlying data buffer.  The result will be allocated in POOL.
@@ -570,6 +713,36 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool);
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache);
 
+/**
+ * Write a snapshot of the current contents of CACHE to the file at PATH,
+ * replacing any previous file atomically.  The cache remains fully usable
+ * while being saved; each segment is written in a consistent state.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_save(svn_membuffer_t *cache,
+                                const char *path,
+                                apr_pool_t *scratch_pool);
+
+/**
+ * Restore the contents of CACHE from the snapshot file at PATH written
+ * by svn_cache__membuffer_cache_save().  Set *LOADED to TRUE if any
+ * data has been restored.
+ *
+ * If the file does not exist, has been written by a different version of
+ * Subversion or for a cache of different size or layout, or if CACHE has
+ * already been in use, leave CACHE untouched and set *LOADED to FALSE.
+ * Segments that fail their consistency checks will be left empty.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_load(svn_membuffer_t *cache,
+                                svn_boolean_t *loaded,
+                                const char *path,
+                                apr_pool_t *scratch_pool);
+
 /** @} */
 
 
@@ -259,11 +259,19 @@ typedef struct svn_fs_fs__stats_t
 /* Scan all contents of the repository FS and return statistics in *STATS,
  * allocated in RESULT_POOL.  Report progress through PROGRESS_FUNC with
  * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.
+ *
+ * If FS has been opened with SVN_FS_CONFIG_FSFS_JOBS set to more than 1,
+ * rev / pack files will be scanned concurrently.  If SNAPSHOT_DIR is not
+ * NULL, the scan results for each pack file will be stored in that
+ * directory and reused instead of re-scanning the pack file in later
+ * calls.  Both only apply to repositories using logical addressing.
+ *
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     const char *snapshot_dir,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -353,6 +361,85 @@ svn_fs_fs__load_index(svn_fs_t *fs,
                       apr_array_header_t *entries,
                       apr_pool_t *scratch_pool);
 
+/* Results of a random read benchmark as run by
+ * svn_fs_fs__benchmark_reads().
+ */
+typedef struct svn_fs_fs__read_benchmark_t
+{
+  /* Number of read requests, summed over all runs of either kind. */
+  apr_int64_t requests;
+
+  /* Number of bytes read, summed over all runs of either kind. */
+  apr_int64_t bytes;
+
+  /* Total time taken to execute the requests sequentially. */
+  apr_interval_time_t sync_time;
+
+  /* Total time taken to execute the requests with multiple reads in
+   * flight. */
+  apr_interval_time_t async_time;
+} svn_fs_fs__read_benchmark_t;
+
+/* Measure the random read throughput of the rev / pack file containing
+ * REVISION in FS and return the figures in *RESULTS.  Read COUNT blocks
+ * at random locations, sequentially as well as with up to MAX_IN_FLIGHT
+ * concurrent requests.  Runs of either kind alternate and start with a
+ * cold OS file cache where the platform allows us to drop it.  If not
+ * NULL, call CANCEL_FUNC with CANCEL_BATON from time to time.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__benchmark_reads(svn_fs_fs__read_benchmark_t *results,
+                           svn_fs_t *fs,
+                           svn_revnum_t revision,
+                           int count,
+                           int max_in_flight,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool);
+
+/* Results of a concurrent commit benchmark as run by
+ * svn_fs_fs__benchmark_commits().
+ */
+typedef struct svn_fs_fs__commit_benchmark_t
+{
+  /* Number of revisions committed. */
+  apr_int64_t commits;
+
+  /* Number of commits that wrote their revision contents before
+   * acquiring the repository write lock. */
+  apr_int64_t prepared;
+
+  /* Number of prepared commits that had to be rolled back and retried
+   * because a concurrent commit got the write lock first. */
+  apr_int64_t rolled_back;
+
+  /* Time taken until all committers completed. */
+  apr_interval_time_t duration;
+} svn_fs_fs__commit_benchmark_t;
+
+/* Run COMMITTERS concurrent committers against FS, each of which makes
+ * COMMIT_COUNT commits to the file "/bench-commit-N", N being the number
+ * of the committer, with the contents "committer N, commit I\n" for its
+ * I-th commit, based on the youngest revision at that time.  Return the
+ * figures in *RESULTS.
+ *
+ * The PREPARED and ROLLED_BACK figures count all commits to the
+ * repository in this process while the benchmark is running.
+ *
+ * If not NULL, call CANCEL_FUNC with CANCEL_BATON from time to time.
+ * CANCEL_FUNC must be thread-safe.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_fs_fs__benchmark_commits(svn_fs_fs__commit_benchmark_t *results,
+                             svn_fs_t *fs,
+                             int committers,
+                             int commit_count,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -141,6 +141,15 @@ svn_ra_svn__set_shim_callbacks(svn_ra_svn_conn_t *conn,
 apr_pool_t *
 svn_ra_svn__get_pool(svn_ra_svn_conn_t *conn);
 
+/**
+ * Return the svndiff version to use when sending deltas over @a conn.
+ * This is the most efficient version supported by the other side:
+ * 2 (LZ4) if accepted, else 1 (zlib) if supported, 0 otherwise.  If
+ * compression has been disabled for @a conn, return 0.
+ */
+int
+svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn);
+
 /**
  * @defgroup ra_svn_deprecated ra_svn low-level functions
  * @{
@@ -96,6 +96,17 @@ const char *
 svn_repos__post_commit_error_str(svn_error_t *err,
                                  apr_pool_t *pool);
 
+/* Set *INDEXED to the youngest revision covered by the changed-paths
+ * index of REPOS, see svn_repos_build_log_index().  Set it to
+ * SVN_INVALID_REVNUM if REPOS has no index or if the index does not belong
+ * to REPOS and would be ignored.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_repos__log_index_youngest(svn_revnum_t *indexed,
+                              svn_repos_t *repos,
+                              apr_pool_t *scratch_pool);
+
 /* A repos version of svn_fs_type */
 svn_error_t *
 svn_repos__fs_type(const char **fs_type,
@@ -573,6 +573,31 @@ svn__decompress(const void *data, apr_size_t len,
                 svn_stringbuf_t *out,
                 apr_size_t limit);
 
+/* Return TRUE if this build of Subversion supports LZ4 compression and
+ * thereby svndiff2.  If it does not, svn__compress_lz4 and
+ * svn__decompress_lz4 return SVN_ERR_UNSUPPORTED_FEATURE.
+ */
+svn_boolean_t
+svn__lz4_supported(void);
+
+/* Compress the data from DATA with length LEN using LZ4 and write the
+ * result to OUT.  Just like svn__compress, the original length will be
+ * prepended and incompressible data will be stored as-is.  LEN must not
+ * exceed LZ4_MAX_INPUT_SIZE.
+ */
+svn_error_t *
+svn__compress_lz4(const void *data, apr_size_t len,
+                  svn_stringbuf_t *out);
+
+/* Decompress the LZ4 compressed data from DATA with length LEN and write
+ * the result to OUT.  Return an error if the decompressed size is larger
+ * than LIMIT.
+ */
+svn_error_t *
+svn__decompress_lz4(const void *data, apr_size_t len,
+                    svn_stringbuf_t *out,
+                    apr_size_t limit);
+
 /** @} */
 
 /**
@@ -720,6 +745,14 @@ const char *svn_zlib__compiled_version(void);
 /* Return the zlib version we run against. */
 const char *svn_zlib__runtime_version(void);
 
+/* Return the lz4 version we compiled against or NULL if we were built
+ * without LZ4 support. */
+const char *svn_lz4__compiled_version(void);
+
+/* Return the lz4 version we run against or NULL if we were built without
+ * LZ4 support. */
+const char *svn_lz4__runtime_version(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
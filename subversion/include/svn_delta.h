@@ -508,7 +508,11 @@ svn_txdelta_apply(svn_stream_t *source,
  * version is @a svndiff_version. @a compression_level is the zlib
  * compression level from 0 (no compression) and 9 (maximum compression).
  *
- * @since New in 1.7.
+ * Version 0 stores the data uncompressed, version 1 uses zlib and
+ * version 2 uses LZ4 as secondary compression.  @a compression_level
+ * is only used with version 1.
+ *
+ * @since New in 1.7.  Since 1.10, @a svndiff_version may be 2.
  */
 void
 svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
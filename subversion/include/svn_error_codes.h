@@ -1452,6 +1452,16 @@ SVN_ERROR_START
              SVN_ERR_MISC_CATEGORY_START + 43,
              "Parser error: invalid input")
 
+  /** @since New in 1.10. */
+  SVN_ERRDEF(SVN_ERR_LZ4_COMPRESSION_FAILED,
+             SVN_ERR_MISC_CATEGORY_START + 44,
+             "Compression of data with LZ4 failed")
+
+  /** @since New in 1.10. */
+  SVN_ERRDEF(SVN_ERR_LZ4_DECOMPRESSION_FAILED,
+             SVN_ERR_MISC_CATEGORY_START + 45,
+             "Decompression of LZ4 compressed data failed")
+
   /* command-line client errors */
 
   SVN_ERRDEF(SVN_ERR_CL_ARG_PARSING_ERROR,
@@ -140,6 +140,38 @@ typedef struct svn_fs_t svn_fs_t;
  */
 #define SVN_FS_CONFIG_FSFS_BLOCK_READ           "fsfs-block-read"
 
+/** Maximum number of delta windows of a large file that FSFS will
+ * reconstruct concurrently, given as a decimal string.  A value of 0 or 1,
+ * which is the default, disables parallel reconstruction.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_PARALLEL_WINDOWS     "fsfs-parallel-windows"
+
+/** Maximum number of read requests that FSFS may have in flight for a
+ * single revision or pack file, given as a decimal string.  A value of 0
+ * or 1, which is the default, makes FSFS read synchronously.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_ASYNC_READS          "fsfs-async-reads"
+
+/** Enable / disable memory-mapping of packed FSFS shards.  If enabled,
+ * data and index information will be read directly from the mapped pack
+ * files instead of through file I/O.  Disabled by default.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_MMAP                 "fsfs-mmap"
+
+/** Maximum number of worker threads that FSFS may use for bulk operations
+ * like packing a repository, given as a decimal string.  A value of 0 or
+ * 1, which is the default, makes these operations run single-threaded.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_JOBS                 "fsfs-jobs"
+
 /** String with a decimal representation of the FSFS format shard size.
  * Zero ("0") means that a repository with linear layout should be created.
  *
@@ -533,10 +565,34 @@ typedef void (*svn_fs_hotcopy_notify_t)(void *baton,
  * @a cancel_baton as usual to allow the user to preempt this potentially
  * lengthy operation.
  *
+ * @a fs_config is passed to the filesystem implementation and may be
+ * @c NULL.  With FSFS, #SVN_FS_CONFIG_FSFS_JOBS allows for copying
+ * multiple shards and revisions concurrently.  @a cancel_func must be
+ * thread-safe in that case.
+ *
  * Use @a scratch_pool for temporary allocations.
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_hotcopy4(const char *src_path,
+                const char *dest_path,
+                svn_boolean_t clean,
+                svn_boolean_t incremental,
+                apr_hash_t *fs_config,
+                svn_fs_hotcopy_notify_t notify_func,
+                void *notify_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_fs_hotcopy4(), but with @a fs_config always passed as @c NULL.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_hotcopy3(const char *src_path,
                 const char *dest_path,
@@ -3111,11 +3167,31 @@ typedef svn_error_t *(*svn_fs_pack_notify_t)(void *baton,
                                              apr_pool_t *pool);
 
 /**
- * Possibly update the filesystem located in the directory @a path
+ * Possibly update the filesystem located in the directory @a db_path
  * to use disk space more efficiently.
  *
+ * @a fs_config is passed to the filesystem implementation as described
+ * for svn_fs_open2() and may be @c NULL.  FSFS, for instance, will pack
+ * multiple shards concurrently if #SVN_FS_CONFIG_FSFS_JOBS is set.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_pack2(const char *db_path,
+             apr_hash_t *fs_config,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool);
+
+/**
+ * Like svn_fs_pack2() but without @a fs_config.
+ *
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  * @since New in 1.6.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_pack(const char *db_path,
             svn_fs_pack_notify_t notify_func,
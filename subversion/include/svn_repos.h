@@ -159,6 +159,30 @@ typedef svn_error_t *(*svn_repos_authz_callback_t)
    void *baton,
    apr_pool_t *pool);
 
+
+/** Callback type for checking read authorization on a whole subtree.
+ *
+ * Set @a *readable to TRUE to indicate that @a path in @a root as well
+ * as every path below it is readable, according to the same rules as
+ * the #svn_repos_authz_func_t sharing the same @a baton.  Setting
+ * @a *readable to FALSE does not mean that @a path is unreadable, only
+ * that individual paths within the subtree need to be checked.
+ *
+ * Implementations should answer in a single lookup.  Callers use this
+ * to skip the per-path checks within subtrees that are readable as a
+ * whole.
+ *
+ * Do not assume @a pool has any lifetime beyond this call.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_repos_authz_subtree_func_t)
+  (svn_boolean_t *readable,
+   svn_fs_root_t *root,
+   const char *path,
+   void *baton,
+   apr_pool_t *pool);
+
 /** @} */
 
 
@@ -250,7 +274,11 @@ typedef enum svn_repos_notify_action_t
   svn_repos_notify_pack_noop,
 
   /** The revision properties got set. @since New in 1.10. */
-  svn_repos_notify_load_revprop_set
+  svn_repos_notify_load_revprop_set,
+
+  /** A revision has been added to the changed-paths index.
+   * @since New in 1.10. */
+  svn_repos_notify_log_index_rev
 } svn_repos_notify_action_t;
 
 /** The type of warning occurring.
@@ -297,7 +325,15 @@ typedef enum svn_repos_notify_warning_t
    *
    * @since New in 1.9.
    */
-  svn_repos_notify_warning_invalid_mergeinfo
+  svn_repos_notify_warning_invalid_mergeinfo,
+
+  /**
+   * A warning reported by the underlying filesystem, see
+   * svn_fs_set_warning_func().
+   *
+   * @since New in 1.10.
+   */
+  svn_repos_notify_warning_filesystem
 } svn_repos_notify_warning_t;
 
 /**
@@ -317,8 +353,8 @@ typedef struct svn_repos_notify_t
   /** Action that describes what happened in the repository. */
   svn_repos_notify_action_t action;
 
-  /** For #svn_repos_notify_dump_rev_end and #svn_repos_notify_verify_rev_end,
-   * the revision which just completed.
+  /** For #svn_repos_notify_dump_rev_end, #svn_repos_notify_verify_rev_end
+   * and #svn_repos_notify_log_index_rev, the revision which just completed.
    * For #svn_fs_upgrade_format_bumped, the new format version. */
   svn_revnum_t revision;
 
@@ -661,11 +697,34 @@ svn_repos_fs_type(svn_repos_t *repos,
  * The optional @a cancel_func callback will be invoked with
  * @a cancel_baton as usual to allow the user to preempt this potentially
  * lengthy operation.
- * 
+ *
+ * @a fs_config is passed to the filesystem and may be @c NULL; see
+ * svn_fs_hotcopy4().
+ *
  * Use @a scratch_pool for temporary allocations.
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_hotcopy4(const char *src_path,
+                   const char *dst_path,
+                   svn_boolean_t clean_logs,
+                   svn_boolean_t incremental,
+                   apr_hash_t *fs_config,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_hotcopy4(), but with @a fs_config always passed as
+ * @c NULL.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_hotcopy3(const char *src_path,
                    const char *dst_path,
@@ -1022,7 +1081,10 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
  *
  * Use @a authz_read_func and @a authz_read_baton (if not @c NULL) to
  * avoid sending data through @a editor/@a edit_baton which is not
- * authorized for transmission.
+ * authorized for transmission.  If @a authz_subtree_func is not @c NULL
+ * as well, it will be called with @a authz_read_baton for directories
+ * and the checks for individual paths below those that are readable as
+ * a whole will be skipped.
  *
  * @a zero_copy_limit controls the maximum size (in bytes) at which
  * data blocks may be sent using the zero-copy code path.  On that
@@ -1068,8 +1130,35 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
  * than or equal to the depth of the working copy, then the editor
  * operations will affect only paths at or above @a depth.
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_begin_report4(void **report_baton,
+                        svn_revnum_t revnum,
+                        svn_repos_t *repos,
+                        const char *fs_base,
+                        const char *target,
+                        const char *tgt_path,
+                        svn_boolean_t text_deltas,
+                        svn_depth_t depth,
+                        svn_boolean_t ignore_ancestry,
+                        svn_boolean_t send_copyfrom_args,
+                        const svn_delta_editor_t *editor,
+                        void *edit_baton,
+                        svn_repos_authz_func_t authz_read_func,
+                        svn_repos_authz_subtree_func_t authz_subtree_func,
+                        void *authz_read_baton,
+                        apr_size_t zero_copy_limit,
+                        apr_pool_t *pool);
+
+/**
+ * The same as svn_repos_begin_report4(), but with @a authz_subtree_func
+ * always passed as @c NULL.
+ *
  * @since New in 1.8.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_begin_report3(void **report_baton,
                         svn_revnum_t revnum,
@@ -1146,7 +1235,7 @@ svn_repos_begin_report(void **report_baton,
 
 
 /**
- * Given a @a report_baton constructed by svn_repos_begin_report3(),
+ * Given a @a report_baton constructed by svn_repos_begin_report4(),
  * record the presence of @a path, at @a revision with depth @a depth,
  * in the current tree.
  *
@@ -1217,7 +1306,7 @@ svn_repos_set_path(void *report_baton,
                    apr_pool_t *pool);
 
 /**
- * Given a @a report_baton constructed by svn_repos_begin_report3(),
+ * Given a @a report_baton constructed by svn_repos_begin_report4(),
  * record the presence of @a path in the current tree, containing the contents
  * of @a link_path at @a revision with depth @a depth.
  *
@@ -1283,7 +1372,7 @@ svn_repos_link_path(void *report_baton,
                     svn_boolean_t start_empty,
                     apr_pool_t *pool);
 
-/** Given a @a report_baton constructed by svn_repos_begin_report3(),
+/** Given a @a report_baton constructed by svn_repos_begin_report4(),
  * record the non-existence of @a path in the current tree.
  *
  * @a path may not be underneath a path on which svn_repos_set_path3()
@@ -1299,7 +1388,7 @@ svn_repos_delete_path(void *report_baton,
                       const char *path,
                       apr_pool_t *pool);
 
-/** Given a @a report_baton constructed by svn_repos_begin_report3(),
+/** Given a @a report_baton constructed by svn_repos_begin_report4(),
  * finish the report and drive the editor as specified when the report
  * baton was constructed.
  *
@@ -1316,7 +1405,7 @@ svn_repos_finish_report(void *report_baton,
                         apr_pool_t *pool);
 
 
-/** Given a @a report_baton constructed by svn_repos_begin_report3(),
+/** Given a @a report_baton constructed by svn_repos_begin_report4(),
  * abort the report.  This function can be called anytime before
  * svn_repos_finish_report() is called.
  *
@@ -1926,6 +2015,11 @@ svn_repos_node_location_segments(svn_repos_t *repos,
  *
  * See also the documentation for #svn_log_entry_receiver_t.
  *
+ * If @a repos has a changed-paths index (see svn_repos_build_log_index()),
+ * it will be used to find the revisions that changed @a paths instead of
+ * walking their node histories revision by revision.  The results are
+ * the same either way.
+ *
  * Use @a pool for temporary allocations.
  *
  * @since New in 1.5.
@@ -1946,6 +2040,37 @@ svn_repos_get_logs4(svn_repos_t *repos,
                     void *receiver_baton,
                     apr_pool_t *pool);
 
+/**
+ * Create the changed-paths index of @a repos from scratch, covering all
+ * revisions up to the youngest one.  The index maps each changed path to
+ * the revisions that changed it.  Once it exists, commits through
+ * svn_repos_fs_commit_txn() and loads through svn_repos_load_fs6() will
+ * keep it current and svn_repos_get_logs4() will use it.  Revisions
+ * committed by other means will be added to the index by the next such
+ * commits, a limited number per commit.  Until then, svn_repos_get_logs4()
+ * will add a few missing revisions itself but fall back to walking node
+ * histories if the index lags further behind.  An index that does not
+ * match the repository's UUID or youngest revision will be ignored and
+ * started over by the next commit.
+ *
+ * If @a notify_func is not @c NULL, call it with @a notify_baton and
+ * action #svn_repos_notify_log_index_rev for each revision indexed.
+ *
+ * If @a cancel_func is not @c NULL, call it periodically with @a
+ * cancel_baton as argument to see if the caller wishes to cancel.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_build_log_index(svn_repos_t *repos,
+                          svn_repos_notify_func_t notify_func,
+                          void *notify_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool);
+
 /**
  * Same as svn_repos_get_logs4(), but with @a receiver being
  * #svn_log_message_receiver_t instead of #svn_log_entry_receiver_t.
@@ -2909,12 +3034,41 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  * cancel_baton as argument to see if the caller wishes to cancel the
  * verification.
  *
+ * If @a jobs is greater than 1, verify up to @a jobs revisions
+ * concurrently, each worker thread using its own filesystem object.
+ * Notifications will still be sent and @a verify_callback will still be
+ * invoked from the calling thread and in revision order, i.e. the output
+ * is the same as for a sequential verification.  @a cancel_func must be
+ * thread-safe in that case.
+ *
  * Use @a scratch_pool for temporary allocation.
  *
  * @see svn_repos_verify_callback_t
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     int jobs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_verify_fs4(), but with @a jobs set to 1.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -3024,6 +3178,12 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the dump.
  *
+ * If @a jobs is greater than 1, dump up to @a jobs revisions concurrently,
+ * each worker thread using its own filesystem object and buffering its
+ * output.  The output and the notifications will still be written from
+ * the calling thread and in revision order, i.e. they are the same as
+ * for a sequential dump.  @a cancel_func must be thread-safe in that case.
+ *
  * Use @a scratch_pool for temporary allocation.
  *
  * @since New in 1.10.
@@ -3037,6 +3197,7 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    svn_boolean_t use_deltas,
                    svn_boolean_t include_revprops,
                    svn_boolean_t include_changes,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -3152,9 +3313,40 @@ svn_repos_dump_fs(svn_repos_t *repos,
  * If @a cancel_func is not @c NULL, it is called periodically with
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the load.
+ *
+ * If @a jobs is greater than 1, parse @a dumpstream, decode the text
+ * deltas found in it and construct the new revisions in separate threads
+ * that are connected by bounded queues.  All filesystem modifications,
+ * hooks and notifications still happen in the calling thread and in the
+ * same order as for a sequential load.  @a dumpstream will be read from
+ * a different thread and @a cancel_func must be thread-safe in that case.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_load_fs6(svn_repos_t *repos,
+                   svn_stream_t *dumpstream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   enum svn_repos_load_uuid uuid_action,
+                   const char *parent_dir,
+                   svn_boolean_t use_pre_commit_hook,
+                   svn_boolean_t use_post_commit_hook,
+                   svn_boolean_t validate_props,
+                   svn_boolean_t ignore_dates,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/** Similar to svn_repos_load_fs6(), but with @a jobs always passed as 1.
  *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_load_fs5(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
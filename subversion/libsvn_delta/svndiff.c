@@ -38,6 +38,7 @@
 
 static const char SVNDIFF_V0[] = { 'S', 'V', 'N', 0 };
 static const char SVNDIFF_V1[] = { 'S', 'V', 'N', 1 };
+static const char SVNDIFF_V2[] = { 'S', 'V', 'N', 2 };
 
 #define SVNDIFF_HEADER_SIZE (sizeof(SVNDIFF_V0))
 
@@ -46,6 +47,8 @@ get_svndiff_header(int version)
 {
   if (version == 1)
     return SVNDIFF_V1;
+  else if (version == 2)
+    return SVNDIFF_V2;
   else
     return SVNDIFF_V0;
 }
@@ -147,9 +150,30 @@ send_simple_insertion_window(svn_txdelta_window_t *window,
   return SVN_NO_ERROR;
 }
 
+/* Compress the svndiff section DATA of length LEN into a new buffer
+   allocated in POOL and return it in *OUT.  VERSION selects the secondary
+   compressor: zlib with COMPRESSION_LEVEL for svndiff1 and LZ4 for
+   svndiff2. */
+static svn_error_t *
+compress_section(svn_stringbuf_t **out,
+                 const char *data,
+                 apr_size_t len,
+                 int version,
+                 int compression_level,
+                 apr_pool_t *pool)
+{
+  *out = svn_stringbuf_create_empty(pool);
+  if (version == 2)
+    SVN_ERR(svn__compress_lz4(data, len, *out));
+  else
+    SVN_ERR(svn__compress(data, len, *out, compression_level));
+
+  return SVN_NO_ERROR;
+}
+
 /* Encodes delta window WINDOW to svndiff-format.
    The svndiff version is VERSION. COMPRESSION_LEVEL is the zlib
-   compression level to use.
+   compression level to use for svndiff1 and ignored otherwise.
    Returned values will be allocated in POOL or refer to *WINDOW
    fields. */
 static svn_error_t *
@@ -195,21 +219,18 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, window->sview_offset);
   append_encoded_int(header, window->sview_len);
   append_encoded_int(header, window->tview_len);
-  if (version == 1)
-    {
-      svn_stringbuf_t *compressed_instructions;
-      compressed_instructions = svn_stringbuf_create_empty(pool);
-      SVN_ERR(svn__compress(instructions->data, instructions->len,
-                            compressed_instructions, compression_level));
-      instructions = compressed_instructions;
-    }
+  if (version > 0)
+    SVN_ERR(compress_section(&instructions, instructions->data,
+                             instructions->len, version, compression_level,
+                             pool));
   append_encoded_int(header, instructions->len);
-  if (version == 1)
+  if (version > 0)
     {
-      svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+      svn_stringbuf_t *compressed;
 
-      SVN_ERR(svn__compress(window->new_data->data, window->new_data->len,
-                            compressed, compression_level));
+      SVN_ERR(compress_section(&compressed, window->new_data->data,
+                               window->new_data->len, version,
+                               compression_level, pool));
       newdata = svn_stringbuf__morph_into_string(compressed);
     }
   else
@@ -542,15 +563,25 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
 
   insend = data + inslen;
 
-  if (version == 1)
+  if (version == 1 || version == 2)
     {
       svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
       svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
 
-      SVN_ERR(svn__decompress(insend, newlen, ndout,
-                              SVN_DELTA_WINDOW_SIZE));
-      SVN_ERR(svn__decompress(data, insend - data, instout,
-                              MAX_INSTRUCTION_SECTION_LEN));
+      if (version == 1)
+        {
+          SVN_ERR(svn__decompress(insend, newlen, ndout,
+                                  SVN_DELTA_WINDOW_SIZE));
+          SVN_ERR(svn__decompress(data, insend - data, instout,
+                                  MAX_INSTRUCTION_SECTION_LEN));
+        }
+      else
+        {
+          SVN_ERR(svn__decompress_lz4(insend, newlen, ndout,
+                                      SVN_DELTA_WINDOW_SIZE));
+          SVN_ERR(svn__decompress_lz4(data, insend - data, instout,
+                                      MAX_INSTRUCTION_SECTION_LEN));
+        }
 
       newlen = ndout->len;
       data = (unsigned char *)instout->data;
@@ -612,6 +643,8 @@ write_handler(void *baton,
         db->version = 0;
       else if (memcmp(buffer, SVNDIFF_V1 + db->header_bytes, nheader) == 0)
         db->version = 1;
+      else if (memcmp(buffer, SVNDIFF_V2 + db->header_bytes, nheader) == 0)
+        db->version = 2;
       else
         return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
                                 _("Svndiff has invalid header"));
@@ -671,7 +704,7 @@ write_handler(void *baton,
 
           if (tview_len > SVN_DELTA_WINDOW_SIZE ||
               sview_len > SVN_DELTA_WINDOW_SIZE ||
-              /* for svndiff1, newlen includes the original length */
+              /* for svndiff1/2, newlen includes the original length */
               newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
               inslen > MAX_INSTRUCTION_SECTION_LEN)
             return svn_error_create(
@@ -882,7 +915,7 @@ read_window_header(svn_stream_t *stream, svn_filesize_t *sview_offset,
 
   if (*tview_len > SVN_DELTA_WINDOW_SIZE ||
       *sview_len > SVN_DELTA_WINDOW_SIZE ||
-      /* for svndiff1, newlen includes the original length */
+      /* for svndiff1/2, newlen includes the original length */
       *newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
       *inslen > MAX_INSTRUCTION_SECTION_LEN)
     return svn_error_create(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
@@ -629,8 +629,9 @@ svn_fs_delete_fs(const char *path, apr_pool_t *pool)
 }
 
 svn_error_t *
-svn_fs_hotcopy3(const char *src_path, const char *dst_path,
+svn_fs_hotcopy4(const char *src_path, const char *dst_path,
                 svn_boolean_t clean, svn_boolean_t incremental,
+                apr_hash_t *fs_config,
                 svn_fs_hotcopy_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
@@ -650,8 +651,8 @@ svn_fs_hotcopy3(const char *src_path, const char *dst_path,
 
   SVN_ERR(svn_fs_type(&src_fs_type, src_path, scratch_pool));
   SVN_ERR(get_library_vtable(&vtable, src_fs_type, scratch_pool));
-  src_fs = fs_new(NULL, scratch_pool);
-  dst_fs = fs_new(NULL, scratch_pool);
+  src_fs = fs_new(fs_config, scratch_pool);
+  dst_fs = fs_new(fs_config, scratch_pool);
 
   SVN_ERR(svn_io_check_path(dst_path, &dst_kind, scratch_pool));
   if (dst_kind == svn_node_file)
@@ -694,18 +695,19 @@ svn_fs_hotcopy3(const char *src_path, const char *dst_path,
 }
 
 svn_error_t *
-svn_fs_pack(const char *path,
-            svn_fs_pack_notify_t notify_func,
-            void *notify_baton,
-            svn_cancel_func_t cancel_func,
-            void *cancel_baton,
-            apr_pool_t *pool)
+svn_fs_pack2(const char *path,
+             apr_hash_t *fs_config,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool)
 {
   fs_library_vtable_t *vtable;
   svn_fs_t *fs;
 
   SVN_ERR(fs_library_vtable(&vtable, path, pool));
-  fs = fs_new(NULL, pool);
+  fs = fs_new(fs_config, pool);
 
   SVN_ERR(vtable->pack_fs(fs, path, notify_func, notify_baton,
                           cancel_func, cancel_baton, common_pool_lock,
@@ -800,8 +802,8 @@ svn_error_t *
 svn_fs_hotcopy_berkeley(const char *src_path, const char *dest_path,
                         svn_boolean_t clean_logs, apr_pool_t *pool)
 {
-  return svn_error_trace(svn_fs_hotcopy3(src_path, dest_path, clean_logs,
-                                         FALSE, NULL, NULL, NULL, NULL,
+  return svn_error_trace(svn_fs_hotcopy4(src_path, dest_path, clean_logs,
+                                         FALSE, NULL, NULL, NULL, NULL, NULL,
                                          pool));
 }
 
@@ -0,0 +1,167 @@
+/* bench-commit.c -- implements the svn_fs_fs__benchmark_commits private API
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "private/svn_fs_fs_private.h"
+
+#include "fs.h"
+#include "fs_fs.h"
+#include "tasks.h"
+#include "transaction.h"
+
+#include "../libsvn_fs/fs-loader.h"
+
+/* State of a single committer. */
+typedef struct committer_t
+{
+  /* Repository to commit to.  Committers open clones of it. */
+  svn_fs_t *fs;
+
+  /* Number of this committer.  Determines the file that it modifies. */
+  int id;
+
+  /* Number of commits to make. */
+  int commit_count;
+
+  /* Optional cancellation support. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} committer_t;
+
+/* Make a single commit to PATH in FS with CONTENTS, based on the youngest
+ * revision.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+commit_contents(svn_fs_t *fs,
+                const char *path,
+                const char *contents,
+                apr_pool_t *scratch_pool)
+{
+  svn_revnum_t youngest;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_node_kind_t kind;
+  svn_stream_t *stream;
+  const char *conflict;
+  apr_size_t len = strlen(contents);
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__begin_txn(&txn, fs, youngest, 0, scratch_pool));
+  SVN_ERR(txn->vtable->root(&root, txn, scratch_pool));
+
+  SVN_ERR(root->vtable->check_path(&kind, root, path, scratch_pool));
+  if (kind == svn_node_none)
+    SVN_ERR(root->vtable->make_file(root, path, scratch_pool));
+
+  SVN_ERR(root->vtable->apply_text(&stream, root, path, NULL, scratch_pool));
+  SVN_ERR(svn_stream_write(stream, contents, &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* Concurrent committers touch different paths, hence out-of-date
+   * transactions get merged and there will be no conflicts. */
+  SVN_ERR(txn->vtable->commit(&conflict, &youngest, txn, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_fs_fs__task_func_t.  Make all commits of the committer_t
+ * given by BATON, using a private clone of its repository. */
+static svn_error_t *
+committer_task(void *baton)
+{
+  committer_t *committer = baton;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  const char *path = apr_psprintf(pool, "/bench-commit-%d", committer->id);
+  svn_fs_t *fs;
+  svn_error_t *err;
+  int i;
+
+  /* svn_fs_t instances must not be shared between threads. */
+  err = svn_fs_fs__open_clone(&fs, committer->fs, pool, pool);
+  for (i = 0; !err && i < committer->commit_count; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      if (committer->cancel_func)
+        err = committer->cancel_func(committer->cancel_baton);
+      if (!err)
+        err = commit_contents(fs, path,
+                              apr_psprintf(iterpool,
+                                           "committer %d, commit %d\n",
+                                           committer->id, i),
+                              iterpool);
+    }
+
+  svn_pool_destroy(pool);
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_fs_fs__benchmark_commits(svn_fs_fs__commit_benchmark_t *results,
+                             svn_fs_t *fs,
+                             int committers,
+                             int commit_count,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  committer_t *batons;
+  void **tasks;
+  svn_atomic_t prepared, rolled_back;
+  apr_time_t start;
+  svn_error_t *err;
+  int i;
+
+  committers = MAX(committers, 1);
+  batons = apr_pcalloc(scratch_pool, committers * sizeof(*batons));
+  tasks = apr_palloc(scratch_pool, committers * sizeof(*tasks));
+  for (i = 0; i < committers; ++i)
+    {
+      batons[i].fs = fs;
+      batons[i].id = i;
+      batons[i].commit_count = commit_count;
+      batons[i].cancel_func = cancel_func;
+      batons[i].cancel_baton = cancel_baton;
+      tasks[i] = &batons[i];
+    }
+
+  prepared = svn_atomic_read(&ffd->shared->prepared_commits);
+  rolled_back = svn_atomic_read(&ffd->shared->rolled_back_commits);
+  start = apr_time_now();
+
+  err = svn_fs_fs__run_tasks(committer_task, tasks, committers,
+                             scratch_pool);
+
+  results->duration = apr_time_now() - start;
+  results->commits = (apr_int64_t)committers * commit_count;
+  results->prepared = svn_atomic_read(&ffd->shared->prepared_commits)
+                    - prepared;
+  results->rolled_back = svn_atomic_read(&ffd->shared->rolled_back_commits)
+                       - rolled_back;
+
+  return svn_error_trace(err);
+}
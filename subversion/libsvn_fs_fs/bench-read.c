@@ -0,0 +1,150 @@
+/* bench-read.c -- implements the svn_fs_fs__benchmark_reads private API
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_time.h>
+#if APR_HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "private/svn_fs_fs_private.h"
+
+#include "fs_fs.h"
+#include "rev_file.h"
+#include "util.h"
+
+#include "../libsvn_fs/fs-loader.h"
+
+/* Number of sequential and concurrent runs each.  The order alternates
+ * between rounds, so neither kind of run gets to profit more often from
+ * data that the other one left in the OS file cache. */
+#define BENCH_READ_ROUNDS 4
+
+/* Ask the OS to drop the cached contents of FILE, if we know how to.
+ * Rev and pack files are never modified, so this does not cause any
+ * writes.  Failure is not an error; the alternating order of the runs
+ * will still keep the comparison fair.
+ */
+static void
+drop_file_cache(svn_fs_fs__revision_file_t *file)
+{
+#if defined(POSIX_FADV_DONTNEED)
+  apr_os_file_t fd;
+
+  if (apr_os_file_get(&fd, file->file) == APR_SUCCESS)
+    (void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+}
+
+/* Execute the COUNT REQUESTS against FILE with MAX_IN_FLIGHT concurrent
+ * reads, starting with a cold file cache where possible.  Add the time
+ * it took to *DURATION and the number of bytes read to *BYTES.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+timed_run(apr_interval_time_t *duration,
+          apr_int64_t *bytes,
+          svn_fs_fs__revision_file_t *file,
+          svn_fs_fs__read_request_t *requests,
+          int count,
+          int max_in_flight,
+          apr_pool_t *scratch_pool)
+{
+  apr_time_t start;
+  int i;
+
+  drop_file_cache(file);
+
+  start = apr_time_now();
+  SVN_ERR(svn_fs_fs__rev_file_read_async(file, requests, count,
+                                         max_in_flight, scratch_pool));
+  *duration += apr_time_now() - start;
+
+  for (i = 0; i < count; ++i)
+    *bytes += requests[i].read;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__benchmark_reads(svn_fs_fs__read_benchmark_t *results,
+                           svn_fs_t *fs,
+                           svn_revnum_t revision,
+                           int count,
+                           int max_in_flight,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__read_request_t *requests;
+  svn_filesize_t filesize;
+  apr_int64_t blocks;
+  apr_uint32_t seed = (apr_uint32_t)revision;
+  apr_int64_t async_bytes = 0;
+  int i, round;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(revision, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, revision,
+                                           scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_file_size_get(&filesize, rev_file->file, scratch_pool));
+
+  /* Pick block-aligned locations at random.  The sequence depends on
+   * REVISION only, i.e. repeated runs will read the same data. */
+  blocks = MAX(1, filesize / ffd->block_size);
+  requests = apr_pcalloc(scratch_pool, count * sizeof(*requests));
+  for (i = 0; i < count; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      requests[i].offset = (apr_off_t)(seed % blocks) * ffd->block_size;
+      requests[i].size = (apr_size_t)ffd->block_size;
+      requests[i].buffer = apr_palloc(scratch_pool, requests[i].size);
+    }
+
+  results->requests = (apr_int64_t)count * BENCH_READ_ROUNDS;
+  results->bytes = 0;
+  results->sync_time = 0;
+  results->async_time = 0;
+
+  for (round = 0; round < BENCH_READ_ROUNDS; ++round)
+    {
+      svn_boolean_t sync_first = (round % 2 == 0);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (sync_first)
+        SVN_ERR(timed_run(&results->sync_time, &results->bytes, rev_file,
+                          requests, count, 1, scratch_pool));
+
+      SVN_ERR(timed_run(&results->async_time, &async_bytes, rev_file,
+                        requests, count, max_in_flight, scratch_pool));
+
+      if (!sync_first)
+        SVN_ERR(timed_run(&results->sync_time, &results->bytes, rev_file,
+                          requests, count, 1, scratch_pool));
+    }
+
+  return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+}
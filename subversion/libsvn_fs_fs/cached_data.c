@@ -38,6 +38,7 @@
 #include "index.h"
 #include "low_level.h"
 #include "pack.h"
+#include "tasks.h"
 #include "util.h"
 #include "temp_serializer.h"
 
@@ -56,6 +57,16 @@ block_read(void **result,
            apr_pool_t *result_pool,
            apr_pool_t *scratch_pool);
 
+static svn_error_t *
+block_read_at(void **result,
+              svn_fs_t *fs,
+              svn_revnum_t revision,
+              apr_uint64_t item_index,
+              apr_off_t wanted_offset,
+              svn_fs_fs__revision_file_t *revision_file,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool);
+
 
 /* Define this to enable access logging via dbg_log_access
 #define SVN_FS_FS__LOG_ACCESS
@@ -208,6 +219,123 @@ aligned_seek(svn_fs_t *fs,
                                                   pool));
 }
 
+/* Record that we are about to issue another read request against a rev
+   or pack file in FS. */
+static void
+count_round_trip(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_atomic_inc(&ffd->rep_read_round_trips);
+}
+
+apr_uint64_t
+svn_fs_fs__reset_rep_read_round_trips(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_atomic_t result;
+
+  /* Don't lose increments that happen while we reset the counter. */
+  do
+    result = svn_atomic_read(&ffd->rep_read_round_trips);
+  while (svn_atomic_cas(&ffd->rep_read_round_trips, 0, result) != result);
+
+  return result;
+}
+
+/* Baton type for streams over a range of a file mapping.  Unlike
+   svn_string_t, the data is not NUL-terminated. */
+typedef struct mapped_stream_baton_t
+{
+  /* The mapped data and its length. */
+  const char *data;
+  apr_size_t size;
+
+  /* Current read position within DATA. */
+  apr_size_t pos;
+} mapped_stream_baton_t;
+
+/* Implements svn_read_fn_t for mapped_stream_baton_t BATON. */
+static svn_error_t *
+read_handler_mapped(void *baton,
+                    char *buffer,
+                    apr_size_t *len)
+{
+  mapped_stream_baton_t *btn = baton;
+
+  *len = MIN(*len, btn->size - btn->pos);
+  memcpy(buffer, btn->data + btn->pos, *len);
+  btn->pos += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_skip_fn_t for mapped_stream_baton_t BATON. */
+static svn_error_t *
+skip_handler_mapped(void *baton,
+                    apr_size_t len)
+{
+  mapped_stream_baton_t *btn = baton;
+  btn->pos += MIN(len, btn->size - btn->pos);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_mark_fn_t for mapped_stream_baton_t BATON.
+   The mark is the read position, allocated in POOL. */
+static svn_error_t *
+mark_handler_mapped(void *baton,
+                    svn_stream_mark_t **mark,
+                    apr_pool_t *pool)
+{
+  mapped_stream_baton_t *btn = baton;
+  apr_size_t *pos = apr_palloc(pool, sizeof(*pos));
+
+  *pos = btn->pos;
+  *mark = (svn_stream_mark_t *)pos;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_seek_fn_t for mapped_stream_baton_t BATON. */
+static svn_error_t *
+seek_handler_mapped(void *baton,
+                    const svn_stream_mark_t *mark)
+{
+  mapped_stream_baton_t *btn = baton;
+  btn->pos = mark ? *(const apr_size_t *)mark : 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* If REV_FILE has been mapped into memory, return a stream over the SIZE
+   bytes starting at OFFSET in it.  The stream does not copy the data.
+   Return NULL if the file is not mapped.  Allocate the result in POOL. */
+static svn_stream_t *
+mapped_stream(svn_fs_fs__revision_file_t *rev_file,
+              apr_off_t offset,
+              apr_size_t size,
+              apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  mapped_stream_baton_t *baton;
+  const char *mapped = svn_fs_fs__rev_file_mapped(rev_file, offset, size);
+  if (mapped == NULL)
+    return NULL;
+
+  baton = apr_palloc(pool, sizeof(*baton));
+  baton->data = mapped;
+  baton->size = size;
+  baton->pos = 0;
+
+  stream = svn_stream_create(baton, pool);
+  svn_stream_set_read2(stream, read_handler_mapped, read_handler_mapped);
+  svn_stream_set_skip(stream, skip_handler_mapped);
+  svn_stream_set_mark(stream, mark_handler_mapped);
+  svn_stream_set_seek(stream, seek_handler_mapped);
+
+  return stream;
+}
+
 /* Open the revision file for revision REV in filesystem FS and store
    the newly opened file in FILE.  Seek to location OFFSET before
    returning.  Perform temporary allocations in POOL. */
@@ -808,9 +936,20 @@ auto_read_diff_version(rep_state_t *rs, apr_pool_t *pool)
   if (rs->ver == -1)
     {
       char buf[4];
-      SVN_ERR(rs_aligned_seek(rs, NULL, rs->start, pool));
-      SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
-                                     sizeof(buf), NULL, NULL, pool));
+      const char *mapped = svn_fs_fs__rev_file_mapped(rs->sfile->rfile,
+                                                      rs->start,
+                                                      sizeof(buf));
+      if (mapped)
+        {
+          memcpy(buf, mapped, sizeof(buf));
+        }
+      else
+        {
+          count_round_trip(rs->sfile->fs);
+          SVN_ERR(rs_aligned_seek(rs, NULL, rs->start, pool));
+          SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
+                                         sizeof(buf), NULL, NULL, pool));
+        }
 
       /* ### Layering violation */
       if (! ((buf[0] == 'S') && (buf[1] == 'V') && (buf[2] == 'N')))
@@ -939,6 +1078,7 @@ create_rep_state_body(rep_state_t **rep_state,
                                                result_pool));
         }
 
+      count_round_trip(fs);
       SVN_ERR(svn_fs_fs__read_rep_header(&rh, rs->sfile->rfile->stream,
                                          result_pool, scratch_pool));
       SVN_ERR(get_file_offset(&rs->start, rs, result_pool));
@@ -1227,6 +1367,18 @@ struct rep_read_baton
   /* Pool used to store file handles and other data that is persistant
      for the entire stream read. */
   apr_pool_t *filehandle_pool;
+
+  /* Maximum number of windows to reconstruct concurrently.
+     Parallel reconstruction is disabled if this is < 2. */
+  int parallel_windows;
+
+  /* Windows that have been reconstructed in parallel but not been
+     delivered yet, as svn_stringbuf_t *.  NEXT_READY is the index of
+     the next window to deliver.  Both are allocated in READY_POOL,
+     which will be NULL until the first parallel batch gets created. */
+  apr_array_header_t *ready_windows;
+  int next_ready;
+  apr_pool_t *ready_pool;
 };
 
 /* Set window key in *KEY to address the window described by RS.
@@ -1268,8 +1420,8 @@ parse_raw_window(void **out,
   stream = svn_stream_from_string(&raw_window, result_pool);
 
   /* parse it */
-  SVN_ERR(svn_txdelta_read_svndiff_window(&result->window, stream, 1,
-                                          result_pool));
+  SVN_ERR(svn_txdelta_read_svndiff_window(&result->window, stream,
+                                          window->ver, result_pool));
 
   /* complete the window and return it */
   result->end_offset = window->end_offset;
@@ -1422,6 +1574,250 @@ set_cached_combined_window(svn_stringbuf_t *window,
   return SVN_NO_ERROR;
 }
 
+/* Upper limit for the number of bytes fetched by a single prefetch read
+   in prefetch_rep_list(). */
+#define MAX_PREFETCH_SIZE (1024 * 1024)
+
+/* A delta representation whose first windows shall be prefetched. */
+typedef struct prefetch_item_t
+{
+  /* The representation. */
+  rep_state_t *rs;
+
+  /* First revision in the rev / pack file that contains RS. */
+  svn_revnum_t file_rev;
+
+  /* Absolute offsets within that file of the first byte to prefetch and
+     of the first byte behind that range. */
+  apr_off_t start;
+  apr_off_t end;
+} prefetch_item_t;
+
+/* Sort prefetch_item_t * by file and offset. */
+static int
+compare_prefetch_items(const void *lhs, const void *rhs)
+{
+  const prefetch_item_t *a = *(const prefetch_item_t * const *)lhs;
+  const prefetch_item_t *b = *(const prefetch_item_t * const *)rhs;
+
+  if (a->file_rev != b->file_rev)
+    return a->file_rev < b->file_rev ? -1 : 1;
+  if (a->start != b->start)
+    return a->start < b->start ? -1 : 1;
+
+  return 0;
+}
+
+/* DATA contains the first LEN bytes of delta representation RS, starting
+   at its svndiff header.  Put all windows that are fully contained in
+   DATA into RS->RAW_WINDOW_CACHE.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+cache_prefetched_windows(rep_state_t *rs,
+                         const char *data,
+                         apr_size_t len,
+                         apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  window_cache_key_t key = { 0 };
+  apr_off_t current = 4;
+  int ver;
+
+  /* Leave error reporting for malformed reps to the regular code path. */
+  if (len < 4 || data[0] != 'S' || data[1] != 'V' || data[2] != 'N')
+    return SVN_NO_ERROR;
+
+  ver = data[3];
+  get_window_key(&key, rs);
+  key.chunk_index = 0;
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (current < rs->size && current < len)
+    {
+      svn_fs_fs__raw_cached_window_t window;
+      svn_string_t remainder;
+      apr_size_t window_len;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* The last window may have been cut off by the prefetch limit. */
+      remainder.data = data + current;
+      remainder.len = len - (apr_size_t)current;
+      err = svn_txdelta__read_raw_window_len(&window_len,
+                                             svn_stream_from_string(
+                                                 &remainder, iterpool),
+                                             iterpool);
+      if (err || window_len > remainder.len)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      current += window_len;
+      if (current > rs->size)
+        break;
+
+      window.end_offset = current;
+      window.ver = ver;
+      window.window.len = window_len;
+      window.window.data = remainder.data;
+
+      SVN_ERR(svn_cache__set(rs->raw_window_cache, &key, &window, iterpool));
+      key.chunk_index++;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Before reconstructing any contents from the delta chain in LIST,
+   fetch the first few windows of all its representations that we don't
+   have in our caches yet.  Reps that are close to each other in the
+   same rev / pack file are fetched with a single read request.  Their
+   locations are taken from the index, so the number of I/O round trips
+   no longer grows with the length of the delta chain.  If enabled, the
+   requests for the same file will be executed concurrently.  FS is the file
+   system that contains the reps.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+prefetch_rep_list(apr_array_header_t *list,
+                  svn_fs_t *fs,
+                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *items;
+  apr_pool_t *iterpool;
+  int i, k, next_file;
+
+  /* Prefetching a single rep would not save any round trips. */
+  if (list->nelts < 2 || !ffd->raw_window_cache)
+    return SVN_NO_ERROR;
+
+  /* Collect the reps that we would need to read. */
+  items = apr_array_make(scratch_pool, list->nelts,
+                         sizeof(prefetch_item_t *));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < list->nelts; ++i)
+    {
+      rep_state_t *rs = APR_ARRAY_IDX(list, i, rep_state_t *);
+      window_cache_key_t key = { 0 };
+      svn_boolean_t is_cached;
+      prefetch_item_t *item;
+
+      svn_pool_clear(iterpool);
+
+      /* Reps in txns and those too large for the window caches will be
+         read directly. */
+      if (!SVN_IS_VALID_REVNUM(rs->revision) || !rs->window_cache)
+        continue;
+
+      SVN_ERR(svn_cache__has_key(&is_cached, rs->window_cache,
+                                 get_window_key(&key, rs), iterpool));
+      if (!is_cached)
+        SVN_ERR(svn_cache__has_key(&is_cached, rs->raw_window_cache,
+                                   &key, iterpool));
+      if (is_cached)
+        continue;
+
+      /* Locate the rep using the index. */
+      SVN_ERR(auto_open_shared_file(rs->sfile));
+      SVN_ERR(auto_set_start_offset(rs, iterpool));
+
+      item = apr_pcalloc(scratch_pool, sizeof(*item));
+      item->rs = rs;
+      item->file_rev = svn_fs_fs__is_packed_rev(fs, rs->revision)
+                     ? svn_fs_fs__packed_base_rev(fs, rs->revision)
+                     : rs->revision;
+      item->start = rs->start;
+      item->end = rs->start + MIN(rs->size, ffd->block_size);
+
+      APR_ARRAY_PUSH(items, prefetch_item_t *) = item;
+    }
+
+  svn_sort__array(items, compare_prefetch_items);
+
+  /* Fetch runs of nearby reps at once.  All runs within the same file
+     are being sent as a single batch of potentially concurrent reads. */
+  for (i = 0; i < items->nelts; i = next_file)
+    {
+      prefetch_item_t *first = APR_ARRAY_IDX(items, i, prefetch_item_t *);
+      svn_fs_fs__read_request_t *requests;
+      int *run_starts;
+      int runs = 0;
+      int j;
+
+      svn_pool_clear(iterpool);
+
+      for (next_file = i + 1; next_file < items->nelts; ++next_file)
+        if (APR_ARRAY_IDX(items, next_file, prefetch_item_t *)->file_rev
+            != first->file_rev)
+          break;
+
+      requests = apr_pcalloc(iterpool, (next_file - i) * sizeof(*requests));
+      run_starts = apr_palloc(iterpool,
+                              (next_file - i + 1) * sizeof(*run_starts));
+
+      for (k = i; k < next_file; k = j)
+        {
+          prefetch_item_t *run_first = APR_ARRAY_IDX(items, k,
+                                                     prefetch_item_t *);
+          apr_off_t end = run_first->end;
+
+          for (j = k + 1; j < next_file; ++j)
+            {
+              prefetch_item_t *next = APR_ARRAY_IDX(items, j,
+                                                    prefetch_item_t *);
+              if (   next->start - end > ffd->block_size
+                  || next->end - run_first->start > MAX_PREFETCH_SIZE)
+                break;
+
+              end = MAX(end, next->end);
+            }
+
+          /* A single round trip for all reps in [k, j). */
+          requests[runs].offset = run_first->start;
+          requests[runs].size = (apr_size_t)(end - run_first->start);
+          requests[runs].buffer = apr_palloc(iterpool,
+                                             requests[runs].size + 1);
+          run_starts[runs] = k;
+          count_round_trip(fs);
+          runs++;
+        }
+      run_starts[runs] = next_file;
+
+      SVN_ERR(svn_fs_fs__rev_file_read_async(first->rs->sfile->rfile,
+                                             requests, runs,
+                                             ffd->async_reads, iterpool));
+
+      for (k = 0; k < runs; ++k)
+        for (j = run_starts[k]; j < run_starts[k + 1]; ++j)
+          {
+            prefetch_item_t *item = APR_ARRAY_IDX(items, j,
+                                                  prefetch_item_t *);
+            apr_off_t offset = item->start - requests[k].offset;
+            apr_off_t item_end = MIN(item->end,
+                                     requests[k].offset
+                                     + (apr_off_t)requests[k].read);
+
+            /* The raw window serializer includes the terminating NUL. */
+            requests[k].buffer[requests[k].read] = 0;
+
+            if (item_end > item->start)
+              SVN_ERR(cache_prefetched_windows(item->rs,
+                                               requests[k].buffer + offset,
+                                               (apr_size_t)(item_end
+                                                            - item->start),
+                                               iterpool));
+          }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Build an array of rep_state structures in *LIST giving the delta
    reps from first_rep to a plain-text or self-compressed rep.  Set
    *SRC_STATE to the plain-text rep we find at the end of the chain,
@@ -1498,6 +1894,11 @@ build_rep_list(apr_array_header_t **list,
 
       rs = NULL;
     }
+
+  /* Now that we know the whole chain, fetch the delta data in as few
+     round trips as possible. */
+  svn_pool_clear(iterpool);
+  SVN_ERR(prefetch_rep_list(*list, fs, iterpool));
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -1533,6 +1934,10 @@ rep_read_get_baton(struct rep_read_baton **rb_p,
   b->fulltext_cache = NULL;
   b->fulltext_delivered = 0;
   b->current_fulltext = NULL;
+  b->parallel_windows = ((fs_fs_data_t *)fs->fsap_data)->parallel_windows;
+  b->ready_windows = NULL;
+  b->next_ready = 0;
+  b->ready_pool = NULL;
 
   /* Save our output baton. */
   *rb_p = b;
@@ -1594,6 +1999,7 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   /* RS->FILE may be shared between RS instances -> make sure we point
    * to the right data. */
   start_offset = rs->start + rs->current;
+  count_round_trip(rs->sfile->fs);
   SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, scratch_pool));
 
   /* Skip windows to reach the current chunk if we aren't there yet. */
@@ -1646,6 +2052,7 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
   SVN_ERR(auto_set_start_offset(rs, scratch_pool));
 
   offset = rs->start + rs->current;
+  count_round_trip(rs->sfile->fs);
   SVN_ERR(rs_aligned_seek(rs, NULL, offset, scratch_pool));
 
   /* Read the plain data. */
@@ -1754,6 +2161,190 @@ get_combined_window(svn_stringbuf_t **result,
   return SVN_NO_ERROR;
 }
 
+/* All the data needed to reconstruct a single window of a deltified
+   representation without further access to the repository.  Filled
+   in by prepare_window_task() and processed by combine_window_task(). */
+typedef struct window_task_t
+{
+  /* The delta windows for this chunk, starting at the representation
+     that we want to read and ending at the first window that does not
+     depend on its predecessors. */
+  svn_txdelta_window_t **windows;
+  int count;
+
+  /* Source data for the last entry in WINDOWS.  May be NULL. */
+  svn_stringbuf_t *source;
+
+  /* Buffers for intermediate results.  Large enough to hold any
+     target view in WINDOWS. */
+  svn_stringbuf_t *intermediate[2];
+
+  /* The reconstructed window.  Pre-allocated. */
+  svn_stringbuf_t *result;
+} window_task_t;
+
+/* Read all windows of chunk number CHUNK_INDEX from the delta chain in
+   RB as well as the base fulltext data that they need and store them in
+   *TASK.  Advance all representation states in RB to the next chunk.
+   This does the same I/O in the same order as get_combined_window() but
+   does not combine the windows.  Allocate the data in RESULT_POOL and
+   use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+prepare_window_task(window_task_t *task,
+                    struct rep_read_baton *rb,
+                    int chunk_index,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  int i;
+  apr_size_t max_len = 0;
+  svn_txdelta_window_t *window;
+  rep_state_t *rs;
+
+  task->windows = apr_palloc(result_pool,
+                             rb->rs_list->nelts * sizeof(*task->windows));
+  for (i = 0; i < rb->rs_list->nelts; ++i)
+    {
+      rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
+      SVN_ERR(read_delta_window(&window, chunk_index, rs, result_pool,
+                                scratch_pool));
+
+      task->windows[i] = window;
+      max_len = MAX(max_len, window->tview_len);
+      if (window->src_ops == 0)
+        {
+          ++i;
+          break;
+        }
+    }
+  task->count = i;
+
+  /* Fetch the source data for the deepest window, if needed. */
+  window = task->windows[task->count - 1];
+  task->source = rb->base_window;
+  if (task->source == NULL && rb->src_state != NULL && window->src_ops)
+    SVN_ERR(read_plain_window(&task->source, rb->src_state,
+                              window->sview_len, result_pool,
+                              scratch_pool));
+
+  /* We are done with this chunk in all reps that contributed to it. */
+  for (i = 0; i < task->count; ++i)
+    APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *)->chunk_index++;
+
+  /* Workers must not allocate from shared pools.  So, provide all the
+     buffers that they will need. */
+  task->result = svn_stringbuf_create_ensure(task->windows[0]->tview_len,
+                                             result_pool);
+  if (task->count > 1)
+    {
+      task->intermediate[0] = svn_stringbuf_create_ensure(max_len,
+                                                          result_pool);
+      task->intermediate[1] = svn_stringbuf_create_ensure(max_len,
+                                                          result_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_fs_fs__task_func_t.  Combine the windows in the
+   window_task_t given by BATON into its pre-allocated result buffer.
+   This only touches data that belongs to BATON. */
+static svn_error_t *
+combine_window_task(void *baton)
+{
+  window_task_t *task = baton;
+  svn_stringbuf_t *source = task->source;
+  int i;
+
+  for (i = task->count - 1; i >= 0; --i)
+    {
+      svn_txdelta_window_t *window = task->windows[i];
+      svn_stringbuf_t *target = i ? task->intermediate[i % 2]
+                                  : task->result;
+
+      target->len = window->tview_len;
+      svn_txdelta_apply_instructions(window, source ? source->data : NULL,
+                                     target->data, &target->len);
+      if (target->len != window->tview_len)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("svndiff window length is "
+                                  "corrupt"));
+
+      source = target;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Reconstruct the next up to RB->PARALLEL_WINDOWS windows of the
+   representation in RB concurrently and queue them in RB->READY_WINDOWS.
+   All I/O happens sequentially in the calling thread; only the CPU-bound
+   window combination gets distributed across worker threads. */
+static svn_error_t *
+combine_window_batch(struct rep_read_baton *rb)
+{
+  rep_state_t *rs = APR_ARRAY_IDX(rb->rs_list, 0, rep_state_t *);
+  apr_array_header_t *tasks;
+  apr_pool_t *iterpool;
+  int chunk_index = rb->chunk_index;
+
+  /* Release the previous batch.  All of it has been delivered. */
+  if (rb->ready_pool)
+    svn_pool_clear(rb->ready_pool);
+  else
+    rb->ready_pool = svn_pool_create(rb->filehandle_pool);
+
+  tasks = apr_array_make(rb->ready_pool, rb->parallel_windows,
+                         sizeof(window_task_t *));
+  rb->ready_windows = apr_array_make(rb->ready_pool, rb->parallel_windows,
+                                     sizeof(svn_stringbuf_t *));
+  rb->next_ready = 0;
+
+  iterpool = svn_pool_create(rb->pool);
+  while (tasks->nelts < rb->parallel_windows && rs->current < rs->size)
+    {
+      window_task_t *task = apr_pcalloc(rb->ready_pool, sizeof(*task));
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(prepare_window_task(task, rb, chunk_index++, rb->ready_pool,
+                                  iterpool));
+
+      APR_ARRAY_PUSH(tasks, window_task_t *) = task;
+      APR_ARRAY_PUSH(rb->ready_windows, svn_stringbuf_t *) = task->result;
+    }
+
+  SVN_ERR(svn_fs_fs__run_tasks(combine_window_task, (void **)tasks->elts,
+                               tasks->nelts, iterpool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if RB still holds windows that have been reconstructed in
+   parallel but not been delivered yet. */
+static svn_boolean_t
+has_ready_windows(struct rep_read_baton *rb)
+{
+  return rb->ready_windows && rb->next_ready < rb->ready_windows->nelts;
+}
+
+/* Like get_combined_window but reconstruct windows in batches in
+   parallel.  Set *RESULT to the next window of the representation in RB.
+   The result remains valid until the next call to this function. */
+static svn_error_t *
+get_parallel_window(svn_stringbuf_t **result,
+                    struct rep_read_baton *rb)
+{
+  if (!has_ready_windows(rb))
+    SVN_ERR(combine_window_batch(rb));
+
+  *result = APR_ARRAY_IDX(rb->ready_windows, rb->next_ready,
+                          svn_stringbuf_t *);
+  rb->next_ready++;
+
+  return SVN_NO_ERROR;
+}
+
 /* Returns whether or not the expanded fulltext of the file is cachable
  * based on its size SIZE.  The decision depends on the cache used by FFD.
  */
@@ -1857,11 +2448,16 @@ get_contents_from_windows(struct rep_read_baton *rb,
           svn_stringbuf_t *sbuf = NULL;
 
           rs = APR_ARRAY_IDX(rb->rs_list, 0, rep_state_t *);
-          if (rs->current == rs->size)
+          if (rs->current == rs->size && !has_ready_windows(rb))
             break;
 
-          /* Get more buffered data by evaluating a chunk. */
-          SVN_ERR(get_combined_window(&sbuf, rb));
+          /* Get more buffered data by evaluating a chunk.  The first
+             chunk always gets reconstructed sequentially as that is the
+             only one that may be cached as a combined window. */
+          if (rb->parallel_windows > 1 && rb->chunk_index > 0)
+            SVN_ERR(get_parallel_window(&sbuf, rb));
+          else
+            SVN_ERR(get_combined_window(&sbuf, rb));
 
           rb->chunk_index++;
           rb->buf_len = sbuf->len;
@@ -2873,6 +3469,80 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of changed paths lists that prefetch_changes reads
+ * ahead. */
+#define CHANGES_PREFETCH_COUNT 16
+
+/* REV in FS has just been read from the pack file REVISION_FILE in
+ * block-read mode.  Callers like "svn log -v" will typically ask for the
+ * changes of the preceding revisions next.  Put the changed paths lists
+ * of up to CHANGES_PREFETCH_COUNT of those revisions into the cache,
+ * stopping at the first one that has already been cached.
+ *
+ * The changes lists of a pack file are stored next to each other, so
+ * a single block read will usually fetch many of them.  The caller is
+ * expected to ignore any errors returned by this function.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+prefetch_changes(svn_fs_t *fs,
+                 svn_revnum_t rev,
+                 svn_fs_fs__revision_file_t *revision_file,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__id_part_t items[CHANGES_PREFETCH_COUNT];
+  apr_off_t offsets[CHANGES_PREFETCH_COUNT];
+  svn_revnum_t prefetch_rev;
+  apr_pool_t *iterpool;
+  int count = 0;
+  int i;
+
+  if (!ffd->changes_cache || !revision_file->is_packed)
+    return SVN_NO_ERROR;
+
+  for (prefetch_rev = rev - 1;
+       prefetch_rev >= revision_file->start_revision
+         && count < CHANGES_PREFETCH_COUNT;
+       --prefetch_rev)
+    {
+      svn_boolean_t is_cached;
+      SVN_ERR(svn_cache__has_key(&is_cached, ffd->changes_cache,
+                                 &prefetch_rev, scratch_pool));
+      if (is_cached)
+        break;
+
+      items[count].revision = prefetch_rev;
+      items[count].number = SVN_FS_FS__ITEM_INDEX_CHANGES;
+      ++count;
+    }
+
+  /* Resolve all item offsets at once. */
+  SVN_ERR(svn_fs_fs__item_offsets(offsets, fs, revision_file, items, count,
+                                  scratch_pool));
+
+  /* Each block read may cache the lists of many of the following
+   * revisions as well. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < count; ++i)
+    {
+      svn_boolean_t is_cached;
+      void *changes = NULL;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__has_key(&is_cached, ffd->changes_cache,
+                                 &items[i].revision, iterpool));
+      if (!is_cached)
+        SVN_ERR(block_read_at(&changes, fs, items[i].revision,
+                              items[i].number, offsets[i], revision_file,
+                              iterpool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__get_changes(apr_array_header_t **changes,
                        svn_fs_t *fs,
@@ -2911,6 +3581,12 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
           SVN_ERR(block_read((void **)changes, fs,
                              rev, SVN_FS_FS__ITEM_INDEX_CHANGES,
                              revision_file, result_pool, scratch_pool));
+
+          /* The caller will likely ask for older revisions next.
+           * This is merely speculative, so failing to prefetch must not
+           * fail the request.  We simply read those later, if needed. */
+          svn_error_clear(prefetch_changes(fs, rev, revision_file,
+                                           scratch_pool));
         }
       else
         {
@@ -2997,9 +3673,9 @@ init_rep_state(rep_state_t *rs,
   rs->item_index = entry->item.number;
   rs->header_size = rep_header->header_size;
   rs->start = entry->offset + rs->header_size;
-  rs->current = rep_header->type == svn_fs_fs__rep_plain ? 0 : 4;
+  rs->current = 0;
   rs->size = entry->size - rep_header->header_size - 7;
-  rs->ver = 1;
+  rs->ver = -1;
   rs->chunk_index = 0;
   rs->raw_window_cache = ffd->raw_window_cache;
   rs->window_cache = ffd->txdelta_window_cache;
@@ -3095,28 +3771,56 @@ cache_windows(svn_fs_t *fs,
           svn_fs_fs__raw_cached_window_t window;
           apr_off_t start_offset = rs->start + rs->current;
           apr_size_t window_len;
-          char *buf;
-
-          /* navigate to the current window */
-          SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
-          SVN_ERR(svn_txdelta__read_raw_window_len(&window_len,
-                                                   rs->sfile->rfile->stream,
-                                                   iterpool));
+          const char *mapped;
+          svn_stream_t *stream
+            = mapped_stream(rs->sfile->rfile, start_offset,
+                            (apr_size_t)(rs->size - rs->current), iterpool);
 
-          /* Read the raw window. */
-          buf = apr_palloc(iterpool, window_len + 1);
-          SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
-          SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
-                                         window_len, NULL, NULL, iterpool));
-          buf[window_len] = 0;
+          if (stream)
+            {
+              /* Zero-copy: parse and cache the window right from the
+               * mapped file contents.  The window data will not be
+               * NUL-terminated;  the cache serializer takes care of that
+               * for the cached copy. */
+              SVN_ERR(svn_txdelta__read_raw_window_len(&window_len, stream,
+                                                       iterpool));
+              mapped = svn_fs_fs__rev_file_mapped(rs->sfile->rfile,
+                                                  start_offset,
+                                                  window_len);
+              if (mapped == NULL)
+                return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                        _("Reading one svndiff window read "
+                                          "beyond the end of the file"));
+            }
+          else
+            {
+              char *buf;
+
+              /* navigate to the current window */
+              count_round_trip(fs);
+              SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
+              SVN_ERR(svn_txdelta__read_raw_window_len(&window_len,
+                                                  rs->sfile->rfile->stream,
+                                                  iterpool));
+
+              /* Read the raw window. */
+              buf = apr_palloc(iterpool, window_len + 1);
+              SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
+              SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
+                                             window_len, NULL, NULL,
+                                             iterpool));
+              buf[window_len] = 0;
+              mapped = buf;
+            }
 
           /* update relative offset in representation */
           rs->current += window_len;
 
           /* Construct the cachable raw window object. */
           window.end_offset = rs->current;
+          window.ver = rs->ver;
           window.window.len = window_len;
-          window.window.data = buf;
+          window.window.data = mapped;
 
           /* cache the window now */
           SVN_ERR(svn_cache__set(rs->raw_window_cache, &key, &window,
@@ -3171,6 +3875,7 @@ block_read_windows(svn_fs_fs__rep_header_t *rep_header,
     {
       svn_stringbuf_t *plaintext;
       svn_boolean_t is_cached;
+      const char *mapped;
 
       /* already in cache? */
       SVN_ERR(svn_cache__has_key(&is_cached, rs.combined_cache,
@@ -3179,15 +3884,25 @@ block_read_windows(svn_fs_fs__rep_header_t *rep_header,
       if (is_cached)
         return SVN_NO_ERROR;
 
-      /* for larger reps, the header may have crossed a block boundary.
-       * make sure we still read blocks properly aligned, i.e. don't use
-       * plain seek here. */
-      SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset, scratch_pool));
-
       plaintext = svn_stringbuf_create_ensure(rs.size, result_pool);
-      SVN_ERR(svn_io_file_read_full2(rev_file->file, plaintext->data,
-                                     rs.size, &plaintext->len, NULL,
-                                     result_pool));
+      mapped = svn_fs_fs__rev_file_mapped(rev_file, offset,
+                                          (apr_size_t)rs.size);
+      if (mapped)
+        {
+          memcpy(plaintext->data, mapped, (apr_size_t)rs.size);
+          plaintext->len = (apr_size_t)rs.size;
+        }
+      else
+        {
+          /* for larger reps, the header may have crossed a block boundary.
+           * make sure we still read blocks properly aligned, i.e. don't use
+           * plain seek here. */
+          SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset,
+                               scratch_pool));
+          SVN_ERR(svn_io_file_read_full2(rev_file->file, plaintext->data,
+                                         rs.size, &plaintext->len, NULL,
+                                         result_pool));
+        }
       plaintext->data[plaintext->len] = 0;
       rs.current += rs.size;
 
@@ -3195,6 +3910,8 @@ block_read_windows(svn_fs_fs__rep_header_t *rep_header,
     }
   else
     {
+      /* Skip the svndiff header but remember its version. */
+      SVN_ERR(auto_read_diff_version(&rs, scratch_pool));
       SVN_ERR(cache_windows(fs, &rs, max_offset, scratch_pool));
     }
 
@@ -3253,11 +3970,15 @@ block_read_contents(svn_fs_t *fs,
 {
   pair_cache_key_t header_key = { 0 };
   svn_fs_fs__rep_header_t *rep_header;
+  svn_stream_t *stream = mapped_stream(rev_file, entry->offset,
+                                       (apr_size_t)entry->size,
+                                       scratch_pool);
 
   header_key.revision = (apr_int32_t)entry->item.revision;
   header_key.second = entry->item.number;
 
-  SVN_ERR(read_rep_header(&rep_header, fs, rev_file->stream, &header_key,
+  SVN_ERR(read_rep_header(&rep_header, fs,
+                          stream ? stream : rev_file->stream, &header_key,
                           result_pool, scratch_pool));
   SVN_ERR(block_read_windows(rep_header, fs, rev_file, entry, max_offset,
                              result_pool, scratch_pool));
@@ -3279,17 +4000,29 @@ read_item(svn_stream_t **stream,
   apr_uint32_t digest;
   svn_checksum_t *expected, *actual;
   apr_uint32_t plain_digest;
+  const char *mapped = svn_fs_fs__rev_file_mapped(rev_file, entry->offset,
+                                                  (apr_size_t)entry->size);
 
-  /* Read item into string buffer. */
-  svn_stringbuf_t *text = svn_stringbuf_create_ensure(entry->size, pool);
-  text->len = entry->size;
-  text->data[text->len] = 0;
-  SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
-                                 NULL, NULL, pool));
-
-  /* Return (construct, calculate) stream and checksum. */
-  *stream = svn_stream_from_stringbuf(text, pool);
-  digest = svn__fnv1a_32x4(text->data, text->len);
+  if (mapped)
+    {
+      /* Use the mapped file contents directly. */
+      *stream = mapped_stream(rev_file, entry->offset,
+                              (apr_size_t)entry->size, pool);
+      digest = svn__fnv1a_32x4(mapped, (apr_size_t)entry->size);
+    }
+  else
+    {
+      /* Read item into string buffer. */
+      svn_stringbuf_t *text = svn_stringbuf_create_ensure(entry->size, pool);
+      text->len = entry->size;
+      text->data[text->len] = 0;
+      SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
+                                     NULL, NULL, pool));
+
+      /* Return (construct, calculate) stream and checksum. */
+      *stream = svn_stream_from_stringbuf(text, pool);
+      digest = svn__fnv1a_32x4(text->data, text->len);
+    }
 
   /* Checksums will match most of the time. */
   if (entry->fnv1_checksum == digest)
@@ -3407,26 +4140,21 @@ block_read_noderev(node_revision_t **noderev_p,
   return SVN_NO_ERROR;
 }
 
-/* Read the whole (e.g. 64kB) block containing ITEM_INDEX of REVISION in FS
- * and put all data into cache.  If necessary and depending on heuristics,
- * neighboring blocks may also get read.  The data is being read from
- * already open REVISION_FILE, which must be the correct rev / pack file
- * w.r.t. REVISION.
- *
- * For noderevs and changed path lists, the item fetched can be allocated
- * RESULT_POOL and returned in *RESULT.  Otherwise, RESULT must be NULL.
+/* Like block_read but with the WANTED_OFFSET of ITEM_INDEX in REVISION
+ * already being known, e.g. from a batched index lookup.
  */
 static svn_error_t *
-block_read(void **result,
-           svn_fs_t *fs,
-           svn_revnum_t revision,
-           apr_uint64_t item_index,
-           svn_fs_fs__revision_file_t *revision_file,
-           apr_pool_t *result_pool,
-           apr_pool_t *scratch_pool)
+block_read_at(void **result,
+              svn_fs_t *fs,
+              svn_revnum_t revision,
+              apr_uint64_t item_index,
+              apr_off_t wanted_offset,
+              svn_fs_fs__revision_file_t *revision_file,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  apr_off_t offset, wanted_offset = 0;
+  apr_off_t offset;
   apr_off_t block_start = 0;
   apr_array_header_t *entries;
   int run_count = 0;
@@ -3443,11 +4171,8 @@ block_read(void **result,
   /* don't try this on transaction protorev files */
   SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(revision));
 
-  /* index lookup: find the OFFSET of the item we *must* read plus (in the
-   * "do-while" block) the list of items in the same block. */
-  SVN_ERR(svn_fs_fs__item_offset(&wanted_offset, fs, revision_file,
-                                 revision, NULL, item_index, iterpool));
-
+  /* Start at the OFFSET of the item we *must* read and (in the "do-while"
+   * block) get the list of items in the same block. */
   offset = wanted_offset;
 
   /* Heuristics:
@@ -3467,8 +4192,13 @@ block_read(void **result,
                                           ffd->block_size, scratch_pool,
                                           scratch_pool));
 
-      SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, offset,
-                           iterpool));
+      /* Mapped files are accessed in-place.  No need to fetch anything. */
+      if (!revision_file->mapped_data)
+        {
+          count_round_trip(fs);
+          SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, offset,
+                               iterpool));
+        }
 
       /* read all items from the block */
       for (i = 0; i < entries->nelts; ++i)
@@ -3500,8 +4230,9 @@ block_read(void **result,
                             && entry->size < ffd->block_size))
             {
               void *item = NULL;
-              SVN_ERR(svn_io_file_seek(revision_file->file, APR_SET,
-                                       &entry->offset, iterpool));
+              if (!revision_file->mapped_data)
+                SVN_ERR(svn_io_file_seek(revision_file->file, APR_SET,
+                                         &entry->offset, iterpool));
               switch (entry->type)
                 {
                   case SVN_FS_FS__ITEM_TYPE_FILE_REP:
@@ -3555,3 +4286,40 @@ block_read(void **result,
 
   return SVN_NO_ERROR;
 }
+
+/* Read the whole (e.g. 64kB) block containing ITEM_INDEX of REVISION in FS
+ * and put all data into cache.  If necessary and depending on heuristics,
+ * neighboring blocks may also get read.  The data is being read from
+ * already open REVISION_FILE, which must be the correct rev / pack file
+ * w.r.t. REVISION.
+ *
+ * For noderevs and changed path lists, the item fetched can be allocated
+ * RESULT_POOL and returned in *RESULT.  Otherwise, RESULT must be NULL.
+ */
+static svn_error_t *
+block_read(void **result,
+           svn_fs_t *fs,
+           svn_revnum_t revision,
+           apr_uint64_t item_index,
+           svn_fs_fs__revision_file_t *revision_file,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  apr_off_t wanted_offset = 0;
+
+  /* Block read is an optional feature. If the caller does not want anything
+   * specific we may not have to read anything. */
+  if (!result)
+    return SVN_NO_ERROR;
+
+  /* don't try this on transaction protorev files */
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(revision));
+
+  /* index lookup: find the OFFSET of the item we *must* read */
+  SVN_ERR(svn_fs_fs__item_offset(&wanted_offset, fs, revision_file,
+                                 revision, NULL, item_index, scratch_pool));
+
+  return svn_error_trace(block_read_at(result, fs, revision, item_index,
+                                       wanted_offset, revision_file,
+                                       result_pool, scratch_pool));
+}
@@ -167,4 +167,11 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
                        svn_revnum_t rev,
                        apr_pool_t *pool);
 
+/* Return the number of read requests that have been issued against rev
+ * and pack files in FS while reading representations since the last call
+ * to this function.  Reset the counter to 0.
+ */
+apr_uint64_t
+svn_fs_fs__reset_rep_read_round_trips(svn_fs_t *fs);
+
 #endif
@@ -30,6 +30,7 @@
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_config.h"
+#include "svn_dirent_uri.h"
 #include "svn_cache_config.h"
 
 #include "svn_private_config.h"
@@ -339,16 +340,45 @@ create_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+/* Set *INSTANCE_ID to a string that identifies the repository instance
+ * of FS in cache keys.  Allocate it in POOL.
+ *
+ * Repositories before SVN_FS_FS__MIN_INSTANCE_ID_FORMAT don't store an
+ * instance ID and FFD->INSTANCE_ID falls back to the UUID.  The UUID
+ * survives restoring a backup, so use the identity of the "uuid" file
+ * instead.  It gets re-created whenever the repository does.
+ */
+static svn_error_t *
+get_cache_instance_id(const char **instance_id,
+                      svn_fs_t *fs,
+                      apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_finfo_t finfo;
+
+  if (ffd->format >= SVN_FS_FS__MIN_INSTANCE_ID_FORMAT)
+    {
+      *instance_id = ffd->instance_id;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_stat(&finfo, svn_dirent_join(fs->path, PATH_UUID, pool),
+                      APR_FINFO_INODE | APR_FINFO_MTIME, pool));
+  *instance_id = apr_psprintf(pool, "%s-%" APR_UINT64_T_FMT
+                              "-%" APR_TIME_T_FMT,
+                              ffd->instance_id,
+                              (apr_uint64_t)finfo.inode, finfo.mtime);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__initialize_caches(svn_fs_t *fs,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  const char *prefix = apr_pstrcat(pool,
-                                   "fsfs:", fs->uuid,
-                                   "/", normalize_key_part(fs->path, pool),
-                                   ":",
-                                   SVN_VA_NULL);
+  const char *prefix;
+  const char *instance_id;
   svn_membuffer_t *membuffer;
   svn_boolean_t no_handler = ffd->fail_stop;
   svn_boolean_t cache_txdeltas;
@@ -356,6 +386,19 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   const char *cache_namespace;
   svn_boolean_t has_namespace;
 
+  /* Cache contents may survive server restarts (see
+     svn_cache__membuffer_cache_save).  The instance ID changes whenever
+     a repository gets replaced by a different one with the same UUID at
+     the same path, e.g. by restoring a backup, so restored entries for
+     the old repository will never be hit. */
+  SVN_ERR(get_cache_instance_id(&instance_id, fs, pool));
+  prefix = apr_pstrcat(pool,
+                       "fsfs:", fs->uuid,
+                       "/", instance_id,
+                       "/", normalize_key_part(fs->path, pool),
+                       ":",
+                       SVN_VA_NULL);
+
   /* Evaluating the cache configuration. */
   SVN_ERR(read_config(&cache_namespace,
                       &cache_txdeltas,
@@ -42,6 +42,7 @@
 #include "recovery.h"
 #include "rep-cache.h"
 #include "revprops.h"
+#include "tasks.h"
 #include "transaction.h"
 #include "util.h"
 #include "verify.h"
@@ -123,6 +124,15 @@ fs_serialized_init(svn_fs_t *fs, apr_pool_t *common_pool, apr_pool_t *pool)
          transaction list and free transaction pointer. */
       SVN_ERR(svn_mutex__init(&ffsd->txn_list_lock, TRUE, common_pool));
 
+      /* A mutex to coalesce the directory syncs after updating
+         the 'current' file. */
+      SVN_ERR(svn_mutex__init(&ffsd->current_sync_lock, TRUE, common_pool));
+      ffsd->synced_revision = SVN_INVALID_REVNUM;
+
+      /* ... and one for the rep-cache filter. */
+      SVN_ERR(svn_mutex__init(&ffsd->rep_cache_filter_lock, TRUE,
+                              common_pool));
+
       key = apr_pstrdup(common_pool, key);
       status = apr_pool_userdata_set(ffsd, key, NULL, common_pool);
       if (status)
@@ -307,6 +317,33 @@ uninitialize_fs_struct(svn_fs_t *fs)
   fs->fsap_data = NULL;
 }
 
+svn_error_t *
+svn_fs_fs__open_clone(svn_fs_t **clone_p,
+                      svn_fs_t *fs,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_t *clone = apr_pcalloc(result_pool, sizeof(*clone));
+
+  clone->pool = result_pool;
+  clone->vtable = &fs_vtable;
+  clone->warning = fs->warning;
+  clone->warning_baton = fs->warning_baton;
+  clone->config = fs->config;
+
+  SVN_ERR(initialize_fs_struct(clone));
+  SVN_ERR(svn_fs_fs__open(clone, fs->path, scratch_pool));
+  SVN_ERR(svn_fs_fs__initialize_caches(clone, scratch_pool));
+
+  /* FS has already been registered with the process-wide data. */
+  ((fs_fs_data_t *)clone->fsap_data)->shared = ffd->shared;
+
+  *clone_p = clone;
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements the fs_library_vtable_t.create() API.  Create a new
    fsfs-backed Subversion filesystem at path PATH and link it into
    *FS.  Perform temporary allocations in POOL, and fs-global allocations
@@ -624,6 +661,8 @@ svn_fs_fs__init(const svn_version_t *loader_version,
                              loader_version->major);
   SVN_ERR(svn_ver_check_list2(fs_version(), checklist, svn_ver_equal));
 
+  SVN_ERR(svn_fs_fs__tasks_init());
+
   *vtable = &library_vtable;
   return SVN_NO_ERROR;
 }
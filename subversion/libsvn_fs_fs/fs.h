@@ -64,6 +64,7 @@ extern "C" {
 #define PATH_TXN_CURRENT      "txn-current"      /* File with next txn key */
 #define PATH_TXN_CURRENT_LOCK "txn-current-lock" /* Lock for txn-current */
 #define PATH_LOCKS_DIR        "locks"            /* Directory of locks */
+#define PATH_LOCKS_DB         "locks.db"         /* Lock store */
 #define PATH_MIN_UNPACKED_REV "min-unpacked-rev" /* Oldest revision which
                                                     has not been packed. */
 #define PATH_REVPROP_GENERATION "revprop-generation"
@@ -108,6 +109,7 @@ extern "C" {
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
+#define CONFIG_OPTION_COMPRESSION        "compression"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
 #define CONFIG_OPTION_COMPRESS_PACKED_REVPROPS  "compress-packed-revprops"
@@ -125,11 +127,14 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_fs__create() as well.
  */
-#define SVN_FS_FS__FORMAT_NUMBER   7
+#define SVN_FS_FS__FORMAT_NUMBER   8
 
 /* The minimum format number that supports svndiff version 1.  */
 #define SVN_FS_FS__MIN_SVNDIFF1_FORMAT 2
 
+/* The minimum format number that supports svndiff version 2.  */
+#define SVN_FS_FS__MIN_SVNDIFF2_FORMAT 8
+
 /* The minimum format number that supports transaction ID generation
    using a transaction sequence in the txn-current file. */
 #define SVN_FS_FS__MIN_TXN_CURRENT_FORMAT 3
@@ -180,6 +185,15 @@ extern "C" {
 /* Minimum format number that supports per-instance filesystem IDs. */
 #define SVN_FS_FS__MIN_INSTANCE_ID_FORMAT 7
 
+/* Minimum format number that keeps all locks in PATH_LOCKS_DB instead of
+   the digest file tree under PATH_LOCKS_DIR. */
+#define SVN_FS_FS__MIN_LOCKS_DB_FORMAT 8
+
+/* Minimum format number that maintains the PATH_REVPROP_GENERATION file.
+   Older servers don't update it, so it must not be created for older
+   formats. */
+#define SVN_FS_FS__MIN_REVPROP_GENERATION_FORMAT 8
+
 /* The minimum format number that supports a configuration file (fsfs.conf) */
 #define SVN_FS_FS__MIN_CONFIG_FILE 4
 
@@ -253,6 +267,26 @@ typedef struct fs_fs_shared_data_t
      txn-current file. */
   svn_mutex__t *txn_current_lock;
 
+  /* A lock for intra-process synchronization when flushing the directory
+     entry of the 'current' file to disk.  May be NULL. */
+  svn_mutex__t *current_sync_lock;
+
+  /* The youngest revision for which the 'current' file update is known
+     to be on disk.  Protected by CURRENT_SYNC_LOCK. */
+  svn_revnum_t synced_revision;
+
+  /* In-memory bloom filter over the keys in rep-cache.db, see rep-cache.c.
+     NULL until first used.  Protected by REP_CACHE_FILTER_LOCK. */
+  struct rep_cache_filter_t *rep_cache_filter;
+  svn_mutex__t *rep_cache_filter_lock;
+
+  /* Number of commits whose revision contents have been written before
+     acquiring the write lock, and how many of those had to be rolled back
+     because a concurrent commit took the revision number.  Statistics
+     only, see svn_fs_fs__benchmark_commits(). */
+  volatile svn_atomic_t prepared_commits;
+  volatile svn_atomic_t rolled_back_commits;
+
   /* The common pool, under which this object is allocated, subpools
      of which are used to allocate the transaction objects. */
   apr_pool_t *common_pool;
@@ -289,6 +323,19 @@ typedef struct window_cache_key_t
   apr_uint64_t item_index;
 } window_cache_key_t;
 
+/* Secondary compression used for deltified content in the repository. */
+typedef enum compression_type_t
+{
+  /* Store deltas as svndiff0, i.e. uncompressed. */
+  compression_type_none,
+
+  /* svndiff1 with zlib at the configured compression level. */
+  compression_type_zlib,
+
+  /* svndiff2 with LZ4, only available in format 8+ repositories. */
+  compression_type_lz4
+} compression_type_t;
+
 /* Private (non-shared) FSFS-specific data for each svn_fs_t object.
    Any caches in here may be NULL. */
 typedef struct fs_fs_data_t
@@ -318,6 +365,28 @@ typedef struct fs_fs_data_t
    * (not just the one bit that we need, atm). */
   svn_boolean_t use_block_read;
 
+  /* Maximum number of delta windows of a single representation that we
+   * reconstruct concurrently.  Values < 2 disable parallel reconstruction. */
+  int parallel_windows;
+
+  /* Maximum number of concurrent read requests that we may have in flight
+   * for a single rev / pack file.  Values < 2 disable asynchronous reads. */
+  int async_reads;
+
+  /* If set, map pack files into memory and read from them directly. */
+  svn_boolean_t use_mmap;
+
+  /* Maximum number of worker threads to use for bulk operations like
+   * pack.  Values < 2 make them run single-threaded. */
+  int jobs;
+
+  /* Number of read requests issued against rev / pack files while reading
+     representations, i.e. I/O round trips that could not be avoided by
+     caching or prefetching.  Purely statistical information.  Counts the
+     requests since the last svn_fs_fs__reset_rep_read_round_trips call.
+     Parallel window reconstruction may update it from several threads. */
+  volatile svn_atomic_t rep_read_round_trips;
+
   /* The revision that was youngest, last time we checked. */
   svn_revnum_t youngest_rev_cache;
 
@@ -351,10 +420,16 @@ typedef struct fs_fs_data_t
      rep key (revision/offset) to svn_stringbuf_t. */
   svn_cache__t *fulltext_cache;
 
-  /* The current prefix to be used for revprop cache entries.
-     If this is 0, a new unique prefix must be chosen. */
+  /* The current prefix to be used for revprop cache entries.  It is
+     derived from REVPROP_GENERATION, if the repository has a revprop
+     generation file.  If this is 0, a new prefix must be chosen. */
   apr_uint64_t revprop_prefix;
 
+  /* The revprop generation as read at the last sync barrier, see
+     revprops.c.  -1 if the repository has no revprop generation file.
+     Only valid if REVPROP_PREFIX is not 0. */
+  apr_int64_t revprop_generation;
+
   /* Revision property cache.  Maps from (rev,prefix) to apr_hash_t.
      Unparsed svn_string_t representations of the serialized hash
      will be written to the cache but the getter returns apr_hash_t. */
@@ -436,6 +511,13 @@ typedef struct fs_fs_data_t
   /* Thread-safe boolean */
   svn_atomic_t rep_cache_db_opened;
 
+  /* The sqlite database holding the locks.  NULL until first used and
+   * for formats before SVN_FS_FS__MIN_LOCKS_DB_FORMAT. */
+  svn_sqlite__db_t *locks_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t locks_db_opened;
+
   /* The oldest revision not in a pack file.  It also applies to revprops
    * if revprop packing has been enabled by the FSFS format version. */
   svn_revnum_t min_unpacked_rev;
@@ -467,6 +549,9 @@ typedef struct fs_fs_data_t
   /* Compression level to use with txdelta storage format in new revs. */
   int delta_compression_level;
 
+  /* Secondary compression to apply to txdelta windows in new revs. */
+  compression_type_t delta_compression_type;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
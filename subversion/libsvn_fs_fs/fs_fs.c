@@ -37,6 +37,7 @@
 #include "cached_data.h"
 #include "id.h"
 #include "index.h"
+#include "lock.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "transaction.h"
@@ -65,6 +66,17 @@
    Values < 2 will result in standard skip-delta behavior. */
 #define SVN_FS_FS_MAX_LINEAR_DELTIFICATION 16
 
+/* Upper limit to the SVN_FS_CONFIG_FSFS_PARALLEL_WINDOWS setting.
+   Each window may take up to a few 100kB of memory while being
+   reconstructed. */
+#define SVN_FS_FS_MAX_PARALLEL_WINDOWS 64
+
+/* Upper limit to the SVN_FS_CONFIG_FSFS_ASYNC_READS setting. */
+#define SVN_FS_FS_MAX_ASYNC_READS 64
+
+/* Upper limit to the SVN_FS_CONFIG_FSFS_JOBS setting. */
+#define SVN_FS_FS_MAX_JOBS 64
+
 /* Finding a deltification base takes operations proportional to the
    number of changes being skipped. To prevent exploding runtime
    during commits, limit the deltification range to this value.
@@ -743,6 +755,44 @@ read_config(fs_fs_data_t *ffd,
       ffd->delta_compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
     }
 
+  /* Initialize the secondary compression for deltified content. */
+  if (ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT)
+    {
+      const char *compression;
+
+      svn_config_get(config, &compression, CONFIG_SECTION_DELTIFICATION,
+                     CONFIG_OPTION_COMPRESSION,
+                     svn__lz4_supported() ? "lz4" : "zlib");
+      if (svn_cstring_casecmp(compression, "lz4") == 0)
+        {
+          if (!svn__lz4_supported())
+            return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                     _("fsfs.conf setting '%s' is '%s' but "
+                                       "this build of Subversion does not "
+                                       "support LZ4"),
+                                     CONFIG_OPTION_COMPRESSION, compression);
+
+          ffd->delta_compression_type = compression_type_lz4;
+        }
+      else if (svn_cstring_casecmp(compression, "zlib") == 0)
+        ffd->delta_compression_type = compression_type_zlib;
+      else if (svn_cstring_casecmp(compression, "none") == 0)
+        ffd->delta_compression_type = compression_type_none;
+      else
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("'%s' is invalid for fsfs.conf setting "
+                                   "'%s'."),
+                                 compression, CONFIG_OPTION_COMPRESSION);
+    }
+  else if (ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT)
+    {
+      ffd->delta_compression_type = compression_type_zlib;
+    }
+  else
+    {
+      ffd->delta_compression_type = compression_type_none;
+    }
+
   /* Initialize revprop packing settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
     {
@@ -949,7 +999,17 @@ write_config(svn_fs_t *fs,
 "### Valid values are 0 to 9 with 9 providing the highest compression ratio" NL
 "### and 0 disabling it altogether."                                         NL
 "### The default value is 5."                                                NL
+"### This setting only applies if " CONFIG_OPTION_COMPRESSION " is zlib."    NL
 "# " CONFIG_OPTION_COMPRESSION_LEVEL " = 5"                                  NL
+"###"                                                                        NL
+"### Format 8 repositories and later may use LZ4 instead of zlib to"         NL
+"### compress deltified data.  LZ4 compresses slightly worse than zlib but"  NL
+"### is an order of magnitude faster, in particular when reading data."      NL
+"### Valid values are 'lz4', 'zlib' and 'none'.  The latter stores deltas"   NL
+"### uncompressed.  Older repository formats always use zlib."               NL
+"### 'lz4' requires Subversion to be built with LZ4 support."               NL
+"### The default value is 'lz4' if LZ4 is available and 'zlib' otherwise."  NL
+"# " CONFIG_OPTION_COMPRESSION " = lz4"                                      NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -1024,6 +1084,25 @@ write_config(svn_fs_t *fs,
                             fsfs_conf_contents, pool);
 }
 
+/* Set *VALUE to the integer value of the option KEY in FS->CONFIG.
+ * Default to 0 and accept values in the range 0 to MAX only. */
+static svn_error_t *
+get_config_int(int *value,
+               svn_fs_t *fs,
+               const char *key,
+               int max)
+{
+  const char *str = fs->config ? svn_hash_gets(fs->config, key) : NULL;
+  apr_int64_t number = 0;
+
+  if (str)
+    SVN_ERR(svn_cstring_strtoi64(&number, str, 0, max, 10));
+
+  *value = (int)number;
+
+  return SVN_NO_ERROR;
+}
+
 /* Read / Evaluate the global configuration in FS->CONFIG to set up
  * parameters in FS. */
 static svn_error_t *
@@ -1033,11 +1112,31 @@ read_global_config(svn_fs_t *fs)
 
   /* Providing a config hash is optional. */
   if (fs->config)
-    ffd->use_block_read = svn_hash__get_bool(fs->config,
-                                             SVN_FS_CONFIG_FSFS_BLOCK_READ,
-                                             FALSE);
+    {
+      ffd->use_block_read = svn_hash__get_bool(fs->config,
+                                               SVN_FS_CONFIG_FSFS_BLOCK_READ,
+                                               FALSE);
+      ffd->use_mmap = svn_hash__get_bool(fs->config,
+                                         SVN_FS_CONFIG_FSFS_MMAP,
+                                         FALSE);
+    }
   else
-    ffd->use_block_read = FALSE;
+    {
+      ffd->use_block_read = FALSE;
+      ffd->use_mmap = FALSE;
+    }
+
+  /* Parallel window reconstruction and asynchronous reads are opt-in. */
+  SVN_ERR(get_config_int(&ffd->parallel_windows, fs,
+                         SVN_FS_CONFIG_FSFS_PARALLEL_WINDOWS,
+                         SVN_FS_FS_MAX_PARALLEL_WINDOWS));
+  SVN_ERR(get_config_int(&ffd->async_reads, fs,
+                         SVN_FS_CONFIG_FSFS_ASYNC_READS,
+                         SVN_FS_FS_MAX_ASYNC_READS));
+
+  /* So are multi-threaded bulk operations. */
+  SVN_ERR(get_config_int(&ffd->jobs, fs, SVN_FS_CONFIG_FSFS_JOBS,
+                         SVN_FS_FS_MAX_JOBS));
 
   /* Ignore the user-specified larger block size if we don't use block-read.
      Defaulting to 4k gives us the same access granularity in format 7 as in
@@ -1168,6 +1267,7 @@ upgrade_body(void *baton, apr_pool_t *pool)
   const char *format_path = path_format(fs, pool);
   svn_node_kind_t kind;
   svn_boolean_t needs_revprop_shard_cleanup = FALSE;
+  svn_boolean_t needs_locks_cleanup = FALSE;
 
   /* Read the FS format number and max-files-per-dir setting. */
   SVN_ERR(read_format(&format, &max_files_per_dir, &use_log_addressing,
@@ -1237,6 +1337,14 @@ upgrade_body(void *baton, apr_pool_t *pool)
                                                pool));
     }
 
+  /* Move existing locks into the lock store.  The digest files remain
+     authoritative until after the format bump. */
+  if (format < SVN_FS_FS__MIN_LOCKS_DB_FORMAT)
+    {
+      needs_locks_cleanup = TRUE;
+      SVN_ERR(svn_fs_fs__upgrade_locks(fs, pool));
+    }
+
   /* We will need the UUID info shortly ...
      Read it before the format bump as the UUID file still uses the old
      format. */
@@ -1270,6 +1378,13 @@ upgrade_body(void *baton, apr_pool_t *pool)
                                                upgrade_baton->cancel_baton,
                                                pool));
 
+  /* The digest files are obsolete now. */
+  if (needs_locks_cleanup)
+    SVN_ERR(svn_io_remove_dir2(svn_dirent_join(fs->path, PATH_LOCKS_DIR,
+                                               pool),
+                               TRUE, upgrade_baton->cancel_func,
+                               upgrade_baton->cancel_baton, pool));
+
   /* Done */
   return SVN_NO_ERROR;
 }
@@ -1811,6 +1926,9 @@ svn_fs_fs__create(svn_fs_t *fs,
           case 8: format = 6;
                   break;
 
+          case 9: format = 7;
+                  break;
+
           default:format = SVN_FS_FS__FORMAT_NUMBER;
         }
 
@@ -2179,8 +2297,11 @@ svn_fs_fs__info_format(int *fs_format,
     case 7:
       (*supports_version)->minor = 9;
       break;
+    case 8:
+      (*supports_version)->minor = 10;
+      break;
 #ifdef SVN_DEBUG
-# if SVN_FS_FS__FORMAT_NUMBER != 7
+# if SVN_FS_FS__FORMAT_NUMBER != 8
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
@@ -48,6 +48,18 @@ svn_error_t *svn_fs_fs__initialize_shared_data(svn_fs_t *fs,
                                                apr_pool_t *pool,
                                                apr_pool_t *common_pool);
 
+/* Open another instance of the already opened filesystem FS and return it
+   in *CLONE_P.  Since svn_fs_t objects are not thread-safe, this is how
+   worker threads get their own access to FS.  The clone shares FS's
+   process-wide data and configuration, which must outlive it.
+
+   Allocate *CLONE_P in RESULT_POOL, which must not be used by other
+   threads, and use SCRATCH_POOL for temporary allocations. */
+svn_error_t *svn_fs_fs__open_clone(svn_fs_t **clone_p,
+                                   svn_fs_t *fs,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool);
+
 /* Upgrade the fsfs filesystem FS.  Indicate progress via the optional
  * NOTIFY_FUNC callback using NOTIFY_BATON.  The optional CANCEL_FUNC
  * will periodically be called with CANCEL_BATON to allow for preemption.
@@ -22,6 +22,9 @@
 #include "svn_pools.h"
 #include "svn_path.h"
 #include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+
+#include "private/svn_atomic.h"
 
 #include "fs_fs.h"
 #include "hotcopy.h"
@@ -29,6 +32,7 @@
 #include "recovery.h"
 #include "revprops.h"
 #include "rep-cache.h"
+#include "tasks.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
@@ -237,6 +241,30 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
   return SVN_NO_ERROR;
 }
 
+/* If REV is the first revision in a shard as per MAX_FILES_PER_DIR, create
+ * the respective shard directory in DST_SUBDIR.  It's o.k. for that folder
+ * to exist already.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_make_shard_dir(const char *dst_subdir,
+                       svn_revnum_t rev,
+                       int max_files_per_dir,
+                       apr_pool_t *scratch_pool)
+{
+  if (max_files_per_dir && (rev % max_files_per_dir == 0))
+    {
+      const char *dst_subdir_shard
+        = svn_dirent_join(dst_subdir,
+                          apr_psprintf(scratch_pool, "%ld",
+                                       rev / max_files_per_dir),
+                          scratch_pool);
+
+      SVN_ERR(svn_io_make_dir_recursively(dst_subdir_shard, scratch_pool));
+      SVN_ERR(svn_io_copy_perms(dst_subdir, dst_subdir_shard, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy an un-packed revision or revprop file for revision REV from SRC_SUBDIR
  * to DST_SUBDIR. Assume a sharding layout based on MAX_FILES_PER_DIR.
  * Set *SKIPPED_P to FALSE only if the file was copied, do not change the
@@ -260,12 +288,8 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
       src_subdir_shard = svn_dirent_join(src_subdir, shard, scratch_pool);
       dst_subdir_shard = svn_dirent_join(dst_subdir, shard, scratch_pool);
 
-      if (rev % max_files_per_dir == 0)
-        {
-          SVN_ERR(svn_io_make_dir_recursively(dst_subdir_shard, scratch_pool));
-          SVN_ERR(svn_io_copy_perms(dst_subdir, dst_subdir_shard,
-                                    scratch_pool));
-        }
+      SVN_ERR(hotcopy_make_shard_dir(dst_subdir, rev, max_files_per_dir,
+                                     scratch_pool));
     }
 
   SVN_ERR(hotcopy_io_dir_file_copy(skipped_p,
@@ -279,15 +303,16 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
 
 /* Copy a packed shard containing revision REV, and which contains
  * MAX_FILES_PER_DIR revisions, from SRC_FS to DST_FS.
- * Update *DST_MIN_UNPACKED_REV in case the shard is new in DST_FS.
  * Do not re-copy data which already exists in DST_FS.
  * Set *SKIPPED_P to FALSE only if at least one part of the shard
  * was copied, do not change the value in *SKIPPED_P otherwise.
  * SKIPPED_P may be NULL if not required.
+ *
+ * This only reads the paths and the immutable configuration of SRC_FS
+ * and DST_FS, i.e. it may be called concurrently for different shards.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
-                          svn_revnum_t *dst_min_unpacked_rev,
                           svn_fs_t *src_fs,
                           svn_fs_t *dst_fs,
                           svn_revnum_t rev,
@@ -357,15 +382,6 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                                               scratch_pool));
     }
 
-  /* If necessary, update the min-unpacked rev file in the hotcopy. */
-  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
-    {
-      *dst_min_unpacked_rev = rev + max_files_per_dir;
-      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
-                                                *dst_min_unpacked_rev,
-                                                scratch_pool));
-    }
-
   return SVN_NO_ERROR;
 }
 
@@ -532,6 +548,231 @@ remove_folder(const char *path,
   return svn_error_trace(err);
 }
 
+/* Baton type for hotcopy_packed_shard_task(). */
+typedef struct packed_shard_task_t
+{
+  /* Source and destination filesystem.  Only their paths and immutable
+   * configuration will be accessed. */
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+
+  /* First revision of the shard to copy and the shard size. */
+  svn_revnum_t rev;
+  int max_files_per_dir;
+
+  /* Will be set to FALSE, if any file got copied. */
+  svn_boolean_t skipped;
+} packed_shard_task_t;
+
+/* Implements svn_fs_fs__task_func_t.  Copy the packed shard described by
+ * the packed_shard_task_t BATON but don't update any of the metadata in
+ * the destination.
+ */
+static svn_error_t *
+hotcopy_packed_shard_task(void *baton)
+{
+  packed_shard_task_t *task = baton;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  svn_error_t *err;
+
+  err = hotcopy_copy_packed_shard(&task->skipped, task->src_fs, task->dst_fs,
+                                  task->rev, task->max_files_per_dir, pool);
+  svn_pool_destroy(pool);
+
+  return svn_error_trace(err);
+}
+
+/* Number of non-packed revisions that we hand out per job in a single
+ * batch of a concurrent hotcopy. */
+#define REVISIONS_PER_JOB 64
+
+/* A non-packed revision to copy. */
+typedef struct unpacked_rev_t
+{
+  /* The revision. */
+  svn_revnum_t rev;
+
+  /* Will be set to FALSE, if any file got copied. */
+  svn_boolean_t skipped;
+} unpacked_rev_t;
+
+/* Baton type for hotcopy_unpacked_lane(), shared by all lanes of a batch. */
+typedef struct unpacked_batch_t
+{
+  /* Source and destination folders. */
+  const char *src_revs_dir;
+  const char *dst_revs_dir;
+  const char *src_revprops_dir;
+  const char *dst_revprops_dir;
+  int max_files_per_dir;
+
+  /* The revisions to copy. */
+  unpacked_rev_t *revs;
+  int count;
+
+  /* Index of the next element in REVS that has not been picked up by any
+   * lane, yet.  May exceed COUNT. */
+  volatile svn_atomic_t next;
+
+  /* Cancellation support.  CANCEL_FUNC must be thread-safe. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} unpacked_batch_t;
+
+/* Implements svn_fs_fs__task_func_t.  Keep copying the rev and revprop
+ * files of the next revision from the unpacked_batch_t BATON until there
+ * is none left.  Lanes that finish early will simply "steal" work from
+ * the others.
+ */
+static svn_error_t *
+hotcopy_unpacked_lane(void *baton)
+{
+  unpacked_batch_t *batch = baton;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      unpacked_rev_t *rev;
+      int i = (int)svn_atomic_inc(&batch->next);
+      if (i >= batch->count)
+        break;
+
+      svn_pool_clear(pool);
+      rev = &batch->revs[i];
+
+      if (batch->cancel_func)
+        err = batch->cancel_func(batch->cancel_baton);
+
+      /* Copy the rev file. */
+      if (!err)
+        err = hotcopy_copy_shard_file(&rev->skipped,
+                                      batch->src_revs_dir,
+                                      batch->dst_revs_dir, rev->rev,
+                                      batch->max_files_per_dir, pool);
+
+      /* Copy the revprop file. */
+      if (!err)
+        err = hotcopy_copy_shard_file(&rev->skipped,
+                                      batch->src_revprops_dir,
+                                      batch->dst_revprops_dir, rev->rev,
+                                      batch->max_files_per_dir, pool);
+    }
+
+  svn_pool_destroy(pool);
+
+  return svn_error_trace(err);
+}
+
+/* Copy the rev and revprop files of the BATCH->COUNT revisions in BATCH
+ * using up to JOBS concurrent lanes.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+hotcopy_unpacked_revs(unpacked_batch_t *batch,
+                      int jobs,
+                      apr_pool_t *scratch_pool)
+{
+  void **lanes;
+  int i;
+
+  /* Lanes must not race for the creation of the shard folders. */
+  for (i = 0; i < batch->count; ++i)
+    {
+      SVN_ERR(hotcopy_make_shard_dir(batch->dst_revs_dir,
+                                     batch->revs[i].rev,
+                                     batch->max_files_per_dir,
+                                     scratch_pool));
+      SVN_ERR(hotcopy_make_shard_dir(batch->dst_revprops_dir,
+                                     batch->revs[i].rev,
+                                     batch->max_files_per_dir,
+                                     scratch_pool));
+    }
+
+  batch->next = 0;
+  jobs = MIN(jobs, batch->count);
+  lanes = apr_palloc(scratch_pool, jobs * sizeof(*lanes));
+  for (i = 0; i < jobs; ++i)
+    lanes[i] = batch;
+
+  return svn_error_trace(svn_fs_fs__run_tasks(hotcopy_unpacked_lane, lanes,
+                                              jobs, scratch_pool));
+}
+
+/* Update the metadata in DST_FS after the packed shard starting at REV
+ * has been copied.  SKIPPED indicates whether no files needed copying.
+ * The other parameters are the same as for hotcopy_revisions().  Update
+ * *DST_MIN_UNPACKED_REV in case the shard is new in DST_FS.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+hotcopy_finalize_packed_shard(svn_fs_t *dst_fs,
+                              svn_revnum_t *dst_min_unpacked_rev,
+                              svn_revnum_t rev,
+                              svn_boolean_t skipped,
+                              svn_revnum_t dst_youngest,
+                              svn_boolean_t incremental,
+                              int max_files_per_dir,
+                              svn_fs_hotcopy_notify_t notify_func,
+                              void* notify_baton,
+                              svn_cancel_func_t cancel_func,
+                              void* cancel_baton,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  svn_revnum_t pack_end_rev = rev + max_files_per_dir - 1;
+
+  /* If necessary, update the min-unpacked rev file in the hotcopy. */
+  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
+    {
+      *dst_min_unpacked_rev = rev + max_files_per_dir;
+      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
+                                                *dst_min_unpacked_rev,
+                                                scratch_pool));
+    }
+
+  /* Whenever this pack did not previously exist in the destination,
+   * update 'current' to the most recent packed rev (so readers can see
+   * new revisions which arrived in this pack). */
+  if (pack_end_rev > dst_youngest)
+    {
+      SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
+                                       scratch_pool));
+    }
+
+  /* When notifying about packed shards, make things simpler by either
+   * reporting a full revision range, i.e [pack start, pack end] or
+   * reporting nothing. There is one case when this approach might not
+   * be exact (incremental hotcopy with a pack replacing last unpacked
+   * revisions), but generally this is good enough. */
+  if (notify_func && !skipped)
+    notify_func(notify_baton, rev, pack_end_rev, scratch_pool);
+
+  /* Remove revision files which are now packed. */
+  if (incremental)
+    {
+      SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
+                                       rev + max_files_per_dir,
+                                       max_files_per_dir, scratch_pool));
+      if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+        SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
+                                             rev + max_files_per_dir,
+                                             max_files_per_dir,
+                                             scratch_pool));
+    }
+
+  /* Now that all revisions have moved into the pack, the original
+   * rev dir can be removed. */
+  SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, scratch_pool),
+                        cancel_func, cancel_baton, scratch_pool));
+  if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
+                                                         scratch_pool),
+                          cancel_func, cancel_baton, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy the revision and revprop files (possibly sharded / packed) from
  * SRC_FS to DST_FS.  Do not re-copy data which already exists in DST_FS.
  * When copying packed or unpacked shards, checkpoint the result in DST_FS
@@ -539,6 +780,10 @@ remove_folder(const char *path,
  * the >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT filesystem format without
  * global next-ID counters.  Indicate progress via the optional NOTIFY_FUNC
  * callback using NOTIFY_BATON.  Use POOL for temporary allocations.
+ *
+ * If SRC_FS has been configured to use more than one job, copy several
+ * shards resp. revisions concurrently.  The metadata in DST_FS will still
+ * be updated and the notifications be sent in revision order.
  */
 static svn_error_t *
 hotcopy_revisions(svn_fs_t *src_fs,
@@ -557,12 +802,16 @@ hotcopy_revisions(svn_fs_t *src_fs,
                   apr_pool_t *pool)
 {
   fs_fs_data_t *src_ffd = src_fs->fsap_data;
-  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
   int max_files_per_dir = src_ffd->max_files_per_dir;
+  int jobs = MAX(src_ffd->jobs, 1);
   svn_revnum_t src_min_unpacked_rev;
   svn_revnum_t dst_min_unpacked_rev;
   svn_revnum_t rev;
   apr_pool_t *iterpool;
+  packed_shard_task_t *shard_tasks;
+  void **shard_batons;
+  unpacked_batch_t *batch;
+  int count, i;
 
   /* Copy the min unpacked rev, and read its value. */
   if (src_ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
@@ -601,63 +850,45 @@ hotcopy_revisions(svn_fs_t *src_fs,
    */
 
   iterpool = svn_pool_create(pool);
-  /* First, copy packed shards. */
-  for (rev = 0; rev < src_min_unpacked_rev; rev += max_files_per_dir)
-    {
-      svn_boolean_t skipped = TRUE;
-      svn_revnum_t pack_end_rev;
 
+  /* First, copy packed shards, up to JOBS of them at a time. */
+  shard_tasks = apr_pcalloc(pool, jobs * sizeof(*shard_tasks));
+  shard_batons = apr_palloc(pool, jobs * sizeof(*shard_batons));
+  for (i = 0; i < jobs; ++i)
+    shard_batons[i] = &shard_tasks[i];
+
+  for (rev = 0; rev < src_min_unpacked_rev; rev += count * max_files_per_dir)
+    {
       svn_pool_clear(iterpool);
 
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Copy the packed shard. */
-      SVN_ERR(hotcopy_copy_packed_shard(&skipped, &dst_min_unpacked_rev,
-                                        src_fs, dst_fs,
-                                        rev, max_files_per_dir,
-                                        iterpool));
-
-      pack_end_rev = rev + max_files_per_dir - 1;
-
-      /* Whenever this pack did not previously exist in the destination,
-       * update 'current' to the most recent packed rev (so readers can see
-       * new revisions which arrived in this pack). */
-      if (pack_end_rev > dst_youngest)
-        {
-          SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
-                                           iterpool));
-        }
-
-      /* When notifying about packed shards, make things simpler by either
-       * reporting a full revision range, i.e [pack start, pack end] or
-       * reporting nothing. There is one case when this approach might not
-       * be exact (incremental hotcopy with a pack replacing last unpacked
-       * revisions), but generally this is good enough. */
-      if (notify_func && !skipped)
-        notify_func(notify_baton, rev, pack_end_rev, iterpool);
-
-      /* Remove revision files which are now packed. */
-      if (incremental)
+      count = (int)MIN(jobs,
+                       (src_min_unpacked_rev - rev) / max_files_per_dir);
+      for (i = 0; i < count; ++i)
         {
-          SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
-                                           rev + max_files_per_dir,
-                                           max_files_per_dir, iterpool));
-          if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-            SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
-                                                 rev + max_files_per_dir,
-                                                 max_files_per_dir,
-                                                 iterpool));
+          shard_tasks[i].src_fs = src_fs;
+          shard_tasks[i].dst_fs = dst_fs;
+          shard_tasks[i].rev = rev + i * max_files_per_dir;
+          shard_tasks[i].max_files_per_dir = max_files_per_dir;
+          shard_tasks[i].skipped = TRUE;
         }
 
-      /* Now that all revisions have moved into the pack, the original
-       * rev dir can be removed. */
-      SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, iterpool),
-                            cancel_func, cancel_baton, iterpool));
-      if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-        SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
-                                                             iterpool),
-                              cancel_func, cancel_baton, iterpool));
+      /* Copy the packed shards. */
+      SVN_ERR(svn_fs_fs__run_tasks(hotcopy_packed_shard_task, shard_batons,
+                                   count, iterpool));
+
+      /* Make them visible in the destination in revision order. */
+      for (i = 0; i < count; ++i)
+        SVN_ERR(hotcopy_finalize_packed_shard(dst_fs, &dst_min_unpacked_rev,
+                                              shard_tasks[i].rev,
+                                              shard_tasks[i].skipped,
+                                              dst_youngest, incremental,
+                                              max_files_per_dir,
+                                              notify_func, notify_baton,
+                                              cancel_func, cancel_baton,
+                                              iterpool));
     }
 
   if (cancel_func)
@@ -667,54 +898,68 @@ hotcopy_revisions(svn_fs_t *src_fs,
   SVN_ERR_ASSERT(src_min_unpacked_rev == dst_min_unpacked_rev);
 
   /* Now, copy pairs of non-packed revisions and revprop files.
-   * If necessary, update 'current' after copying all files from a shard. */
-  for (; rev <= src_youngest; rev++)
+   * If necessary, update 'current' after copying all files from a shard.
+   *
+   * Copying non-packed revisions is racy in case the source repository is
+   * being packed concurrently with this hotcopy operation. The race can
+   * happen with FS formats prior to SVN_FS_FS__MIN_PACK_LOCK_FORMAT that
+   * support packed revisions. With the pack lock, however, the race is
+   * impossible, because hotcopy and pack operations block each other.
+   *
+   * We assume that all revisions coming after 'min-unpacked-rev' really
+   * are unpacked and that's not necessarily true with concurrent packing.
+   * Don't try to be smart in this edge case, because handling it properly
+   * might require copying *everything* from the start. Just abort the
+   * hotcopy with an ENOENT (revision file moved to a pack, so it is no
+   * longer where we expect it to be). */
+  batch = apr_pcalloc(pool, sizeof(*batch));
+  batch->src_revs_dir = src_revs_dir;
+  batch->dst_revs_dir = dst_revs_dir;
+  batch->src_revprops_dir = src_revprops_dir;
+  batch->dst_revprops_dir = dst_revprops_dir;
+  batch->max_files_per_dir = max_files_per_dir;
+  batch->cancel_func = cancel_func;
+  batch->cancel_baton = cancel_baton;
+  batch->revs = apr_pcalloc(pool, jobs * REVISIONS_PER_JOB
+                                  * sizeof(*batch->revs));
+
+  for (; rev <= src_youngest; rev += count)
     {
-      svn_boolean_t skipped = TRUE;
-
       svn_pool_clear(iterpool);
 
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Copying non-packed revisions is racy in case the source repository is
-       * being packed concurrently with this hotcopy operation. The race can
-       * happen with FS formats prior to SVN_FS_FS__MIN_PACK_LOCK_FORMAT that
-       * support packed revisions. With the pack lock, however, the race is
-       * impossible, because hotcopy and pack operations block each other.
-       *
-       * We assume that all revisions coming after 'min-unpacked-rev' really
-       * are unpacked and that's not necessarily true with concurrent packing.
-       * Don't try to be smart in this edge case, because handling it properly
-       * might require copying *everything* from the start. Just abort the
-       * hotcopy with an ENOENT (revision file moved to a pack, so it is no
-       * longer where we expect it to be). */
+      count = (int)MIN(jobs > 1 ? jobs * REVISIONS_PER_JOB : 1,
+                       src_youngest - rev + 1);
+      for (i = 0; i < count; ++i)
+        {
+          batch->revs[i].rev = rev + i;
+          batch->revs[i].skipped = TRUE;
+        }
 
-      /* Copy the rev file. */
-      SVN_ERR(hotcopy_copy_shard_file(&skipped,
-                                      src_revs_dir, dst_revs_dir, rev,
-                                      max_files_per_dir,
-                                      iterpool));
-      /* Copy the revprop file. */
-      SVN_ERR(hotcopy_copy_shard_file(&skipped,
-                                      src_revprops_dir, dst_revprops_dir,
-                                      rev, max_files_per_dir,
-                                      iterpool));
-
-      /* Whenever this revision did not previously exist in the destination,
-       * checkpoint the progress via 'current' (do that once per full shard
-       * in order not to slow things down). */
-      if (rev > dst_youngest)
+      batch->count = count;
+      SVN_ERR(hotcopy_unpacked_revs(batch, jobs, iterpool));
+
+      for (i = 0; i < count; ++i)
         {
-          if (max_files_per_dir && (rev % max_files_per_dir == 0))
+          svn_revnum_t copied_rev = batch->revs[i].rev;
+
+          /* Whenever this revision did not previously exist in the
+           * destination, checkpoint the progress via 'current' (do that
+           * once per full shard in order not to slow things down). */
+          if (copied_rev > dst_youngest)
             {
-              SVN_ERR(svn_fs_fs__write_current(dst_fs, rev, 0, 0,
-                                               iterpool));
+              if (max_files_per_dir && (copied_rev % max_files_per_dir == 0))
+                {
+                  SVN_ERR(svn_fs_fs__write_current(dst_fs, copied_rev, 0, 0,
+                                                   iterpool));
+                }
             }
-        }
 
-      if (notify_func && !skipped)
-        notify_func(notify_baton, rev, rev, iterpool);
+          if (notify_func && !batch->revs[i].skipped)
+            notify_func(notify_baton, copied_rev, copied_rev, iterpool);
+        }
     }
   svn_pool_destroy(iterpool);
 
@@ -945,6 +1190,10 @@ hotcopy_body(void *baton, apr_pool_t *pool)
                                        src_next_copy_id, pool));
     }
 
+  /* An incremental hotcopy may have replaced revprops in the destination,
+   * so make other processes drop their cached copies. */
+  SVN_ERR(svn_fs_fs__bump_revprop_generation(dst_fs, pool));
+
   /* Replace the locks tree.
    * This is racy in case readers are currently trying to list locks in
    * the destination. However, we need to get rid of stale locks.
@@ -959,6 +1208,17 @@ hotcopy_body(void *baton, apr_pool_t *pool)
                                         PATH_LOCKS_DIR, TRUE,
                                         cancel_func, cancel_baton, pool));
 
+  /* Same for the lock store database. */
+  dst_subdir = svn_dirent_join(dst_fs->path, PATH_LOCKS_DB, pool);
+  SVN_ERR(svn_io_remove_file2(dst_subdir, TRUE, pool));
+  src_subdir = svn_dirent_join(src_fs->path, PATH_LOCKS_DB, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    {
+      SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+      SVN_ERR(svn_io_set_file_read_write(dst_subdir, FALSE, pool));
+    }
+
   /* Now copy the node-origins cache tree. */
   src_subdir = svn_dirent_join(src_fs->path, PATH_NODE_ORIGINS_DIR, pool);
   SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
@@ -21,6 +21,7 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 
 #include "svn_io.h"
 #include "svn_pools.h"
@@ -186,6 +187,11 @@ struct svn_fs_fs__packed_number_stream_t
   /* underlying data file containing the packed values */
   apr_file_t *file;
 
+  /* If not NULL, the contents of FILE mapped into memory, starting at
+   * file offset 0.  In that case, we parse directly from memory and never
+   * access FILE. */
+  const unsigned char *mapped_data;
+
   /* Offset within FILE at which the stream data starts
    * (i.e. which offset will reported as offset 0 by packed_stream_offset). */
   apr_off_t stream_start;
@@ -239,28 +245,19 @@ stream_error_create(svn_fs_fs__packed_number_stream_t *stream,
                                         (apr_uint64_t)offset));
 }
 
-/* Read up to MAX_NUMBER_PREFETCH numbers from the STREAM->NEXT_OFFSET in
- * STREAM->FILE and buffer them.
- *
- * We don't want GCC and others to inline this (infrequently called)
- * function into packed_stream_get() because it prevents the latter from
- * being inlined itself.
+/* Read the next chunk of packed numbers from STREAM->NEXT_OFFSET in
+ * STREAM->FILE into BUFFER, which must provide MAX_NUMBER_PREFETCH bytes.
+ * Return the number of bytes read in *BYTES_READ.
  */
-SVN__PREVENT_INLINE
 static svn_error_t *
-packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
+packed_stream_fetch(svn_fs_fs__packed_number_stream_t *stream,
+                    unsigned char *buffer,
+                    apr_size_t *bytes_read)
 {
-  unsigned char buffer[MAX_NUMBER_PREFETCH];
-  apr_size_t bytes_read = 0;
-  apr_size_t i;
-  value_position_pair_t *target;
   apr_off_t block_start = 0;
   apr_off_t block_left = 0;
   apr_status_t err;
 
-  /* all buffered data will have been read starting here */
-  stream->start_offset = stream->next_offset;
-
   /* packed numbers are usually not aligned to MAX_NUMBER_PREFETCH blocks,
    * i.e. the last number has been incomplete (and not buffered in stream)
    * and need to be re-read.  Therefore, always correct the file pointer.
@@ -273,40 +270,76 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
    * boundaries.  This shall prevent jumping back and forth between two
    * blocks because the extra data was not actually request _now_.
    */
-  bytes_read = sizeof(buffer);
+  *bytes_read = MAX_NUMBER_PREFETCH;
   block_left = stream->block_size - (stream->next_offset - block_start);
-  if (block_left >= 10 && block_left < bytes_read)
-    bytes_read = (apr_size_t)block_left;
+  if (block_left >= 10 && block_left < *bytes_read)
+    *bytes_read = (apr_size_t)block_left;
 
   /* Don't read beyond the end of the file section that belongs to this
    * index / stream. */
-  bytes_read = (apr_size_t)MIN(bytes_read,
-                               stream->stream_end - stream->next_offset);
+  *bytes_read = (apr_size_t)MIN(*bytes_read,
+                                stream->stream_end - stream->next_offset);
 
-  err = apr_file_read(stream->file, buffer, &bytes_read);
+  err = apr_file_read(stream->file, buffer, bytes_read);
   if (err && !APR_STATUS_IS_EOF(err))
     return stream_error_create(stream, err,
       _("Can't read index file '%s' at offset 0x%s"));
 
+  return SVN_NO_ERROR;
+}
+
+/* Read up to MAX_NUMBER_PREFETCH numbers from the STREAM->NEXT_OFFSET in
+ * STREAM->FILE, or its memory mapped contents, and buffer them.
+ *
+ * We don't want GCC and others to inline this (infrequently called)
+ * function into packed_stream_get() because it prevents the latter from
+ * being inlined itself.
+ */
+SVN__PREVENT_INLINE
+static svn_error_t *
+packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
+{
+  unsigned char buffer[MAX_NUMBER_PREFETCH];
+  const unsigned char *source = buffer;
+  apr_size_t bytes_read = 0;
+  apr_size_t i;
+  value_position_pair_t *target;
+
+  /* all buffered data will have been read starting here */
+  stream->start_offset = stream->next_offset;
+
+  /* With the file mapped into memory, there is no need to copy any data.
+   * Simply parse the next chunk in-place. */
+  if (stream->mapped_data)
+    {
+      source = stream->mapped_data + stream->next_offset;
+      bytes_read = (apr_size_t)MIN(sizeof(buffer),
+                                   stream->stream_end - stream->next_offset);
+    }
+  else
+    {
+      SVN_ERR(packed_stream_fetch(stream, buffer, &bytes_read));
+    }
+
   /* if the last number is incomplete, trim it from the buffer */
-  while (bytes_read > 0 && buffer[bytes_read-1] >= 0x80)
+  while (bytes_read > 0 && source[bytes_read-1] >= 0x80)
     --bytes_read;
 
   /* we call read() only if get() requires more data.  So, there must be
    * at least *one* further number. */
   if SVN__PREDICT_FALSE(bytes_read == 0)
-    return stream_error_create(stream, err,
+    return stream_error_create(stream, APR_EOF,
       _("Unexpected end of index file %s at offset 0x%s"));
 
   /* parse file buffer and expand into stream buffer */
   target = stream->buffer;
   for (i = 0; i < bytes_read;)
     {
-      if (buffer[i] < 0x80)
+      if (source[i] < 0x80)
         {
           /* numbers < 128 are relatively frequent and particularly easy
            * to decode.  Give them special treatment. */
-          target->value = buffer[i];
+          target->value = source[i];
           ++i;
           target->total_len = i;
           ++target;
@@ -315,14 +348,14 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
         {
           apr_uint64_t value = 0;
           apr_uint64_t shift = 0;
-          while (buffer[i] >= 0x80)
+          while (source[i] >= 0x80)
             {
-              value += ((apr_uint64_t)buffer[i] & 0x7f) << shift;
+              value += ((apr_uint64_t)source[i] & 0x7f) << shift;
               shift += 7;
               ++i;
             }
 
-          target->value = value + ((apr_uint64_t)buffer[i] << shift);
+          target->value = value + ((apr_uint64_t)source[i] << shift);
           ++i;
           target->total_len = i;
           ++target;
@@ -345,12 +378,15 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
 
 /* Create and open a packed number stream reading from offsets START to
  * END in FILE and return it in *STREAM.  Access the file in chunks of
- * BLOCK_SIZE bytes.  Expect the stream to be prefixed by STREAM_PREFIX.
- * Allocate *STREAM in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ * BLOCK_SIZE bytes.  If MAPPED_DATA is not NULL, it must contain the
+ * contents of FILE up to END and will be used instead of FILE.  Expect
+ * the stream to be prefixed by STREAM_PREFIX.  Allocate *STREAM in
+ * RESULT_POOL and use SCRATCH_POOL for temporaries.
  */
 static svn_error_t *
 packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
                    apr_file_t *file,
+                   const char *mapped_data,
                    apr_off_t start,
                    apr_off_t end,
                    const char *stream_prefix,
@@ -367,10 +403,17 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
   SVN_ERR_ASSERT(len < sizeof(buffer));
 
   /* Read the header prefix and compare it with the expected prefix */
-  SVN_ERR(svn_io_file_aligned_seek(file, block_size, NULL, start,
-                                   scratch_pool));
-  SVN_ERR(svn_io_file_read_full2(file, buffer, len, NULL, NULL,
-                                 scratch_pool));
+  if (mapped_data && start + (apr_off_t)len <= end)
+    {
+      memcpy(buffer, mapped_data + start, len);
+    }
+  else
+    {
+      SVN_ERR(svn_io_file_aligned_seek(file, block_size, NULL, start,
+                                       scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(file, buffer, len, NULL, NULL,
+                                     scratch_pool));
+    }
 
   if (strncmp(buffer, stream_prefix, len))
     return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
@@ -383,6 +426,7 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
 
   result->pool = result_pool;
   result->file = file;
+  result->mapped_data = (const unsigned char *)mapped_data;
   result->stream_start = start + len;
   result->stream_end = end;
 
@@ -947,6 +991,8 @@ auto_open_l2p_index(svn_fs_fs__revision_file_t *rev_file,
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
       SVN_ERR(packed_stream_open(&rev_file->l2p_stream,
                                  rev_file->file,
+                                 svn_fs_fs__rev_file_mapped(rev_file, 0,
+                                     (apr_size_t)rev_file->footer_offset),
                                  rev_file->l2p_offset,
                                  rev_file->p2l_offset,
                                  L2P_STREAM_PREFIX,
@@ -1706,6 +1752,181 @@ get_l2p_header(l2p_header_t **header,
   return SVN_NO_ERROR;
 }
 
+/* One entry of a batched l2p index lookup.
+ */
+typedef struct l2p_batch_item_t
+{
+  /* position of this item in the caller's request list */
+  int index;
+
+  /* page location of the item as determined from the index header */
+  l2p_page_info_baton_t info;
+} l2p_batch_item_t;
+
+/* Request data structure for l2p_batch_access_func.
+ */
+typedef struct l2p_batch_baton_t
+{
+  /* in data */
+  /* items located in the same l2p index page */
+  const l2p_batch_item_t *items;
+
+  /* number of entries in ITEMS */
+  int count;
+
+  /* out data */
+  /* result array of the batch lookup, indexed by l2p_batch_item_t.INDEX */
+  apr_off_t *offsets;
+} l2p_batch_baton_t;
+
+/* qsort-compatible compare function ordering l2p_batch_item_t by revision
+ * and l2p index page.  Within the same page, order by page offset. */
+static int
+compare_l2p_batch_items(const void *lhs,
+                        const void *rhs)
+{
+  const l2p_page_info_baton_t *a = &((const l2p_batch_item_t *)lhs)->info;
+  const l2p_page_info_baton_t *b = &((const l2p_batch_item_t *)rhs)->info;
+
+  if (a->revision != b->revision)
+    return a->revision < b->revision ? -1 : 1;
+  if (a->page_no != b->page_no)
+    return a->page_no < b->page_no ? -1 : 1;
+  if (a->page_offset != b->page_offset)
+    return a->page_offset < b->page_offset ? -1 : 1;
+
+  return 0;
+}
+
+/* Return the rev / pack file offsets of all items in BATON from OFFSETS
+ * of PAGE.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+l2p_page_get_entries(l2p_batch_baton_t *baton,
+                     const l2p_page_t *page,
+                     const apr_uint64_t *offsets,
+                     apr_pool_t *scratch_pool)
+{
+  int i;
+  for (i = 0; i < baton->count; ++i)
+    {
+      const l2p_batch_item_t *item = &baton->items[i];
+      l2p_entry_baton_t entry_baton;
+
+      entry_baton.revision = item->info.revision;
+      entry_baton.item_index = item->info.item_index;
+      entry_baton.page_offset = item->info.page_offset;
+      SVN_ERR(l2p_page_get_entry(&entry_baton, page, offsets, scratch_pool));
+
+      baton->offsets[item->index] = (apr_off_t)entry_baton.offset;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__partial_getter_func_t: copy the offsets requested
+ * in l2p_batch_baton_t *BATON from l2p_page_t *DATA into BATON->OFFSETS.
+ * *OUT remains unchanged.
+ */
+static svn_error_t *
+l2p_batch_access_func(void **out,
+                      const void *data,
+                      apr_size_t data_len,
+                      void *baton,
+                      apr_pool_t *result_pool)
+{
+  /* resolve all in-cache pointers */
+  const l2p_page_t *page = data;
+  const apr_uint64_t *offsets
+    = svn_temp_deserializer__ptr(page, (const void *const *)&page->offsets);
+
+  /* return the requested data */
+  return l2p_page_get_entries(baton, page, offsets, result_pool);
+}
+
+/* Using the log-to-phys indexes in FS, find the absolute offsets in the
+ * rev / pack file REV_FILE for the COUNT ITEMS and return them in
+ * OFFSETS.  All ITEMS must be stored in REV_FILE.  Every index page will
+ * be looked up in the cache or read from disk only once.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+l2p_index_lookup_batch(apr_off_t *offsets,
+                       svn_fs_t *fs,
+                       svn_fs_fs__revision_file_t *rev_file,
+                       const svn_fs_fs__id_part_t *items,
+                       int count,
+                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  l2p_header_t *header = NULL;
+  l2p_batch_item_t *batch;
+  apr_pool_t *iterpool;
+  int i, k;
+
+  /* A single index header covers all revisions in REV_FILE. */
+  SVN_ERR(get_l2p_header(&header, rev_file, fs, items[0].revision,
+                         scratch_pool, scratch_pool));
+
+  /* Locate all items within the index and group them by page. */
+  batch = apr_palloc(scratch_pool, count * sizeof(*batch));
+  for (i = 0; i < count; ++i)
+    {
+      batch[i].index = i;
+      batch[i].info.revision = items[i].revision;
+      batch[i].info.item_index = items[i].number;
+      SVN_ERR(l2p_page_info_copy(&batch[i].info, header, header->page_table,
+                                 header->page_table_index, scratch_pool));
+    }
+
+  qsort(batch, count, sizeof(*batch), compare_l2p_batch_items);
+
+  /* Process one page at a time. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < count; i = k)
+    {
+      svn_fs_fs__page_cache_key_t key = { 0 };
+      l2p_batch_baton_t baton;
+      svn_boolean_t is_cached = FALSE;
+      void *dummy = NULL;
+
+      svn_pool_clear(iterpool);
+
+      for (k = i + 1; k < count; ++k)
+        if (   batch[k].info.revision != batch[i].info.revision
+            || batch[k].info.page_no != batch[i].info.page_no)
+          break;
+
+      baton.items = batch + i;
+      baton.count = k - i;
+      baton.offsets = offsets;
+
+      assert(batch[i].info.revision <= APR_UINT32_MAX);
+      key.revision = (apr_uint32_t)batch[i].info.revision;
+      key.is_packed = rev_file->is_packed;
+      key.page = batch[i].info.page_no;
+
+      SVN_ERR(svn_cache__get_partial(&dummy, &is_cached,
+                                     ffd->l2p_page_cache, &key,
+                                     l2p_batch_access_func, &baton,
+                                     iterpool));
+      if (!is_cached)
+        {
+          /* read the page from disk, cache it and extract all offsets */
+          l2p_page_t *page = NULL;
+          SVN_ERR(get_l2p_page(&page, rev_file, fs, header->first_revision,
+                               &batch[i].info.entry, iterpool));
+          SVN_ERR(svn_cache__set(ffd->l2p_page_cache, &key, page, iterpool));
+          SVN_ERR(l2p_page_get_entries(&baton, page, page->offsets,
+                                       iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__l2p_get_max_ids(apr_array_header_t **max_ids,
                            svn_fs_t *fs,
@@ -1816,6 +2037,38 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_fs_fs__item_offsets(apr_off_t *absolute_positions,
+                        svn_fs_t *fs,
+                        svn_fs_fs__revision_file_t *rev_file,
+                        const svn_fs_fs__id_part_t *items,
+                        int count,
+                        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Batching only pays off when the index pages need to be looked up.
+   * Single items also get the page prefetching of the normal lookup. */
+  if (count > 1 && svn_fs_fs__use_log_addressing(fs))
+    return svn_error_trace(l2p_index_lookup_batch(absolute_positions, fs,
+                                                  rev_file, items, count,
+                                                  scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < count; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__item_offset(&absolute_positions[i], fs, rev_file,
+                                     items[i].revision, NULL,
+                                     items[i].number, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /*
  * phys-to-log index
  */
@@ -2139,6 +2392,8 @@ auto_open_p2l_index(svn_fs_fs__revision_file_t *rev_file,
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
       SVN_ERR(packed_stream_open(&rev_file->p2l_stream,
                                  rev_file->file,
+                                 svn_fs_fs__rev_file_mapped(rev_file, 0,
+                                     (apr_size_t)rev_file->footer_offset),
                                  rev_file->p2l_offset,
                                  rev_file->footer_offset,
                                  P2L_STREAM_PREFIX,
@@ -200,6 +200,22 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
                        apr_uint64_t item_index,
                        apr_pool_t *scratch_pool);
 
+/* For the COUNT ITEMS in FS, return their positions within REV_FILE in
+ * the caller-provided array ABSOLUTE_POSITIONS, in the same order.  All
+ * ITEMS must be committed and be stored in REV_FILE.
+ *
+ * This is equivalent to calling svn_fs_fs__item_offset for every item
+ * but looks up each l2p index page only once.  The items don't need to
+ * be sorted.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__item_offsets(apr_off_t *absolute_positions,
+                        svn_fs_t *fs,
+                        svn_fs_fs__revision_file_t *rev_file,
+                        const svn_fs_fs__id_part_t *items,
+                        int count,
+                        apr_pool_t *scratch_pool);
+
 /* Use the log-to-phys indexes in FS to determine the maximum item indexes
  * assigned to revision START_REV to START_REV + COUNT - 1.  That is a
  * close upper limit to the actual number of items in the respective revs.
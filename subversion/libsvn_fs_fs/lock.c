@@ -42,8 +42,11 @@
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
 #include "svn_private_config.h"
 
+#include "locks-db.h"
+
 /* Names of hash keys used to store a lock for writing to disk. */
 #define PATH_KEY "path"
 #define TOKEN_KEY "token"
@@ -58,6 +61,11 @@
    calculate a subdirectory in which to drop that file. */
 #define DIGEST_SUBDIR_LEN 3
 
+/* Schema version of the lock store database. */
+#define LOCKS_DB_SCHEMA_FORMAT 1
+
+LOCKS_DB_SQL_DECLARE_STATEMENTS(statements);
+
 
 
 /*** Generic helper functions. ***/
@@ -332,6 +340,281 @@ read_digest_file(apr_hash_t **children_p,
 
 
 
+/*** Lock store database functions.
+
+     Starting with SVN_FS_FS__MIN_LOCKS_DB_FORMAT, all locks of the
+     repository are kept in a single SQLite table keyed by their canonical
+     path instead of the digest file tree.  Batches of locks are then
+     written in a single transaction and no parent index files need to be
+     maintained.  Since the canonical paths of all locks within a sub-tree
+     form a contiguous key range, enumerating them is a simple index range
+     scan.  ***/
+
+/* Set *LOCK_P to the lock described by the current row in STMT.
+   Allocate the result in RESULT_POOL. */
+static void
+read_lock_row(svn_lock_t **lock_p,
+              svn_sqlite__stmt_t *stmt,
+              apr_pool_t *result_pool)
+{
+  svn_lock_t *lock = svn_lock_create(result_pool);
+
+  lock->path = svn_sqlite__column_text(stmt, 0, result_pool);
+  lock->token = svn_sqlite__column_text(stmt, 1, result_pool);
+  lock->owner = svn_sqlite__column_text(stmt, 2, result_pool);
+  lock->comment = svn_sqlite__column_text(stmt, 3, result_pool);
+  lock->is_dav_comment = svn_sqlite__column_boolean(stmt, 4);
+  lock->creation_date = svn_sqlite__column_int64(stmt, 5);
+  if (!svn_sqlite__column_is_null(stmt, 6))
+    lock->expiration_date = svn_sqlite__column_int64(stmt, 6);
+
+  *lock_p = lock;
+}
+
+/* Add LOCK to the lock store DB, replacing any previous lock on the
+   same path. */
+static svn_error_t *
+db_set_lock(svn_sqlite__db_t *db,
+            const svn_lock_t *lock)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_SET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssssdL", lock->path, lock->token,
+                            lock->owner, lock->comment,
+                            lock->is_dav_comment ? 1 : 0,
+                            (apr_int64_t)lock->creation_date));
+  if (lock->expiration_date)
+    SVN_ERR(svn_sqlite__bind_int64(stmt, 7, lock->expiration_date));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+/* Remove the lock on PATH from the lock store DB, if there is one. */
+static svn_error_t *
+db_delete_lock(svn_sqlite__db_t *db,
+               const char *path)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_DELETE_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+
+  return svn_error_trace(svn_sqlite__update(NULL, stmt));
+}
+
+/* Set *LOCK_P to the lock on PATH in the lock store DB or to NULL, if
+   there is none.  Allocate the result in RESULT_POOL. */
+static svn_error_t *
+db_get_lock(svn_lock_t **lock_p,
+            svn_sqlite__db_t *db,
+            const char *path,
+            apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  *lock_p = NULL;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_GET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    read_lock_row(lock_p, stmt, result_pool);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Set *LOCKS to an array of all locks (svn_lock_t *) in the lock store DB
+   on PATH and below it, sorted by path.  Allocate the result in
+   RESULT_POOL. */
+static svn_error_t *
+db_get_locks_below(apr_array_header_t **locks,
+                   svn_sqlite__db_t *db,
+                   const char *path,
+                   apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  char *lower, *upper;
+
+  /* All paths strictly below PATH are in the [LOWER, UPPER) key range. */
+  lower = svn_fspath__is_root(path, strlen(path))
+        ? apr_pstrdup(result_pool, "/")
+        : apr_pstrcat(result_pool, path, "/", SVN_VA_NULL);
+  upper = apr_pstrdup(result_pool, lower);
+  upper[strlen(upper) - 1] = '0';
+
+  *locks = apr_array_make(result_pool, 16, sizeof(svn_lock_t *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_GET_LOCKS_BELOW));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sss", path, lower, upper));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      svn_lock_t *lock;
+
+      read_lock_row(&lock, stmt, result_pool);
+      APR_ARRAY_PUSH(*locks, svn_lock_t *) = lock;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Create the schema of the lock store DB for FS and copy all locks found
+   in the digest file tree into it.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+db_import_digest_locks(svn_sqlite__db_t *db,
+                       svn_fs_t *fs,
+                       apr_pool_t *scratch_pool)
+{
+  const char *digest_path;
+  apr_hash_t *children;
+  apr_hash_index_t *hi;
+  svn_lock_t *lock;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_sqlite__exec_statements(db, STMT_CREATE_SCHEMA));
+
+  /* The index file of the root lists the digests of all locked paths. */
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, "/", scratch_pool));
+  SVN_ERR(read_digest_file(&children, &lock, fs->path, digest_path,
+                           scratch_pool));
+  if (lock)
+    SVN_ERR(db_set_lock(db, lock));
+
+  for (hi = apr_hash_first(scratch_pool, children);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *digest = apr_hash_this_key(hi);
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(read_digest_file(NULL, &lock, fs->path,
+                               digest_path_from_digest(fs->path, digest,
+                                                       iterpool),
+                               iterpool));
+      if (lock)
+        SVN_ERR(db_set_lock(db, lock));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Create an empty lock store database file for FS at DB_PATH, unless it
+   exists already.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+create_locks_db_file(const char *db_path,
+                     svn_fs_t *fs,
+                     apr_pool_t *scratch_pool)
+{
+#ifndef WIN32
+  /* We want to extend the permissions that apply to the repository
+     as a whole when creating a new lock store and not simply default
+     to umask. */
+  svn_error_t *err = svn_io_file_create_empty(db_path, scratch_pool);
+
+  if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
+    /* A real error. */
+    return svn_error_trace(err);
+  else if (err)
+    /* Some other thread/process created the file. */
+    svn_error_clear(err);
+  else
+    /* We created the file. */
+    SVN_ERR(svn_io_copy_perms(svn_fs_fs__path_current(fs, scratch_pool),
+                              db_path, scratch_pool));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of get_locks_db().
+   Implements svn_atomic__init_once().init_func.
+ */
+static svn_error_t *
+open_locks_db(void *baton,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *db;
+  const char *db_path = svn_dirent_join(fs->path, PATH_LOCKS_DB, pool);
+  int version;
+
+  /* Open (or create) the sqlite database.  It will be automatically
+     closed when fs->pool is destroyed. */
+  SVN_ERR(create_locks_db_file(db_path, fs, pool));
+  SVN_ERR(svn_sqlite__open(&db, db_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, 0, fs->pool, pool));
+
+  SVN_ERR(svn_sqlite__read_schema_version(&version, db, pool));
+  if (version < LOCKS_DB_SCHEMA_FORMAT)
+    {
+      /* Must be 0 -- an uninitialized (no schema) database.  Since the
+         repository format uses the lock store, there are no digest
+         files to import. */
+      SVN_ERR(svn_sqlite__exec_statements(db, STMT_CREATE_SCHEMA));
+    }
+
+  /* This is used as a flag that the database is available so don't
+     set it earlier. */
+  ffd->locks_db = db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DB_P to the lock store database of FS, opening it on first use.
+   If the format of FS predates the lock store, set *DB_P to NULL and the
+   caller shall use the digest files instead.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+get_locks_db(svn_sqlite__db_t **db_p,
+             svn_fs_t *fs,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  *db_p = NULL;
+  if (ffd->format < SVN_FS_FS__MIN_LOCKS_DB_FORMAT)
+    return SVN_NO_ERROR;
+
+  SVN_ERR_W(svn_atomic__init_once(&ffd->locks_db_opened, open_locks_db,
+                                  fs, scratch_pool),
+            _("Couldn't open lock store database"));
+
+  *db_p = ffd->locks_db;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__upgrade_locks(svn_fs_t *fs,
+                         apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *db;
+  const char *db_path = svn_dirent_join(fs->path, PATH_LOCKS_DB,
+                                        scratch_pool);
+
+  /* An interrupted upgrade may have left an incomplete database behind.
+     Until the format gets bumped, the digest files are authoritative, so
+     start from scratch. */
+  SVN_ERR(svn_io_remove_file2(db_path, TRUE, scratch_pool));
+  SVN_ERR(create_locks_db_file(db_path, fs, scratch_pool));
+  SVN_ERR(svn_sqlite__open(&db, db_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, 0, scratch_pool,
+                           scratch_pool));
+
+  SVN_SQLITE__WITH_TXN(db_import_digest_locks(db, fs, scratch_pool), db);
+
+  return svn_error_trace(svn_sqlite__close(db));
+}
+
+
+
 /*** Lock helper functions (path here are still FS paths, not on-disk
      schema-supporting paths) ***/
 
@@ -472,15 +755,26 @@ get_lock(svn_lock_t **lock_p,
          apr_pool_t *pool)
 {
   svn_lock_t *lock = NULL;
-  const char *digest_path;
-  svn_node_kind_t kind;
-
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+  svn_sqlite__db_t *db;
 
   *lock_p = NULL;
-  if (kind != svn_node_none)
-    SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+
+  SVN_ERR(get_locks_db(&db, fs, pool));
+  if (db)
+    {
+      SVN_ERR(db_get_lock(&lock, db, path, pool));
+    }
+  else
+    {
+      const char *digest_path;
+      svn_node_kind_t kind;
+
+      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+      SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+
+      if (kind != svn_node_none)
+        SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+    }
 
   if (! lock)
     return must_exist ? SVN_FS__ERR_NO_SUCH_LOCK(fs, path) : SVN_NO_ERROR;
@@ -533,13 +827,54 @@ get_lock_helper(svn_fs_t *fs,
 }
 
 
+/* Like walk_locks() but for the lock store database DB of FS. */
+static svn_error_t *
+walk_db_locks(svn_fs_t *fs,
+              svn_sqlite__db_t *db,
+              const char *path,
+              svn_fs_get_locks_callback_t get_locks_func,
+              void *get_locks_baton,
+              svn_boolean_t have_write_lock,
+              apr_pool_t *pool)
+{
+  apr_array_header_t *locks;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Fetch all rows before invoking any callback.  The callbacks might
+     well access the lock store themselves. */
+  SVN_ERR(db_get_locks_below(&locks, db, path, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < locks->nelts; ++i)
+    {
+      svn_lock_t *lock = APR_ARRAY_IDX(locks, i, svn_lock_t *);
+      svn_pool_clear(iterpool);
+
+      if (lock_expired(lock))
+        {
+          /* Only remove the lock if we have the write lock.
+             Read operations shouldn't change the filesystem. */
+          if (have_write_lock)
+            SVN_ERR(unlock_single(fs, lock, iterpool));
+        }
+      else
+        {
+          SVN_ERR(get_locks_func(get_locks_baton, lock, iterpool));
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* A function that calls GET_LOCKS_FUNC/GET_LOCKS_BATON for
    all locks in and under PATH in FS.
    HAVE_WRITE_LOCK should be true if the caller (directly or indirectly)
    has the FS write lock. */
 static svn_error_t *
 walk_locks(svn_fs_t *fs,
-           const char *digest_path,
+           const char *path,
            svn_fs_get_locks_callback_t get_locks_func,
            void *get_locks_baton,
            svn_boolean_t have_write_lock,
@@ -549,8 +884,17 @@ walk_locks(svn_fs_t *fs,
   apr_hash_t *children;
   apr_pool_t *subpool;
   svn_lock_t *lock;
+  svn_sqlite__db_t *db;
+  const char *digest_path;
+
+  SVN_ERR(get_locks_db(&db, fs, pool));
+  if (db)
+    return svn_error_trace(walk_db_locks(fs, db, path, get_locks_func,
+                                         get_locks_baton, have_write_lock,
+                                         pool));
 
   /* First, send up any locks in the current digest file. */
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
   SVN_ERR(read_digest_file(&children, &lock, fs->path, digest_path, pool));
 
   if (lock && lock_expired(lock))
@@ -652,9 +996,7 @@ svn_fs_fs__allow_locked_operation(const char *path,
   if (recurse)
     {
       /* Discover all locks at or below the path. */
-      const char *digest_path;
-      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-      SVN_ERR(walk_locks(fs, digest_path, get_locks_callback,
+      SVN_ERR(walk_locks(fs, path, get_locks_callback,
                          fs, have_write_lock, pool));
     }
   else
@@ -823,6 +1165,25 @@ struct lock_info_t {
   svn_error_t *fs_err;
 };
 
+/* Write all locks in INFOS (struct lock_info_t) that passed the checks
+   to the lock store DB. */
+static svn_error_t *
+set_db_locks(svn_sqlite__db_t *db,
+             apr_array_header_t *infos)
+{
+  int i;
+
+  for (i = 0; i < infos->nelts; ++i)
+    {
+      struct lock_info_t *info = &APR_ARRAY_IDX(infos, i,
+                                                struct lock_info_t);
+      if (info->lock)
+        SVN_ERR(db_set_lock(db, info->lock));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* The body of svn_fs_fs__lock(), which see.
 
    BATON is a 'struct lock_baton *' holding the effective arguments.
@@ -844,8 +1205,11 @@ lock_body(void *baton, apr_pool_t *pool)
   int i;
   apr_hash_t *index_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
+  svn_sqlite__db_t *db;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
+  SVN_ERR(get_locks_db(&db, lb->fs, pool));
+
   /* Until we implement directory locks someday, we only allow locks
      on files. */
   /* Use fs->vtable->foo instead of svn_fs_foo to avoid circular
@@ -869,8 +1233,8 @@ lock_body(void *baton, apr_pool_t *pool)
                          youngest, iterpool));
 
       /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
+         this path.  The lock store does not need any. */
+      if (!info.fs_err && !db)
         schedule_index_update(index_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(lb->infos, struct lock_info_t) = info;
@@ -925,8 +1289,29 @@ lock_body(void *baton, apr_pool_t *pool)
           info->lock->creation_date = apr_time_now();
           info->lock->expiration_date = lb->expiration_date;
 
-          info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
-                                  iterpool);
+          if (!db)
+            info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
+                                    iterpool);
+        }
+    }
+
+  /* The lock store gets all new locks in a single transaction.  Either
+     all of them will be written or none. */
+  if (db)
+    {
+      svn_error_t *err;
+
+      SVN_ERR(svn_sqlite__begin_transaction(db));
+      err = set_db_locks(db, lb->infos);
+      err = svn_sqlite__finish_transaction(db, err);
+
+      if (err)
+        {
+          for (i = 0; i < lb->infos->nelts; ++i)
+            APR_ARRAY_IDX(lb->infos, i, struct lock_info_t).lock = NULL;
+
+          svn_pool_destroy(iterpool);
+          return svn_error_trace(err);
         }
     }
 
@@ -975,6 +1360,25 @@ struct unlock_info_t {
   svn_boolean_t done;
 };
 
+/* Remove the locks for all paths in INFOS (struct unlock_info_t) that
+   passed the checks from the lock store DB. */
+static svn_error_t *
+delete_db_locks(svn_sqlite__db_t *db,
+                apr_array_header_t *infos)
+{
+  int i;
+
+  for (i = 0; i < infos->nelts; ++i)
+    {
+      struct unlock_info_t *info = &APR_ARRAY_IDX(infos, i,
+                                                  struct unlock_info_t);
+      if (!info->fs_err)
+        SVN_ERR(db_delete_lock(db, info->path));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* The body of svn_fs_fs__unlock(), which see.
 
    BATON is a 'struct unlock_baton *' holding the effective arguments.
@@ -996,8 +1400,11 @@ unlock_body(void *baton, apr_pool_t *pool)
   int i;
   apr_hash_t *indices_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
+  svn_sqlite__db_t *db;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
+  SVN_ERR(get_locks_db(&db, ub->fs, pool));
+
   SVN_ERR(ub->fs->vtable->youngest_rev(&youngest, ub->fs, pool));
   SVN_ERR(ub->fs->vtable->revision_root(&root, ub->fs, youngest, pool));
 
@@ -1019,8 +1426,8 @@ unlock_body(void *baton, apr_pool_t *pool)
                              iterpool));
 
       /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
+         this path.  The lock store does not need any. */
+      if (!info.fs_err && !db)
         schedule_index_update(indices_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(ub->infos, struct unlock_info_t) = info;
@@ -1028,6 +1435,21 @@ unlock_body(void *baton, apr_pool_t *pool)
 
   rev_0_path = svn_fs_fs__path_rev_absolute(ub->fs, 0, pool);
 
+  /* The lock store removes all locks in a single transaction. */
+  if (db)
+    {
+      SVN_SQLITE__WITH_TXN(delete_db_locks(db, ub->infos), db);
+      for (i = 0; i < ub->infos->nelts; ++i)
+        {
+          struct unlock_info_t *info = &APR_ARRAY_IDX(ub->infos, i,
+                                                      struct unlock_info_t);
+          info->done = !info->fs_err;
+        }
+
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
   /* Unlike the lock_body(), we need to delete locks *before* we start to
      update indices. */
 
@@ -1348,7 +1770,6 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
                      void *get_locks_baton,
                      apr_pool_t *pool)
 {
-  const char *digest_path;
   get_locks_filter_baton_t glfb;
 
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
@@ -1359,9 +1780,8 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
   glfb.get_locks_func = get_locks_func;
   glfb.get_locks_baton = get_locks_baton;
 
-  /* Get the top digest path in our tree of interest, and then walk it. */
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(walk_locks(fs, digest_path, get_locks_filter_func, &glfb,
+  /* Walk the tree of interest. */
+  SVN_ERR(walk_locks(fs, path, get_locks_filter_func, &glfb,
                      FALSE, pool));
   return SVN_NO_ERROR;
 }
@@ -103,6 +103,14 @@ svn_error_t *svn_fs_fs__allow_locked_operation(const char *path,
                                                svn_boolean_t have_write_lock,
                                                apr_pool_t *pool);
 
+/* Copy all locks of FS from the digest file tree into a new lock store
+   database, replacing any previous one.  The digest files are left in
+   place.  The caller must hold the FS write lock and bump the format to
+   SVN_FS_FS__MIN_LOCKS_DB_FORMAT or later afterwards.  Use SCRATCH_POOL
+   for temporary allocations. */
+svn_error_t *svn_fs_fs__upgrade_locks(svn_fs_t *fs,
+                                      apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
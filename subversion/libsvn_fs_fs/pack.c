@@ -38,6 +38,7 @@
 #include "index.h"
 #include "low_level.h"
 #include "revprops.h"
+#include "tasks.h"
 #include "transaction.h"
 
 #include "../libsvn_fs/fs-loader.h"
@@ -85,7 +86,8 @@
  */
 
 /* Maximum amount of memory we allocate for placement information during
- * the pack process.
+ * the pack process.  When packing shards concurrently, this limit applies
+ * to each of them individually.
  */
 #define DEFAULT_MAX_MEM (64 * 1024 * 1024)
 
@@ -1912,6 +1914,59 @@ synced_pack_shard(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Return the path of the directory in REVS_DIR that holds the unpacked
+ * revisions of SHARD.  Allocate the result in POOL.
+ */
+static const char *
+rev_shard_dir(const char *revs_dir,
+              apr_int64_t shard,
+              apr_pool_t *pool)
+{
+  return svn_dirent_join(revs_dir,
+                         apr_psprintf(pool, "%" APR_INT64_T_FMT, shard),
+                         pool);
+}
+
+/* Return the path of the directory in REVS_DIR that holds the packed
+ * revisions of SHARD.  Allocate the result in POOL.
+ */
+static const char *
+rev_pack_dir(const char *revs_dir,
+             apr_int64_t shard,
+             apr_pool_t *pool)
+{
+  const char *name = apr_psprintf(pool,
+                                  "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                                  shard);
+  return svn_dirent_join(revs_dir, name, pool);
+}
+
+/* Switch the repository over to the already packed revision contents of
+ * the shard described by BATON and pack its revprops.
+ */
+static svn_error_t *
+publish_shard(struct pack_baton *baton,
+              apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+
+  /* For newer repo formats, we only acquired the pack lock so far.
+     Before modifying the repo state by switching over to the packed
+     data, we need to acquire the global (write) lock. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
+                                       pool));
+  else
+    SVN_ERR(synced_pack_shard(baton, pool));
+
+  /* Notify caller we're starting to pack this shard. */
+  if (baton->notify_func)
+    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
+                               svn_fs_pack_notify_end, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Pack the shard described by BATON.
  *
  * If for some reason we detect a partial packing already performed,
@@ -1930,16 +1985,8 @@ pack_shard(struct pack_baton *baton,
                                svn_fs_pack_notify_start, pool));
 
   /* Some useful paths. */
-  rev_pack_file_dir = svn_dirent_join(baton->revs_dir,
-                  apr_psprintf(pool,
-                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                               baton->shard),
-                  pool);
-  baton->rev_shard_path = svn_dirent_join(baton->revs_dir,
-                                          apr_psprintf(pool,
-                                                       "%" APR_INT64_T_FMT,
-                                                       baton->shard),
-                                          pool);
+  rev_pack_file_dir = rev_pack_dir(baton->revs_dir, baton->shard, pool);
+  baton->rev_shard_path = rev_shard_dir(baton->revs_dir, baton->shard, pool);
 
   /* pack the revision content */
   SVN_ERR(pack_rev_shard(baton->fs, rev_pack_file_dir, baton->rev_shard_path,
@@ -1947,19 +1994,98 @@ pack_shard(struct pack_baton *baton,
                          DEFAULT_MAX_MEM, baton->cancel_func,
                          baton->cancel_baton, pool));
 
-  /* For newer repo formats, we only acquired the pack lock so far.
-     Before modifying the repo state by switching over to the packed
-     data, we need to acquire the global (write) lock. */
-  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
-    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
-                                       pool));
-  else
-    SVN_ERR(synced_pack_shard(baton, pool));
+  return svn_error_trace(publish_shard(baton, pool));
+}
 
-  /* Notify caller we're starting to pack this shard. */
-  if (baton->notify_func)
-    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
-                               svn_fs_pack_notify_end, pool));
+/* Baton type for pack_shard_task(), describing the revision contents of
+ * a single shard to pack.  All members are read-only for the task.
+ */
+typedef struct pack_task_t
+{
+  /* The filesystem to pack.  The task will use its own clone of it. */
+  svn_fs_t *fs;
+
+  /* The shard to pack and the respective source and target directories. */
+  apr_int64_t shard;
+  const char *rev_shard_path;
+  const char *rev_pack_file_dir;
+
+  /* Cancellation support.  CANCEL_FUNC must be thread-safe. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} pack_task_t;
+
+/* Implements svn_fs_fs__task_func_t.  Pack the revision contents of the
+ * shard described by the pack_task_t BATON but don't publish them.
+ */
+static svn_error_t *
+pack_shard_task(void *baton)
+{
+  pack_task_t *task = baton;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  err = svn_fs_fs__open_clone(&fs, task->fs, pool, pool);
+  if (!err)
+    {
+      fs_fs_data_t *ffd = fs->fsap_data;
+      err = pack_rev_shard(fs, task->rev_pack_file_dir, task->rev_shard_path,
+                           task->shard, ffd->max_files_per_dir,
+                           DEFAULT_MAX_MEM, task->cancel_func,
+                           task->cancel_baton, pool);
+    }
+
+  svn_pool_destroy(pool);
+
+  return svn_error_trace(err);
+}
+
+/* Pack COUNT consecutive shards, starting at BATON->SHARD, concurrently.
+ * The packed contents will be published in shard order, i.e. the
+ * min-unpacked-rev will only ever move forward, one shard at a time.
+ *
+ * Use POOL for temporary allocations.
+ */
+static svn_error_t *
+pack_shards_concurrently(struct pack_baton *baton,
+                         int count,
+                         apr_pool_t *pool)
+{
+  apr_int64_t first_shard = baton->shard;
+  pack_task_t **tasks = apr_pcalloc(pool, count * sizeof(*tasks));
+  int i;
+
+  for (i = 0; i < count; ++i)
+    {
+      pack_task_t *task = apr_pcalloc(pool, sizeof(*task));
+      task->fs = baton->fs;
+      task->shard = first_shard + i;
+      task->rev_shard_path = rev_shard_dir(baton->revs_dir, task->shard,
+                                           pool);
+      task->rev_pack_file_dir = rev_pack_dir(baton->revs_dir, task->shard,
+                                             pool);
+      task->cancel_func = baton->cancel_func;
+      task->cancel_baton = baton->cancel_baton;
+      tasks[i] = task;
+    }
+
+  SVN_ERR(svn_fs_fs__run_tasks(pack_shard_task, (void **)tasks, count,
+                               pool));
+
+  /* Switch over to the packed data, shard by shard.  Report start and
+     end of each shard together, so notifications are paired the same way
+     as for sequential packing. */
+  for (i = 0; i < count; ++i)
+    {
+      baton->shard = tasks[i]->shard;
+      baton->rev_shard_path = tasks[i]->rev_shard_path;
+
+      if (baton->notify_func)
+        SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
+                                   svn_fs_pack_notify_start, pool));
+      SVN_ERR(publish_shard(baton, pool));
+    }
 
   return SVN_NO_ERROR;
 }
@@ -2013,6 +2139,7 @@ pack_body(void *baton,
   struct pack_baton *pb = baton;
   fs_fs_data_t *ffd = pb->fs->fsap_data;
   apr_int64_t completed_shards;
+  apr_int64_t shard;
   apr_pool_t *iterpool;
   svn_boolean_t fully_packed;
 
@@ -2036,16 +2163,22 @@ pack_body(void *baton,
                                         pool);
 
   iterpool = svn_pool_create(pool);
-  for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
-       pb->shard < completed_shards;
-       pb->shard++)
+  shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+  while (shard < completed_shards)
     {
+      int count = (int)MIN(MAX(ffd->jobs, 1), completed_shards - shard);
       svn_pool_clear(iterpool);
 
       if (pb->cancel_func)
         SVN_ERR(pb->cancel_func(pb->cancel_baton));
 
-      SVN_ERR(pack_shard(pb, iterpool));
+      pb->shard = shard;
+      if (count > 1)
+        SVN_ERR(pack_shards_concurrently(pb, count, iterpool));
+      else
+        SVN_ERR(pack_shard(pb, iterpool));
+
+      shard += count;
     }
 
   svn_pool_destroy(iterpool);
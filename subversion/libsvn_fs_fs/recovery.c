@@ -470,6 +470,10 @@ recover_body(void *baton, apr_pool_t *pool)
                                max_rev);
     }
 
+  /* Complete revprop changes that got interrupted, so readers may use
+     their revprop caches again. */
+  SVN_ERR(svn_fs_fs__repair_revprop_generation(fs, pool));
+
   /* Prune younger-than-(newfound-youngest) revisions from the rep
      cache if sharing is enabled taking care not to create the cache
      if it does not exist. */
@@ -31,8 +31,10 @@
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_path.h"
+#include "svn_sorts.h"
 
 #include "private/svn_sqlite.h"
+#include "private/svn_subr_private.h"
 
 #include "rep-cache-db.h"
 
@@ -51,6 +53,413 @@ path_rep_cache_db(const char *fs_path,
   return svn_dirent_join(fs_path, REP_CACHE_DB_NAME, result_pool);
 }
 
+
+/** The rep-cache filter.
+ *
+ * Most representations written during a commit or load are new, i.e. the
+ * rep-cache lookup will fail.  To not pay for a SQLite query each time,
+ * we keep a bloom filter over all SHA1 keys in rep-cache.db and only
+ * consult the database if the filter reports a potential hit.
+ *
+ * The filter is shared between all svn_fs_t instances of the same
+ * repository within this process.  It is filled incrementally, using the
+ * ROWIDs of the rep_cache table, whenever we see a new youngest revision.
+ * Entries added by other processes may be missing from the filter for a
+ * while.  That only means we miss some rep-sharing opportunities; false
+ * positives simply cost a DB lookup.
+ *
+ * The table has no INTEGER PRIMARY KEY, so SQLite may hand out ROWIDs
+ * again after STMT_DEL_REPS_YOUNGER_THAN_REV removed the latest rows, and
+ * a re-created DB starts over at 1.  Rows added that way would never be
+ * read by the incremental fill.  Therefore, we remember the key of the
+ * last row read and rebuild the filter once that row has been removed or
+ * replaced.
+ *
+ * Scanning a large rep-cache.db takes a while, so no single lookup reads
+ * more than FILTER_FILL_BATCH rows.  Until the filter has caught up with
+ * the DB, it is not used and all lookups go to the DB directly.
+ */
+
+/* Bits per expected entry and number of probes per key.  This gives a
+   false positive rate of about 2%. */
+#define FILTER_BITS_PER_ENTRY 8
+#define FILTER_PROBES 6
+
+/* Don't bother with smaller filters. */
+#define FILTER_MIN_CAPACITY 0x10000
+
+/* Maximum number of DB rows to add to the filter per lookup. */
+#define FILTER_FILL_BATCH 0x4000
+
+typedef struct rep_cache_filter_t
+{
+  /* Root pool owning this structure and BITS. */
+  apr_pool_t *pool;
+
+  /* The bloom filter bits and their number. */
+  svn_bit_array__t *bits;
+  apr_uint64_t bit_count;
+
+  /* Number of keys we sized the filter for and actually added to it.
+     Once COUNT exceeds CAPACITY, the filter gets rebuilt. */
+  apr_int64_t capacity;
+  apr_int64_t count;
+
+  /* All rep_cache rows up to this ROWID have been added. */
+  apr_int64_t last_rowid;
+
+  /* The hash column of the row at LAST_ROWID.  Empty if no row has been
+     read, yet. */
+  char last_hash[2 * APR_SHA1_DIGESTSIZE + 1];
+
+  /* TRUE, if the last filter_fill() reached the end of the rep_cache
+     table.  Only then may we use the filter to skip lookups. */
+  svn_boolean_t complete;
+
+  /* The youngest revision in the repository when we last read new rows
+     from the DB. */
+  svn_revnum_t refreshed_rev;
+} rep_cache_filter_t;
+
+/* Return the bit index in FILTER for the I-th probe of SHA1 DIGEST.
+   DIGEST is uniformly distributed already, so we simply use its bytes
+   for double hashing. */
+static apr_uint64_t
+filter_probe(const rep_cache_filter_t *filter,
+             const unsigned char *digest,
+             int i)
+{
+  apr_uint64_t h1 = 0, h2 = 0;
+  int k;
+
+  for (k = 0; k < 8; ++k)
+    {
+      h1 = (h1 << 8) | digest[k];
+      h2 = (h2 << 8) | digest[k + 8];
+    }
+
+  return (h1 + (apr_uint64_t)i * (h2 | 1)) % filter->bit_count;
+}
+
+/* Add SHA1 DIGEST to FILTER. */
+static void
+filter_add(rep_cache_filter_t *filter,
+           const unsigned char *digest)
+{
+  int i;
+  for (i = 0; i < FILTER_PROBES; ++i)
+    svn_bit_array__set(filter->bits,
+                       (apr_size_t)filter_probe(filter, digest, i), TRUE);
+
+  filter->count++;
+}
+
+/* Return FALSE, if SHA1 DIGEST is definitely not in FILTER. */
+static svn_boolean_t
+filter_may_contain(rep_cache_filter_t *filter,
+                   const unsigned char *digest)
+{
+  int i;
+  for (i = 0; i < FILTER_PROBES; ++i)
+    if (!svn_bit_array__get(filter->bits,
+                            (apr_size_t)filter_probe(filter, digest, i)))
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Add up to FILTER_FILL_BATCH rows from rep-cache.db of FS to FILTER that
+   have not been added, yet.  Set FILTER->COMPLETE if there are no more rows
+   left.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+filter_fill(rep_cache_filter_t *filter,
+            svn_fs_t *fs,
+            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int iterations = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_HASHES_AFTER_ROWID));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, filter->last_rowid));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 2, FILTER_FILL_BATCH));
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      svn_checksum_t *checksum;
+      apr_int64_t rowid;
+      const char *sha1_digest;
+      svn_error_t *err;
+
+      /* Clear ITERPOOL occasionally. */
+      if (iterations++ % 1024 == 0)
+        svn_pool_clear(iterpool);
+
+      rowid = svn_sqlite__column_int64(stmt, 0);
+      sha1_digest = svn_sqlite__column_text(stmt, 1, iterpool);
+
+      /* Keys that we can't parse can't be looked up either. */
+      err = svn_checksum_parse_hex(&checksum, svn_checksum_sha1,
+                                   sha1_digest, iterpool);
+      if (err)
+        svn_error_clear(err);
+      else if (checksum)
+        filter_add(filter, checksum->digest);
+
+      /* Rows come in ROWID order. */
+      filter->last_rowid = rowid;
+      apr_cpystrn(filter->last_hash, sha1_digest, sizeof(filter->last_hash));
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  SVN_ERR(svn_sqlite__reset(stmt));
+  svn_pool_destroy(iterpool);
+
+  filter->complete = iterations < FILTER_FILL_BATCH;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FILTER to a new filter for FS, large enough for all current
+   rep-cache.db entries plus some headroom, and start filling it.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+filter_create(rep_cache_filter_t **filter,
+              svn_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_int64_t max_rowid;
+  apr_pool_t *pool;
+  rep_cache_filter_t *result;
+  svn_error_t *err;
+
+  /* ROWIDs are assigned sequentially, so the largest one is a cheap
+     upper bound for the number of entries. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_MAX_ROWID));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  max_rowid = svn_sqlite__column_int64(stmt, 0);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* The filter is shared across threads and outlives FS. */
+  pool = svn_pool_create(NULL);
+  result = apr_pcalloc(pool, sizeof(*result));
+  result->pool = pool;
+  result->capacity = MAX(max_rowid + max_rowid / 2, FILTER_MIN_CAPACITY);
+  result->bit_count = (apr_uint64_t)result->capacity * FILTER_BITS_PER_ENTRY;
+  result->bits = svn_bit_array__create((apr_size_t)result->bit_count, pool);
+  result->refreshed_rev = ffd->youngest_rev_cache;
+
+  err = filter_fill(result, fs, scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  *filter = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *STALE to TRUE, if the row that FILTER has read last from the
+   rep-cache.db of FS has been removed or replaced since.  In that case,
+   ROWIDs have been reused and FILTER may lack some entries.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+filter_is_stale(svn_boolean_t *stale,
+                rep_cache_filter_t *filter,
+                svn_fs_t *fs,
+                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  /* Any row will be read by the next fill. */
+  if (filter->last_rowid == 0)
+    {
+      *stale = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_HASH_BY_ROWID));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, filter->last_rowid));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  *stale = !have_row
+        || strcmp(svn_sqlite__column_text(stmt, 0, scratch_pool),
+                  filter->last_hash) != 0;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Make sure the shared rep-cache filter of FS exists, has enough capacity
+   and covers all DB entries up to FS's youngest revision that we know of.
+   Call this with the REP_CACHE_FILTER_LOCK being held.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+filter_update(svn_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  rep_cache_filter_t *filter = ffsd->rep_cache_filter;
+
+  if (filter && filter->count > filter->capacity)
+    {
+      /* Too many false positives.  Start over with a larger one. */
+      ffsd->rep_cache_filter = NULL;
+      svn_pool_destroy(filter->pool);
+      filter = NULL;
+    }
+
+  if (filter == NULL)
+    {
+      SVN_ERR(filter_create(&filter, fs, scratch_pool));
+      ffsd->rep_cache_filter = filter;
+    }
+  else if (   !filter->complete
+           || ffd->youngest_rev_cache > filter->refreshed_rev)
+    {
+      svn_boolean_t stale;
+
+      /* Continue filling the filter or, if others have committed,
+         pick up their new entries.  If they removed entries and ROWIDs
+         got reused, we must start over. */
+      SVN_ERR(filter_is_stale(&stale, filter, fs, scratch_pool));
+      if (stale)
+        {
+          ffsd->rep_cache_filter = NULL;
+          svn_pool_destroy(filter->pool);
+          SVN_ERR(filter_create(&filter, fs, scratch_pool));
+          ffsd->rep_cache_filter = filter;
+        }
+      else
+        {
+          filter->refreshed_rev = ffd->youngest_rev_cache;
+          SVN_ERR(filter_fill(filter, fs, scratch_pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of filter_check(), to be called with the REP_CACHE_FILTER_LOCK.
+   Parameters are the same. */
+static svn_error_t *
+filter_check_body(svn_boolean_t *may_exist,
+                  svn_fs_t *fs,
+                  const apr_array_header_t *checksums,
+                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  rep_cache_filter_t *filter;
+  int i;
+
+  SVN_ERR(filter_update(fs, scratch_pool));
+
+  filter = ffd->shared->rep_cache_filter;
+  for (i = 0; i < checksums->nelts; ++i)
+    {
+      const svn_checksum_t *checksum
+        = APR_ARRAY_IDX(checksums, i, const svn_checksum_t *);
+      may_exist[i] = !filter->complete
+                  || filter_may_contain(filter, checksum->digest);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* For all SHA1 CHECKSUMS (const svn_checksum_t *), set the respective
+   element in the MAY_EXIST array to FALSE iff that key is definitely not
+   in the rep-cache.db of FS.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+filter_check(svn_boolean_t *may_exist,
+             svn_fs_t *fs,
+             const apr_array_header_t *checksums,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_MUTEX__WITH_LOCK(ffd->shared->rep_cache_filter_lock,
+                       filter_check_body(may_exist, fs, checksums,
+                                         scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of filter_add_reps(), to be called with the REP_CACHE_FILTER_LOCK.
+   Parameters are the same. */
+static svn_error_t *
+filter_add_reps_body(svn_fs_t *fs,
+                     const apr_array_header_t *reps)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  rep_cache_filter_t *filter = ffd->shared->rep_cache_filter;
+  int i;
+
+  /* Without a filter, there is nothing to keep up-to-date. */
+  if (filter)
+    for (i = 0; i < reps->nelts; ++i)
+      filter_add(filter,
+                 APR_ARRAY_IDX(reps, i, representation_t *)->sha1_digest);
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of filter_reset(), to be called with the REP_CACHE_FILTER_LOCK.
+   Parameters are the same. */
+static svn_error_t *
+filter_reset_body(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  rep_cache_filter_t *filter = ffd->shared->rep_cache_filter;
+
+  ffd->shared->rep_cache_filter = NULL;
+  if (filter)
+    svn_pool_destroy(filter->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Drop the rep-cache filter of FS, e.g. after removing rows from the DB.
+   The next lookup will create a new one. */
+static svn_error_t *
+filter_reset(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_MUTEX__WITH_LOCK(ffd->shared->rep_cache_filter_lock,
+                       filter_reset_body(fs));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the keys of all REPS (representation_t *) to the rep-cache filter
+   of FS, if that has been created already. */
+static svn_error_t *
+filter_add_reps(svn_fs_t *fs,
+                const apr_array_header_t *reps)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_MUTEX__WITH_LOCK(ffd->shared->rep_cache_filter_lock,
+                       filter_add_reps_body(fs, reps));
+
+  return SVN_NO_ERROR;
+}
+
 
 /** Library-private API's. **/
 
@@ -235,29 +644,20 @@ svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
 }
 
 
-/* This function's caller ignores most errors it returns.
-   If you extend this function, check the callsite to see if you have
-   to make it not-ignore additional error codes.  */
-svn_error_t *
-svn_fs_fs__get_rep_reference(representation_t **rep,
-                             svn_fs_t *fs,
-                             svn_checksum_t *checksum,
-                             apr_pool_t *pool)
+/* Look up the representation with fulltext SHA1 CHECKSUM in the
+   rep-cache.db of FS and return it in *REP, allocated in POOL.  Set *REP
+   to NULL if there is no such entry.  This bypasses the rep-cache filter.
+ */
+static svn_error_t *
+lookup_rep(representation_t **rep,
+           svn_fs_t *fs,
+           const svn_checksum_t *checksum,
+           apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
 
-  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
-  if (! ffd->rep_cache_db)
-    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
-
-  /* We only allow SHA1 checksums in this table. */
-  if (checksum->kind != svn_checksum_sha1)
-    return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL,
-                            _("Only SHA1 checksums can be used as keys in the "
-                              "rep_cache table.\n"));
-
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "s",
                             svn_checksum_to_cstring(checksum, pool)));
@@ -297,28 +697,137 @@ svn_fs_fs__get_rep_reference(representation_t **rep,
   return SVN_NO_ERROR;
 }
 
+/* This function's caller ignores most errors it returns.
+   If you extend this function, check the callsite to see if you have
+   to make it not-ignore additional error codes.  */
 svn_error_t *
-svn_fs_fs__set_rep_reference(svn_fs_t *fs,
-                             representation_t *rep,
+svn_fs_fs__get_rep_reference(representation_t **rep,
+                             svn_fs_t *fs,
+                             svn_checksum_t *checksum,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  svn_sqlite__stmt_t *stmt;
-  svn_error_t *err;
-  svn_checksum_t checksum;
-  checksum.kind = svn_checksum_sha1;
-  checksum.digest = rep->sha1_digest;
+  apr_array_header_t *checksums;
+  svn_boolean_t may_exist;
 
   SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
   if (! ffd->rep_cache_db)
     SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
   /* We only allow SHA1 checksums in this table. */
-  if (! rep->has_sha1)
+  if (checksum->kind != svn_checksum_sha1)
     return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
+  /* Skip the DB lookup, if we know that it would fail. */
+  checksums = apr_array_make(pool, 1, sizeof(checksum));
+  APR_ARRAY_PUSH(checksums, svn_checksum_t *) = checksum;
+  SVN_ERR(filter_check(&may_exist, fs, checksums, pool));
+
+  *rep = NULL;
+  if (may_exist)
+    SVN_ERR(lookup_rep(rep, fs, checksum, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Look up all CANDIDATES (const svn_checksum_t *) in the rep-cache.db of
+   FS and add the ones found to REPS, allocated in RESULT_POOL.  See
+   svn_fs_fs__get_rep_references for details.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+lookup_reps(apr_hash_t *reps,
+            svn_fs_t *fs,
+            const apr_array_header_t *candidates,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < candidates->nelts; ++i)
+    {
+      const svn_checksum_t *checksum
+        = APR_ARRAY_IDX(candidates, i, const svn_checksum_t *);
+      representation_t *rep;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(lookup_rep(&rep, fs, checksum, iterpool));
+      if (rep)
+        apr_hash_set(reps,
+                     apr_pmemdup(result_pool, checksum->digest,
+                                 APR_SHA1_DIGESTSIZE),
+                     APR_SHA1_DIGESTSIZE,
+                     apr_pmemdup(result_pool, rep, sizeof(*rep)));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_rep_references(apr_hash_t **reps,
+                              svn_fs_t *fs,
+                              const apr_array_header_t *checksums,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *candidates;
+  svn_boolean_t *may_exist;
+  int i;
+
+  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+
+  /* We only allow SHA1 checksums in this table. */
+  for (i = 0; i < checksums->nelts; ++i)
+    if (APR_ARRAY_IDX(checksums, i, const svn_checksum_t *)->kind
+          != svn_checksum_sha1)
+      return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL,
+                              _("Only SHA1 checksums can be used as keys in "
+                                "the rep_cache table.\n"));
+
+  /* Weed out all keys that are known to not be in the DB. */
+  may_exist = apr_pcalloc(scratch_pool,
+                          sizeof(*may_exist) * (checksums->nelts + 1));
+  SVN_ERR(filter_check(may_exist, fs, checksums, scratch_pool));
+
+  candidates = apr_array_make(scratch_pool, checksums->nelts,
+                              sizeof(const svn_checksum_t *));
+  for (i = 0; i < checksums->nelts; ++i)
+    if (may_exist[i])
+      APR_ARRAY_PUSH(candidates, const svn_checksum_t *)
+        = APR_ARRAY_IDX(checksums, i, const svn_checksum_t *);
+
+  /* Look up the remainder within a single SQLite transaction. */
+  *reps = apr_hash_make(result_pool);
+  if (candidates->nelts)
+    SVN_SQLITE__WITH_LOCK(lookup_reps(*reps, fs, candidates, result_pool,
+                                      scratch_pool),
+                          ffd->rep_cache_db);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add REP to the rep-cache.db of FS, using REP->SHA1_DIGEST as key.
+   Existing entries will be left untouched.  This bypasses the rep-cache
+   filter.  Use POOL for temporary allocations. */
+static svn_error_t *
+insert_rep(svn_fs_t *fs,
+           representation_t *rep,
+           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_error_t *err;
+  svn_checksum_t checksum;
+  checksum.kind = svn_checksum_sha1;
+  checksum.digest = rep->sha1_digest;
+
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_SET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "siiii",
                             svn_checksum_to_cstring(&checksum, pool),
@@ -340,7 +849,7 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
       /* Constraint failed so the mapping for SHA1_CHECKSUM->REP
          should exist.  If so that's cool -- just do nothing.  If not,
          that's a red flag!  */
-      SVN_ERR(svn_fs_fs__get_rep_reference(&old_rep, fs, &checksum, pool));
+      SVN_ERR(lookup_rep(&old_rep, fs, &checksum, pool));
 
       if (!old_rep)
         {
@@ -353,6 +862,69 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Call insert_rep() for all REPS (representation_t *) in FS.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+insert_reps(svn_fs_t *fs,
+            const apr_array_header_t *reps,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < reps->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(insert_rep(fs, APR_ARRAY_IDX(reps, i, representation_t *),
+                         iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__set_rep_reference(svn_fs_t *fs,
+                             representation_t *rep,
+                             apr_pool_t *pool)
+{
+  apr_array_header_t *reps = apr_array_make(pool, 1, sizeof(rep));
+  APR_ARRAY_PUSH(reps, representation_t *) = rep;
+
+  return svn_error_trace(svn_fs_fs__set_rep_references(fs, reps, pool));
+}
+
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
+
+  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+
+  /* We only allow SHA1 checksums in this table. */
+  for (i = 0; i < reps->nelts; ++i)
+    if (! APR_ARRAY_IDX(reps, i, representation_t *)->has_sha1)
+      return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL,
+                              _("Only SHA1 checksums can be used as keys in "
+                                "the rep_cache table.\n"));
+
+  /* Write all entries within a single SQLite transaction.
+   * See <http://www.sqlite.org/faq.html#q19>. */
+  SVN_SQLITE__WITH_LOCK(insert_reps(fs, reps, scratch_pool),
+                        ffd->rep_cache_db);
+
+  /* Future lookups shall find them. */
+  SVN_ERR(filter_add_reps(fs, reps));
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_fs_fs__del_rep_reference(svn_fs_t *fs,
@@ -371,6 +943,10 @@ svn_fs_fs__del_rep_reference(svn_fs_t *fs,
   SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
   SVN_ERR(svn_sqlite__step_done(stmt));
 
+  /* ROWIDs of the removed rows may be reused for new rows, which an
+     incremental refresh of the filter would not pick up. */
+  SVN_ERR(filter_reset(fs));
+
   return SVN_NO_ERROR;
 }
 
@@ -69,6 +69,22 @@ svn_fs_fs__get_rep_reference(representation_t **rep,
                              svn_checksum_t *checksum,
                              apr_pool_t *pool);
 
+/* Look up all SHA1 CHECKSUMS (const svn_checksum_t *) in FS at once and
+   return the representations found in *REPS, mapping the SHA1 digest
+   to the representation_t *.  Keys not found in the rep-cache will not be
+   in *REPS.  Allocate *REPS in RESULT_POOL and use SCRATCH_POOL for
+   temporary allocations.
+
+   This is much more efficient than calling svn_fs_fs__get_rep_reference
+   for each key.  Returns SVN_ERR_FS_CORRUPT if a reference beyond HEAD is
+   detected. */
+svn_error_t *
+svn_fs_fs__get_rep_references(apr_hash_t **reps,
+                              svn_fs_t *fs,
+                              const apr_array_header_t *checksums,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 /* Set the representation REP in FS, using REP->CHECKSUM.
    Use POOL for temporary allocations.  Returns SVN_ERR_FS_CORRUPT if
    an existing reference beyond HEAD is detected.
@@ -79,6 +95,14 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              representation_t *rep,
                              apr_pool_t *pool);
 
+/* Like svn_fs_fs__set_rep_reference but add all REPS (representation_t *)
+   within a single database transaction.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool);
+
 /* Delete from the cache all reps corresponding to revisions younger
    than YOUNGEST. */
 svn_error_t *
@@ -20,14 +20,20 @@
  * ====================================================================
  */
 
+#include <apr_mmap.h>
+
 #include "rev_file.h"
 #include "fs_fs.h"
 #include "index.h"
 #include "low_level.h"
+#include "tasks.h"
 #include "util.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
+#include "svn_dirent_uri.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
 #include "private/svn_io_private.h"
 #include "svn_private_config.h"
 
@@ -45,6 +51,10 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   file->start_revision = svn_fs_fs__packed_base_rev(fs, revision);
 
   file->file = NULL;
+  file->path = NULL;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
+  file->mmap = NULL;
   file->stream = NULL;
   file->p2l_stream = NULL;
   file->l2p_stream = NULL;
@@ -120,6 +130,35 @@ auto_make_writable(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Map the contents of the already open FILE into memory, if supported by
+ * the OS.  Failure to do so is not an error;  FILE will simply remain
+ * unmapped.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+map_revision_file(svn_fs_fs__revision_file_t *file,
+                  apr_pool_t *scratch_pool)
+{
+#if APR_HAS_MMAP
+  svn_filesize_t size;
+  apr_mmap_t *mmap;
+
+  SVN_ERR(svn_io_file_size_get(&size, file->file, scratch_pool));
+  if (size == 0 || size > APR_SIZE_MAX)
+    return SVN_NO_ERROR;
+
+  /* The mapping will be released together with FILE->POOL. */
+  if (apr_mmap_create(&mmap, file->file, 0, (apr_size_t)size,
+                      APR_MMAP_READ, file->pool) == APR_SUCCESS)
+    {
+      file->mmap = mmap;
+      file->mapped_data = (const char *)mmap->mm;
+      file->mapped_size = (apr_off_t)size;
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Core implementation of svn_fs_fs__open_pack_or_rev_file working on an
  * existing, initialized FILE structure.  If WRITABLE is TRUE, give write
  * access to the file - temporarily resetting the r/o state if necessary.
@@ -156,10 +195,16 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
       if (!err)
         {
           file->file = apr_file;
+          file->path = apr_pstrdup(result_pool, path);
           file->stream = svn_stream_from_aprfile2(apr_file, TRUE,
                                                   result_pool);
           file->is_packed = svn_fs_fs__is_packed_rev(fs, rev);
 
+          /* Pack files are immutable, so we may map them.  We only read
+           * from the mapping, hence writable files don't qualify. */
+          if (file->is_packed && ffd->use_mmap && !writable)
+            SVN_ERR(map_revision_file(file, scratch_pool));
+
           return SVN_NO_ERROR;
         }
 
@@ -275,14 +320,13 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                apr_pool_t *scratch_pool)
 {
   apr_file_t *apr_file;
-  SVN_ERR(svn_io_file_open(&apr_file,
-                           svn_fs_fs__path_txn_proto_rev(fs, txn_id,
-                                                         scratch_pool),
-                           APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
-                           result_pool));
+  const char *path = svn_fs_fs__path_txn_proto_rev(fs, txn_id, result_pool);
+  SVN_ERR(svn_io_file_open(&apr_file, path, APR_READ | APR_BUFFERED,
+                           APR_OS_DEFAULT, result_pool));
 
   *file = apr_pcalloc(result_pool, sizeof(**file));
   (*file)->file = apr_file;
+  (*file)->path = path;
   (*file)->is_packed = FALSE;
   (*file)->start_revision = SVN_INVALID_REVNUM;
   (*file)->stream = svn_stream_from_aprfile2(apr_file, TRUE, result_pool);
@@ -290,18 +334,230 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
   return SVN_NO_ERROR;
 }
 
+const char *
+svn_fs_fs__rev_file_mapped(svn_fs_fs__revision_file_t *file,
+                           apr_off_t offset,
+                           apr_size_t size)
+{
+  if (   file->mapped_data
+      && offset >= 0
+      && offset <= file->mapped_size
+      && (apr_off_t)size <= file->mapped_size - offset)
+    return file->mapped_data + offset;
+
+  return NULL;
+}
+
+/* Execute REQUEST against the already open FILE.  BLOCK_SIZE is the
+ * alignment to use for buffered reads;  0 disables alignment.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_request(apr_file_t *file,
+             apr_off_t block_size,
+             svn_fs_fs__read_request_t *request,
+             apr_pool_t *scratch_pool)
+{
+  svn_boolean_t eof;
+
+  if (block_size)
+    SVN_ERR(svn_io_file_aligned_seek(file, block_size, NULL,
+                                     request->offset, scratch_pool));
+  else
+    SVN_ERR(svn_io_file_seek(file, APR_SET, &request->offset,
+                             scratch_pool));
+
+  SVN_ERR(svn_io_file_read_full2(file, request->buffer, request->size,
+                                 &request->read, &eof, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Execute every STRIDE-th request in REQUESTS, starting at FIRST and
+ * stopping at COUNT, against FILE.  BLOCK_SIZE is the alignment to use.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_requests(apr_file_t *file,
+              apr_off_t block_size,
+              svn_fs_fs__read_request_t *requests,
+              int first,
+              int count,
+              int stride,
+              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = first; i < count; i += stride)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_request(file, block_size, &requests[i], iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* One worker's share of an svn_fs_fs__rev_file_read_async() batch:
+ * Every STRIDE-th request in REQUESTS, starting at FIRST.
+ */
+typedef struct read_lane_t
+{
+  /* File to read from and alignment to use. */
+  const char *path;
+  apr_off_t block_size;
+
+  /* All requests of the batch. */
+  svn_fs_fs__read_request_t *requests;
+  int count;
+
+  /* Selection of the requests that belong to this lane. */
+  int first;
+  int stride;
+
+  /* Set if PATH could not be opened again.  The requests of this lane
+   * have not been executed, then. */
+  svn_boolean_t deferred;
+
+  /* Private root pool for this lane with its own allocator. */
+  apr_pool_t *pool;
+} read_lane_t;
+
+/* Implement svn_fs_fs__task_func_t.  Open a private handle for the file
+ * in the read_lane_t given by BATON and execute all its requests.
+ *
+ * The file may have been removed since our caller opened it, e.g. because
+ * its shard got packed.  Since request offsets are only valid within the
+ * file that our caller opened, we can't switch to the pack file but defer
+ * the requests to the caller instead.  Any other failure to open the
+ * file is an error. */
+static svn_error_t *
+read_lane(void *baton)
+{
+  read_lane_t *lane = baton;
+  apr_file_t *file;
+  svn_error_t *err;
+
+  err = svn_io_file_open(&file, lane->path, APR_READ | APR_BUFFERED,
+                         APR_OS_DEFAULT, lane->pool);
+  if (err && (   APR_STATUS_IS_ENOENT(err->apr_err)
+              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+    {
+      svn_error_clear(err);
+      lane->deferred = TRUE;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(read_requests(file, lane->block_size, lane->requests, lane->first,
+                        lane->count, lane->stride, lane->pool));
+
+  return svn_error_trace(svn_io_file_close(file, lane->pool));
+}
+
+svn_error_t *
+svn_fs_fs__rev_file_read_async(svn_fs_fs__revision_file_t *file,
+                               svn_fs_fs__read_request_t *requests,
+                               int count,
+                               int max_in_flight,
+                               apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+  apr_pool_t *batch_pool;
+  void **lanes;
+  int i;
+
+  /* Mapped files don't need any I/O.  Just copy the data. */
+  if (file->mapped_data)
+    {
+      for (i = 0; i < count; ++i)
+        {
+          apr_off_t offset = MIN(requests[i].offset, file->mapped_size);
+          requests[i].read = (apr_size_t)MIN((apr_off_t)requests[i].size,
+                                             file->mapped_size - offset);
+          memcpy(requests[i].buffer, file->mapped_data + offset,
+                 requests[i].read);
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Simple case: no concurrency. */
+  if (max_in_flight < 2 || count < 2 || file->path == NULL)
+    return svn_error_trace(read_requests(file->file, file->block_size,
+                                         requests, 0, count, 1,
+                                         scratch_pool));
+
+  /* Distribute the requests evenly across the lanes.  Each lane has its
+   * own file handle and pool, such that they may run concurrently. */
+  batch_pool = svn_pool_create(scratch_pool);
+  max_in_flight = MIN(max_in_flight, count);
+  lanes = apr_palloc(batch_pool, max_in_flight * sizeof(*lanes));
+  for (i = 0; i < max_in_flight; ++i)
+    {
+      read_lane_t *lane = apr_pcalloc(batch_pool, sizeof(*lane));
+      lane->path = file->path;
+      lane->block_size = file->block_size;
+      lane->requests = requests;
+      lane->count = count;
+      lane->first = i;
+      lane->stride = max_in_flight;
+      lane->pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      lanes[i] = lane;
+    }
+
+  err = svn_fs_fs__run_tasks(read_lane, lanes, max_in_flight, batch_pool);
+
+  /* The lane pools are not sub-pools of BATCH_POOL. */
+  for (i = 0; i < max_in_flight; ++i)
+    svn_pool_destroy(((read_lane_t *)lanes[i])->pool);
+
+  /* Execute whatever the lanes could not do through our own handle. */
+  for (i = 0; i < max_in_flight && !err; ++i)
+    {
+      read_lane_t *lane = lanes[i];
+      if (lane->deferred)
+        err = read_requests(file->file, file->block_size, requests,
+                            lane->first, count, lane->stride, batch_pool);
+    }
+
+  svn_pool_destroy(batch_pool);
+
+  return svn_error_trace(err);
+}
+
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file)
 {
+  svn_error_t *err = SVN_NO_ERROR;
+
+#if APR_HAS_MMAP
+  /* Failing to unmap the file must not keep us from closing it. */
+  if (file->mmap)
+    {
+      apr_status_t status = apr_mmap_delete(file->mmap);
+      if (status)
+        err = svn_error_wrap_apr(status, _("Can't unmap file '%s'"),
+                                 svn_dirent_local_style(file->path,
+                                                        file->pool));
+    }
+#endif
+
+  file->mmap = NULL;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
+
   if (file->stream)
-    SVN_ERR(svn_stream_close(file->stream));
+    err = svn_error_compose_create(err, svn_stream_close(file->stream));
   if (file->file)
-    SVN_ERR(svn_io_file_close(file->file, file->pool));
+    err = svn_error_compose_create(err, svn_io_file_close(file->file,
+                                                          file->pool));
 
   file->file = NULL;
   file->stream = NULL;
   file->l2p_stream = NULL;
   file->p2l_stream = NULL;
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(err);
 }
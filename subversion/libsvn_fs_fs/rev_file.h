@@ -54,6 +54,20 @@ typedef struct svn_fs_fs__revision_file_t
   /* rev / pack file */
   apr_file_t *file;
 
+  /* Absolute path of FILE.  Used to open additional handles for
+   * concurrent reads. */
+  const char *path;
+
+  /* If not NULL, the contents of FILE mapped into memory.  We only map
+   * packed shards because those will never change. */
+  const char *mapped_data;
+
+  /* Number of bytes at MAPPED_DATA.  0 if the file is not mapped. */
+  apr_off_t mapped_size;
+
+  /* The APR mapping object behind MAPPED_DATA or NULL. */
+  struct apr_mmap_t *mmap;
+
   /* stream based on FILE and not NULL exactly when FILE is not NULL */
   svn_stream_t *stream;
 
@@ -137,6 +151,57 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                apr_pool_t* result_pool,
                                apr_pool_t *scratch_pool);
 
+/* If FILE has been mapped into memory and the SIZE bytes starting at
+ * OFFSET lie completely within the mapped range, return a pointer to
+ * them.  Return NULL otherwise.
+ */
+const char *
+svn_fs_fs__rev_file_mapped(svn_fs_fs__revision_file_t *file,
+                           apr_off_t offset,
+                           apr_size_t size);
+
+/* A single positioned read from a rev / pack file, as executed by
+ * svn_fs_fs__rev_file_read_async().
+ */
+typedef struct svn_fs_fs__read_request_t
+{
+  /* Absolute offset within the file to start reading at. */
+  apr_off_t offset;
+
+  /* Number of bytes to read. */
+  apr_size_t size;
+
+  /* Target buffer of at least SIZE bytes.  Provided by the caller. */
+  char *buffer;
+
+  /* Number of bytes actually read.  This may be less than SIZE if the
+   * request reached the end of the file. */
+  apr_size_t read;
+} svn_fs_fs__read_request_t;
+
+/* Execute all COUNT REQUESTS against the rev / pack data in FILE, having
+ * up to MAX_IN_FLIGHT of them executed concurrently.  Return only after
+ * all requests have completed.  Values of MAX_IN_FLIGHT < 2 result in the
+ * requests being executed sequentially through FILE's own handle.
+ *
+ * Concurrent requests use separate file handles, so the current position
+ * of FILE is undefined afterwards in either case.  They run on the FSFS
+ * task threads; there is no native asynchronous I/O backend.
+ *
+ * This only pays off for batches of independent reads that are known
+ * upfront, such as the delta chain prefetch.  Block reads, index lookups
+ * and directory reads each need a single read whose result determines
+ * the next one, so they don't use this function.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__rev_file_read_async(svn_fs_fs__revision_file_t *file,
+                               svn_fs_fs__read_request_t *requests,
+                               int count,
+                               int max_in_flight,
+                               apr_pool_t *scratch_pool);
+
 /* Close all files and streams in FILE.
  */
 svn_error_t *
@@ -213,16 +213,191 @@ svn_fs_fs__reset_revprop_cache(svn_fs_t *fs)
   ffd->revprop_prefix = 0;
 }
 
-/* If FS has not a revprop cache prefix set, generate one.
+/* The revprop generation.
+ *
+ * Revprops may be changed at any time by any process.  Without further
+ * information, cached revprops can therefore only be trusted until the
+ * next sync barrier, i.e. until the caller asks for a refresh.  Bulk
+ * operations like "svn log" served by many short-lived server processes
+ * would keep re-reading and re-parsing the same revprop packs.
+ *
+ * If the PATH_REVPROP_GENERATION file exists, it contains a decimal
+ * counter that every revprop writer advances to the next odd number before
+ * and to the next even number after changing any revprop.  The file gets
+ * replaced atomically.  Readers re-read it at every sync barrier.  Cache
+ * entries are keyed by the generation, which makes them valid across sync
+ * barriers and - with a shared membuffer cache - across all processes on
+ * the host until the next revprop change.  While the generation is odd,
+ * the cache will not be used at all.
+ *
+ * Writers from Subversion versions that don't know about this file will
+ * not update it.  So, it only gets created for repositories of format
+ * SVN_FS_FS__MIN_REVPROP_GENERATION_FORMAT or later, which older servers
+ * can't write to.  An interrupted revprop change leaves the generation
+ * odd, which disables the cache until the next revprop change or until
+ * svnadmin recover repairs it.
+ */
+
+/* Set *GENERATION to the current revprop generation of FS as stored on
+ * disk.  Return -1, if FS has no revprop generation file.  Use
+ * SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+read_revprop_generation(apr_int64_t *generation,
+                        svn_fs_t *fs,
+                        apr_pool_t *scratch_pool)
+{
+  const char *path = svn_fs_fs__path_revprop_generation(fs, scratch_pool);
+  svn_stringbuf_t *content = NULL;
+  svn_boolean_t missing = FALSE;
+  svn_error_t *err;
+  int i;
+
+  for (i = 0;
+       !content && !missing && (i < SVN_FS_FS__RECOVERABLE_RETRY_COUNT);
+       ++i)
+    SVN_ERR(svn_fs_fs__try_stringbuf_from_file(&content, &missing, path,
+                              i + 1 < SVN_FS_FS__RECOVERABLE_RETRY_COUNT,
+                              scratch_pool));
+
+  if (!content)
+    {
+      *generation = -1;
+      return SVN_NO_ERROR;
+    }
+
+  svn_stringbuf_strip_whitespace(content);
+  err = svn_cstring_atoi64(generation, content->data);
+  if (!err && *generation < 0)
+    err = svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL, NULL);
+  if (err)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, err,
+                             _("Revprop generation file '%s' is corrupt"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Atomically replace the revprop generation of FS with GENERATION and
+ * flush it to disk.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+write_revprop_generation(svn_fs_t *fs,
+                         apr_int64_t generation,
+                         apr_pool_t *scratch_pool)
+{
+  char buf[SVN_INT64_BUFFER_SIZE];
+  apr_size_t len = svn__i64toa(buf, generation);
+  buf[len] = '\n';
+
+  SVN_ERR(svn_io_write_atomic2(svn_fs_fs__path_revprop_generation(
+                                 fs, scratch_pool),
+                               buf, len + 1,
+                               svn_fs_fs__path_current(fs, scratch_pool),
+                               TRUE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Advance the revprop generation of FS to the next odd number, if
+ * STARTING is set, and to the next even number otherwise.  Create the
+ * generation file if it does not exist and CREATE is set; otherwise,
+ * do nothing in that case.  Use SCRATCH_POOL for temporaries.
+ *
+ * The caller must hold the FS write lock.
+ */
+static svn_error_t *
+bump_revprop_generation(svn_fs_t *fs,
+                        svn_boolean_t starting,
+                        svn_boolean_t create,
+                        apr_pool_t *scratch_pool)
+{
+  apr_int64_t generation;
+
+  SVN_ERR(read_revprop_generation(&generation, fs, scratch_pool));
+  if (generation < 0)
+    {
+      if (!create)
+        return SVN_NO_ERROR;
+
+      generation = 0;
+    }
+
+  if (starting)
+    generation += (generation & 1) ? 2 : 1;
+  else
+    generation += (generation & 1) ? 1 : 2;
+
+  return svn_error_trace(write_revprop_generation(fs, generation,
+                                                  scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__bump_revprop_generation(svn_fs_t *fs,
+                                   apr_pool_t *scratch_pool)
+{
+  SVN_ERR(bump_revprop_generation(fs, TRUE, FALSE, scratch_pool));
+  SVN_ERR(bump_revprop_generation(fs, FALSE, FALSE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__repair_revprop_generation(svn_fs_t *fs,
+                                     apr_pool_t *scratch_pool)
+{
+  apr_int64_t generation;
+
+  /* With the write lock being held, an odd generation can only be the
+   * result of an interrupted revprop change. */
+  SVN_ERR(read_revprop_generation(&generation, fs, scratch_pool));
+  if (generation >= 0 && (generation & 1))
+    SVN_ERR(bump_revprop_generation(fs, FALSE, FALSE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the revprop cache prefix of FS for the current revprop generation
+ * or, if FS has no generation file, generate one if none has been set.
+ * If REFRESH is set, the caller just crossed a sync barrier.  Set
+ * *USE_CACHE to FALSE, if the cache must not be used right now.
  * Always call this before accessing the revprop cache.
  */
 static svn_error_t *
-prepare_revprop_cache(svn_fs_t *fs,
+prepare_revprop_cache(svn_boolean_t *use_cache,
+                      svn_fs_t *fs,
+                      svn_boolean_t refresh,
                       apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  if (!ffd->revprop_prefix)
-    SVN_ERR(svn_atomic__unique_counter(&ffd->revprop_prefix));
+
+  /* Previous cache contents may be invalid after a sync barrier. */
+  if (refresh || !ffd->revprop_prefix)
+    {
+      SVN_ERR(read_revprop_generation(&ffd->revprop_generation, fs,
+                                      scratch_pool));
+
+      /* Set the top bit to keep these prefixes apart from the
+       * process-local ones. */
+      if (ffd->revprop_generation >= 0)
+        ffd->revprop_prefix = (apr_uint64_t)ffd->revprop_generation
+                            | APR_UINT64_C(0x8000000000000000);
+      else
+        SVN_ERR(svn_atomic__unique_counter(&ffd->revprop_prefix));
+    }
+
+  if (ffd->revprop_generation >= 0)
+    {
+      *use_cache = (ffd->revprop_generation & 1) == 0;
+    }
+  else
+    {
+      /* Only populate the cache if we did not just cross a sync barrier.
+       * This is to eliminate overhead from code that always sets REFRESH.
+       * For callers that want caching, the caching kicks in on read
+       * "later". */
+      *use_cache = !refresh;
+    }
 
   return SVN_NO_ERROR;
 }
@@ -647,11 +822,7 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
                                  apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-
-  /* Only populate the cache if we did not just cross a sync barrier.
-   * This is to eliminate overhead from code that always sets REFRESH.
-   * For callers that want caching, the caching kicks in on read "later". */
-  svn_boolean_t populate_cache = !refresh;
+  svn_boolean_t populate_cache;
 
   /* not found, yet */
   *proplist_p = NULL;
@@ -659,19 +830,14 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
   /* should they be available at all? */
   SVN_ERR(svn_fs_fs__ensure_revision_exists(rev, fs, scratch_pool));
 
-  if (refresh)
-    {
-      /* Previous cache contents is invalid now. */
-      svn_fs_fs__reset_revprop_cache(fs);
-    }
-  else
+  /* Select the prefix and find out whether we may use the cache. */
+  SVN_ERR(prepare_revprop_cache(&populate_cache, fs, refresh, scratch_pool));
+  if (populate_cache)
     {
       /* Try cache lookup first. */
       svn_boolean_t is_cached;
       pair_cache_key_t key;
 
-      /* Auto-alloc prefix and construct the key. */
-      SVN_ERR(prepare_revprop_cache(fs, scratch_pool));
       key.revision = rev;
       key.second = ffd->revprop_prefix;
 
@@ -1131,6 +1297,10 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
   const char *tmp_path;
   const char *perms_reference;
   apr_array_header_t *files_to_delete = NULL;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t create_generation
+    = ffd->format >= SVN_FS_FS__MIN_REVPROP_GENERATION_FORMAT;
+  svn_error_t *err;
 
   SVN_ERR(svn_fs_fs__ensure_revision_exists(rev, fs, pool));
 
@@ -1155,11 +1325,18 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
    */
   perms_reference = svn_fs_fs__path_rev_absolute(fs, rev, pool);
 
-  /* Now, switch to the new revprop data. */
-  SVN_ERR(switch_to_new_revprop(fs, final_path, tmp_path, perms_reference,
-                                files_to_delete, pool));
-
-  return SVN_NO_ERROR;
+  /* Now, switch to the new revprop data.  Tell all other processes that
+   * their cached revprops will no longer be valid.  Even if the switch
+   * fails, some of the files may have been changed already. */
+  SVN_ERR(bump_revprop_generation(fs, TRUE, create_generation, pool));
+  err = switch_to_new_revprop(fs, final_path, tmp_path, perms_reference,
+                              files_to_delete, pool);
+  err = svn_error_compose_create(err,
+                                 bump_revprop_generation(fs, FALSE,
+                                                         create_generation,
+                                                         pool));
+
+  return svn_error_trace(err);
 }
 
 /* Return TRUE, if for REVISION in FS, we can find the revprop pack file.
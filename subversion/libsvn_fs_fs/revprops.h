@@ -62,6 +62,23 @@ svn_fs_fs__upgrade_cleanup_pack_revprops(svn_fs_t *fs,
 void
 svn_fs_fs__reset_revprop_cache(svn_fs_t *fs);
 
+/* If FS has a revprop generation file, advance the generation such that
+ * all processes will discard their cached revprops of FS.  The caller
+ * must hold the FS write lock.  Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__bump_revprop_generation(svn_fs_t *fs,
+                                   apr_pool_t *scratch_pool);
+
+/* If the revprop generation of FS is odd, i.e. a revprop change has been
+ * interrupted, make it even again, so that readers can use their revprop
+ * caches.  The caller must hold the FS write lock.  Use SCRATCH_POOL for
+ * temporaries.
+ */
+svn_error_t *
+svn_fs_fs__repair_revprop_generation(svn_fs_t *fs,
+                                     apr_pool_t *scratch_pool);
+
 /* Read the revprops for revision REV in FS and return them in *PROPERTIES_P.
  * If REFRESH is set, clear the revprop cache before accessing the data.
  *
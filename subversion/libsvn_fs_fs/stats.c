@@ -25,7 +25,9 @@
 #include "svn_pools.h"
 #include "svn_sorts.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_cache.h"
+#include "private/svn_packed_data.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_fs_fs_private.h"
@@ -37,6 +39,7 @@
 #include "fs_fs.h"
 #include "cached_data.h"
 #include "low_level.h"
+#include "tasks.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
@@ -123,6 +126,17 @@ typedef struct rep_ref_t
 
 } rep_ref_t;
 
+/* A noderev references a representation in a rev / pack file that has
+ * been scanned before the current one.  We only need to count these. */
+typedef struct external_ref_t
+{
+  /* Revision that contains the representation. */
+  svn_revnum_t revision;
+
+  /* Item index of the rep within REVISION. */
+  apr_uint64_t item_index;
+} external_ref_t;
+
 /* Represents a single revision.
  * There will be only one instance per revision. */
 typedef struct revision_info_t
@@ -173,6 +187,11 @@ typedef struct query_t
   /* FS API object*/
   svn_fs_t *fs;
 
+  /* First revision in REVISIONS.  0 for the query covering the whole
+   * repository, the first revision of the respective rev / pack file for
+   * the queries used to scan a single file. */
+  svn_revnum_t first_revision;
+
   /* The HEAD revision. */
   svn_revnum_t head;
 
@@ -182,9 +201,21 @@ typedef struct query_t
   /* First non-packed revision. */
   svn_revnum_t min_unpacked_rev;
 
-  /* all revisions */
+  /* all revisions, starting at FIRST_REVISION */
   apr_array_header_t *revisions;
 
+  /* Delta chain links found while scanning rev / pack files in log.
+   * addressing mode.  They get resolved once all base representations
+   * are known.  Elements are rep_ref_t *. */
+  apr_array_header_t *rep_refs;
+
+  /* References from noderevs to representations in revisions before
+   * FIRST_REVISION.  Elements are external_ref_t *. */
+  apr_array_header_t *external_refs;
+
+  /* Directory to keep the per-shard snapshots in.  NULL if disabled. */
+  const char *snapshot_dir;
+
   /* empty representation.
    * Used as a dummy base for DELTA reps without base. */
   rep_stats_t *null_base;
@@ -255,20 +286,32 @@ add_to_histogram(svn_fs_fs__histogram_t *histogram,
   histogram->lines[(apr_size_t)shift].sum += size;
 }
 
-/* Update data aggregators in STATS with this representation of type KIND,
- * on-disk REP_SIZE and expanded node size EXPANDED_SIZE for PATH in REVSION.
- * PLAIN_ADDED indicates whether the node has a deltification predecessor.
+/* Add all entries of SOURCE to HISTOGRAM.
  */
 static void
-add_change(svn_fs_fs__stats_t *stats,
-           apr_uint64_t rep_size,
-           apr_uint64_t expanded_size,
-           svn_revnum_t revision,
-           const char *path,
-           rep_kind_t kind,
-           svn_boolean_t plain_added)
+merge_histogram(svn_fs_fs__histogram_t *histogram,
+                const svn_fs_fs__histogram_t *source)
+{
+  apr_size_t i;
+
+  histogram->total.count += source->total.count;
+  histogram->total.sum += source->total.sum;
+  for (i = 0; i < sizeof(histogram->lines) / sizeof(histogram->lines[0]); ++i)
+    {
+      histogram->lines[i].count += source->lines[i].count;
+      histogram->lines[i].sum += source->lines[i].sum;
+    }
+}
+
+/* Add the representation of REP_SIZE for PATH in REVISION to the list of
+ * largest changes in STATS, if it is large enough.
+ */
+static void
+add_largest_change(svn_fs_fs__stats_t *stats,
+                   apr_uint64_t rep_size,
+                   svn_revnum_t revision,
+                   const char *path)
 {
-  /* identify largest reps */
   if (rep_size >= stats->largest_changes->min_size)
     {
       apr_size_t i;
@@ -291,6 +334,46 @@ add_change(svn_fs_fs__stats_t *stats,
       largest_changes->min_size
         = largest_changes->changes[largest_changes->count-1]->size;
     }
+}
+
+/* Return the per-extension info for EXTENSION in STATS.  Auto-create it
+ * if necessary.
+ */
+static svn_fs_fs__extension_info_t *
+get_extension_info(svn_fs_fs__stats_t *stats,
+                   const char *extension)
+{
+  svn_fs_fs__extension_info_t *info
+    = apr_hash_get(stats->by_extension, extension, APR_HASH_KEY_STRING);
+
+  if (info == NULL)
+    {
+      apr_pool_t *pool = apr_hash_pool_get(stats->by_extension);
+      info = apr_pcalloc(pool, sizeof(*info));
+      info->extension = apr_pstrdup(pool, extension);
+
+      apr_hash_set(stats->by_extension, info->extension,
+                   APR_HASH_KEY_STRING, info);
+    }
+
+  return info;
+}
+
+/* Update data aggregators in STATS with this representation of type KIND,
+ * on-disk REP_SIZE and expanded node size EXPANDED_SIZE for PATH in REVSION.
+ * PLAIN_ADDED indicates whether the node has a deltification predecessor.
+ */
+static void
+add_change(svn_fs_fs__stats_t *stats,
+           apr_uint64_t rep_size,
+           apr_uint64_t expanded_size,
+           svn_revnum_t revision,
+           const char *path,
+           rep_kind_t kind,
+           svn_boolean_t plain_added)
+{
+  /* identify largest reps */
+  add_largest_change(stats, rep_size, revision, path);
 
   /* global histograms */
   add_to_histogram(&stats->rep_size_histogram, rep_size);
@@ -338,16 +421,7 @@ add_change(svn_fs_fs__stats_t *stats,
         extension = "(none)";
 
       /* get / auto-insert entry for this extension */
-      info = apr_hash_get(stats->by_extension, extension, APR_HASH_KEY_STRING);
-      if (info == NULL)
-        {
-          apr_pool_t *pool = apr_hash_pool_get(stats->by_extension);
-          info = apr_pcalloc(pool, sizeof(*info));
-          info->extension = apr_pstrdup(pool, extension);
-
-          apr_hash_set(stats->by_extension, info->extension,
-                       APR_HASH_KEY_STRING, info);
-        }
+      info = get_extension_info(stats, extension);
 
       /* update per-extension histogram */
       add_to_histogram(&info->node_histogram, expanded_size);
@@ -393,7 +467,9 @@ find_representation(int *idx,
   info = revision_info ? *revision_info : NULL;
   if (info == NULL || info->revision != revision)
     {
-      info = APR_ARRAY_IDX(query->revisions, revision, revision_info_t*);
+      info = APR_ARRAY_IDX(query->revisions,
+                           revision - query->first_revision,
+                           revision_info_t*);
       if (revision_info)
         *revision_info = info;
     }
@@ -420,7 +496,8 @@ find_representation(int *idx,
 }
 
 /* Find / auto-construct the representation stats for REP in QUERY and
- * return it in *REPRESENTATION.
+ * return it in *REPRESENTATION.  If REP has been scanned as part of an
+ * earlier rev / pack file, record the reference in QUERY and return NULL.
  *
  * If necessary, allocate the result in RESULT_POOL; use SCRATCH_POOL for
  * temporary allocations.
@@ -438,6 +515,20 @@ parse_representation(rep_stats_t **representation,
 
   /* read location (revision, offset) and size */
 
+  /* representations outside the current scope will be counted later */
+  if (rep->revision < query->first_revision)
+    {
+      /* Only needed until the results get merged. */
+      external_ref_t *ref = apr_palloc(query->external_refs->pool,
+                                       sizeof(*ref));
+      ref->revision = rep->revision;
+      ref->item_index = rep->item_index;
+      APR_ARRAY_PUSH(query->external_refs, external_ref_t *) = ref;
+
+      *representation = NULL;
+      return SVN_NO_ERROR;
+    }
+
   /* look it up */
   result = find_representation(&idx, query, &revision_info, rep->revision,
                                rep->item_index);
@@ -625,7 +716,7 @@ read_noderev(query_t *query,
                                    result_pool, scratch_pool));
 
       /* if we are the first to use this rep, mark it as "text rep" */
-      if (++text->ref_count == 1)
+      if (text && ++text->ref_count == 1)
         text->kind = noderev->kind == svn_node_dir ? dir_rep : file_rep;
     }
 
@@ -636,7 +727,7 @@ read_noderev(query_t *query,
                                    result_pool, scratch_pool));
 
       /* if we are the first to use this rep, mark it as "prop rep" */
-      if (++props->ref_count == 1)
+      if (props && ++props->ref_count == 1)
         props->kind = noderev->kind == svn_node_dir ? dir_property_rep
                                                     : file_property_rep;
     }
@@ -979,7 +1070,8 @@ resolve_representation_refs(query_t *query,
 }
 
 /* Process the logically addressed revision contents of revisions BASE to
- * BASE + COUNT - 1 in QUERY.
+ * BASE + COUNT - 1 in QUERY.  The delta chain links found will be added
+ * to QUERY's REP_REFS and need to be resolved by the caller.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
@@ -998,12 +1090,6 @@ read_log_rev_or_packfile(query_t *query,
   int i;
   svn_fs_fs__revision_file_t *rev_file;
 
-  /* We collect the delta chain links as we scan the file.  Afterwards,
-   * we determine the lengths of those delta chains and throw this
-   * temporary container away. */
-  apr_array_header_t *rep_refs = apr_array_make(scratch_pool, 64,
-                                                sizeof(rep_ref_t *));
-
   /* we will process every revision in the rev / pack file */
   for (i = 0; i < count; ++i)
     {
@@ -1024,7 +1110,8 @@ read_log_rev_or_packfile(query_t *query,
 
   /* record the whole pack size in the first rev so the total sum will
      still be correct */
-  APR_ARRAY_IDX(query->revisions, base, revision_info_t*)->end = max_offset;
+  APR_ARRAY_IDX(query->revisions, base - query->first_revision,
+                revision_info_t*)->end = max_offset;
 
   /* for all offsets in the file, get the P2L index entries and process
      the interesting items (change lists, noderevs) */
@@ -1060,8 +1147,13 @@ read_log_rev_or_packfile(query_t *query,
             continue;
 
           /* read and process interesting items */
-          info = APR_ARRAY_IDX(query->revisions, entry->item.revision,
-                               revision_info_t*);
+          if (   entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV
+              || entry->type == SVN_FS_FS__ITEM_TYPE_CHANGES)
+            info = APR_ARRAY_IDX(query->revisions,
+                                 entry->item.revision - query->first_revision,
+                                 revision_info_t*);
+          else
+            info = NULL;
 
           if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
             {
@@ -1080,9 +1172,11 @@ read_log_rev_or_packfile(query_t *query,
                    || (entry->type == SVN_FS_FS__ITEM_TYPE_FILE_PROPS)
                    || (entry->type == SVN_FS_FS__ITEM_TYPE_DIR_PROPS))
             {
-              /* Collect the delta chain link. */
+              /* Collect the delta chain link.  It is only needed until
+               * the results get merged. */
               svn_fs_fs__rep_header_t *header;
-              rep_ref_t *ref = apr_pcalloc(scratch_pool, sizeof(*ref));
+              rep_ref_t *ref = apr_pcalloc(query->rep_refs->pool,
+                                           sizeof(*ref));
 
               SVN_ERR(svn_io_file_aligned_seek(rev_file->file,
                                                rev_file->block_size,
@@ -1107,7 +1201,7 @@ read_log_rev_or_packfile(query_t *query,
                   ref->base_revision = SVN_INVALID_REVNUM;
                 }
 
-              APR_ARRAY_PUSH(rep_refs, rep_ref_t *) = ref;
+              APR_ARRAY_PUSH(query->rep_refs, rep_ref_t *) = ref;
             }
 
           /* advance offset */
@@ -1115,101 +1209,868 @@ read_log_rev_or_packfile(query_t *query,
         }
     }
 
-  /* Resolve the delta chain links. */
-  SVN_ERR(resolve_representation_refs(query, rep_refs));
-
   /* clean up and close file handles */
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
-/* Read the content of the pack file staring at revision BASE logical
- * addressing mode and store it in QUERY.
- *
- * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
- * temporaries.
+/* Return a new svn_fs_fs__stats_t instance, allocated in RESULT_POOL.
+ */
+static svn_fs_fs__stats_t *
+create_stats(apr_pool_t *result_pool)
+{
+  svn_fs_fs__stats_t *stats = apr_pcalloc(result_pool, sizeof(*stats));
+
+  initialize_largest_changes(stats, 64, result_pool);
+  stats->by_extension = apr_hash_make(result_pool);
+
+  return stats;
+}
+
+/* Number of histograms in svn_fs_fs__stats_t that are being filled by
+ * add_change.
+ */
+#define HISTOGRAM_COUNT 13
+
+/* Set the HISTOGRAM_COUNT elements of HISTOGRAMS to the histograms in
+ * STATS that add_change updates.
+ */
+static void
+get_histograms(svn_fs_fs__histogram_t *histograms[HISTOGRAM_COUNT],
+               svn_fs_fs__stats_t *stats)
+{
+  histograms[0] = &stats->rep_size_histogram;
+  histograms[1] = &stats->node_size_histogram;
+  histograms[2] = &stats->added_rep_size_histogram;
+  histograms[3] = &stats->added_node_size_histogram;
+  histograms[4] = &stats->unused_rep_histogram;
+  histograms[5] = &stats->file_histogram;
+  histograms[6] = &stats->file_rep_histogram;
+  histograms[7] = &stats->file_prop_histogram;
+  histograms[8] = &stats->file_prop_rep_histogram;
+  histograms[9] = &stats->dir_histogram;
+  histograms[10] = &stats->dir_rep_histogram;
+  histograms[11] = &stats->dir_prop_histogram;
+  histograms[12] = &stats->dir_prop_rep_histogram;
+}
+
+/* Add everything that add_change recorded in SOURCE to STATS.
+ */
+static void
+merge_stats(svn_fs_fs__stats_t *stats,
+            svn_fs_fs__stats_t *source)
+{
+  svn_fs_fs__histogram_t *histograms[HISTOGRAM_COUNT];
+  svn_fs_fs__histogram_t *source_histograms[HISTOGRAM_COUNT];
+  svn_fs_fs__largest_changes_t *largest_changes = source->largest_changes;
+  apr_hash_index_t *hi;
+  apr_size_t i;
+
+  get_histograms(histograms, stats);
+  get_histograms(source_histograms, source);
+  for (i = 0; i < HISTOGRAM_COUNT; ++i)
+    merge_histogram(histograms[i], source_histograms[i]);
+
+  /* SOURCE's list is sorted by size, so this keeps the original order
+   * between changes of the same size. */
+  for (i = 0; i < largest_changes->count; ++i)
+    {
+      svn_fs_fs__large_change_info_t *info = largest_changes->changes[i];
+      if (SVN_IS_VALID_REVNUM(info->revision))
+        add_largest_change(stats, info->size, info->revision,
+                           info->path->data);
+    }
+
+  for (hi = apr_hash_first(NULL, source->by_extension);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_fs_fs__extension_info_t *source_info = apr_hash_this_val(hi);
+      svn_fs_fs__extension_info_t *info
+        = get_extension_info(stats, source_info->extension);
+
+      merge_histogram(&info->rep_histogram, &source_info->rep_histogram);
+      merge_histogram(&info->node_histogram, &source_info->node_histogram);
+    }
+}
+
+/* A rev / pack file in log. addressing mode together with the results
+ * of scanning it.
+ */
+typedef struct file_unit_t
+{
+  /* First revision and number of revisions in that file. */
+  svn_revnum_t base;
+  int count;
+
+  /* Query object for this file only.  Its REVISIONS and their contents
+   * are allocated in POOL and will be moved over to the global query.
+   * Everything else lives in TEMP_POOL and can be dropped after that. */
+  query_t *query;
+  apr_pool_t *pool;
+  apr_pool_t *temp_pool;
+
+  /* Whether QUERY has been filled from a snapshot instead of scanning
+   * the file. */
+  svn_boolean_t from_snapshot;
+
+  /* Outcome of the scan. */
+  svn_error_t *err;
+} file_unit_t;
+
+/* Initialize UNIT for the rev / pack file starting at BASE with COUNT
+ * revisions, based on the global QUERY.  Allocate the data that will
+ * outlive the merge into QUERY in RESULT_POOL.
+ */
+static void
+init_file_unit(file_unit_t *unit,
+               query_t *query,
+               svn_revnum_t base,
+               int count,
+               apr_pool_t *result_pool)
+{
+  query_t *file_query;
+
+  unit->base = base;
+  unit->count = count;
+  unit->pool = svn_pool_create(result_pool);
+  unit->temp_pool = svn_pool_create(unit->pool);
+  unit->from_snapshot = FALSE;
+  unit->err = SVN_NO_ERROR;
+
+  /* Same repository and parameters, but separate result containers. */
+  file_query = apr_pmemdup(unit->pool, query, sizeof(*query));
+  file_query->first_revision = base;
+  file_query->revisions = apr_array_make(unit->pool, count,
+                                         sizeof(revision_info_t *));
+  file_query->rep_refs = apr_array_make(unit->temp_pool, 64,
+                                        sizeof(rep_ref_t *));
+  file_query->external_refs = apr_array_make(unit->temp_pool, 16,
+                                             sizeof(external_ref_t *));
+  file_query->stats = create_stats(unit->temp_pool);
+  file_query->progress_func = NULL;
+  file_query->progress_baton = NULL;
+  file_query->snapshot_dir = NULL;
+
+  unit->query = file_query;
+}
+
+/* Scan the rev / pack file described by UNIT in FS and store the results
+ * in UNIT.  Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
-read_log_pack_file(query_t *query,
-                   svn_revnum_t base,
-                   apr_pool_t *result_pool,
-                   apr_pool_t *scratch_pool)
+scan_file(file_unit_t *unit,
+          svn_fs_t *fs,
+          apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, base, query->shard_size,
-                                   result_pool, scratch_pool));
+  svn_fs_t *query_fs = unit->query->fs;
+  svn_error_t *err;
 
-  /* one more pack file processed */
+  unit->query->fs = fs;
+  err = read_log_rev_or_packfile(unit->query, unit->base, unit->count,
+                                 unit->pool, scratch_pool);
+  unit->query->fs = query_fs;
+
+  return svn_error_trace(err);
+}
+
+/* Version number of the snapshot file format. */
+#define SNAPSHOT_FORMAT 3
+
+/* Last integer in every snapshot file.  Reading beyond the end of a
+ * packed stream silently returns 0, so this is how we detect truncated
+ * or otherwise inconsistent snapshots. */
+#define SNAPSHOT_END 0x736e6170
+
+/* Return the path of the snapshot file for the pack file of QUERY starting
+ * at revision BASE.  Allocate the result in RESULT_POOL.
+ */
+static const char *
+snapshot_path(query_t *query,
+              svn_revnum_t base,
+              apr_pool_t *result_pool)
+{
+  return svn_dirent_join(query->snapshot_dir,
+                         apr_psprintf(result_pool, "%ld.stats",
+                                      base / query->shard_size),
+                         result_pool);
+}
+
+/* Set *SIZE and *MTIME to the size and modification time of the pack
+ * file of QUERY starting at revision BASE.  Snapshots record these to
+ * detect pack files that got replaced, e.g. by restoring a backup or
+ * by 'svnadmin load' into a repository with the same UUID.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_pack_stamp(apr_uint64_t *size,
+               apr_uint64_t *mtime,
+               query_t *query,
+               svn_revnum_t base,
+               apr_pool_t *scratch_pool)
+{
+  const svn_io_dirent2_t *dirent;
+  const char *path = svn_fs_fs__path_rev_packed(query->fs, base,
+                                                PATH_PACKED, scratch_pool);
+
+  SVN_ERR(svn_io_stat_dirent2(&dirent, path, FALSE, FALSE,
+                              scratch_pool, scratch_pool));
+  *size = (apr_uint64_t)dirent->filesize;
+  *mtime = (apr_uint64_t)dirent->mtime;
+
+  return SVN_NO_ERROR;
+}
+
+/* Append the contents of HISTOGRAM to INTS.
+ */
+static void
+write_histogram(svn_packed__int_stream_t *ints,
+                const svn_fs_fs__histogram_t *histogram)
+{
+  apr_size_t i;
+
+  svn_packed__add_uint(ints, histogram->total.count);
+  svn_packed__add_uint(ints, histogram->total.sum);
+  for (i = 0; i < sizeof(histogram->lines) / sizeof(histogram->lines[0]); ++i)
+    {
+      svn_packed__add_uint(ints, histogram->lines[i].count);
+      svn_packed__add_uint(ints, histogram->lines[i].sum);
+    }
+}
+
+/* Read the contents of HISTOGRAM from INTS.
+ */
+static void
+read_histogram(svn_fs_fs__histogram_t *histogram,
+               svn_packed__int_stream_t *ints)
+{
+  apr_size_t i;
+
+  histogram->total.count = svn_packed__get_uint(ints);
+  histogram->total.sum = svn_packed__get_uint(ints);
+  for (i = 0; i < sizeof(histogram->lines) / sizeof(histogram->lines[0]); ++i)
+    {
+      histogram->lines[i].count = svn_packed__get_uint(ints);
+      histogram->lines[i].sum = svn_packed__get_uint(ints);
+    }
+}
+
+/* Write the results for the pack file in UNIT to its snapshot file.
+ * This must be called right after merging them into QUERY, i.e. before
+ * any later revision could have referenced UNIT's representations.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_snapshot(query_t *query,
+               file_unit_t *unit,
+               apr_pool_t *scratch_pool)
+{
+  query_t *file_query = unit->query;
+  svn_fs_fs__stats_t *stats = file_query->stats;
+  svn_fs_fs__histogram_t *histograms[HISTOGRAM_COUNT];
+  svn_packed__data_root_t *root = svn_packed__data_create_root(scratch_pool);
+  svn_packed__int_stream_t *ints
+    = svn_packed__create_int_stream(root, FALSE, FALSE);
+  svn_packed__byte_stream_t *strings = svn_packed__create_bytes_stream(root);
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(scratch_pool);
+  svn_fs_fs__large_change_info_t **changes;
+  apr_hash_index_t *hi;
+  apr_uint64_t size, mtime;
+  apr_size_t count;
+  apr_size_t i;
+  int k;
+
+  /* Identify the pack file. */
+  SVN_ERR(get_pack_stamp(&size, &mtime, query, unit->base, scratch_pool));
+  svn_packed__add_uint(ints, SNAPSHOT_FORMAT);
+  svn_packed__add_uint(ints, unit->base);
+  svn_packed__add_uint(ints, unit->count);
+  svn_packed__add_uint(ints, size);
+  svn_packed__add_uint(ints, mtime);
+  svn_packed__add_bytes(strings, query->fs->uuid, strlen(query->fs->uuid));
+
+  /* Revisions and the representations in them. */
+  for (k = 0; k < file_query->revisions->nelts; ++k)
+    {
+      revision_info_t *info = APR_ARRAY_IDX(file_query->revisions, k,
+                                            revision_info_t *);
+      int r;
+
+      svn_packed__add_uint(ints, info->offset);
+      svn_packed__add_uint(ints, info->end);
+      svn_packed__add_uint(ints, info->changes_len);
+      svn_packed__add_uint(ints, info->change_count);
+      svn_packed__add_uint(ints, info->dir_noderev_count);
+      svn_packed__add_uint(ints, info->file_noderev_count);
+      svn_packed__add_uint(ints, info->dir_noderev_size);
+      svn_packed__add_uint(ints, info->file_noderev_size);
+
+      svn_packed__add_uint(ints, info->representations->nelts);
+      for (r = 0; r < info->representations->nelts; ++r)
+        {
+          rep_stats_t *rep = APR_ARRAY_IDX(info->representations, r,
+                                           rep_stats_t *);
+
+          svn_packed__add_uint(ints, rep->item_index);
+          svn_packed__add_uint(ints, rep->size);
+          svn_packed__add_uint(ints, rep->expanded_size);
+          svn_packed__add_uint(ints, rep->ref_count);
+          svn_packed__add_uint(ints, rep->header_size);
+          svn_packed__add_uint(ints, rep->kind);
+          svn_packed__add_uint(ints, rep->chain_length);
+        }
+    }
+
+  /* References to older representations. */
+  svn_packed__add_uint(ints, file_query->external_refs->nelts);
+  for (k = 0; k < file_query->external_refs->nelts; ++k)
+    {
+      external_ref_t *ref = APR_ARRAY_IDX(file_query->external_refs, k,
+                                          external_ref_t *);
+
+      svn_packed__add_uint(ints, ref->revision);
+      svn_packed__add_uint(ints, ref->item_index);
+    }
+
+  /* Whatever add_change recorded. */
+  get_histograms(histograms, stats);
+  for (i = 0; i < HISTOGRAM_COUNT; ++i)
+    write_histogram(ints, histograms[i]);
+
+  changes = stats->largest_changes->changes;
+  for (count = 0; count < stats->largest_changes->count; ++count)
+    if (!SVN_IS_VALID_REVNUM(changes[count]->revision))
+      break;
+
+  svn_packed__add_uint(ints, count);
+  for (i = 0; i < count; ++i)
+    {
+      svn_fs_fs__large_change_info_t *info = changes[i];
+
+      svn_packed__add_uint(ints, info->size);
+      svn_packed__add_uint(ints, info->revision);
+      svn_packed__add_bytes(strings, info->path->data, info->path->len);
+    }
+
+  svn_packed__add_uint(ints, apr_hash_count(stats->by_extension));
+  for (hi = apr_hash_first(scratch_pool, stats->by_extension);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_fs_fs__extension_info_t *info = apr_hash_this_val(hi);
+
+      svn_packed__add_bytes(strings, info->extension,
+                            strlen(info->extension));
+      write_histogram(ints, &info->rep_histogram);
+      write_histogram(ints, &info->node_histogram);
+    }
+
+  svn_packed__add_uint(ints, SNAPSHOT_END);
+
+  SVN_ERR(svn_packed__data_write(svn_stream_from_stringbuf(buffer,
+                                                           scratch_pool),
+                                 root, scratch_pool));
+
+  return svn_error_trace(svn_io_write_atomic2(snapshot_path(query,
+                                                            unit->base,
+                                                            scratch_pool),
+                                              buffer->data, buffer->len,
+                                              NULL, FALSE, scratch_pool));
+}
+
+/* Drop everything that has been read into UNIT from an unusable snapshot
+ * and prepare it for scanning its pack file in QUERY instead.
+ */
+static void
+discard_snapshot(query_t *query,
+                 file_unit_t *unit)
+{
+  apr_pool_t *result_pool = apr_pool_parent_get(unit->pool);
+
+  svn_pool_destroy(unit->pool);
+  init_file_unit(unit, query, unit->base, unit->count, result_pool);
+}
+
+/* Return TRUE, if INTS has fewer numbers left than COUNT items of
+ * ITEM_SIZE numbers each take, i.e. if we would read beyond the end of
+ * a truncated snapshot. */
+static svn_boolean_t
+snapshot_truncated(svn_packed__int_stream_t *ints,
+                   apr_uint64_t count,
+                   apr_size_t item_size)
+{
+  return count > svn_packed__int_count(ints) / item_size;
+}
+
+/* Fill UNIT for a pack file in QUERY from its snapshot file.  Set *FOUND
+ * to TRUE if there was a suitable snapshot and to FALSE otherwise.  In the
+ * latter case, UNIT remains empty.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_snapshot(svn_boolean_t *found,
+              query_t *query,
+              file_unit_t *unit,
+              apr_pool_t *scratch_pool)
+{
+  query_t *file_query = unit->query;
+  svn_fs_fs__stats_t *stats = file_query->stats;
+  svn_fs_fs__histogram_t *histograms[HISTOGRAM_COUNT];
+  svn_packed__data_root_t *root;
+  svn_packed__int_stream_t *ints;
+  svn_packed__byte_stream_t *strings;
+  svn_stringbuf_t *buffer;
+  const char *uuid;
+  apr_size_t len;
+  apr_uint64_t size, mtime;
+  apr_uint64_t count;
+  apr_uint64_t i;
+  int k;
+  svn_error_t *err;
+
+  *found = FALSE;
+
+  /* Missing or unreadable snapshots simply mean that we need to scan
+   * the file. */
+  err = svn_stringbuf_from_file2(&buffer,
+                                 snapshot_path(query, unit->base,
+                                               scratch_pool),
+                                 scratch_pool);
+  if (!err)
+    err = svn_packed__data_read(&root,
+                                svn_stream_from_stringbuf(buffer,
+                                                          scratch_pool),
+                                scratch_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  ints = svn_packed__first_int_stream(root);
+  strings = svn_packed__first_byte_stream(root);
+  if (!ints || !strings)
+    return SVN_NO_ERROR;
+
+  /* Is this the right snapshot? */
+  if (   snapshot_truncated(ints, 5, 1)
+      || svn_packed__get_uint(ints) != SNAPSHOT_FORMAT
+      || svn_packed__get_uint(ints) != (apr_uint64_t)unit->base
+      || svn_packed__get_uint(ints) != (apr_uint64_t)unit->count)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_pack_stamp(&size, &mtime, query, unit->base, scratch_pool));
+  if (   svn_packed__get_uint(ints) != size
+      || svn_packed__get_uint(ints) != mtime)
+    return SVN_NO_ERROR;
+
+  uuid = svn_packed__get_bytes(strings, &len);
+  if (len != strlen(query->fs->uuid) || memcmp(uuid, query->fs->uuid, len))
+    return SVN_NO_ERROR;
+
+  /* Revisions and the representations in them. */
+  for (k = 0; k < unit->count; ++k)
+    {
+      revision_info_t *info = apr_pcalloc(unit->pool, sizeof(*info));
+      info->revision = unit->base + k;
+
+      info->offset = (apr_off_t)svn_packed__get_uint(ints);
+      info->end = (apr_off_t)svn_packed__get_uint(ints);
+      info->changes_len = svn_packed__get_uint(ints);
+      info->change_count = svn_packed__get_uint(ints);
+      info->dir_noderev_count = svn_packed__get_uint(ints);
+      info->file_noderev_count = svn_packed__get_uint(ints);
+      info->dir_noderev_size = svn_packed__get_uint(ints);
+      info->file_noderev_size = svn_packed__get_uint(ints);
+
+      count = svn_packed__get_uint(ints);
+      if (snapshot_truncated(ints, count, 7))
+        {
+          discard_snapshot(query, unit);
+          return SVN_NO_ERROR;
+        }
+
+      info->representations = apr_array_make(unit->pool, (int)count,
+                                             sizeof(rep_stats_t *));
+      for (i = 0; i < count; ++i)
+        {
+          rep_stats_t *rep = apr_pcalloc(unit->pool, sizeof(*rep));
+          rep->revision = info->revision;
+
+          rep->item_index = svn_packed__get_uint(ints);
+          rep->size = svn_packed__get_uint(ints);
+          rep->expanded_size = svn_packed__get_uint(ints);
+          rep->ref_count = (apr_uint32_t)svn_packed__get_uint(ints);
+          rep->header_size = (apr_uint16_t)svn_packed__get_uint(ints);
+          rep->kind = (char)svn_packed__get_uint(ints);
+          rep->chain_length = (apr_byte_t)svn_packed__get_uint(ints);
+
+          APR_ARRAY_PUSH(info->representations, rep_stats_t *) = rep;
+        }
+
+      APR_ARRAY_PUSH(file_query->revisions, revision_info_t *) = info;
+    }
+
+  /* References to older representations. */
+  count = svn_packed__get_uint(ints);
+  if (snapshot_truncated(ints, count, 2))
+    {
+      discard_snapshot(query, unit);
+      return SVN_NO_ERROR;
+    }
+
+  for (i = 0; i < count; ++i)
+    {
+      external_ref_t *ref = apr_palloc(unit->temp_pool, sizeof(*ref));
+      ref->revision = (svn_revnum_t)svn_packed__get_uint(ints);
+      ref->item_index = svn_packed__get_uint(ints);
+
+      APR_ARRAY_PUSH(file_query->external_refs, external_ref_t *) = ref;
+    }
+
+  /* Whatever add_change recorded. */
+  get_histograms(histograms, stats);
+  for (i = 0; i < HISTOGRAM_COUNT; ++i)
+    read_histogram(histograms[i], ints);
+
+  count = svn_packed__get_uint(ints);
+  if (snapshot_truncated(ints, count, 2))
+    {
+      discard_snapshot(query, unit);
+      return SVN_NO_ERROR;
+    }
+
+  for (i = 0; i < count; ++i)
+    {
+      apr_uint64_t size = svn_packed__get_uint(ints);
+      svn_revnum_t revision = (svn_revnum_t)svn_packed__get_uint(ints);
+      const char *path = svn_packed__get_bytes(strings, &len);
+
+      add_largest_change(stats, size, revision,
+                         apr_pstrmemdup(scratch_pool, path, len));
+    }
+
+  /* Each extension has two histograms of at least two numbers each. */
+  count = svn_packed__get_uint(ints);
+  if (snapshot_truncated(ints, count, 4))
+    {
+      discard_snapshot(query, unit);
+      return SVN_NO_ERROR;
+    }
+
+  for (i = 0; i < count; ++i)
+    {
+      const char *extension = svn_packed__get_bytes(strings, &len);
+      svn_fs_fs__extension_info_t *info
+        = get_extension_info(stats, apr_pstrmemdup(scratch_pool, extension,
+                                                   len));
+
+      read_histogram(&info->rep_histogram, ints);
+      read_histogram(&info->node_histogram, ints);
+    }
+
+  /* We must have read exactly what write_snapshot() wrote. */
+  if (   svn_packed__int_count(ints) != 1
+      || svn_packed__get_uint(ints) != SNAPSHOT_END
+      || svn_packed__byte_count(strings) != 0)
+    {
+      discard_snapshot(query, unit);
+      return SVN_NO_ERROR;
+    }
+
+  *found = TRUE;
+  unit->from_snapshot = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the results for the rev / pack file in UNIT to QUERY and release
+ * the temporary data in UNIT.  Write a snapshot for pack files if QUERY
+ * has a snapshot directory.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+merge_file_unit(query_t *query,
+                file_unit_t *unit,
+                apr_pool_t *scratch_pool)
+{
+  query_t *file_query = unit->query;
+  int i;
+
+  /* The revision data itself. */
+  SVN_ERR_ASSERT(query->revisions->nelts == unit->base);
+  for (i = 0; i < file_query->revisions->nelts; ++i)
+    APR_ARRAY_PUSH(query->revisions, revision_info_t *)
+      = APR_ARRAY_IDX(file_query->revisions, i, revision_info_t *);
+
+  /* Noderevs in this file that use representations from older files. */
+  for (i = 0; i < file_query->external_refs->nelts; ++i)
+    {
+      int idx;
+      external_ref_t *ref = APR_ARRAY_IDX(file_query->external_refs, i,
+                                          external_ref_t *);
+      rep_stats_t *rep = find_representation(&idx, query, NULL,
+                                             ref->revision, ref->item_index);
+      if (!rep)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Representation r%ld:i%s referenced "
+                                   "from revision %ld onwards not found"),
+                                 ref->revision,
+                                 apr_psprintf(scratch_pool,
+                                              "%" APR_UINT64_T_FMT,
+                                              ref->item_index),
+                                 unit->base);
+
+      ++rep->ref_count;
+    }
+
+  /* Resolve the delta chain links. */
+  SVN_ERR(resolve_representation_refs(query, file_query->rep_refs));
+
+  merge_stats(query->stats, file_query->stats);
+
+  if (   query->snapshot_dir
+      && !unit->from_snapshot
+      && unit->base < query->min_unpacked_rev)
+    SVN_ERR(write_snapshot(query, unit, scratch_pool));
+
+  svn_pool_destroy(unit->temp_pool);
+  unit->temp_pool = NULL;
+
+  /* show progress for every pack file and every 1000 revs or so */
   if (query->progress_func)
-    query->progress_func(base, query->progress_baton, scratch_pool);
+    {
+      if (query->shard_size && (unit->base % query->shard_size == 0))
+        query->progress_func(unit->base, query->progress_baton,
+                             scratch_pool);
+      if (!query->shard_size && (unit->base % 1000 == 0))
+        query->progress_func(unit->base, query->progress_baton,
+                             scratch_pool);
+    }
 
   return SVN_NO_ERROR;
 }
 
-/* Read the content of the file for REVISION in logical addressing mode
- * and store its contents in QUERY.
+/* Number of rev / pack files that we hand out per job in a single batch
+ * of the concurrent scan. */
+#define FILES_PER_JOB 4
+
+/* Baton type for scan_lane(), shared by all lanes of a batch. */
+typedef struct scan_batch_t
+{
+  /* The filesystem to scan.  Each lane uses its own clone of it. */
+  svn_fs_t *fs;
+
+  /* The files to scan.  Those read from snapshots will be skipped. */
+  file_unit_t *units;
+  int count;
+
+  /* Index of the next element in UNITS that has not been picked up by
+   * any lane, yet.  May exceed COUNT. */
+  volatile svn_atomic_t next;
+} scan_batch_t;
+
+/* Implements svn_fs_fs__task_func_t.  Keep picking the next unscanned file
+ * from the scan_batch_t BATON and scan it until there is none left.
+ */
+static svn_error_t *
+scan_lane(void *baton)
+{
+  scan_batch_t *batch = baton;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  err = svn_fs_fs__open_clone(&fs, batch->fs, pool, pool);
+  while (!err)
+    {
+      file_unit_t *unit;
+      int i = (int)svn_atomic_inc(&batch->next);
+      if (i >= batch->count)
+        break;
+
+      unit = &batch->units[i];
+      if (unit->from_snapshot)
+        continue;
+
+      svn_pool_clear(iterpool);
+      unit->err = scan_file(unit, fs, iterpool);
+    }
+
+  svn_pool_destroy(pool);
+
+  return svn_error_trace(err);
+}
+
+/* Scan all COUNT rev / pack files in UNITS of QUERY that have not been
+ * filled from snapshots, using up to JOBS concurrent lanes.  Store the
+ * outcome in the respective UNITS element.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+scan_file_units(query_t *query,
+                file_unit_t *units,
+                int count,
+                int jobs,
+                apr_pool_t *scratch_pool)
+{
+  scan_batch_t *batch;
+  void **lanes;
+  svn_error_t *err;
+  int i, pending = 0;
+
+  for (i = 0; i < count; ++i)
+    if (!units[i].from_snapshot)
+      ++pending;
+
+  /* Don't bother with threads for a single file. */
+  if (jobs == 1 || pending <= 1)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      for (i = 0; i < count; ++i)
+        if (!units[i].from_snapshot)
+          {
+            svn_pool_clear(iterpool);
+            units[i].err = scan_file(&units[i], query->fs, iterpool);
+          }
+
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
+  batch = apr_pcalloc(scratch_pool, sizeof(*batch));
+  batch->fs = query->fs;
+  batch->units = units;
+  batch->count = count;
+  batch->next = 0;
+
+  jobs = MIN(jobs, pending);
+  lanes = apr_palloc(scratch_pool, jobs * sizeof(*lanes));
+  for (i = 0; i < jobs; ++i)
+    lanes[i] = batch;
+
+  err = svn_fs_fs__run_tasks(scan_lane, lanes, jobs, scratch_pool);
+
+  /* A lane failed to even start.  Don't leak the results of the others. */
+  if (err)
+    for (i = 0; i < count; ++i)
+      {
+        svn_error_clear(units[i].err);
+        units[i].err = SVN_NO_ERROR;
+      }
+
+  return svn_error_trace(err);
+}
+
+/* Read the logically addressed repository and collect the stats info in
+ * QUERY.
+ *
+ * If the filesystem has been configured to use more than one job, the
+ * rev / pack files will be processed in batches, with several worker
+ * threads scanning the files of each batch concurrently.  The results
+ * will be merged in revision order and are the same as for a sequential
+ * scan.  Pack files that have a snapshot will not be scanned at all.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
- * temporaries.
+ * temporaries.  RESULT_POOL must have a thread-safe allocator.
  */
 static svn_error_t *
-read_log_revision_file(query_t *query,
-                       svn_revnum_t revision,
-                       apr_pool_t *result_pool,
-                       apr_pool_t *scratch_pool)
+read_log_files(query_t *query,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, revision, 1,
-                                   result_pool, scratch_pool));
+  fs_fs_data_t *ffd = query->fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int jobs = MAX(ffd->jobs, 1);
+  int batch_size = jobs > 1 ? jobs * FILES_PER_JOB : 1;
+  file_unit_t *units = apr_pcalloc(scratch_pool,
+                                   batch_size * sizeof(*units));
+  svn_revnum_t revision = 0;
 
-  /* show progress every 1000 revs or so */
-  if (query->progress_func)
+  if (query->snapshot_dir)
+    SVN_ERR(svn_io_make_dir_recursively(query->snapshot_dir, scratch_pool));
+
+  while (revision <= query->head)
     {
-      if (query->shard_size && (revision % query->shard_size == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-      if (!query->shard_size && (revision % 1000 == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
+      int count, i;
+
+      svn_pool_clear(iterpool);
+
+      /* Select the next batch of files and look for snapshots. */
+      for (count = 0; revision <= query->head && count < batch_size;
+           ++count)
+        {
+          file_unit_t *unit = &units[count];
+          svn_boolean_t packed = revision < query->min_unpacked_rev;
+
+          init_file_unit(unit, query, revision,
+                         packed ? query->shard_size : 1, result_pool);
+          if (packed && query->snapshot_dir)
+            {
+              svn_boolean_t found;
+              SVN_ERR(read_snapshot(&found, query, unit, iterpool));
+            }
+
+          revision += unit->count;
+        }
+
+      SVN_ERR(scan_file_units(query, units, count, jobs, iterpool));
+
+      /* Merge the results in revision order. */
+      for (i = 0; i < count; ++i)
+        {
+          svn_error_t *err = units[i].err;
+          if (!err)
+            err = merge_file_unit(query, &units[i], iterpool);
+
+          if (err)
+            {
+              for (++i; i < count; ++i)
+                svn_error_clear(units[i].err);
+
+              return svn_error_trace(err);
+            }
+        }
     }
 
+  svn_pool_destroy(iterpool);
+
   return SVN_NO_ERROR;
 }
 
 /* Read the repository and collect the stats info in QUERY.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
- * temporaries.
+ * temporaries.  RESULT_POOL must have a thread-safe allocator.
  */
 static svn_error_t *
 read_revisions(query_t *query,
                apr_pool_t *result_pool,
                apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool;
   svn_revnum_t revision;
 
+  if (svn_fs_fs__use_log_addressing(query->fs))
+    return svn_error_trace(read_log_files(query, result_pool, scratch_pool));
+
   /* read all packed revs */
+  iterpool = svn_pool_create(scratch_pool);
   for ( revision = 0
       ; revision < query->min_unpacked_rev
       ; revision += query->shard_size)
     {
       svn_pool_clear(iterpool);
-
-      if (svn_fs_fs__use_log_addressing(query->fs))
-        SVN_ERR(read_log_pack_file(query, revision, result_pool, iterpool));
-      else
-        SVN_ERR(read_phys_pack_file(query, revision, result_pool, iterpool));
+      SVN_ERR(read_phys_pack_file(query, revision, result_pool, iterpool));
     }
 
   /* read non-packed revs */
   for ( ; revision <= query->head; ++revision)
     {
       svn_pool_clear(iterpool);
-
-      if (svn_fs_fs__use_log_addressing(query->fs))
-        SVN_ERR(read_log_revision_file(query, revision, result_pool,
-                                       iterpool));
-      else
-        SVN_ERR(read_phys_revision_file(query, revision, result_pool,
-                                        iterpool));
+      SVN_ERR(read_phys_revision_file(query, revision, result_pool,
+                                      iterpool));
     }
 
   svn_pool_destroy(iterpool);
@@ -1307,28 +2168,16 @@ aggregate_stats(const apr_array_header_t *revisions,
     }
 }
 
-/* Return a new svn_fs_fs__stats_t instance, allocated in RESULT_POOL.
- */
-static svn_fs_fs__stats_t *
-create_stats(apr_pool_t *result_pool)
-{
-  svn_fs_fs__stats_t *stats = apr_pcalloc(result_pool, sizeof(*stats));
-
-  initialize_largest_changes(stats, 64, result_pool);
-  stats->by_extension = apr_hash_make(result_pool);
-
-  return stats;
-}
-
 /* Create a *QUERY, allocated in RESULT_POOL, reading filesystem FS and
- * collecting results in STATS.  Store the optional PROCESS_FUNC and
- * PROGRESS_BATON as well as CANCEL_FUNC and CANCEL_BATON in *QUERY, too.
- * Use SCRATCH_POOL for temporary allocations.
+ * collecting results in STATS.  Store the optional SNAPSHOT_DIR,
+ * PROCESS_FUNC and PROGRESS_BATON as well as CANCEL_FUNC and CANCEL_BATON
+ * in *QUERY, too.  Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
 create_query(query_t **query,
              svn_fs_t *fs,
              svn_fs_fs__stats_t *stats,
+             const char *snapshot_dir,
              svn_fs_progress_notify_func_t progress_func,
              void *progress_baton,
              svn_cancel_func_t cancel_func,
@@ -1358,6 +2207,7 @@ create_query(query_t **query,
   /* Store other parameters */
   (*query)->fs = fs;
   (*query)->stats = stats;
+  (*query)->snapshot_dir = snapshot_dir;
   (*query)->progress_func = progress_func;
   (*query)->progress_baton = progress_baton;
   (*query)->cancel_func = cancel_func;
@@ -1369,6 +2219,7 @@ create_query(query_t **query,
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     const char *snapshot_dir,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -1377,13 +2228,21 @@ svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      apr_pool_t *scratch_pool)
 {
   query_t *query;
+  apr_pool_t *data_pool;
+  svn_error_t *err;
 
   *stats = create_stats(result_pool);
-  SVN_ERR(create_query(&query, fs, *stats, progress_func, progress_baton,
-                       cancel_func, cancel_baton, scratch_pool,
-                       scratch_pool));
-  SVN_ERR(read_revisions(query, scratch_pool, scratch_pool));
-  aggregate_stats(query->revisions, *stats);
+  SVN_ERR(create_query(&query, fs, *stats, snapshot_dir, progress_func,
+                       progress_baton, cancel_func, cancel_baton,
+                       scratch_pool, scratch_pool));
 
-  return SVN_NO_ERROR;
+  /* The per-revision data may be filled by concurrent worker threads. */
+  data_pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  err = read_revisions(query, data_pool, scratch_pool);
+  if (!err)
+    aggregate_stats(query->revisions, *stats);
+
+  svn_pool_destroy(data_pool);
+
+  return svn_error_trace(err);
 }
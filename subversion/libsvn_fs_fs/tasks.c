@@ -0,0 +1,338 @@
+/* tasks.c --- run independent FSFS tasks concurrently
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_thread_pool.h>
+#include <apr_thread_cond.h>
+#include <apr_time.h>
+
+#include "tasks.h"
+#include "svn_pools.h"
+#include "svn_private_config.h"
+
+#include "private/svn_dep_compat.h"
+#include "private/svn_mutex.h"
+
+/* Handy macro to check APR function results and turning them into
+ * svn_error_t upon failure. */
+#define WRAP_APR_ERR(x,msg)                     \
+  {                                             \
+    apr_status_t status_ = (x);                 \
+    if (status_)                                \
+      return svn_error_wrap_apr(status_, msg);  \
+  }
+
+
+/* Data structures for concurrent execution are only available if we have
+ * threading support.
+ */
+#if APR_HAS_THREADS
+
+/* Number of microseconds that an unused thread remains in the pool before
+ * being terminated.
+ */
+#define THREADPOOL_THREAD_IDLE_LIMIT 1000000
+
+/* Maximum number of threads in THREAD_POOL, i.e. number of tasks that we
+ * may execute concurrently throughout the process. */
+#define MAX_THREADS 16
+
+/* Number of microseconds between checks of a waitable_counter_t if we
+ * can't wait for its condition variable. */
+#define WAIT_POLL_INTERVAL 1000
+
+/* Thread pool to execute the tasks. */
+static apr_thread_pool_t *thread_pool = NULL;
+
+/* Thread-local marker that is non-NULL in THREAD_POOL's worker threads.
+ * Tasks running there must not wait for other tasks in the same pool:
+ * with all workers waiting, the nested tasks would never get executed. */
+static apr_threadkey_t *worker_key = NULL;
+
+/* Utility construct:  The main thread can efficiently wait for the
+ * encapsulated counter to reach a certain value.  Tasks increment it
+ * upon completion.
+ */
+typedef struct waitable_counter_t
+{
+  /* Current value, initialized to 0. */
+  int value;
+
+  /* Synchronization objects. */
+  apr_thread_cond_t *cond;
+  svn_mutex__t *mutex;
+} waitable_counter_t;
+
+/* Set *COUNTER_P to a new waitable_counter_t instance allocated in
+ * RESULT_POOL.  The initial counter value is 0. */
+static svn_error_t *
+waitable_counter__create(waitable_counter_t **counter_p,
+                         apr_pool_t *result_pool)
+{
+  waitable_counter_t *counter = apr_pcalloc(result_pool, sizeof(*counter));
+  counter->value = 0;
+
+  WRAP_APR_ERR(apr_thread_cond_create(&counter->cond, result_pool),
+               _("Can't create condition variable"));
+  SVN_ERR(svn_mutex__init(&counter->mutex, TRUE, result_pool));
+
+  *counter_p = counter;
+
+  return SVN_NO_ERROR;
+}
+
+/* Increment the value in COUNTER by 1. */
+static svn_error_t *
+waitable_counter__increment(waitable_counter_t *counter)
+{
+  SVN_ERR(svn_mutex__lock(counter->mutex));
+  counter->value++;
+
+  WRAP_APR_ERR(apr_thread_cond_broadcast(counter->cond),
+               _("Can't broadcast condition variable"));
+  SVN_ERR(svn_mutex__unlock(counter->mutex, SVN_NO_ERROR));
+
+  return SVN_NO_ERROR;
+}
+
+/* Efficiently wait for COUNTER to assume VALUE.
+ *
+ * The tasks that increment COUNTER work on data owned by our caller, so
+ * we must not return before COUNTER reached VALUE - not even if waiting
+ * fails.  In that case, fall back to polling and return the first error
+ * only once COUNTER reached VALUE. */
+static svn_error_t *
+waitable_counter__wait_for(waitable_counter_t *counter,
+                           int value)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_boolean_t done = FALSE;
+
+  /* This loop implicitly handles spurious wake-ups. */
+  do
+    {
+      svn_error_t *lock_err = svn_mutex__lock(counter->mutex);
+      if (lock_err)
+        {
+          if (err)
+            svn_error_clear(lock_err);
+          else
+            err = lock_err;
+
+          apr_sleep(WAIT_POLL_INTERVAL);
+          continue;
+        }
+
+      if (counter->value == value)
+        {
+          done = TRUE;
+        }
+      else if (!err)
+        {
+          apr_status_t status
+            = apr_thread_cond_wait(counter->cond,
+                                   svn_mutex__get(counter->mutex));
+          if (status)
+            err = svn_error_wrap_apr(status,
+                                     _("Can't wait for condition variable"));
+        }
+
+      lock_err = svn_mutex__unlock(counter->mutex, SVN_NO_ERROR);
+      if (err)
+        svn_error_clear(lock_err);
+      else
+        err = lock_err;
+
+      if (err && !done)
+        apr_sleep(WAIT_POLL_INTERVAL);
+    }
+  while (!done);
+
+  return svn_error_trace(err);
+}
+
+/* Destructor function that implicitly cleans up any running threads
+   in the thread_pool given as DATA and releases their memory pools
+   before they get destroyed themselves.
+
+   Must be run as a pre-cleanup hook.
+ */
+static apr_status_t
+thread_pool_pre_cleanup(void *data)
+{
+  apr_thread_pool_t *tp = data;
+  return apr_thread_pool_destroy(tp);
+}
+
+/* Return TRUE if the current thread is one of THREAD_POOL's workers. */
+static svn_boolean_t
+is_worker_thread(void)
+{
+  void *value = NULL;
+
+  return worker_key
+      && apr_threadkey_private_get(&value, worker_key) == APR_SUCCESS
+      && value != NULL;
+}
+
+#endif
+
+/* A single task as handed to the thread pool. */
+typedef struct task_t
+{
+  /* Function to execute and its parameter. */
+  svn_fs_fs__task_func_t func;
+  void *baton;
+
+  /* Result of FUNC. */
+  svn_error_t *result;
+
+#if APR_HAS_THREADS
+  /* Counter to increment when we completed the task. */
+  waitable_counter_t *counter;
+#endif
+} task_t;
+
+svn_error_t *
+svn_fs_fs__tasks_init(void)
+{
+#if APR_HAS_THREADS
+  /* The thread-pool must be allocated from a thread-safe pool.
+     GLOBAL_POOL may be single-threaded, though. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  WRAP_APR_ERR(apr_threadkey_private_create(&worker_key, NULL, pool),
+               _("Can't create thread-local storage in FSFS"));
+  WRAP_APR_ERR(apr_thread_pool_create(&thread_pool, 0, MAX_THREADS, pool),
+               _("Can't create task thread pool in FSFS"));
+
+  /* Work around an APR bug:  The cleanup must happen in the pre-cleanup
+     hook instead of the normal cleanup hook.  Otherwise, the sub-pools
+     containing the thread objects would already be invalid. */
+  apr_pool_pre_cleanup_register(pool, thread_pool, thread_pool_pre_cleanup);
+
+  /* let idle threads linger for a while in case more requests are
+     coming in */
+  apr_thread_pool_idle_wait_set(thread_pool, THREADPOOL_THREAD_IDLE_LIMIT);
+
+  /* don't queue requests unless we reached the worker thread limit */
+  apr_thread_pool_threshold_set(thread_pool, 0);
+
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Thread-pool task:  Execute the task_t instance given by DATA. */
+static void * APR_THREAD_FUNC
+run_task(apr_thread_t *tid,
+         void *data)
+{
+  task_t *task = data;
+
+  apr_threadkey_private_set(task, worker_key);
+
+  task->result = svn_error_trace(task->func(task->baton));
+
+  /* As soon as the increment call returns, TASK may be invalid
+     (the main thread may have woken up and released the struct).
+     There is no point in trying to report an error here. */
+  svn_error_clear(waitable_counter__increment(task->counter));
+
+  return NULL;
+}
+
+#endif
+
+svn_error_t *
+svn_fs_fs__run_tasks(svn_fs_fs__task_func_t func,
+                     void **batons,
+                     int count,
+                     apr_pool_t *scratch_pool)
+{
+  svn_error_t *chain = SVN_NO_ERROR;
+  task_t *tasks;
+  int i;
+
+#if APR_HAS_THREADS
+  waitable_counter_t *counter = NULL;
+
+  /* Number of tasks sent to the thread pool. */
+  int pushed = 0;
+#endif
+
+  /* Skip the thread-pool and synchronization overhead for trivial sets. */
+  if (count < 2)
+    {
+      for (i = 0; i < count; ++i)
+        chain = svn_error_compose_create(chain, func(batons[i]));
+
+      return svn_error_trace(chain);
+    }
+
+  tasks = apr_pcalloc(scratch_pool, count * sizeof(*tasks));
+
+#if APR_HAS_THREADS
+  /* Tasks that spawn sub-tasks, e.g. parallel window reconstruction
+   * during a concurrent verification, execute those themselves. */
+  if (thread_pool && !is_worker_thread())
+    SVN_ERR(waitable_counter__create(&counter, scratch_pool));
+#endif
+
+  for (i = 0; i < count; ++i)
+    {
+      task_t *task = &tasks[i];
+      task->func = func;
+      task->baton = batons[i];
+
+#if APR_HAS_THREADS
+      if (counter)
+        {
+          apr_status_t status;
+
+          task->counter = counter;
+          status = apr_thread_pool_push(thread_pool, run_task, task, 0, NULL);
+          if (status == APR_SUCCESS)
+            {
+              pushed++;
+              continue;
+            }
+        }
+#endif
+
+      /* No thread available.  Do it ourselves. */
+      task->result = svn_error_trace(func(task->baton));
+    }
+
+#if APR_HAS_THREADS
+  /* Wait for all outstanding tasks to complete. */
+  if (counter)
+    chain = waitable_counter__wait_for(counter, pushed);
+#endif
+
+  /* Collect the results. */
+  for (i = 0; i < count; ++i)
+    chain = svn_error_compose_create(chain, tasks[i].result);
+
+  return svn_error_trace(chain);
+}
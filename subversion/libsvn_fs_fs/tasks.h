@@ -0,0 +1,69 @@
+/* tasks.h --- run independent FSFS tasks concurrently
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS__TASKS_H
+#define SVN_LIBSVN_FS__TASKS_H
+
+#include "svn_error.h"
+
+/* Infrastructure for executing a set of independent tasks concurrently.
+ *
+ * All tasks of a set get pushed to a process-wide thread pool and the
+ * caller waits until all of them have completed.  If the OS does not
+ * support multi-threading or there is only a single task, the tasks will
+ * simply be executed sequentially in the calling thread.
+ *
+ * Tasks must not share pools with each other or with the caller.  They
+ * should only allocate memory from pools that have been created for them
+ * specifically, using thread-safe parent pools.
+ */
+
+/* Function type for a single task.  BATON is the task's private data.
+ * The task's result shall be stored in BATON.
+ */
+typedef svn_error_t *
+(*svn_fs_fs__task_func_t)(void *baton);
+
+/* Initialize the concurrent task infrastructure.
+ *
+ * This function must be called before using any of the other functions in
+ * in this module.  It should only be called once.
+ */
+svn_error_t *
+svn_fs_fs__tasks_init(void);
+
+/* Execute FUNC once for each of the COUNT elements in BATONS, concurrently
+ * if supported by the OS.  Return only after all tasks have completed.
+ * If any of them failed, return all errors as a single chain.
+ *
+ * If called from within a task, the tasks will be executed sequentially
+ * in the calling thread.
+ *
+ * Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__run_tasks(svn_fs_fs__task_func_t func,
+                     void **batons,
+                     int count,
+                     apr_pool_t *scratch_pool);
+
+#endif
@@ -371,10 +371,14 @@ svn_fs_fs__serialize_raw_window(void **buffer,
   /* serialize the sub-structure(s) */
   svn_temp_serializer__add_leaf(context,
                                 (const void * const *)&window->window.data,
-                                window->window.len + 1);
+                                window->window.len);
 
-  /* return the serialized result */
+  /* The window data may point into a read-only file mapping without a
+   * terminating NUL.  Terminate the serialized copy instead. */
   serialized = svn_temp_serializer__get(context);
+  svn_stringbuf_appendbyte(serialized, 0);
+
+  /* return the serialized result */
 
   *buffer = serialized->data;
   *buffer_size = serialized->len;
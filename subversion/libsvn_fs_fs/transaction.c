@@ -32,6 +32,7 @@
 #include "svn_time.h"
 #include "svn_dirent_uri.h"
 
+#include "batch_fsync.h"
 #include "fs_fs.h"
 #include "index.h"
 #include "tree.h"
@@ -2137,6 +2138,35 @@ rep_write_cleanup(void *data)
   return APR_SUCCESS;
 }
 
+/* Select the svndiff version and the compression level to use when
+   writing deltified content to FS and return them in *DIFF_VERSION and
+   *COMPRESSION_LEVEL, respectively. */
+static void
+txdelta_to_svndiff_params(int *diff_version,
+                          int *compression_level,
+                          svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  switch (ffd->delta_compression_type)
+    {
+      case compression_type_lz4:
+        *diff_version = 2;
+        *compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
+        break;
+
+      case compression_type_zlib:
+        *diff_version = 1;
+        *compression_level = ffd->delta_compression_level;
+        break;
+
+      default:
+        *diff_version = 0;
+        *compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
+        break;
+    }
+}
+
 /* Get a rep_write_baton and store it in *WB_P for the representation
    indicated by NODEREV in filesystem FS.  Perform allocations in
    POOL.  Only appropriate for file contents, not for props or
@@ -2153,8 +2183,8 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   svn_stream_t *source;
   svn_txdelta_window_handler_t wh;
   void *whb;
-  fs_fs_data_t *ffd = fs->fsap_data;
-  int diff_version = ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT ? 1 : 0;
+  int diff_version;
+  int compression_level;
   svn_fs_fs__rep_header_t header = { 0 };
 
   b = apr_pcalloc(pool, sizeof(*b));
@@ -2210,11 +2240,12 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
                             apr_pool_cleanup_null);
 
   /* Prepare to write the svndiff data. */
+  txdelta_to_svndiff_params(&diff_version, &compression_level, fs);
   svn_txdelta_to_svndiff3(&wh,
                           &whb,
                           b->rep_stream,
                           diff_version,
-                          ffd->delta_compression_level,
+                          compression_level,
                           pool);
 
   b->delta_stream = svn_txdelta_target_push(wh, whb, source,
@@ -2778,8 +2809,8 @@ write_container_delta_rep(representation_t *rep,
   apr_off_t offset = 0;
 
   struct write_container_baton *whb;
-  fs_fs_data_t *ffd = fs->fsap_data;
-  int diff_version = ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT ? 1 : 0;
+  int diff_version;
+  int compression_level;
   svn_boolean_t is_props = (item_type == SVN_FS_FS__ITEM_TYPE_FILE_PROPS)
                         || (item_type == SVN_FS_FS__ITEM_TYPE_DIR_PROPS);
 
@@ -2810,11 +2841,12 @@ write_container_delta_rep(representation_t *rep,
   SVN_ERR(svn_fs_fs__get_file_offset(&delta_start, file, scratch_pool));
 
   /* Prepare to write the svndiff data. */
+  txdelta_to_svndiff_params(&diff_version, &compression_level, fs);
   svn_txdelta_to_svndiff3(&diff_wh,
                           &diff_whb,
                           file_stream,
                           diff_version,
-                          ffd->delta_compression_level,
+                          compression_level,
                           scratch_pool);
 
   whb = apr_pcalloc(scratch_pool, sizeof(*whb));
@@ -2963,6 +2995,17 @@ get_final_id(svn_fs_fs__id_part_t *part,
     }
 }
 
+/* A directory written by write_final_rev() that shall be put into the
+   directory cache once the new revision has been committed. */
+typedef struct committed_directory_t
+{
+  /* Key of the new directory representation in the DIR_CACHE. */
+  pair_cache_key_t key;
+
+  /* The directory entries, pointing to the final node-revision IDs. */
+  apr_array_header_t *entries;
+} committed_directory_t;
+
 /* Copy a node-revision specified by id ID in fileystem FS from a
    transaction into the proto-rev-file FILE.  Set *NEW_ID_P to a
    pointer to the new node-id which will be allocated in POOL.
@@ -2977,8 +3020,10 @@ get_final_id(svn_fs_fs__id_part_t *part,
    INITIAL_OFFSET is the offset of the proto-rev-file on entry to
    commit_body.
 
-   Collect the pair_cache_key_t of all directories written to the
-   committed cache in DIRECTORY_IDS.
+   If FS has a directory cache, append a committed_directory_t for
+   each directory written to DIRECTORIES, allocated in the pool of that
+   array.  The caller is responsible for putting them into the cache
+   once the revision has been committed.
 
    If REPS_TO_CACHE is not NULL, append to it a copy (allocated in
    REPS_POOL) of each data rep that is new in this revision.
@@ -3001,7 +3046,7 @@ write_final_rev(const svn_fs_id_t **new_id_p,
                 apr_uint64_t start_node_id,
                 apr_uint64_t start_copy_id,
                 apr_off_t initial_offset,
-                apr_array_header_t *directory_ids,
+                apr_array_header_t *directories,
                 apr_array_header_t *reps_to_cache,
                 apr_hash_t *reps_hash,
                 apr_pool_t *reps_pool,
@@ -3030,12 +3075,19 @@ write_final_rev(const svn_fs_id_t **new_id_p,
   if (noderev->kind == svn_node_dir)
     {
       apr_array_header_t *entries;
+      apr_pool_t *entries_pool = pool;
       int i;
 
+      /* New directory contents will be cached after the commit.  Keep
+         them around until then. */
+      if (ffd->dir_cache && noderev->data_rep
+          && is_txn_rep(noderev->data_rep))
+        entries_pool = directories->pool;
+
       /* This is a directory.  Write out all the children first. */
 
-      SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, noderev, pool,
-                                          subpool));
+      SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, noderev,
+                                          entries_pool, subpool));
       for (i = 0; i < entries->nelts; ++i)
         {
           svn_fs_dirent_t *dirent
@@ -3044,17 +3096,14 @@ write_final_rev(const svn_fs_id_t **new_id_p,
           svn_pool_clear(subpool);
           SVN_ERR(write_final_rev(&new_id, file, rev, fs, dirent->id,
                                   start_node_id, start_copy_id, initial_offset,
-                                  directory_ids, reps_to_cache, reps_hash,
+                                  directories, reps_to_cache, reps_hash,
                                   reps_pool, FALSE, subpool));
           if (new_id && (svn_fs_fs__id_rev(new_id) == rev))
-            dirent->id = svn_fs_fs__id_copy(new_id, pool);
+            dirent->id = svn_fs_fs__id_copy(new_id, entries_pool);
         }
 
       if (noderev->data_rep && is_txn_rep(noderev->data_rep))
         {
-          pair_cache_key_t *key;
-          svn_fs_fs__dir_data_t dir_data;
-
           /* Write out the contents of this directory as a text rep. */
           noderev->data_rep->revision = rev;
           if (ffd->deltify_directories)
@@ -3071,22 +3120,22 @@ write_final_rev(const svn_fs_id_t **new_id_p,
 
           reset_txn_in_rep(noderev->data_rep);
 
-          /* Cache the new directory contents.  Otherwise, subsequent reads
-           * or commits will likely have to reconstruct, verify and parse
-           * it again. */
-          key = apr_array_push(directory_ids);
-          key->revision = noderev->data_rep->revision;
-          key->second = noderev->data_rep->item_index;
-
-          /* Store directory contents under the new revision number but mark
-           * it as "stale" by setting the file length to 0.  Committed dirs
-           * will report -1, in-txn dirs will report > 0, so that this can
-           * never match.  We reset that to -1 after the commit is complete.
-           */
-          dir_data.entries = entries;
-          dir_data.txn_filesize = 0;
-
-          SVN_ERR(svn_cache__set(ffd->dir_cache, key, &dir_data, subpool));
+          /* Remember the new directory contents for the cache.  Otherwise,
+           * subsequent reads or commits will likely have to reconstruct,
+           * verify and parse it again.
+           *
+           * We may not be holding the write lock here, so another commit
+           * may still claim NEW_REV and produce different directories under
+           * the same keys.  Therefore, we don't touch the cache before our
+           * revision has actually been committed. */
+          if (ffd->dir_cache)
+            {
+              committed_directory_t *directory
+                = apr_array_push(directories);
+              directory->key.revision = noderev->data_rep->revision;
+              directory->key.second = noderev->data_rep->item_index;
+              directory->entries = entries;
+            }
         }
     }
   else
@@ -3335,7 +3384,8 @@ verify_as_revision_before_current_plus_plus(svn_fs_t *fs,
 
 /* Update the 'current' file to hold the correct next node and copy_ids
    from transaction TXN_ID in filesystem FS.  The current revision is
-   set to REV.  Perform temporary allocations in POOL. */
+   set to REV.  The new directory entry will not be flushed to disk;
+   see svn_fs_fs__sync_current.  Perform temporary allocations in POOL. */
 static svn_error_t *
 write_final_current(svn_fs_t *fs,
                     const svn_fs_fs__id_part_t *txn_id,
@@ -3349,7 +3399,7 @@ write_final_current(svn_fs_t *fs,
   fs_fs_data_t *ffd = fs->fsap_data;
 
   if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
-    return svn_fs_fs__write_current(fs, rev, 0, 0, pool);
+    return svn_fs_fs__write_current2(fs, rev, 0, 0, FALSE, pool);
 
   /* To find the next available ids, we add the id that used to be in
      the 'current' file, to the next ids from the transaction file. */
@@ -3358,8 +3408,8 @@ write_final_current(svn_fs_t *fs,
   start_node_id += txn_node_id;
   start_copy_id += txn_copy_id;
 
-  return svn_fs_fs__write_current(fs, rev, start_node_id, start_copy_id,
-                                  pool);
+  return svn_fs_fs__write_current2(fs, rev, start_node_id, start_copy_id,
+                                   FALSE, pool);
 }
 
 /* Verify that the user registered with FS has all the locks necessary to
@@ -3436,11 +3486,13 @@ verify_locks(svn_fs_t *fs,
 
 /* Writes final revision properties to file PATH applying permissions
    from file PERMS_REFERENCE. This involves setting svn:date and
-   removing any temporary properties associated with the commit flags. */
+   removing any temporary properties associated with the commit flags.
+   The file will be flushed to disk by BATCH. */
 static svn_error_t *
 write_final_revprop(const char *path,
                     const char *perms_reference,
                     svn_fs_txn_t *txn,
+                    svn_fs_fs__batch_fsync_t *batch,
                     apr_pool_t *pool)
 {
   apr_hash_t *txnprops;
@@ -3470,19 +3522,16 @@ write_final_revprop(const char *path,
       svn_hash_sets(txnprops, SVN_PROP_REVISION_DATE, &date);
     }
 
-  /* Create new revprops file. Tell OS to truncate existing file,
-     since  file may already exists from failed transaction. */
-  SVN_ERR(svn_io_file_open(&revprop_file, path,
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  /* Create new revprops file. Truncate existing file, since file may
+     already exists from failed transaction. */
+  SVN_ERR(svn_fs_fs__batch_fsync_open_file(&revprop_file, batch, path,
+                                           pool));
+  SVN_ERR(svn_io_file_trunc(revprop_file, 0, pool));
 
   stream = svn_stream_from_aprfile2(revprop_file, TRUE, pool);
   SVN_ERR(svn_hash_write2(txnprops, stream, SVN_HASH_TERMINATOR, pool));
   SVN_ERR(svn_stream_close(stream));
 
-  SVN_ERR(svn_io_file_flush_to_disk(revprop_file, pool));
-  SVN_ERR(svn_io_file_close(revprop_file, pool));
-
   SVN_ERR(svn_io_copy_perms(perms_reference, path, pool));
 
   return SVN_NO_ERROR;
@@ -3529,12 +3578,15 @@ svn_fs_fs__add_index_data(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* Mark the directories cached in FS with the keys from DIRECTORY_IDS
- * as "valid" now.  Use SCRATCH_POOL for temporaries. */
+/* Put the committed_directory_t elements of DIRECTORIES into the
+ * directory cache of FS.  This must only be called after the revision
+ * containing them has become current and while still holding the write
+ * lock, so no other commit can have produced different contents under
+ * the same keys.  Use SCRATCH_POOL for temporaries. */
 static svn_error_t *
-promote_cached_directories(svn_fs_t *fs,
-                           apr_array_header_t *directory_ids,
-                           apr_pool_t *scratch_pool)
+cache_committed_directories(svn_fs_t *fs,
+                            apr_array_header_t *directories,
+                            apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   apr_pool_t *iterpool;
@@ -3544,19 +3596,19 @@ promote_cached_directories(svn_fs_t *fs,
     return SVN_NO_ERROR;
 
   iterpool = svn_pool_create(scratch_pool);
-  for (i = 0; i < directory_ids->nelts; ++i)
+  for (i = 0; i < directories->nelts; ++i)
     {
-      const pair_cache_key_t *key
-        = &APR_ARRAY_IDX(directory_ids, i, pair_cache_key_t);
+      const committed_directory_t *directory
+        = &APR_ARRAY_IDX(directories, i, committed_directory_t);
+      svn_fs_fs__dir_data_t dir_data;
 
       svn_pool_clear(iterpool);
 
-      /* Currently, the entry for KEY - if it still exists - is marked
-       * as "stale" and would not be used.  Mark it as current for in-
-       * revison data. */
-      SVN_ERR(svn_cache__set_partial(ffd->dir_cache, key,
-                                     svn_fs_fs__reset_txn_filesize, NULL,
-                                     iterpool));
+      /* Committed dirs report a file size of -1. */
+      dir_data.entries = directory->entries;
+      dir_data.txn_filesize = -1;
+      SVN_ERR(svn_cache__set(ffd->dir_cache, &directory->key, &dir_data,
+                             iterpool));
     }
 
   svn_pool_destroy(iterpool);
@@ -3564,6 +3616,114 @@ promote_cached_directories(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Write the final contents of revision NEW_REV from transaction TXN_ID
+   in FS to the proto-rev file PROTO_FILE, i.e. all node-revisions, the
+   directory and property reps, the CHANGED_PATHS list and - depending on
+   the addressing mode - either the indexes or the revision trailer.
+   Flush the result to disk and close PROTO_FILE.
+
+   Return the ID of the new root node in *NEW_ROOT_ID.  START_NODE_ID,
+   START_COPY_ID, DIRECTORIES, REPS_TO_CACHE, REPS_HASH and REPS_POOL
+   are passed through to write_final_rev.  Use POOL for allocations. */
+static svn_error_t *
+write_final_proto_rev(const svn_fs_id_t **new_root_id,
+                      apr_file_t *proto_file,
+                      svn_fs_t *fs,
+                      const svn_fs_fs__id_part_t *txn_id,
+                      svn_revnum_t new_rev,
+                      apr_uint64_t start_node_id,
+                      apr_uint64_t start_copy_id,
+                      apr_hash_t *changed_paths,
+                      apr_array_header_t *directories,
+                      apr_array_header_t *reps_to_cache,
+                      apr_hash_t *reps_hash,
+                      apr_pool_t *reps_pool,
+                      apr_pool_t *pool)
+{
+  const svn_fs_id_t *root_id;
+  apr_off_t initial_offset, changed_path_offset;
+
+  SVN_ERR(svn_fs_fs__get_file_offset(&initial_offset, proto_file, pool));
+
+  /* Write out all the node-revisions and directory contents. */
+  root_id = svn_fs_fs__id_txn_create_root(txn_id, pool);
+  SVN_ERR(write_final_rev(new_root_id, proto_file, new_rev, fs, root_id,
+                          start_node_id, start_copy_id, initial_offset,
+                          directories, reps_to_cache, reps_hash,
+                          reps_pool, TRUE, pool));
+
+  /* Write the changed-path information. */
+  SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
+                                        fs, txn_id, changed_paths,
+                                        pool));
+
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      /* Append the index data to the rev file. */
+      SVN_ERR(svn_fs_fs__add_index_data(fs, proto_file,
+                      svn_fs_fs__path_l2p_proto_index(fs, txn_id, pool),
+                      svn_fs_fs__path_p2l_proto_index(fs, txn_id, pool),
+                      new_rev, pool));
+    }
+  else
+    {
+      /* Write the final line. */
+
+      svn_stringbuf_t *trailer
+        = svn_fs_fs__unparse_revision_trailer
+                  ((apr_off_t)svn_fs_fs__id_item(*new_root_id),
+                   changed_path_offset,
+                   pool);
+      SVN_ERR(svn_io_file_write_full(proto_file, trailer->data, trailer->len,
+                                     NULL, pool));
+    }
+
+  SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
+  SVN_ERR(svn_io_file_close(proto_file, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* A transaction whose final revision contents have already been written
+   to its proto-rev file before acquiring the repository write lock.
+   See prepare_commit(). */
+typedef struct prepared_commit_t
+{
+  /* The revision that the proto-rev file has been finalized for. */
+  svn_revnum_t new_rev;
+
+  /* The repository format that has been used to do that. */
+  int format;
+
+  /* We keep the proto-rev file locked until the commit has completed
+     or the preparation got rolled back.  Otherwise, new representations
+     could be appended to the finalized proto-rev file.
+
+     This means that we hold the proto-rev lock while waiting for the
+     repository write lock.  That cannot deadlock:  The proto-rev lock is
+     never waited for, i.e. get_writable_proto_rev() fails immediately
+     if the lock is taken, and the only code that acquires it while
+     holding the write lock is commit_body() for unprepared commits of
+     its own transaction. */
+  void *proto_file_lockcookie;
+
+  /* ID of the new root node-revision. */
+  const svn_fs_id_t *new_root_id;
+
+  /* The committed_directory_t to put into the DIR_CACHE after the commit.
+   */
+  apr_array_header_t *directories;
+
+  /* Size of the proto-rev and proto-index files before finalization. */
+  apr_off_t proto_rev_size;
+  apr_off_t l2p_proto_size;
+  apr_off_t p2l_proto_size;
+
+  /* Contents of the item index counter file before finalization.
+     NULL if it did not exist. */
+  svn_stringbuf_t *item_index;
+} prepared_commit_t;
+
 /* Baton used for commit_body below. */
 struct commit_baton {
   svn_revnum_t *new_rev_p;
@@ -3572,8 +3732,188 @@ struct commit_baton {
   apr_array_header_t *reps_to_cache;
   apr_hash_t *reps_hash;
   apr_pool_t *reps_pool;
+
+  /* If not NULL, the proto-rev file has already been finalized. */
+  prepared_commit_t *prepared;
 };
 
+/* Set *SIZE to the size of the file at PATH or to 0 if it does not exist.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+get_file_size(apr_off_t *size,
+              const char *path,
+              apr_pool_t *pool)
+{
+  const svn_io_dirent2_t *dirent;
+  SVN_ERR(svn_io_stat_dirent2(&dirent, path, FALSE, TRUE, pool, pool));
+  *size = dirent->kind == svn_node_file ? dirent->filesize : 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Truncate the file at PATH to SIZE bytes, if it exists.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+truncate_file(const char *path,
+              apr_off_t size,
+              apr_pool_t *pool)
+{
+  apr_file_t *file;
+  svn_error_t *err = svn_io_file_open(&file, path, APR_WRITE,
+                                      APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(err);
+  SVN_ERR(svn_io_file_trunc(file, size, pool));
+
+  return svn_error_trace(svn_io_file_close(file, pool));
+}
+
+/* Undo the finalization of the proto-rev file done by prepare_commit()
+   for CB->PREPARED, release the proto-rev lock and reset CB->PREPARED.
+   The transaction can then be committed again.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+rollback_prepared_commit(struct commit_baton *cb,
+                         apr_pool_t *pool)
+{
+  prepared_commit_t *prepared = cb->prepared;
+  svn_fs_t *fs = cb->fs;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
+  const char *item_index_path = svn_fs_fs__path_txn_item_index(fs, txn_id,
+                                                               pool);
+  svn_error_t *err;
+
+  cb->prepared = NULL;
+
+  err = truncate_file(svn_fs_fs__path_txn_proto_rev(fs, txn_id, pool),
+                      prepared->proto_rev_size, pool);
+  if (!err && svn_fs_fs__use_log_addressing(fs))
+    {
+      err = truncate_file(svn_fs_fs__path_l2p_proto_index(fs, txn_id, pool),
+                          prepared->l2p_proto_size, pool);
+      if (!err)
+        err = truncate_file(svn_fs_fs__path_p2l_proto_index(fs, txn_id,
+                                                            pool),
+                            prepared->p2l_proto_size, pool);
+      if (!err)
+        err = prepared->item_index
+            ? svn_io_write_atomic2(item_index_path,
+                                   prepared->item_index->data,
+                                   prepared->item_index->len,
+                                   item_index_path, FALSE, pool)
+            : svn_io_remove_file2(item_index_path, TRUE, pool);
+    }
+
+  /* The rep-cache entries collected so far are not valid anymore. */
+  if (cb->reps_to_cache)
+    apr_array_clear(cb->reps_to_cache);
+  if (cb->reps_hash)
+    apr_hash_clear(cb->reps_hash);
+
+  return svn_error_compose_create(err,
+                                  unlock_proto_rev(fs, txn_id,
+                                          prepared->proto_file_lockcookie,
+                                          pool));
+}
+
+/* Try to do all the expensive parts of committing CB->TXN before we
+   acquire the repository write lock:  Assuming that the commit will
+   succeed, i.e. produce the revision following the current youngest
+   revision, write the final node-revisions, directories, property reps,
+   changed paths list and indexes to the proto-rev file and flush it to
+   disk.  On success, set CB->PREPARED.
+
+   This is only possible for repository formats that don't use global
+   node and copy IDs.  If the transaction is already known to be out of
+   date, skip the preparation;  commit_body() will report the error.
+
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+prepare_commit(struct commit_baton *cb,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = cb->fs;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
+  svn_revnum_t youngest;
+  apr_uint64_t start_node_id, start_copy_id;
+  prepared_commit_t *prepared;
+  apr_file_t *proto_file;
+  apr_hash_t *changed_paths;
+  svn_node_kind_t kind;
+  const char *item_index_path;
+  svn_error_t *err;
+
+  if (ffd->format < SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__read_current(&youngest, &start_node_id, &start_copy_id,
+                                  fs, scratch_pool));
+  if (cb->txn->base_rev != youngest)
+    return SVN_NO_ERROR;
+
+  prepared = apr_pcalloc(result_pool, sizeof(*prepared));
+  prepared->new_rev = youngest + 1;
+  prepared->format = ffd->format;
+  prepared->directories = apr_array_make(result_pool, 4,
+                                         sizeof(committed_directory_t));
+
+  SVN_ERR(get_writable_proto_rev(&proto_file,
+                                 &prepared->proto_file_lockcookie,
+                                 fs, txn_id, result_pool));
+  cb->prepared = prepared;
+
+  /* Remember the state of the transaction's files, so we can restore it
+     if the commit turns out to be out-of-date. */
+  err = svn_fs_fs__get_file_offset(&prepared->proto_rev_size, proto_file,
+                                   scratch_pool);
+  if (!err && svn_fs_fs__use_log_addressing(fs))
+    {
+      item_index_path = svn_fs_fs__path_txn_item_index(fs, txn_id,
+                                                       scratch_pool);
+      err = get_file_size(&prepared->l2p_proto_size,
+                          svn_fs_fs__path_l2p_proto_index(fs, txn_id,
+                                                          scratch_pool),
+                          scratch_pool);
+      if (!err)
+        err = get_file_size(&prepared->p2l_proto_size,
+                            svn_fs_fs__path_p2l_proto_index(fs, txn_id,
+                                                            scratch_pool),
+                            scratch_pool);
+      if (!err)
+        err = svn_io_check_path(item_index_path, &kind, scratch_pool);
+      if (!err && kind == svn_node_file)
+        err = svn_stringbuf_from_file2(&prepared->item_index,
+                                       item_index_path, result_pool);
+    }
+
+  if (!err)
+    err = svn_fs_fs__txn_changes_fetch(&changed_paths, fs, txn_id,
+                                       scratch_pool);
+  if (!err)
+    err = write_final_proto_rev(&prepared->new_root_id, proto_file, fs,
+                                txn_id, prepared->new_rev, start_node_id,
+                                start_copy_id, changed_paths,
+                                prepared->directories, cb->reps_to_cache,
+                                cb->reps_hash, cb->reps_pool, result_pool);
+
+  if (err)
+    return svn_error_compose_create(err,
+                                    rollback_prepared_commit(cb,
+                                                             scratch_pool));
+
+  svn_atomic_inc(&ffd->shared->prepared_commits);
+
+  return SVN_NO_ERROR;
+}
+
 /* The work-horse for svn_fs_fs__commit, called with the FS write lock.
    This implements the svn_fs_fs__with_write_lock() 'body' callback
    type.  BATON is a 'struct commit_baton *'. */
@@ -3584,17 +3924,15 @@ commit_body(void *baton, apr_pool_t *pool)
   fs_fs_data_t *ffd = cb->fs->fsap_data;
   const char *old_rev_filename, *rev_filename, *proto_filename;
   const char *revprop_filename;
-  const svn_fs_id_t *root_id, *new_root_id;
+  const svn_fs_id_t *new_root_id;
   apr_uint64_t start_node_id;
   apr_uint64_t start_copy_id;
   svn_revnum_t old_rev, new_rev;
-  apr_file_t *proto_file;
   void *proto_file_lockcookie;
-  apr_off_t initial_offset, changed_path_offset;
+  svn_fs_fs__batch_fsync_t *batch;
   const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
   apr_hash_t *changed_paths;
-  apr_array_header_t *directory_ids = apr_array_make(pool, 4,
-                                                     sizeof(pair_cache_key_t));
+  apr_array_header_t *directories;
 
   /* Re-Read the current repository format.  All our repo upgrade and
      config evaluation strategies are such that existing information in
@@ -3619,6 +3957,18 @@ commit_body(void *baton, apr_pool_t *pool)
                                   cb->fs, pool));
   ffd->youngest_rev_cache = old_rev;
 
+  /* If we have prepared the proto-rev file for a different revision or
+     format, we must undo that.  Out-of-date transactions will be reported
+     below;  in the other cases, we simply write the final revision again.
+   */
+  if (cb->prepared
+      && (   cb->prepared->new_rev != old_rev + 1
+          || cb->prepared->format != ffd->format))
+    {
+      SVN_ERR(rollback_prepared_commit(cb, pool));
+      svn_atomic_inc(&ffd->shared->rolled_back_commits);
+    }
+
   /* Check to make sure this transaction is based off the most recent
      revision. */
   if (cb->txn->base_rev != old_rev)
@@ -3639,51 +3989,37 @@ commit_body(void *baton, apr_pool_t *pool)
   /* We are going to be one better than this puny old revision. */
   new_rev = old_rev + 1;
 
-  /* Get a write handle on the proto revision file. */
-  SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie,
-                                 cb->fs, txn_id, pool));
-  SVN_ERR(svn_fs_fs__get_file_offset(&initial_offset, proto_file, pool));
-
-  /* Write out all the node-revisions and directory contents. */
-  root_id = svn_fs_fs__id_txn_create_root(txn_id, pool);
-  SVN_ERR(write_final_rev(&new_root_id, proto_file, new_rev, cb->fs, root_id,
-                          start_node_id, start_copy_id, initial_offset,
-                          directory_ids, cb->reps_to_cache, cb->reps_hash,
-                          cb->reps_pool, TRUE, pool));
-
-  /* Write the changed-path information. */
-  SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
-                                        cb->fs, txn_id, changed_paths,
-                                        pool));
-
-  if (svn_fs_fs__use_log_addressing(cb->fs))
+  if (cb->prepared)
     {
-      /* Append the index data to the rev file. */
-      SVN_ERR(svn_fs_fs__add_index_data(cb->fs, proto_file,
-                      svn_fs_fs__path_l2p_proto_index(cb->fs, txn_id, pool),
-                      svn_fs_fs__path_p2l_proto_index(cb->fs, txn_id, pool),
-                      new_rev, pool));
+      /* The final revision contents are already on disk. */
+      proto_file_lockcookie = cb->prepared->proto_file_lockcookie;
+      new_root_id = cb->prepared->new_root_id;
+      directories = cb->prepared->directories;
     }
   else
     {
-      /* Write the final line. */
-
-      svn_stringbuf_t *trailer
-        = svn_fs_fs__unparse_revision_trailer
-                  ((apr_off_t)svn_fs_fs__id_item(new_root_id),
-                   changed_path_offset,
-                   pool);
-      SVN_ERR(svn_io_file_write_full(proto_file, trailer->data, trailer->len,
-                                     NULL, pool));
+      apr_file_t *proto_file;
+
+      /* Get a write handle on the proto revision file. */
+      SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie,
+                                     cb->fs, txn_id, pool));
+
+      directories = apr_array_make(pool, 4, sizeof(committed_directory_t));
+      SVN_ERR(write_final_proto_rev(&new_root_id, proto_file, cb->fs,
+                                    txn_id, new_rev, start_node_id,
+                                    start_copy_id, changed_paths,
+                                    directories, cb->reps_to_cache,
+                                    cb->reps_hash, cb->reps_pool, pool));
     }
 
-  SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
-  SVN_ERR(svn_io_file_close(proto_file, pool));
-
   /* We don't unlock the prototype revision file immediately to avoid a
      race with another caller writing to the prototype revision file
      before we commit it. */
 
+  /* Collect all files and directories that need to be flushed to disk
+     before we may update 'current', and fsync them all in one go. */
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, pool));
+
   /* Create the shard for the rev and revprop file, if we're sharding and
      this is the first revision of a new shard.  We don't care if this
      fails because the shard already existed for some reason. */
@@ -3702,6 +4038,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_dir, pool));
         }
 
       /* Create the revprops shard. */
@@ -3718,6 +4055,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVPROPS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_dir, pool));
         }
     }
 
@@ -3729,8 +4067,11 @@ commit_body(void *baton, apr_pool_t *pool)
   old_rev_filename = svn_fs_fs__path_rev_absolute(cb->fs, old_rev, pool);
   rev_filename = svn_fs_fs__path_rev(cb->fs, new_rev, pool);
   proto_filename = svn_fs_fs__path_txn_proto_rev(cb->fs, txn_id, pool);
-  SVN_ERR(svn_fs_fs__move_into_place(proto_filename, rev_filename,
-                                     old_rev_filename, pool));
+  SVN_ERR(svn_fs_fs__move_into_place2(proto_filename, rev_filename,
+                                      old_rev_filename, batch, pool));
+
+  /* There is nothing left to roll back. */
+  cb->prepared = NULL;
 
   /* Now that we've moved the prototype revision file out of the way,
      we can unlock it (since further attempts to write to the file
@@ -3742,7 +4083,11 @@ commit_body(void *baton, apr_pool_t *pool)
   SVN_ERR_ASSERT(! svn_fs_fs__is_packed_revprop(cb->fs, new_rev));
   revprop_filename = svn_fs_fs__path_revprops(cb->fs, new_rev, pool);
   SVN_ERR(write_final_revprop(revprop_filename, old_rev_filename,
-                              cb->txn, pool));
+                              cb->txn, batch, pool));
+
+  /* Make sure all revision data and the new directory entries are on
+     disk before we bump 'current'. */
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
 
   /* Update the 'current' file. */
   SVN_ERR(verify_as_revision_before_current_plus_plus(cb->fs, new_rev, pool));
@@ -3760,7 +4105,7 @@ commit_body(void *baton, apr_pool_t *pool)
 
   /* Make the directory contents alreday cached for the new revision
    * visible. */
-  SVN_ERR(promote_cached_directories(cb->fs, directory_ids, pool));
+  SVN_ERR(cache_committed_directories(cb->fs, directories, pool));
 
   /* Remove this transaction directory. */
   SVN_ERR(svn_fs_fs__purge_txn(cb->fs, cb->txn->id, pool));
@@ -3768,25 +4113,6 @@ commit_body(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
-/* Add the representations in REPS_TO_CACHE (an array of representation_t *)
- * to the rep-cache database of FS. */
-static svn_error_t *
-write_reps_to_cache(svn_fs_t *fs,
-                    const apr_array_header_t *reps_to_cache,
-                    apr_pool_t *scratch_pool)
-{
-  int i;
-
-  for (i = 0; i < reps_to_cache->nelts; i++)
-    {
-      representation_t *rep = APR_ARRAY_IDX(reps_to_cache, i, representation_t *);
-
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, rep, scratch_pool));
-    }
-
-  return SVN_NO_ERROR;
-}
-
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
@@ -3795,10 +4121,12 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
 {
   struct commit_baton cb;
   fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
 
   cb.new_rev_p = new_rev_p;
   cb.fs = fs;
   cb.txn = txn;
+  cb.prepared = NULL;
 
   if (ffd->rep_sharing_allowed)
     {
@@ -3813,26 +4141,36 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
       cb.reps_pool = NULL;
     }
 
-  SVN_ERR(svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool));
+  /* Do as much of the work as possible before taking the write lock, so
+     concurrent commits may write their revision contents in parallel. */
+  SVN_ERR(prepare_commit(&cb, pool, pool));
+
+  err = svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool);
+
+  /* Keep the transaction intact if the commit failed. */
+  if (err && cb.prepared)
+    err = svn_error_compose_create(err, rollback_prepared_commit(&cb, pool));
+
+  SVN_ERR(err);
 
   /* At this point, *NEW_REV_P has been set, so errors below won't affect
      the success of the commit.  (See svn_fs_commit_txn().)  */
 
+  /* The 'current' update is not durable, yet.  Do that outside the write
+     lock such that other commits from this process can share the fsync. */
+  SVN_ERR(svn_fs_fs__sync_current(fs, *new_rev_p, pool));
+
   if (ffd->rep_sharing_allowed)
     {
       SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
       /* Write new entries to the rep-sharing database.
        *
-       * We use an sqlite transaction to speed things up;
-       * see <http://www.sqlite.org/faq.html#q19>.
-       */
+       * This uses a single sqlite transaction for all of them. */
       /* ### A commit that touches thousands of files will starve other
              (reader/writer) commits for the duration of the below call.
              Maybe write in batches? */
-      SVN_SQLITE__WITH_TXN(
-        write_reps_to_cache(fs, cb.reps_to_cache, pool),
-        ffd->rep_cache_db);
+      SVN_ERR(svn_fs_fs__set_rep_references(fs, cb.reps_to_cache, pool));
     }
 
   return SVN_NO_ERROR;
@@ -26,6 +26,7 @@
 #include "svn_dirent_uri.h"
 #include "private/svn_string_private.h"
 
+#include "batch_fsync.h"
 #include "fs_fs.h"
 #include "pack.h"
 #include "util.h"
@@ -492,11 +493,12 @@ svn_fs_fs__read_current(svn_revnum_t *rev,
 }
 
 svn_error_t *
-svn_fs_fs__write_current(svn_fs_t *fs,
-                         svn_revnum_t rev,
-                         apr_uint64_t next_node_id,
-                         apr_uint64_t next_copy_id,
-                         apr_pool_t *pool)
+svn_fs_fs__write_current2(svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_uint64_t next_node_id,
+                          apr_uint64_t next_copy_id,
+                          svn_boolean_t sync_dir,
+                          apr_pool_t *pool)
 {
   char *buf;
   const char *name;
@@ -518,12 +520,107 @@ svn_fs_fs__write_current(svn_fs_t *fs,
     }
 
   name = svn_fs_fs__path_current(fs, pool);
+
+#ifdef SVN_ON_POSIX
+  if (!sync_dir)
+    {
+      apr_file_t *file;
+      const char *tmp_path;
+      svn_error_t *err;
+
+      /* Same as svn_io_write_atomic2() but we don't fsync the directory
+         after the rename. */
+      SVN_ERR(svn_io_open_unique_file3(&file, &tmp_path,
+                                       svn_dirent_dirname(name, pool),
+                                       svn_io_file_del_none, pool, pool));
+
+      err = svn_io_file_write_full(file, buf, strlen(buf), NULL, pool);
+      if (!err)
+        err = svn_io_file_flush_to_disk(file, pool);
+
+      err = svn_error_compose_create(err, svn_io_file_close(file, pool));
+      if (!err)
+        err = svn_io_copy_perms(name, tmp_path, pool);
+      if (!err)
+        err = svn_io_file_rename2(tmp_path, name, FALSE, pool);
+
+      /* Don't leave the temporary file behind. */
+      if (err)
+        return svn_error_trace(
+                 svn_error_compose_create(err,
+                                          svn_io_remove_file2(tmp_path, TRUE,
+                                                              pool)));
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
   SVN_ERR(svn_io_write_atomic2(name, buf, strlen(buf),
                                name /* copy_perms_path */, TRUE, pool));
 
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__write_current(svn_fs_t *fs,
+                         svn_revnum_t rev,
+                         apr_uint64_t next_node_id,
+                         apr_uint64_t next_copy_id,
+                         apr_pool_t *pool)
+{
+  return svn_error_trace(svn_fs_fs__write_current2(fs, rev, next_node_id,
+                                                   next_copy_id, TRUE,
+                                                   pool));
+}
+
+/* Body of svn_fs_fs__sync_current, to be called under the
+   CURRENT_SYNC_LOCK.  Parameters are the same. */
+static svn_error_t *
+sync_current_body(svn_fs_t *fs,
+                  svn_revnum_t revision,
+                  apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  svn_revnum_t youngest;
+  apr_uint64_t next_node_id, next_copy_id;
+  apr_file_t *dir;
+
+  /* Did someone else flush our update already? */
+  if (ffsd->synced_revision >= revision)
+    return SVN_NO_ERROR;
+
+  /* All updates to 'current' up to YOUNGEST have been done, i.e. the
+     directory fsync below will cover them. */
+  SVN_ERR(svn_fs_fs__read_current(&youngest, &next_node_id, &next_copy_id,
+                                  fs, pool));
+
+  SVN_ERR(svn_io_file_open(&dir, fs->path, APR_READ, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_flush_to_disk(dir, pool));
+  SVN_ERR(svn_io_file_close(dir, pool));
+
+  ffsd->synced_revision = youngest;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__sync_current(svn_fs_t *fs,
+                        svn_revnum_t revision,
+                        apr_pool_t *pool)
+{
+#ifdef SVN_ON_POSIX
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Concurrent callers queue up on the mutex while the first one is
+     flushing.  Most of them will then find their revision covered. */
+  SVN_MUTEX__WITH_LOCK(ffd->shared->current_sync_lock,
+                       sync_current_body(fs, revision, pool));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__try_stringbuf_from_file(svn_stringbuf_t **content,
                                    svn_boolean_t *missing,
@@ -636,6 +733,19 @@ svn_fs_fs__move_into_place(const char *old_filename,
                            const char *new_filename,
                            const char *perms_reference,
                            apr_pool_t *pool)
+{
+  return svn_error_trace(svn_fs_fs__move_into_place2(old_filename,
+                                                     new_filename,
+                                                     perms_reference,
+                                                     NULL, pool));
+}
+
+svn_error_t *
+svn_fs_fs__move_into_place2(const char *old_filename,
+                            const char *new_filename,
+                            const char *perms_reference,
+                            svn_fs_fs__batch_fsync_t *batch,
+                            apr_pool_t *pool)
 {
   svn_error_t *err;
   apr_file_t *file;
@@ -643,8 +753,11 @@ svn_fs_fs__move_into_place(const char *old_filename,
   /* Copying permissions is a no-op on WIN32. */
   SVN_ERR(svn_io_copy_perms(perms_reference, old_filename, pool));
 
-  /* Move the file into place. */
-  err = svn_io_file_rename2(old_filename, new_filename, TRUE, pool);
+  /* Move the file into place.  With a BATCH, we let it do the flushing. */
+  err = svn_io_file_rename2(old_filename, new_filename, batch == NULL,
+                            pool);
+  if (!err && batch)
+    SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_filename, pool));
   if (err && APR_STATUS_IS_EXDEV(err->apr_err))
     {
       /* Can't rename across devices; fall back to copying. */
@@ -25,6 +25,7 @@
 
 #include "svn_fs.h"
 #include "id.h"
+#include "batch_fsync.h"
 
 /* Functions for dealing with recoverable errors on mutable files
  *
@@ -347,6 +348,30 @@ svn_fs_fs__write_current(svn_fs_t *fs,
                          apr_uint64_t next_copy_id,
                          apr_pool_t *pool);
 
+/* Like svn_fs_fs__write_current but if SYNC_DIR is FALSE, don't wait for
+   the new directory entry of the 'current' file to be persisted.  The
+   file contents will always be on disk.  In that case, the caller must
+   call svn_fs_fs__sync_current() before reporting REV as committed. */
+svn_error_t *
+svn_fs_fs__write_current2(svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_uint64_t next_node_id,
+                          apr_uint64_t next_copy_id,
+                          svn_boolean_t sync_dir,
+                          apr_pool_t *pool);
+
+/* Make sure that the update of FS's 'current' file to REVISION, done by
+   svn_fs_fs__write_current2() without SYNC_DIR, has been persisted.
+
+   Concurrent calls within the same process get coalesced:  If another
+   thread already flushed a later update, this is a no-op.  So, a single
+   fsync may serve many commits ("group commit").
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__sync_current(svn_fs_t *fs,
+                        svn_revnum_t revision,
+                        apr_pool_t *pool);
+
 /* Read the file at PATH and return its content in *CONTENT. *CONTENT will
  * not be modified unless the whole file was read successfully.
  *
@@ -401,6 +426,15 @@ svn_fs_fs__move_into_place(const char *old_filename,
                            const char *perms_reference,
                            apr_pool_t *pool);
 
+/* Like svn_fs_fs__move_into_place but if BATCH is not NULL, schedule the
+   necessary fsyncs in BATCH instead of executing them immediately. */
+svn_error_t *
+svn_fs_fs__move_into_place2(const char *old_filename,
+                            const char *new_filename,
+                            const char *perms_reference,
+                            svn_fs_fs__batch_fsync_t *batch,
+                            apr_pool_t *pool);
+
 /* Return TRUE, iff FS uses logical addressing. */
 svn_boolean_t
 svn_fs_fs__use_log_addressing(svn_fs_t *fs);
@@ -23,6 +23,7 @@
 #include "svn_sorts.h"
 #include "svn_checksum.h"
 #include "svn_time.h"
+#include "private/svn_atomic.h"
 #include "private/svn_subr_private.h"
 
 #include "verify.h"
@@ -33,6 +34,7 @@
 #include "revprops.h"
 #include "util.h"
 #include "index.h"
+#include "tasks.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
@@ -366,6 +368,9 @@ compare_p2l_to_l2p_index(svn_fs_t *fs,
     {
       apr_array_header_t *entries;
       svn_fs_fs__p2l_entry_t *last_entry;
+      svn_fs_fs__id_part_t *items;
+      apr_off_t *l2p_offsets;
+      int item_count = 0;
       int i;
 
       svn_pool_clear(iterpool);
@@ -386,6 +391,7 @@ compare_p2l_to_l2p_index(svn_fs_t *fs,
         = &APR_ARRAY_IDX(entries, entries->nelts-1, svn_fs_fs__p2l_entry_t);
       offset = last_entry->offset + last_entry->size;
 
+      items = apr_palloc(iterpool, entries->nelts * sizeof(*items));
       for (i = 0; i < entries->nelts; ++i)
         {
           svn_fs_fs__p2l_entry_t *entry
@@ -411,24 +417,37 @@ compare_p2l_to_l2p_index(svn_fs_t *fs,
             }
           else
             {
-              apr_off_t l2p_offset;
-              SVN_ERR(svn_fs_fs__item_offset(&l2p_offset, fs, rev_file,
-                                             entry->item.revision, NULL,
-                                             entry->item.number, iterpool));
-
-              if (l2p_offset != entry->offset)
-                return svn_error_createf(SVN_ERR_FS_INDEX_INCONSISTENT,
-                                         NULL,
-                                         _("l2p index entry PHYS %s"
-                                           "does not match p2l index value "
-                                           "LOG r%ld:i%ld for PHYS %s"),
-                                         apr_off_t_toa(pool, l2p_offset),
-                                         entry->item.revision,
-                                         (long)entry->item.number,
-                                         apr_off_t_toa(pool, entry->offset));
+              items[item_count++] = entry->item;
             }
         }
 
+      /* look up all used items in the L2P index at once */
+      l2p_offsets = apr_palloc(iterpool, item_count * sizeof(*l2p_offsets));
+      SVN_ERR(svn_fs_fs__item_offsets(l2p_offsets, fs, rev_file, items,
+                                      item_count, iterpool));
+
+      for (i = 0, item_count = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_fs__p2l_entry_t *entry
+            = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+          apr_off_t l2p_offset;
+
+          if (entry->type == SVN_FS_FS__ITEM_TYPE_UNUSED)
+            continue;
+
+          l2p_offset = l2p_offsets[item_count++];
+          if (l2p_offset != entry->offset)
+            return svn_error_createf(SVN_ERR_FS_INDEX_INCONSISTENT,
+                                     NULL,
+                                     _("l2p index entry PHYS %s"
+                                       "does not match p2l index value "
+                                       "LOG r%ld:i%ld for PHYS %s"),
+                                     apr_off_t_toa(pool, l2p_offset),
+                                     entry->item.revision,
+                                     (long)entry->item.number,
+                                     apr_off_t_toa(pool, entry->offset));
+        }
+
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
     }
@@ -764,8 +783,160 @@ pack_size(svn_fs_t *fs, svn_revnum_t rev)
 /* Verify that on-disk representation has not been tempered with (in a way
  * that leaves the repository in a corrupted state).  This compares log-to-
  * phys with phys-to-log indexes, verifies the low-level checksums and
- * checks that all revprops are available.  The function signature is
- * similar to svn_fs_fs__verify.
+ * checks that all revprops are available for the COUNT revisions starting
+ * at PACK_START in FS.  The latter must be the first revision of a pack
+ * file or a non-packed revision.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+verify_pack_metadata(svn_fs_t *fs,
+                     svn_revnum_t pack_start,
+                     svn_revnum_t count,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *pool)
+{
+  /* Check for external corruption to the indexes. */
+  SVN_ERR(verify_index_checksums(fs, pack_start, cancel_func,
+                                 cancel_baton, pool));
+
+  /* two-way index check */
+  SVN_ERR(compare_l2p_to_p2l_index(fs, pack_start, count,
+                                   cancel_func, cancel_baton, pool));
+  SVN_ERR(compare_p2l_to_l2p_index(fs, pack_start, count,
+                                   cancel_func, cancel_baton, pool));
+
+  /* verify in-index checksums and types vs. actual rev / pack files */
+  SVN_ERR(compare_p2l_to_rev(fs, pack_start, count,
+                             cancel_func, cancel_baton, pool));
+
+  /* ensure that revprops are available and accessible */
+  SVN_ERR(verify_revprops(fs, pack_start, pack_start + count,
+                          cancel_func, cancel_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of pack files / non-packed revisions that we hand out per job in
+ * a single batch of the concurrent metadata verification.  Larger values
+ * reduce the overhead of opening FS clones for the worker threads, while
+ * smaller values reduce the latency of the progress notifications. */
+#define UNITS_PER_JOB 16
+
+/* A pack file or a non-packed revision to verify. */
+typedef struct verify_unit_t
+{
+  /* First revision and number of revisions in that unit. */
+  svn_revnum_t pack_start;
+  svn_revnum_t count;
+
+  /* Outcome of the verification. */
+  svn_error_t *err;
+} verify_unit_t;
+
+/* Baton type for verify_lane(), shared by all lanes of a batch. */
+typedef struct verify_batch_t
+{
+  /* The filesystem to verify.  Each lane uses its own clone of it. */
+  svn_fs_t *fs;
+
+  /* The units to verify. */
+  verify_unit_t *units;
+  int count;
+
+  /* Index of the next element in UNITS that has not been picked up by
+   * any lane, yet.  May exceed COUNT. */
+  volatile svn_atomic_t next;
+
+  /* Cancellation support.  CANCEL_FUNC must be thread-safe. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} verify_batch_t;
+
+/* Implements svn_fs_fs__task_func_t.  Keep picking the next unverified unit
+ * from the verify_batch_t BATON and verify it until there is none left.
+ * Lanes that finish early will thus simply "steal" work from the others.
+ */
+static svn_error_t *
+verify_lane(void *baton)
+{
+  verify_batch_t *batch = baton;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  err = svn_fs_fs__open_clone(&fs, batch->fs, pool, pool);
+  while (!err)
+    {
+      verify_unit_t *unit;
+      int i = (int)svn_atomic_inc(&batch->next);
+      if (i >= batch->count)
+        break;
+
+      svn_pool_clear(iterpool);
+      unit = &batch->units[i];
+      unit->err = verify_pack_metadata(fs, unit->pack_start, unit->count,
+                                       batch->cancel_func,
+                                       batch->cancel_baton, iterpool);
+    }
+
+  svn_pool_destroy(pool);
+
+  return svn_error_trace(err);
+}
+
+/* Verify the COUNT UNITS in FS using up to JOBS concurrent lanes and store
+ * the outcome in the respective UNITS element.  Use POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+verify_units_concurrently(svn_fs_t *fs,
+                          verify_unit_t *units,
+                          int count,
+                          int jobs,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *pool)
+{
+  verify_batch_t *batch = apr_pcalloc(pool, sizeof(*batch));
+  void **lanes;
+  svn_error_t *err;
+  int i;
+
+  batch->fs = fs;
+  batch->units = units;
+  batch->count = count;
+  batch->next = 0;
+  batch->cancel_func = cancel_func;
+  batch->cancel_baton = cancel_baton;
+
+  jobs = MIN(jobs, count);
+  lanes = apr_palloc(pool, jobs * sizeof(*lanes));
+  for (i = 0; i < jobs; ++i)
+    lanes[i] = batch;
+
+  err = svn_fs_fs__run_tasks(verify_lane, lanes, jobs, pool);
+
+  /* A lane failed to even start.  Don't leak the results of the others. */
+  if (err)
+    for (i = 0; i < count; ++i)
+      {
+        svn_error_clear(units[i].err);
+        units[i].err = SVN_NO_ERROR;
+      }
+
+  return svn_error_trace(err);
+}
+
+/* Verify the metadata of all pack files / non-packed revisions in FS
+ * from START to END.  The function signature is similar to
+ * svn_fs_fs__verify.
+ *
+ * If FS has been configured to use more than one job, the units will be
+ * processed in batches, with several worker threads verifying the units
+ * of each batch concurrently.  Notifications and errors will still be
+ * reported in revision order and with the same results as a sequential
+ * verification.
  *
  * The values of START and END have already been auto-selected and
  * verified.  You may call this for format7 or higher repos.
@@ -783,68 +954,73 @@ verify_f7_metadata_consistency(svn_fs_t *fs,
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_revnum_t revision, next_revision;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  int jobs = MAX(ffd->jobs, 1);
+  int batch_size = jobs > 1 ? jobs * UNITS_PER_JOB : 1;
+  verify_unit_t *units = apr_pcalloc(pool, batch_size * sizeof(*units));
 
   for (revision = start; revision <= end; revision = next_revision)
     {
-      svn_error_t *err = SVN_NO_ERROR;
-
-      svn_revnum_t count = pack_size(fs, revision);
-      svn_revnum_t pack_start = svn_fs_fs__packed_base_rev(fs, revision);
-      svn_revnum_t pack_end = pack_start + count;
+      svn_revnum_t rev;
+      int count, i;
 
       svn_pool_clear(iterpool);
 
-      if (notify_func && (pack_start % ffd->max_files_per_dir == 0))
-        notify_func(pack_start, notify_baton, iterpool);
-
-      /* Check for external corruption to the indexes. */
-      err = verify_index_checksums(fs, pack_start, cancel_func,
-                                   cancel_baton, iterpool);
-
-      /* two-way index check */
-      if (!err)
-        err = compare_l2p_to_p2l_index(fs, pack_start, pack_end - pack_start,
-                                       cancel_func, cancel_baton, iterpool);
-      if (!err)
-        err = compare_p2l_to_l2p_index(fs, pack_start, pack_end - pack_start,
-                                       cancel_func, cancel_baton, iterpool);
-
-      /* verify in-index checksums and types vs. actual rev / pack files */
-      if (!err)
-        err = compare_p2l_to_rev(fs, pack_start, pack_end - pack_start,
-                                 cancel_func, cancel_baton, iterpool);
-
-      /* ensure that revprops are available and accessible */
-      if (!err)
-        err = verify_revprops(fs, pack_start, pack_end,
-                              cancel_func, cancel_baton, iterpool);
-
-      /* concurrent packing is one of the reasons why verification may fail.
-         Make sure, we operate on up-to-date information. */
-      if (err)
+      /* Select the next batch of units. */
+      for (count = 0, rev = revision; rev <= end && count < batch_size;
+           ++count)
         {
-          svn_error_t *err2
-            = svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev,
-                                               fs, pool);
+          units[count].pack_start = svn_fs_fs__packed_base_rev(fs, rev);
+          units[count].count = pack_size(fs, rev);
+          units[count].err = SVN_NO_ERROR;
+
+          rev = units[count].pack_start + units[count].count;
+        }
+
+      if (count > 1)
+        SVN_ERR(verify_units_concurrently(fs, units, count, jobs,
+                                          cancel_func, cancel_baton,
+                                          iterpool));
+      else
+        units[0].err = verify_pack_metadata(fs, units[0].pack_start,
+                                            units[0].count,
+                                            cancel_func, cancel_baton,
+                                            iterpool);
+
+      /* Report the results in revision order. */
+      next_revision = rev;
+      for (i = 0; i < count; ++i)
+        {
+          verify_unit_t *unit = &units[i];
+          svn_error_t *err = unit->err;
+          svn_error_t *err2;
+          int k;
+
+          if (notify_func && (unit->pack_start % ffd->max_files_per_dir == 0))
+            notify_func(unit->pack_start, notify_baton, iterpool);
+
+          if (!err)
+            continue;
+
+          /* Only the first failure counts. */
+          for (k = i + 1; k < count; ++k)
+            svn_error_clear(units[k].err);
+
+          /* concurrent packing is one of the reasons why verification may
+             fail.  Make sure, we operate on up-to-date information. */
+          err2 = svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev,
+                                                  fs, pool);
 
           /* Be careful to not leak ERR. */
           if (err2)
             return svn_error_trace(svn_error_compose_create(err, err2));
-        }
 
-      /* retry the whole shard if it got packed in the meantime */
-      if (err && count != pack_size(fs, revision))
-        {
-          svn_error_clear(err);
+          /* retry the whole shard if it got packed in the meantime */
+          if (unit->count == pack_size(fs, unit->pack_start))
+            return svn_error_trace(err);
 
-          /* We could simply assign revision here but the code below is
-             more intuitive to maintainers. */
-          next_revision = svn_fs_fs__packed_base_rev(fs, revision);
-        }
-      else
-        {
-          SVN_ERR(err);
-          next_revision = pack_end;
+          svn_error_clear(err);
+          next_revision = svn_fs_fs__packed_base_rev(fs, unit->pack_start);
+          break;
         }
     }
 
@@ -346,7 +346,7 @@ make_reporter(svn_ra_session_t *session,
                                               result_pool));
 
   /* Build a reporter baton. */
-  SVN_ERR(svn_repos_begin_report3(&rbaton,
+  SVN_ERR(svn_repos_begin_report4(&rbaton,
                                   revision,
                                   sess->repos,
                                   sess->fs_path->data,
@@ -360,12 +360,13 @@ make_reporter(svn_ra_session_t *session,
                                   edit_baton,
                                   NULL,
                                   NULL,
+                                  NULL,
                                   0, /* Disable zero-copy codepath, because
                                         RA API users are unaware about the
                                         zero-copy code path limitation (do
                                         not access FSFS data structures
                                         and, hence, caches).  See notes
-                                        to svn_repos_begin_report3() for
+                                        to svn_repos_begin_report4() for
                                         additional details. */
                                   result_pool));
 
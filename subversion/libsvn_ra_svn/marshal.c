@@ -291,6 +291,27 @@ svn_ra_svn_compression_level(svn_ra_svn_conn_t *conn)
   return conn->compression_level;
 }
 
+int
+svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn)
+{
+  /* If we don't want to use compression, use the non-compressing
+   * "version 0" implementation. */
+  if (svn_ra_svn_compression_level(conn) <= 0)
+    return 0;
+
+  /* Prefer LZ4 (svndiff2) over zlib (svndiff1) as it is significantly
+   * faster on both sides of the connection.  We can only send it if we
+   * have been built with LZ4 support ourselves. */
+  if (svn__lz4_supported()
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED))
+    return 2;
+
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF1))
+    return 1;
+
+  return 0;
+}
+
 apr_size_t
 svn_ra_svn_zero_copy_limit(svn_ra_svn_conn_t *conn)
 {
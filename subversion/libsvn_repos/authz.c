@@ -35,59 +35,191 @@
 #include "svn_config.h"
 #include "svn_ctype.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 #include "private/svn_repos_private.h"
 #include "repos.h"
 
 
 /*** Structures. ***/
 
-/* Information for the config enumerators called during authz
-   lookup. */
-struct authz_lookup_baton {
-  /* The authz configuration. */
-  svn_config_t *config;
+/* Information for the config enumeration functions called during the
+   validation process. */
+struct authz_validate_baton {
+  svn_config_t *config; /* The configuration file being validated. */
+  svn_error_t *err;     /* The error being thrown out of the
+                           enumerator, if any. */
+};
 
-  /* The user to authorize. */
+/* The different kinds of match strings in an authz rule. */
+typedef enum authz_rule_kind_t
+{
+  authz_rule_everyone,         /* "*" */
+  authz_rule_anonymous,        /* "$anonymous" */
+  authz_rule_authenticated,    /* "$authenticated" */
+  authz_rule_user,             /* a user name or an alias */
+  authz_rule_group             /* "@group" */
+} authz_rule_kind_t;
+
+/* A single compiled authz rule, i.e. a name-value pair from a section. */
+typedef struct authz_rule_t
+{
+  /* What the match string refers to. */
+  authz_rule_kind_t kind;
+
+  /* Whether the match string has been inverted with '~'. */
+  svn_boolean_t inverted;
+
+  /* For authz_rule_user, the user name with aliases already resolved. */
   const char *user;
 
-  /* Explicitly granted rights. */
+  /* For authz_rule_group, all users in the group, including those of
+     nested groups.  Maps const char * to "". */
+  apr_hash_t *members;
+
+  /* Access granted by the rule.  Anything not granted is denied. */
+  svn_repos_authz_access_t access;
+} authz_rule_t;
+
+/* A node in the prefix tree of compiled authz sections.  There is one
+   node per path segment of any section name, the root node representing
+   "/".  All nodes are immutable once compiled. */
+typedef struct authz_node_t
+{
+  /* Maps path segments (const char *) to sub-nodes (authz_node_t *).
+     NULL if there are no sub-nodes. */
+  apr_hash_t *children;
+
+  /* Rules (authz_rule_t *) of the global section for this path.
+     NULL if there is no such section. */
+  apr_array_header_t *rules;
+
+  /* Maps repository names (const char *) to the rules of the respective
+     repository-specific sections for this path.  NULL if there are
+     none. */
+  apr_hash_t *repos_rules;
+} authz_node_t;
+
+/* The prefix tree of a single user in a single repository.  This only
+   contains those nodes of the full tree that have rules applying to the
+   user at or below them.  The root node always exists. */
+typedef struct authz_user_node_t
+{
+  /* Maps path segments (const char *) to sub-nodes (authz_user_node_t *).
+     NULL if there are no sub-nodes. */
+  apr_hash_t *children;
+
+  /* Whether any rule for this path applies to the user.  If so, ALLOW
+     and DENY are the rights explicitly granted and denied, respectively.
+     Repository-specific sections take precedence over global ones. */
+  svn_boolean_t has_rules;
   svn_repos_authz_access_t allow;
-  /* Explicitly denied rights. */
   svn_repos_authz_access_t deny;
 
-  /* The rights required by the caller of the lookup. */
-  svn_repos_authz_access_t required_access;
+  /* Summary of all sections at or below this node that have rules
+     applying to the user, global and repository-specific alike.  Bit
+     (1 << R) is set in GRANTED_BELOW if some section grants the
+     read / write access combination R and in DENIED_BELOW if some
+     section denies it. */
+  unsigned int granted_below;
+  unsigned int denied_below;
+} authz_user_node_t;
+
+/* Number of (repository, user) combinations for which we keep the
+   filtered prefix trees.  This bounds the memory used by a long-lived
+   authz object.  Once that many have been cached, we drop the least
+   recently used ones. */
+#define AUTHZ_MAX_USER_VIEWS 1024
+
+/* A cached prefix tree of a single user in a single repository. */
+typedef struct authz_view_t
+{
+  /* The key as built by user_view_key(). */
+  const char *key;
 
-  /* The following are used exclusively in recursive lookups. */
+  /* The filtered prefix tree. */
+  authz_user_node_t *root;
 
-  /* The path in the repository (an fspath) to authorize. */
-  const char *repos_path;
-  /* repos_path prefixed by the repository name and a colon. */
-  const char *qualified_repos_path;
+  /* Root pool that KEY, ROOT and this structure are allocated in.  Views
+     have their own pools, so they can get built without holding the
+     authz mutex and get dropped individually. */
+  apr_pool_t *pool;
 
-  /* Whether, at the end of a recursive lookup, access is granted. */
-  svn_boolean_t access;
-};
+  /* Number of access checks currently using this view.  As long as this
+     is not 0, POOL must not get destroyed. */
+  int refcount;
 
-/* Information for the config enumeration functions called during the
-   validation process. */
-struct authz_validate_baton {
-  svn_config_t *config; /* The configuration file being validated. */
-  svn_error_t *err;     /* The error being thrown out of the
-                           enumerator, if any. */
-};
+  /* Whether this view has been removed from the cache.  The last check
+     still using it then destroys it. */
+  svn_boolean_t evicted;
 
-/* Currently this structure is just a wrapper around a svn_config_t.
-   Please update authz_pool if you modify this structure. */
+  /* Neighbours in the list of cached views, most recently used first. */
+  struct authz_view_t *prev;
+  struct authz_view_t *next;
+} authz_view_t;
+
+/* The compiled authz rules.  Please update authz_pool if you modify
+   the way this structure gets constructed. */
 struct svn_authz_t
 {
-  svn_config_t *cfg;
+  /* The prefix tree of all sections. */
+  authz_node_t *root;
+
+  /* Serializes access to VIEWS, the list of views and the reference
+     counts.  The views themselves get built and used without it. */
+  svn_mutex__t *mutex;
+
+  /* Maps (repository, user) keys as built by user_view_key() to the
+     respective authz_view_t *. */
+  apr_hash_t *views;
+
+  /* Least recently used list of all views in VIEWS. */
+  authz_view_t *first_view;
+  authz_view_t *last_view;
 };
 
+/* Information for the config enumerators called while compiling an
+   authz configuration. */
+struct authz_compile_baton
+{
+  /* The authz configuration. */
+  svn_config_t *config;
+
+  /* Maps group names (const char *) to the members of the group
+     (apr_hash_t * as in authz_rule_t) for all groups resolved so far. */
+  apr_hash_t *groups;
+
+  /* The root of the prefix tree being built. */
+  authz_node_t *root;
+
+  /* Rules of the section currently being compiled. */
+  apr_array_header_t *rules;
+
+  /* Pool for the compiled structures. */
+  apr_pool_t *pool;
+};
+
+
 
-
 /*** Checking access. ***/
 
+/* Decide whether the REQUIRED access has been conclusively
+ * determined.  Return TRUE if the given ALLOW/DENY authz are
+ * conclusive regarding the REQUIRED authz.
+ *
+ * Conclusive determination occurs when any of the REQUIRED authz are
+ * granted or denied by ALLOW/DENY.
+ */
+static svn_boolean_t
+authz_access_is_determined(svn_repos_authz_access_t allow,
+                           svn_repos_authz_access_t deny,
+                           svn_repos_authz_access_t required)
+{
+  if ((deny & required) || (allow & required))
+    return TRUE;
+  else
+    return FALSE;
+}
+
 /* Determine whether the REQUIRED access is granted given what authz
  * to ALLOW or DENY.  Return TRUE if the REQUIRED access is
  * granted.
@@ -113,367 +245,591 @@ authz_access_is_granted(svn_repos_authz_access_t allow,
 }
 
 
-/* Decide whether the REQUIRED access has been conclusively
- * determined.  Return TRUE if the given ALLOW/DENY authz are
- * conclusive regarding the REQUIRED authz.
- *
- * Conclusive determination occurs when any of the REQUIRED authz are
- * granted or denied by ALLOW/DENY.
+/* Return TRUE if RULE applies to USER, which is NULL for anonymous
+ * access.
  */
 static svn_boolean_t
-authz_access_is_determined(svn_repos_authz_access_t allow,
-                           svn_repos_authz_access_t deny,
-                           svn_repos_authz_access_t required)
+authz_rule_applies_to_user(const authz_rule_t *rule,
+                           const char *user)
 {
-  if ((deny & required) || (allow & required))
-    return TRUE;
-  else
-    return FALSE;
+  svn_boolean_t applies;
+
+  switch (rule->kind)
+    {
+      case authz_rule_everyone:
+        applies = TRUE;
+        break;
+
+      case authz_rule_anonymous:
+        applies = (user == NULL);
+        break;
+
+      case authz_rule_authenticated:
+        applies = (user != NULL);
+        break;
+
+      case authz_rule_user:
+        applies = (user != NULL && strcmp(user, rule->user) == 0);
+        break;
+
+      default:
+        applies = (user != NULL && svn_hash_gets(rule->members, user));
+        break;
+    }
+
+  return rule->inverted ? !applies : applies;
 }
 
-/* Return TRUE is USER equals ALIAS. The alias definitions are in the
-   "aliases" sections of CFG. Use POOL for temporary allocations during
-   the lookup. */
+
+/* Accumulate the rights explicitly granted to and denied from USER by
+ * the RULES of one section in *ALLOW and *DENY, respectively.  Return
+ * TRUE if any rule applied to the user.
+ */
 static svn_boolean_t
-authz_alias_is_user(svn_config_t *cfg,
-                    const char *alias,
-                    const char *user,
-                    apr_pool_t *pool)
+authz_rules_access(svn_repos_authz_access_t *allow,
+                   svn_repos_authz_access_t *deny,
+                   const apr_array_header_t *rules,
+                   const char *user)
 {
-  const char *value;
+  svn_boolean_t applied = FALSE;
+  int i;
 
-  svn_config_get(cfg, &value, "aliases", alias, NULL);
-  if (!value)
+  *allow = *deny = svn_authz_none;
+  if (!rules)
     return FALSE;
 
-  if (strcmp(value, user) == 0)
-    return TRUE;
+  for (i = 0; i < rules->nelts; i++)
+    {
+      const authz_rule_t *rule = APR_ARRAY_IDX(rules, i, authz_rule_t *);
+      if (!authz_rule_applies_to_user(rule, user))
+        continue;
 
-  return FALSE;
+      applied = TRUE;
+      *allow |= rule->access;
+      *deny |= ~rule->access & (svn_authz_read | svn_authz_write);
+    }
+
+  return applied;
 }
 
 
-/* Return TRUE if USER is in GROUP.  The group definitions are in the
-   "groups" section of CFG.  Use POOL for temporary allocations during
-   the lookup. */
-static svn_boolean_t
-authz_group_contains_user(svn_config_t *cfg,
-                          const char *group,
-                          const char *user,
-                          apr_pool_t *pool)
+/* Add the outcome of a section that explicitly grants ALLOW and denies
+ * DENY to the GRANTED_BELOW and DENIED_BELOW summaries of NODE.
+ */
+static void
+authz_summarize_section(authz_user_node_t *node,
+                        svn_repos_authz_access_t allow,
+                        svn_repos_authz_access_t deny)
 {
-  const char *value;
-  apr_array_header_t *list;
-  int i;
+  svn_repos_authz_access_t required;
+
+  for (required = svn_authz_read;
+       required <= (svn_authz_read | svn_authz_write);
+       required++)
+    if (authz_access_is_granted(allow, deny, required))
+      node->granted_below |= 1u << required;
+    else
+      node->denied_below |= 1u << required;
+}
 
-  svn_config_get(cfg, &value, "groups", group, NULL);
 
-  list = svn_cstring_split(value, ",", TRUE, pool);
+/* Return the part of the prefix tree at NODE that applies to USER in
+ * the repository REPOS_NAME, allocated in RESULT_POOL.  Return NULL if
+ * no rule at or below NODE applies, unless FORCE is set.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static authz_user_node_t *
+authz_filter_node(const authz_node_t *node,
+                  const char *repos_name,
+                  const char *user,
+                  svn_boolean_t force,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  authz_user_node_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  svn_repos_authz_access_t allow, deny;
+  svn_boolean_t used = force;
 
-  for (i = 0; i < list->nelts; i++)
+  /* Global rules first, as repository-specific ones take precedence. */
+  if (authz_rules_access(&allow, &deny, node->rules, user))
     {
-      const char *group_user = APR_ARRAY_IDX(list, i, char *);
+      result->has_rules = TRUE;
+      result->allow = allow;
+      result->deny = deny;
+      authz_summarize_section(result, allow, deny);
+    }
 
-      /* If the 'user' is a subgroup, recurse into it. */
-      if (*group_user == '@')
-        {
-          if (authz_group_contains_user(cfg, &group_user[1],
-                                        user, pool))
-            return TRUE;
-        }
+  if (node->repos_rules
+      && authz_rules_access(&allow, &deny,
+                            svn_hash_gets(node->repos_rules, repos_name),
+                            user))
+    {
+      result->has_rules = TRUE;
+      result->allow = allow;
+      result->deny = deny;
+      authz_summarize_section(result, allow, deny);
+    }
 
-      /* If the 'user' is an alias, verify it. */
-      else if (*group_user == '&')
+  if (node->children)
+    {
+      apr_hash_index_t *hi;
+      for (hi = apr_hash_first(scratch_pool, node->children);
+           hi;
+           hi = apr_hash_next(hi))
         {
-          if (authz_alias_is_user(cfg, &group_user[1],
-                                  user, pool))
-            return TRUE;
+          const void *key;
+          apr_ssize_t klen;
+          void *val;
+          authz_user_node_t *child;
+
+          apr_hash_this(hi, &key, &klen, &val);
+          child = authz_filter_node(val, repos_name, user, FALSE,
+                                    result_pool, scratch_pool);
+          if (!child)
+            continue;
+
+          if (!result->children)
+            result->children = apr_hash_make(result_pool);
+
+          apr_hash_set(result->children, key, klen, child);
+          result->granted_below |= child->granted_below;
+          result->denied_below |= child->denied_below;
         }
-
-      /* If the user matches, stop. */
-      else if (strcmp(user, group_user) == 0)
-        return TRUE;
     }
 
-  return FALSE;
+  used |= result->has_rules || result->children;
+  return used ? result : NULL;
 }
 
 
-/* Determines whether an authz rule applies to the current
- * user, given the name part of the rule's name-value pair
- * in RULE_MATCH_STRING and the authz_lookup_baton object
- * B with the username in question.
+/* Return the key for the prefix tree of USER in the repository
+ * REPOS_NAME, allocated in POOL.
  */
-static svn_boolean_t
-authz_line_applies_to_user(const char *rule_match_string,
-                           struct authz_lookup_baton *b,
-                           apr_pool_t *pool)
+static const char *
+user_view_key(const char *repos_name,
+              const char *user,
+              apr_pool_t *pool)
 {
-  /* If the rule has an inversion, recurse and invert the result. */
-  if (rule_match_string[0] == '~')
-    return !authz_line_applies_to_user(&rule_match_string[1], b, pool);
-
-  /* Check for special tokens. */
-  if (strcmp(rule_match_string, "$anonymous") == 0)
-    return (b->user == NULL);
-  if (strcmp(rule_match_string, "$authenticated") == 0)
-    return (b->user != NULL);
-
-  /* Check for a wildcard rule. */
-  if (strcmp(rule_match_string, "*") == 0)
-    return TRUE;
-
-  /* If we get here, then the rule is:
-   *  - Not an inversion rule.
-   *  - Not an authz token rule.
-   *  - Not a wildcard rule.
-   *
-   * All that's left over is regular user or group specifications.
-   */
-
-  /* If the session is anonymous, then a user/group
-   * rule definitely won't match.
-   */
-  if (b->user == NULL)
-    return FALSE;
-
-  /* Process the rule depending on whether it is
-   * a user, alias or group rule.
-   */
-  if (rule_match_string[0] == '@')
-    return authz_group_contains_user(
-      b->config, &rule_match_string[1], b->user, pool);
-  else if (rule_match_string[0] == '&')
-    return authz_alias_is_user(
-      b->config, &rule_match_string[1], b->user, pool);
-  else
-    return (strcmp(b->user, rule_match_string) == 0);
+  /* Prefix with the length of the repository name to keep the key
+     unambiguous.  Anonymous access must not collide with any user. */
+  return apr_psprintf(pool, "%" APR_SIZE_T_FMT ":%s%s%s",
+                      strlen(repos_name), repos_name,
+                      user ? "+" : "-", user ? user : "");
 }
 
 
-/* Callback to parse one line of an authz file and update the
- * authz_baton accordingly.
+/* Remove VIEW from the list of views in AUTHZ.  The caller must hold
+ * AUTHZ->MUTEX.
  */
-static svn_boolean_t
-authz_parse_line(const char *name, const char *value,
-                 void *baton, apr_pool_t *pool)
+static void
+unlink_view(svn_authz_t *authz,
+            authz_view_t *view)
 {
-  struct authz_lookup_baton *b = baton;
-
-  /* Stop if the rule doesn't apply to this user. */
-  if (!authz_line_applies_to_user(name, b, pool))
-    return TRUE;
+  if (view->prev)
+    view->prev->next = view->next;
+  else
+    authz->first_view = view->next;
 
-  /* Set the access grants for the rule. */
-  if (strchr(value, 'r'))
-    b->allow |= svn_authz_read;
+  if (view->next)
+    view->next->prev = view->prev;
   else
-    b->deny |= svn_authz_read;
+    authz->last_view = view->prev;
 
-  if (strchr(value, 'w'))
-    b->allow |= svn_authz_write;
+  view->prev = view->next = NULL;
+}
+
+/* Put VIEW at the head of the list of views in AUTHZ.  The caller must
+ * hold AUTHZ->MUTEX.
+ */
+static void
+link_view(svn_authz_t *authz,
+          authz_view_t *view)
+{
+  view->prev = NULL;
+  view->next = authz->first_view;
+  if (view->next)
+    view->next->prev = view;
   else
-    b->deny |= svn_authz_write;
+    authz->last_view = view;
 
-  return TRUE;
+  authz->first_view = view;
 }
 
+/* Set *VIEW_P to the cached view in AUTHZ with the given KEY and add a
+ * reference to it.  Set it to NULL if there is no such view.  The caller
+ * must hold AUTHZ->MUTEX.
+ */
+static svn_error_t *
+acquire_view_locked(authz_view_t **view_p,
+                    svn_authz_t *authz,
+                    const char *key)
+{
+  authz_view_t *view = svn_hash_gets(authz->views, key);
+  if (view)
+    {
+      ++view->refcount;
+      unlink_view(authz, view);
+      link_view(authz, view);
+    }
+
+  *view_p = view;
+  return SVN_NO_ERROR;
+}
 
-/* Return TRUE iff the access rules in SECTION_NAME apply to PATH_SPEC
- * (which is a repository name, colon, and repository fspath, such as
- * "myrepos:/trunk/foo").
+/* Add the new VIEW to the cache in AUTHZ, unless some other thread has
+ * been faster, and set *VIEW_P to the cached view with a reference
+ * added to it.  Drop the least recently used views that are not in use
+ * if the cache is full.  The caller must hold AUTHZ->MUTEX.
  */
-static svn_boolean_t
-is_applicable_section(const char *path_spec,
-                      const char *section_name)
+static svn_error_t *
+publish_view_locked(authz_view_t **view_p,
+                    svn_authz_t *authz,
+                    authz_view_t *view)
 {
-  apr_size_t path_spec_len = strlen(path_spec);
+  SVN_ERR(acquire_view_locked(view_p, authz, view->key));
+  if (*view_p)
+    {
+      svn_pool_destroy(view->pool);
+      return SVN_NO_ERROR;
+    }
 
-  return ((strncmp(path_spec, section_name, path_spec_len) == 0)
-          && (path_spec[path_spec_len - 1] == '/'
-              || section_name[path_spec_len] == '/'
-              || section_name[path_spec_len] == '\0'));
+  while (apr_hash_count(authz->views) >= AUTHZ_MAX_USER_VIEWS)
+    {
+      authz_view_t *victim = authz->last_view;
+
+      svn_hash_sets(authz->views, victim->key, NULL);
+      unlink_view(authz, victim);
+      if (victim->refcount)
+        victim->evicted = TRUE;
+      else
+        svn_pool_destroy(victim->pool);
+    }
+
+  view->refcount = 1;
+  svn_hash_sets(authz->views, view->key, view);
+  link_view(authz, view);
+
+  *view_p = view;
+  return SVN_NO_ERROR;
 }
 
+/* Drop the reference to VIEW taken by acquire_view_locked() or
+ * publish_view_locked().  The caller must hold the mutex of the
+ * svn_authz_t that VIEW belongs to.
+ */
+static svn_error_t *
+release_view_locked(authz_view_t *view)
+{
+  if (--view->refcount == 0 && view->evicted)
+    svn_pool_destroy(view->pool);
+
+  return SVN_NO_ERROR;
+}
 
-/* Callback to parse a section and update the authz_baton if the
- * section denies access to the subtree the baton describes.
+/* Set *VIEW_P to the prefix tree of USER in the repository REPOS_NAME
+ * as described by AUTHZ and add a reference to it.  Filter the full
+ * prefix tree if the view is not cached yet.  The caller must release
+ * the view with release_view_locked().  Use SCRATCH_POOL for temporary
+ * allocations.
  */
-static svn_boolean_t
-authz_parse_section(const char *section_name, void *baton, apr_pool_t *pool)
+static svn_error_t *
+get_user_view(authz_view_t **view_p,
+              svn_authz_t *authz,
+              const char *repos_name,
+              const char *user,
+              apr_pool_t *scratch_pool)
 {
-  struct authz_lookup_baton *b = baton;
-  svn_boolean_t conclusive;
+  const char *key = user_view_key(repos_name, user, scratch_pool);
+  authz_view_t *view;
+  apr_pool_t *view_pool;
+
+  SVN_MUTEX__WITH_LOCK(authz->mutex,
+                       acquire_view_locked(view_p, authz, key));
+  if (*view_p)
+    return SVN_NO_ERROR;
+
+  /* Filtering can take a while.  Don't hold up other checks meanwhile. */
+  view_pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  view = apr_pcalloc(view_pool, sizeof(*view));
+  view->key = apr_pstrdup(view_pool, key);
+  view->root = authz_filter_node(authz->root, repos_name, user, TRUE,
+                                 view_pool, scratch_pool);
+  view->pool = view_pool;
+
+  SVN_MUTEX__WITH_LOCK(authz->mutex,
+                       publish_view_locked(view_p, authz, view));
 
-  /* Does the section apply to us? */
-  if (!is_applicable_section(b->qualified_repos_path, section_name)
-      && !is_applicable_section(b->repos_path, section_name))
-    return TRUE;
+  return SVN_NO_ERROR;
+}
 
-  /* Work out what this section grants. */
-  b->allow = b->deny = 0;
-  svn_config_enumerate2(b->config, section_name,
-                        authz_parse_line, b, pool);
+/* Pool cleanup function destroying all views of the svn_authz_t given
+ * as DATA.
+ */
+static apr_status_t
+destroy_views(void *data)
+{
+  svn_authz_t *authz = data;
 
-  /* Has the section explicitly determined an access? */
-  conclusive = authz_access_is_determined(b->allow, b->deny,
-                                          b->required_access);
+  while (authz->first_view)
+    {
+      authz_view_t *view = authz->first_view;
 
-  /* Is access granted OR inconclusive? */
-  b->access = authz_access_is_granted(b->allow, b->deny,
-                                      b->required_access)
-    || !conclusive;
+      authz->first_view = view->next;
+      svn_pool_destroy(view->pool);
+    }
 
-  /* As long as access isn't conclusively denied, carry on. */
-  return b->access;
+  authz->last_view = NULL;
+  return APR_SUCCESS;
 }
 
 
-/* Validate access to the given user for the given path.  This
- * function checks rules for exactly the given path, and first tries
- * to access a section specific to the given repository before falling
- * back to pan-repository rules.
- *
- * Update *access_granted to inform the caller of the outcome of the
- * lookup.  Return a boolean indicating whether the access rights were
- * successfully determined.
+/* Validate the REQUIRED_ACCESS to the canonical fspath PATH as
+ * described by the prefix tree ROOT of the respective user.  The rules
+ * for the youngest ancestor of PATH (or PATH itself) which has any
+ * rules applying to the user determine the access.  If REQUIRED_ACCESS
+ * contains svn_authz_recursive, all rules for sub-paths of PATH must
+ * grant the access as well.  Deny access if no rules apply.
  */
 static svn_boolean_t
-authz_get_path_access(svn_config_t *cfg, const char *repos_name,
-                      const char *path, const char *user,
-                      svn_repos_authz_access_t required_access,
-                      svn_boolean_t *access_granted,
-                      apr_pool_t *pool)
+authz_get_path_access(const authz_user_node_t *root,
+                      const char *path,
+                      svn_repos_authz_access_t required_access)
 {
-  const char *qualified_path;
-  struct authz_lookup_baton baton = { 0 };
+  const authz_user_node_t *node = root;
+  const authz_user_node_t *determining = NULL;
+  svn_repos_authz_access_t stripped_req
+    = required_access & (svn_authz_read | svn_authz_write);
+  const char *segment = path + 1;
+  svn_boolean_t granted;
+
+  if (root->has_rules
+      && authz_access_is_determined(root->allow, root->deny,
+                                    required_access))
+    determining = root;
+
+  /* Walk the tree down towards PATH.  Paths without a node in ROOT have
+     no rules applying to the user at or below them.  Like the rules for
+     the individual paths, only the rules that are conclusive for
+     REQUIRED_ACCESS count.  Without read or write access being asked
+     for, none ever is and access gets denied. */
+  while (node && *segment)
+    {
+      const char *end = strchr(segment, '/');
+      apr_size_t len = end ? end - segment : strlen(segment);
+
+      node = node->children
+           ? apr_hash_get(node->children, segment, len)
+           : NULL;
+      if (   node && node->has_rules
+          && authz_access_is_determined(node->allow, node->deny,
+                                        required_access))
+        determining = node;
+
+      segment += end ? len + 1 : len;
+    }
 
-  baton.config = cfg;
-  baton.user = user;
+  if (!determining)
+    return FALSE;
 
-  /* Try to locate a repository-specific block first. */
-  qualified_path = apr_pstrcat(pool, repos_name, ":", path, SVN_VA_NULL);
-  svn_config_enumerate2(cfg, qualified_path,
-                        authz_parse_line, &baton, pool);
+  granted = authz_access_is_granted(determining->allow, determining->deny,
+                                    required_access);
 
-  *access_granted = authz_access_is_granted(baton.allow, baton.deny,
-                                            required_access);
+  /* If the caller requested recursive access, no rule for any path at
+     or below PATH may deny it. */
+  if (granted && node && (required_access & svn_authz_recursive))
+    granted = !(node->denied_below & (1u << stripped_req));
 
-  /* If the first test has determined access, stop now. */
-  if (authz_access_is_determined(baton.allow, baton.deny,
-                                 required_access))
-    return TRUE;
+  return granted;
+}
 
-  /* No repository specific rule, try pan-repository rules. */
-  svn_config_enumerate2(cfg, path, authz_parse_line, &baton, pool);
 
-  *access_granted = authz_access_is_granted(baton.allow, baton.deny,
-                                            required_access);
-  return authz_access_is_determined(baton.allow, baton.deny,
-                                    required_access);
+/* Return TRUE if USER has the REQUIRED_ACCESS to any path within the
+ * repository as described by the user's prefix tree ROOT.
+ */
+static svn_boolean_t
+authz_get_any_access(const authz_user_node_t *root,
+                     svn_repos_authz_access_t required_access)
+{
+  svn_repos_authz_access_t stripped_req
+    = required_access & (svn_authz_read | svn_authz_write);
+
+  /* Any section explicitly granting the access will do. */
+  return stripped_req != svn_authz_none
+      && (root->granted_below & (1u << stripped_req));
 }
 
 
-/* Validate access to the given user for the subtree starting at the
- * given path.  This function walks the whole authz file in search of
- * rules applying to paths in the requested subtree which deny the
- * requested access.
- *
- * As soon as one is found, or else when the whole ACL file has been
- * searched, return the updated authorization status.
+
+/*** Compiling the authz file. ***/
+
+/* Return the members of GROUP as described in authz_rule_t, using the
+ * definitions in B->CONFIG.  The group definitions must already have
+ * been validated.
  */
-static svn_boolean_t
-authz_get_tree_access(svn_config_t *cfg, const char *repos_name,
-                      const char *path, const char *user,
-                      svn_repos_authz_access_t required_access,
-                      apr_pool_t *pool)
+static apr_hash_t *
+authz_group_members(struct authz_compile_baton *b,
+                    const char *group)
 {
-  struct authz_lookup_baton baton = { 0 };
+  apr_hash_t *members = svn_hash_gets(b->groups, group);
+  const char *value;
+  apr_array_header_t *list;
+  int i;
 
-  baton.config = cfg;
-  baton.user = user;
-  baton.required_access = required_access;
-  baton.repos_path = path;
-  baton.qualified_repos_path = apr_pstrcat(pool, repos_name,
-                                           ":", path, SVN_VA_NULL);
-  /* Default to access granted if no rules say otherwise. */
-  baton.access = TRUE;
-
-  svn_config_enumerate_sections2(cfg, authz_parse_section,
-                                 &baton, pool);
+  if (members)
+    return members;
+
+  members = apr_hash_make(b->pool);
+  svn_config_get(b->config, &value, "groups", group, NULL);
+  list = svn_cstring_split(value, ",", TRUE, b->pool);
 
-  return baton.access;
+  for (i = 0; i < list->nelts; i++)
+    {
+      const char *group_user = APR_ARRAY_IDX(list, i, char *);
+
+      /* Resolve subgroups and aliases here, once. */
+      if (*group_user == '@')
+        {
+          apr_hash_t *subgroup = authz_group_members(b, &group_user[1]);
+          apr_hash_index_t *hi;
+
+          for (hi = apr_hash_first(b->pool, subgroup);
+               hi;
+               hi = apr_hash_next(hi))
+            svn_hash_sets(members, apr_hash_this_key(hi), "");
+        }
+      else if (*group_user == '&')
+        {
+          const char *alias;
+
+          svn_config_get(b->config, &alias, "aliases", &group_user[1], NULL);
+          svn_hash_sets(members, alias, "");
+        }
+      else
+        {
+          svn_hash_sets(members, group_user, "");
+        }
+    }
+
+  svn_hash_sets(b->groups, apr_pstrdup(b->pool, group), members);
+  return members;
 }
 
 
-/* Callback to parse sections of the configuration file, looking for
-   any kind of granted access.  Implements the
-   svn_config_section_enumerator2_t interface. */
+/* Callback to compile one rule of an authz section and add it to
+ * the current list of rules in the authz_compile_baton BATON.
+ */
 static svn_boolean_t
-authz_get_any_access_parser_cb(const char *section_name, void *baton,
-                               apr_pool_t *pool)
+authz_compile_rule(const char *rule_match_string,
+                   const char *value,
+                   void *baton,
+                   apr_pool_t *pool)
 {
-  struct authz_lookup_baton *b = baton;
+  struct authz_compile_baton *b = baton;
+  authz_rule_t *rule = apr_pcalloc(b->pool, sizeof(*rule));
+  const char *match = rule_match_string;
 
-  /* Does the section apply to the query? */
-  if (section_name[0] == '/'
-      || strncmp(section_name, b->qualified_repos_path,
-                 strlen(b->qualified_repos_path)) == 0)
+  if (match[0] == '~')
     {
-      b->allow = b->deny = svn_authz_none;
-
-      svn_config_enumerate2(b->config, section_name,
-                            authz_parse_line, baton, pool);
-      b->access = authz_access_is_granted(b->allow, b->deny,
-                                          b->required_access);
+      rule->inverted = TRUE;
+      match++;
+    }
 
-      /* Continue as long as we don't find a determined, granted access. */
-      return !(b->access
-               && authz_access_is_determined(b->allow, b->deny,
-                                             b->required_access));
+  if (strcmp(match, "$anonymous") == 0)
+    rule->kind = authz_rule_anonymous;
+  else if (strcmp(match, "$authenticated") == 0)
+    rule->kind = authz_rule_authenticated;
+  else if (strcmp(match, "*") == 0)
+    rule->kind = authz_rule_everyone;
+  else if (match[0] == '@')
+    {
+      rule->kind = authz_rule_group;
+      rule->members = authz_group_members(b, &match[1]);
     }
+  else if (match[0] == '&')
+    {
+      rule->kind = authz_rule_user;
+      svn_config_get(b->config, &rule->user, "aliases", &match[1], NULL);
+      rule->user = apr_pstrdup(b->pool, rule->user);
+    }
+  else
+    {
+      rule->kind = authz_rule_user;
+      rule->user = apr_pstrdup(b->pool, match);
+    }
+
+  if (strchr(value, 'r'))
+    rule->access |= svn_authz_read;
+  if (strchr(value, 'w'))
+    rule->access |= svn_authz_write;
+
+  APR_ARRAY_PUSH(b->rules, authz_rule_t *) = rule;
 
   return TRUE;
 }
 
 
-/* Walk through the authz CFG to check if USER has the REQUIRED_ACCESS
- * to any path within the REPOSITORY.  Return TRUE if so.  Use POOL
- * for temporary allocations. */
+/* Callback to compile the authz section given by NAME and add it to
+ * the prefix tree in the authz_compile_baton BATON.  The section must
+ * already have been validated.
+ */
 static svn_boolean_t
-authz_get_any_access(svn_config_t *cfg, const char *repos_name,
-                     const char *user,
-                     svn_repos_authz_access_t required_access,
-                     apr_pool_t *pool)
+authz_compile_section(const char *name,
+                      void *baton,
+                      apr_pool_t *pool)
 {
-  struct authz_lookup_baton baton = { 0 };
+  struct authz_compile_baton *b = baton;
+  authz_node_t *node = b->root;
+  const char *fspath = strchr(name, ':');
+  const char *segment;
 
-  baton.config = cfg;
-  baton.user = user;
-  baton.required_access = required_access;
-  baton.access = FALSE; /* Deny access by default. */
-  baton.repos_path = "/";
-  baton.qualified_repos_path = apr_pstrcat(pool, repos_name,
-                                           ":/", SVN_VA_NULL);
-
-  /* We could have used svn_config_enumerate2 for "repos_name:/".
-   * However, this requires access for root explicitly (which the user
-   * may not always have). So we end up enumerating the sections in
-   * the authz CFG and stop on the first match with some access for
-   * this user. */
-  svn_config_enumerate_sections2(cfg, authz_get_any_access_parser_cb,
-                                 &baton, pool);
+  if (strcmp(name, "groups") == 0 || strcmp(name, "aliases") == 0)
+    return TRUE;
 
-  /* If walking the configuration was inconclusive, deny access. */
-  if (!authz_access_is_determined(baton.allow,
-                                  baton.deny, baton.required_access))
-    return FALSE;
+  /* Find or create the node for the section's path. */
+  segment = (fspath ? fspath + 1 : name) + 1;
+  while (*segment)
+    {
+      const char *end = strchr(segment, '/');
+      apr_size_t len = end ? end - segment : strlen(segment);
+      authz_node_t *child = NULL;
+
+      if (node->children)
+        child = apr_hash_get(node->children, segment, len);
+      else
+        node->children = apr_hash_make(b->pool);
+
+      if (!child)
+        {
+          child = apr_pcalloc(b->pool, sizeof(*child));
+          apr_hash_set(node->children, apr_pstrmemdup(b->pool, segment, len),
+                       len, child);
+        }
+
+      node = child;
+      segment += end ? len + 1 : len;
+    }
 
-  return baton.access;
+  b->rules = apr_array_make(b->pool, 4, sizeof(authz_rule_t *));
+  svn_config_enumerate2(b->config, name, authz_compile_rule, b, pool);
+
+  if (fspath)
+    {
+      if (!node->repos_rules)
+        node->repos_rules = apr_hash_make(b->pool);
+
+      svn_hash_sets(node->repos_rules,
+                    apr_pstrmemdup(b->pool, name, fspath - name), b->rules);
+    }
+  else
+    {
+      node->rules = b->rules;
+    }
+
+  return TRUE;
 }
 
 
-
+
 /*** Validating the authz file. ***/
 
 /* Check for errors in GROUP's definition of CFG.  The errors
@@ -749,16 +1105,18 @@ static svn_boolean_t authz_validate_section(const char *name,
 }
 
 
-svn_error_t *
-svn_repos__authz_validate(svn_authz_t *authz, apr_pool_t *pool)
+/* Walk the configuration CFG looking for any errors.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+authz_validate(svn_config_t *cfg, apr_pool_t *pool)
 {
   struct authz_validate_baton baton = { 0 };
 
   baton.err = SVN_NO_ERROR;
-  baton.config = authz->cfg;
+  baton.config = cfg;
 
   /* Step through the entire rule file stopping on error. */
-  svn_config_enumerate_sections2(authz->cfg, authz_validate_section,
+  svn_config_enumerate_sections2(cfg, authz_validate_section,
                                  &baton, pool);
   SVN_ERR(baton.err);
 
@@ -766,6 +1124,40 @@ svn_repos__authz_validate(svn_authz_t *authz, apr_pool_t *pool)
 }
 
 
+svn_error_t *
+svn_repos__authz_compile(svn_authz_t **authz_p,
+                         svn_config_t *cfg,
+                         svn_boolean_t thread_safe,
+                         apr_pool_t *pool)
+{
+  svn_authz_t *authz = apr_pcalloc(pool, sizeof(*authz));
+  struct authz_compile_baton baton = { 0 };
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+
+  /* Make sure there are no errors in the configuration. */
+  SVN_ERR(authz_validate(cfg, scratch_pool));
+
+  /* Resolve all groups and put all sections into the prefix tree. */
+  baton.config = cfg;
+  baton.groups = apr_hash_make(scratch_pool);
+  baton.root = apr_pcalloc(pool, sizeof(*baton.root));
+  baton.pool = pool;
+  svn_config_enumerate_sections2(cfg, authz_compile_section, &baton,
+                                 scratch_pool);
+
+  authz->root = baton.root;
+  SVN_ERR(svn_mutex__init(&authz->mutex, thread_safe, pool));
+  authz->views = apr_hash_make(pool);
+  apr_pool_cleanup_register(pool, authz, destroy_views,
+                            apr_pool_cleanup_null);
+
+  svn_pool_destroy(scratch_pool);
+
+  *authz_p = authz;
+  return SVN_NO_ERROR;
+}
+
+
 /* Retrieve the file at DIRENT (contained in a repo) then parse it as a config
  * file placing the result into CFG_P allocated in POOL.
  *
@@ -908,16 +1300,16 @@ authz_copy_group(const char *name, const char *value,
   return TRUE;
 }
 
-/* Copy group definitions from GROUPS_CFG to the resulting AUTHZ.
- * If AUTHZ already contains any group definition, report an error.
+/* Copy group definitions from GROUPS_CFG to the resulting AUTHZ_CFG.
+ * If AUTHZ_CFG already contains any group definition, report an error.
  * Use POOL for temporary allocations. */
 static svn_error_t *
-authz_copy_groups(svn_authz_t *authz, svn_config_t *groups_cfg,
+authz_copy_groups(svn_config_t *authz_cfg, svn_config_t *groups_cfg,
                   apr_pool_t *pool)
 {
   /* Easy out: we prohibit local groups in the authz file when global
      groups are being used. */
-  if (svn_config_has_section(authz->cfg, SVN_CONFIG_SECTION_GROUPS))
+  if (svn_config_has_section(authz_cfg, SVN_CONFIG_SECTION_GROUPS))
     {
       return svn_error_create(SVN_ERR_AUTHZ_INVALID_CONFIG, NULL,
                               "Authz file cannot contain any groups "
@@ -925,7 +1317,7 @@ authz_copy_groups(svn_authz_t *authz, svn_config_t *groups_cfg,
     }
 
   svn_config_enumerate2(groups_cfg, SVN_CONFIG_SECTION_GROUPS,
-                        authz_copy_group, authz->cfg, pool);
+                        authz_copy_group, authz_cfg, pool);
 
   return SVN_NO_ERROR;
 }
@@ -935,14 +1327,14 @@ svn_repos__authz_read(svn_authz_t **authz_p, const char *path,
                       const char *groups_path, svn_boolean_t must_exist,
                       svn_boolean_t accept_urls, apr_pool_t *pool)
 {
-  svn_authz_t *authz = apr_palloc(pool, sizeof(*authz));
+  svn_config_t *cfg;
 
   /* Load the authz file */
   if (accept_urls)
-    SVN_ERR(svn_repos__retrieve_config(&authz->cfg, path, must_exist, TRUE,
+    SVN_ERR(svn_repos__retrieve_config(&cfg, path, must_exist, TRUE,
                                        pool));
   else
-    SVN_ERR(svn_config_read3(&authz->cfg, path, must_exist, TRUE, TRUE,
+    SVN_ERR(svn_config_read3(&cfg, path, must_exist, TRUE, TRUE,
                              pool));
 
   if (groups_path)
@@ -959,7 +1351,7 @@ svn_repos__authz_read(svn_authz_t **authz_p, const char *path,
                                  TRUE, TRUE, pool));
 
       /* Copy the groups from groups_cfg into authz. */
-      err = authz_copy_groups(authz, groups_cfg, pool);
+      err = authz_copy_groups(cfg, groups_cfg, pool);
 
       /* Add the paths to the error stack since the authz_copy_groups
          routine knows nothing about them. */
@@ -969,15 +1361,12 @@ svn_repos__authz_read(svn_authz_t **authz_p, const char *path,
                                  "groups file '%s':", path, groups_path);
     }
 
-  /* Make sure there are no errors in the configuration. */
-  SVN_ERR(svn_repos__authz_validate(authz, pool));
-
-  *authz_p = authz;
-  return SVN_NO_ERROR;
+  /* Validate and compile the rules. */
+  return svn_error_trace(svn_repos__authz_compile(authz_p, cfg, TRUE, pool));
 }
 
 
-
+
 /*** Public functions. ***/
 
 svn_error_t *
@@ -994,10 +1383,10 @@ svn_error_t *
 svn_repos_authz_parse(svn_authz_t **authz_p, svn_stream_t *stream,
                       svn_stream_t *groups_stream, apr_pool_t *pool)
 {
-  svn_authz_t *authz = apr_palloc(pool, sizeof(*authz));
+  svn_config_t *cfg;
 
   /* Parse the authz stream */
-  SVN_ERR(svn_config_parse(&authz->cfg, stream, TRUE, TRUE, pool));
+  SVN_ERR(svn_config_parse(&cfg, stream, TRUE, TRUE, pool));
 
   if (groups_stream)
     {
@@ -1006,14 +1395,11 @@ svn_repos_authz_parse(svn_authz_t **authz_p, svn_stream_t *stream,
       /* Parse the groups stream */
       SVN_ERR(svn_config_parse(&groups_cfg, groups_stream, TRUE, TRUE, pool));
 
-      SVN_ERR(authz_copy_groups(authz, groups_cfg, pool));
+      SVN_ERR(authz_copy_groups(cfg, groups_cfg, pool));
     }
 
-  /* Make sure there are no errors in the configuration. */
-  SVN_ERR(svn_repos__authz_validate(authz, pool));
-
-  *authz_p = authz;
-  return SVN_NO_ERROR;
+  /* Validate and compile the rules. */
+  return svn_error_trace(svn_repos__authz_compile(authz_p, cfg, TRUE, pool));
 }
 
 
@@ -1024,51 +1410,29 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
                              svn_boolean_t *access_granted,
                              apr_pool_t *pool)
 {
-  const char *current_path;
+  authz_view_t *view;
 
   if (!repos_name)
     repos_name = "";
 
-  /* If PATH is NULL, check if the user has *any* access. */
-  if (!path)
+  if (path)
     {
-      *access_granted = authz_get_any_access(authz->cfg, repos_name,
-                                             user, required_access, pool);
-      return SVN_NO_ERROR;
+      /* Sanity check. */
+      SVN_ERR_ASSERT(path[0] == '/');
+      path = svn_fspath__canonicalize(path, pool);
     }
 
-  /* Sanity check. */
-  SVN_ERR_ASSERT(path[0] == '/');
-
-  /* Determine the granted access for the requested path. */
-  path = svn_fspath__canonicalize(path, pool);
-  current_path = path;
-
-  while (!authz_get_path_access(authz->cfg, repos_name,
-                                current_path, user,
-                                required_access,
-                                access_granted,
-                                pool))
-    {
-      /* Stop if the loop hits the repository root with no
-         results. */
-      if (current_path[0] == '/' && current_path[1] == '\0')
-        {
-          /* Deny access by default. */
-          *access_granted = FALSE;
-          return SVN_NO_ERROR;
-        }
+  /* The view remains valid while we hold a reference to it. */
+  SVN_ERR(get_user_view(&view, authz, repos_name, user, pool));
 
-      /* Work back to the parent path. */
-      current_path = svn_fspath__dirname(current_path, pool);
-    }
+  /* If PATH is NULL, check if the user has *any* access. */
+  if (!path)
+    *access_granted = authz_get_any_access(view->root, required_access);
+  else
+    *access_granted = authz_get_path_access(view->root, path,
+                                            required_access);
 
-  /* If the caller requested recursive access, we need to walk through
-     the entire authz config to see whether any child paths are denied
-     to the requested user. */
-  if (*access_granted && (required_access & svn_authz_recursive))
-    *access_granted = authz_get_tree_access(authz->cfg, repos_name, path,
-                                            user, required_access, pool);
+  SVN_MUTEX__WITH_LOCK(authz->mutex, release_view_locked(view));
 
   return SVN_NO_ERROR;
 }
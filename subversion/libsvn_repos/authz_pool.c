@@ -38,13 +38,6 @@
 
 #include "repos.h"
 
-/* Currently this structure is just a wrapper around a svn_config_t.
- */
-struct svn_authz_t
-{
-  svn_config_t *cfg;
-};
-
 /* The wrapper object structure that we store in the object pool.  It
  * combines the authz with the underlying config structures and their
  * identifying keys.
@@ -63,7 +56,9 @@ typedef struct authz_object_t
   svn_config_t *authz_cfg;
   svn_config_t *groups_cfg;
 
-  /* Case-sensitive config. */
+  /* Rules compiled from AUTHZ_CFG and GROUPS_CFG.  Filtered rule sets
+     for individual users are being cached within this object and are
+     shared by all users of the pool. */
   svn_authz_t *authz;
 } authz_object_t;
 
@@ -76,6 +71,9 @@ struct svn_repos__authz_pool_t
 
   /* factory and storage of (shared) configuration objects */
   svn_repos__config_pool_t *config_pool;
+
+  /* whether the authz objects may be used by multiple threads */
+  svn_boolean_t thread_safe;
 };
 
 /* Return a combination of AUTHZ_KEY and GROUPS_KEY, allocated in POOL.
@@ -135,6 +133,7 @@ svn_repos__authz_pool_create(svn_repos__authz_pool_t **authz_pool,
   result = apr_pcalloc(pool, sizeof(*result));
   result->object_pool = object_pool;
   result->config_pool = config_pool;
+  result->thread_safe = thread_safe;
 
   *authz_pool = result;
   return SVN_NO_ERROR;
@@ -192,14 +191,11 @@ svn_repos__authz_pool_get(svn_authz_t **authz_p,
       return SVN_NO_ERROR;
     }
 
-  authz_ref->authz = apr_palloc(authz_ref_pool, sizeof(*authz_ref->authz));
-  authz_ref->authz->cfg = authz_ref->authz_cfg;
-
   if (groups_path)
     {
       /* Easy out: we prohibit local groups in the authz file when global
          groups are being used. */
-      if (svn_config_has_section(authz_ref->authz->cfg,
+      if (svn_config_has_section(authz_ref->authz_cfg,
                                  SVN_CONFIG_SECTION_GROUPS))
         return svn_error_createf(SVN_ERR_AUTHZ_INVALID_CONFIG, NULL,
                                  "Error reading authz file '%s' with "
@@ -210,13 +206,14 @@ svn_repos__authz_pool_get(svn_authz_t **authz_p,
 
       /* We simply need to add the [Groups] section to the authz config.
        */
-      svn_config__shallow_replace_section(authz_ref->authz->cfg,
+      svn_config__shallow_replace_section(authz_ref->authz_cfg,
                                           authz_ref->groups_cfg,
                                           SVN_CONFIG_SECTION_GROUPS);
     }
 
-  /* Make sure there are no errors in the configuration. */
-  SVN_ERR(svn_repos__authz_validate(authz_ref->authz, authz_ref_pool));
+  /* Make sure there are no errors in the configuration and compile it. */
+  SVN_ERR(svn_repos__authz_compile(&authz_ref->authz, authz_ref->authz_cfg,
+                                   authz_pool->thread_safe, authz_ref_pool));
 
   SVN_ERR(svn_object_pool__insert((void **)authz_p, authz_pool->object_pool,
                                   authz_ref->key, authz_ref, NULL,
@@ -22,6 +22,8 @@
 
 
 #include <stdarg.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 #include "svn_private_config.h"
 #include "svn_pools.h"
@@ -38,12 +40,14 @@
 #include "svn_props.h"
 #include "svn_sorts.h"
 
+#include "private/svn_mutex.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_fs_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
+#include "private/svn_subr_private.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -1963,6 +1967,701 @@ write_revision_record(svn_stream_t *stream,
 
 
 
+/* Helper for svn_repos_dump_fs.
+
+   Write the dump of revision REV in FS to STREAM, i.e. its revision record
+   followed by its changes as selected by INCLUDE_CHANGES.  START_REV is
+   the first revision of the whole dump.  For INCREMENTAL, USE_DELTAS,
+   INCLUDE_REVPROPS, NOTIFY_FUNC and NOTIFY_BATON see svn_repos_dump_fs4().
+   Set *FOUND_OLD_REFERENCE and *FOUND_OLD_MERGEINFO as get_dump_editor()
+   does.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+dump_one_revision(svn_stream_t *stream,
+                  svn_fs_t *fs,
+                  svn_revnum_t rev,
+                  svn_revnum_t start_rev,
+                  svn_boolean_t incremental,
+                  svn_boolean_t use_deltas,
+                  svn_boolean_t include_revprops,
+                  svn_boolean_t include_changes,
+                  svn_boolean_t *found_old_reference,
+                  svn_boolean_t *found_old_mergeinfo,
+                  svn_repos_notify_func_t notify_func,
+                  void *notify_baton,
+                  apr_pool_t *scratch_pool)
+{
+  const svn_delta_editor_t *dump_editor;
+  void *dump_edit_baton = NULL;
+  svn_fs_root_t *to_root;
+  svn_boolean_t use_deltas_for_rev;
+
+  /* Write the revision record. */
+  SVN_ERR(write_revision_record(stream, fs, rev, include_revprops,
+                                scratch_pool));
+
+  /* When dumping revision 0, we just write out the revision record.
+     The parser might want to use its properties.
+     If we don't want revision changes at all, skip in any case. */
+  if (rev == 0 || !include_changes)
+    return SVN_NO_ERROR;
+
+  /* Fetch the editor which dumps nodes to a file.  Regardless of
+     what we've been told, don't use deltas for the first rev of a
+     non-incremental dump. */
+  use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
+  SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
+                          "", stream, found_old_reference,
+                          found_old_mergeinfo, NULL,
+                          notify_func, notify_baton,
+                          start_rev, use_deltas_for_rev, FALSE, FALSE,
+                          scratch_pool));
+
+  /* Drive the editor in one way or another. */
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, scratch_pool));
+
+  /* If this is the first revision of a non-incremental dump,
+     we're in for a full tree dump.  Otherwise, we want to simply
+     replay the revision.  */
+  if ((rev == start_rev) && (! incremental))
+    {
+      /* Compare against revision 0, so everything appears to be added. */
+      svn_fs_root_t *from_root;
+      SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, scratch_pool));
+      SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
+                                   to_root, "",
+                                   dump_editor, dump_edit_baton,
+                                   NULL,
+                                   NULL,
+                                   FALSE, /* don't send text-deltas */
+                                   svn_depth_infinity,
+                                   FALSE, /* don't send entry props */
+                                   FALSE, /* don't ignore ancestry */
+                                   scratch_pool));
+    }
+  else
+    {
+      /* The normal case: compare consecutive revs. */
+      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                                dump_editor, dump_edit_baton,
+                                NULL, NULL, scratch_pool));
+
+      /* While our editor close_edit implementation is a no-op, we still
+         do this for completeness. */
+      SVN_ERR(dump_editor->close_edit(dump_edit_baton, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Number of revisions per job that the concurrent dump and verification
+ * may process ahead of the oldest revision not reported yet.  Larger values
+ * keep the workers busy when a single revision is expensive, while smaller
+ * values reduce the amount of buffered output and notifications. */
+#define REVISIONS_PER_JOB 16
+
+/* Maximum amount of dump data per revision that the concurrent dump
+ * buffers in memory.  Anything beyond that goes to a temporary file. */
+#define DUMP_MEMORY_PER_REVISION (1024 * 1024)
+
+/* Baton type for record_notification(). */
+typedef struct record_notification_baton_t
+{
+  apr_array_header_t *notifications;
+  apr_pool_t *result_pool;
+} record_notification_baton_t;
+
+/* Implements svn_repos_notify_func_t.  Append a copy of NOTIFY to the
+ * list of notifications of the record_notification_baton_t BATON. */
+static void
+record_notification(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  record_notification_baton_t *nb = baton;
+  svn_repos_notify_t *copy = apr_pmemdup(nb->result_pool, notify,
+                                         sizeof(*notify));
+  copy->warning_str = apr_pstrdup(nb->result_pool, notify->warning_str);
+  copy->path = apr_pstrdup(nb->result_pool, notify->path);
+
+  APR_ARRAY_PUSH(nb->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Implements svn_fs_warning_callback_t for the FS objects of the worker
+ * threads.  Record ERR as a warning notification with the
+ * record_notification_baton_t BATON, so it gets reported in revision order
+ * like all other notifications.  Warnings outside any revision or without
+ * a notification receiver are dropped. */
+static void
+record_fs_warning(void *baton,
+                  svn_error_t *err)
+{
+  record_notification_baton_t *nb = baton;
+  svn_repos_notify_t *notify;
+  char buf[256];
+
+  if (!nb->notifications)
+    return;
+
+  notify = svn_repos_notify_create(svn_repos_notify_warning,
+                                   nb->result_pool);
+  notify->warning = svn_repos_notify_warning_filesystem;
+  notify->warning_str = apr_pstrdup(nb->result_pool,
+                                    svn_err_best_message(err, buf,
+                                                         sizeof(buf)));
+
+  APR_ARRAY_PUSH(nb->notifications, svn_repos_notify_t *) = notify;
+}
+
+/* Hands out revisions to worker threads and lets the main thread pick up
+ * their results in revision order.  Workers will not get ahead of the
+ * oldest revision that has not been reported, yet, by more than SIZE
+ * revisions.  Thus, expensive revisions don't stall the other workers
+ * while the amount of buffered results remains bounded.
+ *
+ * The per-revision results are to be kept in an array of SIZE elements,
+ * indexed by revision modulo SIZE.  The worker owns that element between
+ * window_take() and window_done();  the main thread owns it between
+ * window_wait() and window_release().
+ */
+typedef struct rev_window_t
+{
+  /* Revisions to process. */
+  svn_revnum_t end_rev;
+
+  /* Maximum number of revisions in flight or waiting to be reported. */
+  int size;
+
+  /* Next revision to hand out to a worker. */
+  svn_revnum_t next_rev;
+
+  /* All revisions before this one have been released by the main thread.
+   */
+  svn_revnum_t released_rev;
+
+  /* Completion flags, indexed by revision modulo SIZE. */
+  svn_boolean_t *done;
+
+  /* Number of workers that did not call window_leave(), yet. */
+  int workers;
+
+  /* If set, don't hand out any more revisions. */
+  svn_boolean_t stop;
+
+  /* Synchronization objects protecting all of the above. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *changed;
+} rev_window_t;
+
+/* Set *WINDOW to a new rev_window_t for the revisions START_REV to END_REV
+ * with SIZE slots, expecting WORKERS worker threads.  Allocate it in
+ * RESULT_POOL. */
+static svn_error_t *
+window_create(rev_window_t **window,
+              svn_revnum_t start_rev,
+              svn_revnum_t end_rev,
+              int size,
+              int workers,
+              apr_pool_t *result_pool)
+{
+  rev_window_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  apr_status_t status;
+
+  result->end_rev = end_rev;
+  result->size = size;
+  result->next_rev = start_rev;
+  result->released_rev = start_rev;
+  result->done = apr_pcalloc(result_pool, size * sizeof(*result->done));
+  result->workers = workers;
+
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, result_pool));
+  status = apr_thread_cond_create(&result->changed, result_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  *window = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for a change in WINDOW.  Call this with WINDOW's mutex being held. */
+static svn_error_t *
+window_wait_for_change(rev_window_t *window)
+{
+  apr_status_t status
+    = apr_thread_cond_wait(window->changed, svn_mutex__get(window->mutex));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait for condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Notify all threads waiting for a change in WINDOW.  Call this with
+ * WINDOW's mutex being held. */
+static svn_error_t *
+window_changed(rev_window_t *window)
+{
+  apr_status_t status = apr_thread_cond_broadcast(window->changed);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't broadcast condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of window_take(), to be called with WINDOW's mutex being held. */
+static svn_error_t *
+window_take_body(svn_revnum_t *revision,
+                 rev_window_t *window)
+{
+  while (   !window->stop
+         && window->next_rev <= window->end_rev
+         && window->next_rev >= window->released_rev + window->size)
+    SVN_ERR(window_wait_for_change(window));
+
+  if (window->stop || window->next_rev > window->end_rev)
+    {
+      *revision = SVN_INVALID_REVNUM;
+    }
+  else
+    {
+      *revision = window->next_rev++;
+      window->done[*revision % window->size] = FALSE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *REVISION to the next revision in WINDOW that the calling worker
+ * shall process.  Block while the window is full.  Set *REVISION to
+ * SVN_INVALID_REVNUM if there is nothing left to do. */
+static svn_error_t *
+window_take(svn_revnum_t *revision,
+            rev_window_t *window)
+{
+  SVN_MUTEX__WITH_LOCK(window->mutex, window_take_body(revision, window));
+  return SVN_NO_ERROR;
+}
+
+/* Body of window_done(), to be called with WINDOW's mutex being held. */
+static svn_error_t *
+window_done_body(rev_window_t *window,
+                 svn_revnum_t revision)
+{
+  window->done[revision % window->size] = TRUE;
+  return svn_error_trace(window_changed(window));
+}
+
+/* Tell WINDOW that the worker has completed REVISION. */
+static svn_error_t *
+window_done(rev_window_t *window,
+            svn_revnum_t revision)
+{
+  SVN_MUTEX__WITH_LOCK(window->mutex, window_done_body(window, revision));
+  return SVN_NO_ERROR;
+}
+
+/* Body of window_leave(), to be called with WINDOW's mutex being held. */
+static svn_error_t *
+window_leave_body(rev_window_t *window,
+                  svn_boolean_t failed)
+{
+  window->workers--;
+  if (failed)
+    window->stop = TRUE;
+
+  return svn_error_trace(window_changed(window));
+}
+
+/* Tell WINDOW that the calling worker terminates.  If FAILED is set,
+ * stop handing out revisions to the other workers as well. */
+static svn_error_t *
+window_leave(rev_window_t *window,
+             svn_boolean_t failed)
+{
+  SVN_MUTEX__WITH_LOCK(window->mutex, window_leave_body(window, failed));
+  return SVN_NO_ERROR;
+}
+
+/* Body of window_wait(), to be called with WINDOW's mutex being held. */
+static svn_error_t *
+window_wait_body(svn_boolean_t *available,
+                 rev_window_t *window,
+                 svn_revnum_t revision)
+{
+  /* Once REVISION has been handed out, it will be completed unless its
+     worker dies.  Otherwise, wait until it gets handed out, unless the
+     workers have been stopped. */
+  while (!(   revision < window->next_rev
+           && window->done[revision % window->size]))
+    {
+      if (   window->workers == 0
+          || (window->stop && revision >= window->next_rev))
+        break;
+
+      SVN_ERR(window_wait_for_change(window));
+    }
+
+  *available = revision < window->next_rev
+            && window->done[revision % window->size];
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the workers to complete REVISION in WINDOW, which must be the
+ * oldest revision not released, yet.  Set *AVAILABLE to FALSE if that
+ * won't happen because the workers have stopped or terminated. */
+static svn_error_t *
+window_wait(svn_boolean_t *available,
+            rev_window_t *window,
+            svn_revnum_t revision)
+{
+  SVN_MUTEX__WITH_LOCK(window->mutex,
+                       window_wait_body(available, window, revision));
+  return SVN_NO_ERROR;
+}
+
+/* Body of window_release(), to be called with WINDOW's mutex being held. */
+static svn_error_t *
+window_release_body(rev_window_t *window,
+                    svn_revnum_t revision)
+{
+  window->released_rev = revision + 1;
+  return svn_error_trace(window_changed(window));
+}
+
+/* Tell WINDOW that the main thread is done with the results of REVISION,
+ * i.e. the workers may reuse its slot. */
+static svn_error_t *
+window_release(rev_window_t *window,
+               svn_revnum_t revision)
+{
+  SVN_MUTEX__WITH_LOCK(window->mutex, window_release_body(window, revision));
+  return SVN_NO_ERROR;
+}
+
+/* Body of window_stop(), to be called with WINDOW's mutex being held. */
+static svn_error_t *
+window_stop_body(rev_window_t *window)
+{
+  window->stop = TRUE;
+  return svn_error_trace(window_changed(window));
+}
+
+/* Make the workers of WINDOW terminate after their current revision. */
+static svn_error_t *
+window_stop(rev_window_t *window)
+{
+  SVN_MUTEX__WITH_LOCK(window->mutex, window_stop_body(window));
+  return SVN_NO_ERROR;
+}
+
+/* A revision to dump concurrently and the results of that. */
+typedef struct dump_rev_t
+{
+  /* Root pool of this slot.  The dump data and the recorded notifications
+   * live in here and remain valid until the revision has been written. */
+  apr_pool_t *pool;
+
+  /* Notifications sent while dumping (svn_repos_notify_t *).  They will
+   * be replayed in revision order. */
+  apr_array_header_t *notifications;
+
+  /* The dump data for this revision. */
+  svn_spillbuf_t *contents;
+
+  /* Outcome of the dump. */
+  svn_error_t *err;
+} dump_rev_t;
+
+/* Data shared by all lanes of a concurrent dump. */
+typedef struct dump_context_t
+{
+  /* Repository to dump.  Every lane will open its own FS object. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+
+  /* Hands out the revisions to dump. */
+  rev_window_t *window;
+
+  /* Results, indexed by revision modulo the WINDOW size. */
+  dump_rev_t *revs;
+
+  /* Parameters to dump_one_revision(). */
+  svn_revnum_t start_rev;
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+  svn_boolean_t include_revprops;
+  svn_boolean_t include_changes;
+  svn_boolean_t record_notifications;
+
+  /* Cancellation support.  CANCEL_FUNC must be thread-safe. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} dump_context_t;
+
+/* A single worker thread of the concurrent dump. */
+typedef struct dump_lane_t
+{
+  /* Data shared with all other lanes. */
+  dump_context_t *context;
+
+  /* Root pool owned by this lane. */
+  apr_pool_t *pool;
+
+  /* Flags set by the dump editor for the revisions of this lane. */
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+
+  /* The thread executing this lane and its overall result. */
+  apr_thread_t *thread;
+  svn_error_t *err;
+} dump_lane_t;
+
+/* Thread function of the dump_lane_t in DATA.  Keep picking the next
+ * revision to dump from the window and dump it into a buffer until there
+ * is none left.  The lane uses the same FS object for all its revisions.
+ */
+static void * APR_THREAD_FUNC
+dump_lane_thread(apr_thread_t *thread,
+                 void *data)
+{
+  dump_lane_t *lane = data;
+  dump_context_t *context = lane->context;
+  apr_pool_t *iterpool = svn_pool_create(lane->pool);
+  record_notification_baton_t *nb = apr_pcalloc(lane->pool, sizeof(*nb));
+  svn_fs_t *fs;
+
+  lane->err = svn_fs_open2(&fs, context->fs_path, context->fs_config,
+                           lane->pool, lane->pool);
+  if (!lane->err)
+    svn_fs_set_warning_func(fs, record_fs_warning, nb);
+
+  while (!lane->err)
+    {
+      dump_rev_t *rev;
+      svn_revnum_t revision;
+
+      lane->err = window_take(&revision, context->window);
+      if (lane->err || !SVN_IS_VALID_REVNUM(revision))
+        break;
+
+      svn_pool_clear(iterpool);
+      rev = &context->revs[revision % context->window->size];
+      rev->notifications = apr_array_make(rev->pool, 0,
+                                          sizeof(svn_repos_notify_t *));
+      rev->contents = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                           DUMP_MEMORY_PER_REVISION,
+                                           rev->pool);
+      nb->notifications = rev->notifications;
+      nb->result_pool = rev->pool;
+
+      if (context->cancel_func)
+        rev->err = context->cancel_func(context->cancel_baton);
+
+      if (!rev->err)
+        rev->err = dump_one_revision(svn_stream__from_spillbuf(rev->contents,
+                                                               iterpool),
+                                     fs, revision, context->start_rev,
+                                     context->incremental,
+                                     context->use_deltas,
+                                     context->include_revprops,
+                                     context->include_changes,
+                                     &lane->found_old_reference,
+                                     &lane->found_old_mergeinfo,
+                                     context->record_notifications
+                                       ? record_notification
+                                       : NULL,
+                                     nb, iterpool);
+
+      /* The slot belongs to the main thread from here on. */
+      nb->notifications = NULL;
+      lane->err = window_done(context->window, revision);
+    }
+
+  svn_pool_destroy(iterpool);
+  lane->err = svn_error_compose_create(lane->err,
+                                       window_leave(context->window,
+                                                    lane->err != NULL));
+
+  return NULL;
+}
+
+/* Write the contents of BUFFER to STREAM.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+write_spillbuf(svn_stream_t *stream,
+               svn_spillbuf_t *buffer,
+               apr_pool_t *scratch_pool)
+{
+  while (TRUE)
+    {
+      const char *data;
+      apr_size_t len;
+
+      SVN_ERR(svn_spillbuf__read(&data, &len, buffer, scratch_pool));
+      if (data == NULL)
+        break;
+
+      SVN_ERR(svn_stream_write(stream, data, &len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Dump the revisions START_REV to END_REV in FS to STREAM using JOBS
+ * worker threads.  Write the output and send the notifications in
+ * revision order, i.e. produce the same result as a sequential dump.
+ * Set *FOUND_OLD_REFERENCE and
+ * *FOUND_OLD_MERGEINFO if the respective warnings have been issued;
+ * leave them untouched otherwise.  For all other parameters see
+ * svn_repos_dump_fs4().
+ *
+ * The lanes pick up the next revision that has not been dumped yet as
+ * soon as they become idle, i.e. large revisions will not stall the other
+ * lanes.  They may get ahead of the output by up to REVISIONS_PER_JOB
+ * revisions each, which limits the amount of buffered dump data.
+ */
+static svn_error_t *
+dump_revisions_concurrently(svn_stream_t *stream,
+                            svn_fs_t *fs,
+                            svn_revnum_t start_rev,
+                            svn_revnum_t end_rev,
+                            svn_boolean_t incremental,
+                            svn_boolean_t use_deltas,
+                            svn_boolean_t include_revprops,
+                            svn_boolean_t include_changes,
+                            int jobs,
+                            svn_boolean_t *found_old_reference,
+                            svn_boolean_t *found_old_mergeinfo,
+                            svn_repos_notify_func_t notify_func,
+                            void *notify_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int window_size = jobs * REVISIONS_PER_JOB;
+  dump_context_t *context = apr_pcalloc(scratch_pool, sizeof(*context));
+  dump_lane_t *lanes = apr_pcalloc(scratch_pool, jobs * sizeof(*lanes));
+  svn_repos_notify_t *notify = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_revnum_t rev;
+  int i, k, started;
+
+  context->fs_path = svn_fs_path(fs, scratch_pool);
+  context->fs_config = svn_fs_config(fs, scratch_pool);
+  context->revs = apr_pcalloc(scratch_pool,
+                              window_size * sizeof(*context->revs));
+  context->start_rev = start_rev;
+  context->incremental = incremental;
+  context->use_deltas = use_deltas;
+  context->include_revprops = include_revprops;
+  context->include_changes = include_changes;
+  context->record_notifications = notify_func != NULL;
+  context->cancel_func = cancel_func;
+  context->cancel_baton = cancel_baton;
+  SVN_ERR(window_create(&context->window, start_rev, end_rev, window_size,
+                        jobs, scratch_pool));
+
+  for (i = 0; i < window_size; ++i)
+    context->revs[i].pool = svn_pool_create(NULL);
+
+  if (notify_func)
+    notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
+                                     scratch_pool);
+
+  /* Start the lanes.  They will run until all revisions have been
+     dumped or we tell them to stop. */
+  for (started = 0; started < jobs; ++started)
+    {
+      dump_lane_t *lane = &lanes[started];
+      apr_status_t status;
+
+      lane->context = context;
+      lane->pool = svn_pool_create(NULL);
+      lane->err = SVN_NO_ERROR;
+
+      status = apr_thread_create(&lane->thread, NULL, dump_lane_thread,
+                                 lane, lane->pool);
+      if (status)
+        {
+          svn_pool_destroy(lane->pool);
+          err = svn_error_wrap_apr(status, _("Can't create thread"));
+          break;
+        }
+    }
+
+  /* Write the results in revision order.  Stop at the first failed
+   * revision, just like a sequential dump would. */
+  for (rev = start_rev; rev <= end_rev && !err; ++rev)
+    {
+      dump_rev_t *result = &context->revs[rev % window_size];
+      svn_boolean_t available;
+
+      svn_pool_clear(iterpool);
+
+      err = window_wait(&available, context->window, rev);
+      if (err || !available)
+        break;
+
+      if (notify_func)
+        for (k = 0; k < result->notifications->nelts; ++k)
+          notify_func(notify_baton,
+                      APR_ARRAY_IDX(result->notifications, k,
+                                    svn_repos_notify_t *),
+                      iterpool);
+
+      err = result->err;
+      result->err = SVN_NO_ERROR;
+
+      if (!err)
+        err = write_spillbuf(stream, result->contents, iterpool);
+
+      if (!err && notify_func)
+        {
+          notify->revision = rev;
+          notify_func(notify_baton, notify, iterpool);
+        }
+
+      svn_pool_clear(result->pool);
+      if (!err)
+        err = window_release(context->window, rev);
+    }
+
+  /* Wait for the lanes to finish. */
+  err = svn_error_compose_create(err, window_stop(context->window));
+  for (i = 0; i < started; ++i)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, lanes[i].thread);
+      if (status)
+        err = svn_error_compose_create(err,
+                svn_error_wrap_apr(status, _("Can't join thread")));
+
+      err = svn_error_compose_create(err, lanes[i].err);
+      *found_old_reference |= lanes[i].found_old_reference;
+      *found_old_mergeinfo |= lanes[i].found_old_mergeinfo;
+      svn_pool_destroy(lanes[i].pool);
+    }
+
+  /* Clean up. */
+  for (i = 0; i < window_size; ++i)
+    {
+      svn_error_clear(context->revs[i].err);
+      svn_pool_destroy(context->revs[i].pool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif
+
+
 /* The main dumper. */
 svn_error_t *
 svn_repos_dump_fs4(svn_repos_t *repos,
@@ -1973,14 +2672,13 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    svn_boolean_t use_deltas,
                    svn_boolean_t include_revprops,
                    svn_boolean_t include_changes,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  const svn_delta_editor_t *dump_editor;
-  void *dump_edit_baton = NULL;
   svn_revnum_t rev;
   svn_fs_t *fs = svn_repos_fs(repos);
   apr_pool_t *iterpool = svn_pool_create(pool);
@@ -2040,74 +2738,37 @@ svn_repos_dump_fs4(svn_repos_t *repos,
     notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
                                      pool);
 
+#if APR_HAS_THREADS
+  /* Revisions get dumped independently from each other, so we can do that
+     concurrently as long as we write them out in order. */
+  if (jobs > 1 && start_rev < end_rev)
+    SVN_ERR(dump_revisions_concurrently(stream, fs, start_rev, end_rev,
+                                        incremental, use_deltas,
+                                        include_revprops, include_changes,
+                                        (int)MIN(jobs,
+                                                 end_rev - start_rev + 1),
+                                        &found_old_reference,
+                                        &found_old_mergeinfo,
+                                        notify_func, notify_baton,
+                                        cancel_func, cancel_baton,
+                                        iterpool));
+  else
+#endif
   /* Main loop:  we're going to dump revision REV.  */
   for (rev = start_rev; rev <= end_rev; rev++)
     {
-      svn_fs_root_t *to_root;
-      svn_boolean_t use_deltas_for_rev;
-
       svn_pool_clear(iterpool);
 
       /* Check for cancellation. */
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Write the revision record. */
-      SVN_ERR(write_revision_record(stream, fs, rev, include_revprops,
-                                    iterpool));
-
-      /* When dumping revision 0, we just write out the revision record.
-         The parser might want to use its properties.
-         If we don't want revision changes at all, skip in any case. */
-      if (rev == 0 || !include_changes)
-        goto loop_end;
-
-      /* Fetch the editor which dumps nodes to a file.  Regardless of
-         what we've been told, don't use deltas for the first rev of a
-         non-incremental dump. */
-      use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
-      SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
-                              "", stream, &found_old_reference,
-                              &found_old_mergeinfo, NULL,
-                              notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE, FALSE,
-                              iterpool));
-
-      /* Drive the editor in one way or another. */
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, iterpool));
-
-      /* If this is the first revision of a non-incremental dump,
-         we're in for a full tree dump.  Otherwise, we want to simply
-         replay the revision.  */
-      if ((rev == start_rev) && (! incremental))
-        {
-          /* Compare against revision 0, so everything appears to be added. */
-          svn_fs_root_t *from_root;
-          SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, iterpool));
-          SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
-                                       to_root, "",
-                                       dump_editor, dump_edit_baton,
-                                       NULL,
-                                       NULL,
-                                       FALSE, /* don't send text-deltas */
-                                       svn_depth_infinity,
-                                       FALSE, /* don't send entry props */
-                                       FALSE, /* don't ignore ancestry */
-                                       iterpool));
-        }
-      else
-        {
-          /* The normal case: compare consecutive revs. */
-          SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                    dump_editor, dump_edit_baton,
-                                    NULL, NULL, iterpool));
-
-          /* While our editor close_edit implementation is a no-op, we still
-             do this for completeness. */
-          SVN_ERR(dump_editor->close_edit(dump_edit_baton, iterpool));
-        }
+      SVN_ERR(dump_one_revision(stream, fs, rev, start_rev, incremental,
+                                use_deltas, include_revprops,
+                                include_changes, &found_old_reference,
+                                &found_old_mergeinfo,
+                                notify_func, notify_baton, iterpool));
 
-    loop_end:
       if (notify_func)
         {
           notify->revision = rev;
@@ -2387,12 +3048,266 @@ report_error(svn_revnum_t revision,
     }
 }
 
+#if APR_HAS_THREADS
+
+/* A revision to verify concurrently and the results of that. */
+typedef struct verify_rev_t
+{
+  /* Root pool of this slot.  The recorded notifications live in here and
+   * remain valid until the revision has been reported. */
+  apr_pool_t *pool;
+
+  /* Notifications sent during the verification (svn_repos_notify_t *).
+   * They will be replayed in revision order. */
+  apr_array_header_t *notifications;
+
+  /* Outcome of the verification. */
+  svn_error_t *err;
+} verify_rev_t;
+
+/* Data shared by all lanes of a concurrent verification. */
+typedef struct verify_context_t
+{
+  /* Repository to verify.  Every lane will open its own FS object. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+
+  /* Hands out the revisions to verify. */
+  rev_window_t *window;
+
+  /* Results, indexed by revision modulo the WINDOW size. */
+  verify_rev_t *revs;
+
+  /* Parameters to verify_one_revision(). */
+  svn_revnum_t start_rev;
+  svn_boolean_t check_normalization;
+  svn_boolean_t record_notifications;
+
+  /* Cancellation support.  CANCEL_FUNC must be thread-safe. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} verify_context_t;
+
+/* A single worker thread of the concurrent verification. */
+typedef struct verify_lane_t
+{
+  /* Data shared with all other lanes. */
+  verify_context_t *context;
+
+  /* Root pool owned by this lane. */
+  apr_pool_t *pool;
+
+  /* The thread executing this lane and its overall result. */
+  apr_thread_t *thread;
+  svn_error_t *err;
+} verify_lane_t;
+
+/* Thread function of the verify_lane_t in DATA.  Keep picking the next
+ * revision to check from the window and verify it until there is none
+ * left.  The lane uses the same FS object for all its revisions.
+ */
+static void * APR_THREAD_FUNC
+verify_lane_thread(apr_thread_t *thread,
+                   void *data)
+{
+  verify_lane_t *lane = data;
+  verify_context_t *context = lane->context;
+  apr_pool_t *iterpool = svn_pool_create(lane->pool);
+  record_notification_baton_t *nb = apr_pcalloc(lane->pool, sizeof(*nb));
+  svn_fs_t *fs;
+
+  lane->err = svn_fs_open2(&fs, context->fs_path, context->fs_config,
+                           lane->pool, lane->pool);
+  if (!lane->err)
+    svn_fs_set_warning_func(fs, record_fs_warning, nb);
+
+  while (!lane->err)
+    {
+      verify_rev_t *rev;
+      svn_revnum_t revision;
+
+      lane->err = window_take(&revision, context->window);
+      if (lane->err || !SVN_IS_VALID_REVNUM(revision))
+        break;
+
+      svn_pool_clear(iterpool);
+      rev = &context->revs[revision % context->window->size];
+      rev->notifications = apr_array_make(rev->pool, 0,
+                                          sizeof(svn_repos_notify_t *));
+      nb->notifications = rev->notifications;
+      nb->result_pool = rev->pool;
+
+      rev->err = verify_one_revision(fs, revision,
+                                     context->record_notifications
+                                       ? record_notification
+                                       : NULL,
+                                     nb, context->start_rev,
+                                     context->check_normalization,
+                                     context->cancel_func,
+                                     context->cancel_baton, iterpool);
+
+      /* The slot belongs to the main thread from here on. */
+      nb->notifications = NULL;
+      lane->err = window_done(context->window, revision);
+    }
+
+  svn_pool_destroy(iterpool);
+  lane->err = svn_error_compose_create(lane->err,
+                                       window_leave(context->window,
+                                                    lane->err != NULL));
+
+  return NULL;
+}
+
+/* Verify the revisions START_REV to END_REV in FS using JOBS worker threads
+ * and report the results in revision order.  With the exception of JOBS,
+ * the parameters are the same as for svn_repos_verify_fs4().
+ *
+ * The lanes pick up the next unverified revision as soon as they become
+ * idle, i.e. expensive revisions will not stall the other lanes.  They may
+ * get ahead of the reporting by up to REVISIONS_PER_JOB revisions each.
+ */
+static svn_error_t *
+verify_revisions_concurrently(svn_fs_t *fs,
+                              svn_revnum_t start_rev,
+                              svn_revnum_t end_rev,
+                              int jobs,
+                              svn_boolean_t check_normalization,
+                              svn_repos_notify_func_t notify_func,
+                              void *notify_baton,
+                              svn_repos_verify_callback_t verify_callback,
+                              void *verify_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int window_size = jobs * REVISIONS_PER_JOB;
+  verify_context_t *context = apr_pcalloc(scratch_pool, sizeof(*context));
+  verify_lane_t *lanes = apr_pcalloc(scratch_pool, jobs * sizeof(*lanes));
+  svn_repos_notify_t *notify = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_revnum_t rev;
+  int i, k, started;
+
+  context->fs_path = svn_fs_path(fs, scratch_pool);
+  context->fs_config = svn_fs_config(fs, scratch_pool);
+  context->revs = apr_pcalloc(scratch_pool,
+                              window_size * sizeof(*context->revs));
+  context->start_rev = start_rev;
+  context->check_normalization = check_normalization;
+  context->record_notifications = notify_func != NULL;
+  context->cancel_func = cancel_func;
+  context->cancel_baton = cancel_baton;
+  SVN_ERR(window_create(&context->window, start_rev, end_rev, window_size,
+                        jobs, scratch_pool));
+
+  for (i = 0; i < window_size; ++i)
+    context->revs[i].pool = svn_pool_create(NULL);
+
+  if (notify_func)
+    notify = svn_repos_notify_create(svn_repos_notify_verify_rev_end,
+                                     scratch_pool);
+
+  /* Start the lanes.  They will run until all revisions have been
+     verified or we tell them to stop. */
+  for (started = 0; started < jobs; ++started)
+    {
+      verify_lane_t *lane = &lanes[started];
+      apr_status_t status;
+
+      lane->context = context;
+      lane->pool = svn_pool_create(NULL);
+      lane->err = SVN_NO_ERROR;
+
+      status = apr_thread_create(&lane->thread, NULL, verify_lane_thread,
+                                 lane, lane->pool);
+      if (status)
+        {
+          svn_pool_destroy(lane->pool);
+          err = svn_error_wrap_apr(status, _("Can't create thread"));
+          break;
+        }
+    }
+
+  /* Report the results in revision order. */
+  for (rev = start_rev; rev <= end_rev && !err; ++rev)
+    {
+      verify_rev_t *result = &context->revs[rev % window_size];
+      svn_error_t *verify_err;
+      svn_boolean_t available;
+
+      svn_pool_clear(iterpool);
+
+      err = window_wait(&available, context->window, rev);
+      if (err || !available)
+        break;
+
+      verify_err = result->err;
+      result->err = SVN_NO_ERROR;
+
+      if (notify_func)
+        for (k = 0; k < result->notifications->nelts; ++k)
+          notify_func(notify_baton,
+                      APR_ARRAY_IDX(result->notifications, k,
+                                    svn_repos_notify_t *),
+                      iterpool);
+
+      if (verify_err && verify_err->apr_err == SVN_ERR_CANCELLED)
+        {
+          err = verify_err;
+        }
+      else if (verify_err)
+        {
+          err = report_error(rev, verify_err, verify_callback,
+                             verify_baton, iterpool);
+        }
+      else if (notify_func)
+        {
+          notify->revision = rev;
+          notify_func(notify_baton, notify, iterpool);
+        }
+
+      svn_pool_clear(result->pool);
+      if (!err)
+        err = window_release(context->window, rev);
+    }
+
+  /* Wait for the lanes to finish. */
+  err = svn_error_compose_create(err, window_stop(context->window));
+  for (i = 0; i < started; ++i)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, lanes[i].thread);
+      if (status)
+        err = svn_error_compose_create(err,
+                svn_error_wrap_apr(status, _("Can't join thread")));
+
+      err = svn_error_compose_create(err, lanes[i].err);
+      svn_pool_destroy(lanes[i].pool);
+    }
+
+  /* Clean up. */
+  for (i = 0; i < window_size; ++i)
+    {
+      svn_error_clear(context->revs[i].err);
+      svn_pool_destroy(context->revs[i].pool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif
+
 svn_error_t *
-svn_repos_verify_fs3(svn_repos_t *repos,
+svn_repos_verify_fs4(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      svn_boolean_t check_normalization,
                      svn_boolean_t metadata_only,
+                     int jobs,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_repos_verify_callback_t verify_callback,
@@ -2465,6 +3380,18 @@ svn_repos_verify_fs3(svn_repos_t *repos,
                            verify_baton, iterpool));
     }
 
+#if APR_HAS_THREADS
+  if (!metadata_only && jobs > 1 && start_rev < end_rev)
+    SVN_ERR(verify_revisions_concurrently(fs, start_rev, end_rev,
+                                          (int)MIN(jobs,
+                                                   end_rev - start_rev + 1),
+                                          check_normalization,
+                                          notify_func, notify_baton,
+                                          verify_callback, verify_baton,
+                                          cancel_func, cancel_baton,
+                                          iterpool));
+  else
+#endif
   if (!metadata_only)
     for (rev = start_rev; rev <= end_rev; rev++)
       {
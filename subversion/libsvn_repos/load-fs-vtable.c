@@ -1095,6 +1095,10 @@ close_revision(void *baton)
         return svn_error_trace(err);
     }
 
+  /* Keep the changed-paths index current, as svn_repos_fs_commit_txn()
+     does.  Readers will catch up with the index anyway. */
+  svn_error_clear(svn_repos__log_index_update(pb->repos, rb->pool));
+
   /* Run post-commit hook, if so commanded.  */
   if (pb->use_post_commit_hook)
     {
@@ -1226,7 +1230,7 @@ svn_repos_get_fs_build_parser5(const svn_repos_parse_fns3_t **callbacks,
 
 
 svn_error_t *
-svn_repos_load_fs5(svn_repos_t *repos,
+svn_repos_load_fs6(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
                    svn_revnum_t start_rev,
                    svn_revnum_t end_rev,
@@ -1236,6 +1240,7 @@ svn_repos_load_fs5(svn_repos_t *repos,
                    svn_boolean_t use_post_commit_hook,
                    svn_boolean_t validate_props,
                    svn_boolean_t ignore_dates,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -1261,6 +1266,12 @@ svn_repos_load_fs5(svn_repos_t *repos,
                                          notify_baton,
                                          pool));
 
+  if (jobs > 1)
+    return svn_repos__parse_dumpstream_pipelined(dumpstream,
+                                                 parser, parse_baton,
+                                                 cancel_func, cancel_baton,
+                                                 pool);
+
   return svn_repos_parse_dumpstream3(dumpstream, parser, parse_baton, FALSE,
                                      cancel_func, cancel_baton, pool);
 }
@@ -22,6 +22,8 @@
 
 
 #include <apr.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 #include "svn_hash.h"
 #include "svn_pools.h"
@@ -33,6 +35,7 @@
 #include "svn_ctype.h"
 
 #include "private/svn_dep_compat.h"
+#include "private/svn_mutex.h"
 
 /*----------------------------------------------------------------------*/
 
@@ -798,3 +801,964 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
   svn_pool_destroy(nodepool);
   return SVN_NO_ERROR;
 }
+
+
+
+/*----------------------------------------------------------------------*/
+
+/** The pipelined parser **/
+
+#if APR_HAS_THREADS
+
+/* Maximum number of items that may be waiting in any queue of the
+ * pipeline.  Content is passed on in chunks of at most
+ * SVN__STREAM_CHUNK_SIZE bytes, so this limits the memory held by the
+ * pipeline to a few MB. */
+#define PIPELINE_QUEUE_SIZE 64
+
+/* Maximum number of unused item pools kept for reuse.  This covers
+ * all items that may be in flight at any time. */
+#define PIPELINE_MAX_FREE_POOLS (2 * PIPELINE_QUEUE_SIZE + 8)
+
+/* Memory that the allocator of an item pool may retain after the pool
+ * got cleared.  Most items are small, so this keeps the many pools that
+ * we recycle from holding on to the buffers of the occasional large
+ * item. */
+#define PIPELINE_ITEM_MAX_FREE (64 * 1024)
+
+/* The different kinds of pipeline_item_t.  Each corresponds to a call
+ * to one of the svn_repos_parse_fns3_t callbacks or to a text stream /
+ * window handler that got returned by them. */
+typedef enum item_kind_t
+{
+  item_magic_header,
+  item_uuid,
+  item_new_revision,
+  item_new_node,
+  item_set_revision_property,
+  item_set_node_property,
+  item_delete_node_property,
+  item_remove_node_props,
+  item_fulltext,
+  item_textdelta,
+  item_text_data,
+  item_text_window,
+  item_text_end,
+  item_close_node,
+  item_close_revision
+} item_kind_t;
+
+/* A recorded parser callback invocation, passed from one pipeline stage
+ * to the next. */
+typedef struct pipeline_item_t
+{
+  item_kind_t kind;
+
+  /* Root pool containing this item and all the data it refers to.
+   * Whoever owns the item, releases it with item_release(). */
+  apr_pool_t *pool;
+
+  /* The pipeline that this item belongs to. */
+  struct pipeline_t *pipeline;
+
+  /* Callback parameters.  Which of them are valid depends on KIND. */
+  int version;
+  const char *value;
+  apr_hash_t *headers;
+  const char *name;
+  const svn_string_t *prop_value;
+  const char *data;
+  apr_size_t len;
+  svn_txdelta_window_t *window;
+
+  /* For item_fulltext and item_textdelta: whether the text belongs to
+   * a node or a revision record. */
+  svn_boolean_t for_node;
+} pipeline_item_t;
+
+/* A bounded FIFO of pipeline_item_t connecting two pipeline stages. */
+typedef struct item_queue_t
+{
+  /* Ring buffer of PIPELINE_QUEUE_SIZE items, COUNT of them in use,
+   * starting at FIRST. */
+  pipeline_item_t *items[PIPELINE_QUEUE_SIZE];
+  int first;
+  int count;
+
+  /* Set by the producer after its last item has been added. */
+  svn_boolean_t closed;
+
+  /* Set by the consumer if it will not take any further items. */
+  svn_boolean_t aborted;
+
+  /* Synchronization objects.  NOT_EMPTY gets signaled upon adding items
+   * and closing the queue, NOT_FULL upon removing items and aborting. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *not_empty;
+  apr_thread_cond_t *not_full;
+} item_queue_t;
+
+/* Data shared by all stages of the pipeline. */
+typedef struct pipeline_t
+{
+  /* Parsed records as they come from the dumpstream. */
+  item_queue_t parsed;
+
+  /* The same records with the text deltas decoded into windows. */
+  item_queue_t decoded;
+
+  /* Input to the parser stage. */
+  svn_stream_t *stream;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Root pools, threads and results of the parser and decoder stages. */
+  apr_pool_t *parser_pool;
+  apr_thread_t *parser_thread;
+  svn_error_t *parser_err;
+
+  apr_pool_t *decoder_pool;
+  apr_thread_t *decoder_thread;
+  svn_error_t *decoder_err;
+
+  /* Cleared root pools of released items, FREE_POOL_COUNT of them, to be
+   * reused for new items.  Each has its own allocator, so the stages
+   * don't contend for the global one.  FREE_POOLS_MUTEX serializes
+   * access to them. */
+  apr_pool_t *free_pools[PIPELINE_MAX_FREE_POOLS];
+  int free_pool_count;
+  svn_mutex__t *free_pools_mutex;
+} pipeline_t;
+
+/* Record baton handed out by the parser stage. */
+typedef struct pipeline_record_t
+{
+  pipeline_t *pipeline;
+
+  /* The record headers.  They remain valid until the next record. */
+  apr_hash_t *headers;
+
+  /* Whether this is a node record. */
+  svn_boolean_t is_node;
+} pipeline_record_t;
+
+/* Set *POOL to an unused item pool of PIPELINE or to NULL if there is
+ * none. */
+static svn_error_t *
+take_free_pool_locked(apr_pool_t **pool,
+                      pipeline_t *pipeline)
+{
+  *pool = pipeline->free_pool_count
+        ? pipeline->free_pools[--pipeline->free_pool_count]
+        : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a new, otherwise empty item of the given KIND for PIPELINE.
+ * The item will be in its own root pool, recycled from earlier items
+ * whenever possible. */
+static pipeline_item_t *
+item_create(pipeline_t *pipeline,
+            item_kind_t kind)
+{
+  apr_pool_t *pool = NULL;
+  pipeline_item_t *item;
+  svn_error_t *err;
+
+  err = svn_mutex__lock(pipeline->free_pools_mutex);
+  if (!err)
+    err = svn_mutex__unlock(pipeline->free_pools_mutex,
+                            take_free_pool_locked(&pool, pipeline));
+
+  /* Mutex failure?!  Well, continue with a new pool. */
+  svn_error_clear(err);
+  if (!pool)
+    {
+      apr_allocator_t *allocator = svn_pool_create_allocator(FALSE);
+      apr_allocator_max_free_set(allocator, PIPELINE_ITEM_MAX_FREE);
+      pool = apr_allocator_owner_get(allocator);
+    }
+
+  item = apr_pcalloc(pool, sizeof(*item));
+  item->kind = kind;
+  item->pool = pool;
+  item->pipeline = pipeline;
+
+  return item;
+}
+
+/* Add POOL to the unused item pools of PIPELINE, if there is room.
+ * Set *KEPT to whether we did. */
+static svn_error_t *
+keep_free_pool_locked(svn_boolean_t *kept,
+                      pipeline_t *pipeline,
+                      apr_pool_t *pool)
+{
+  *kept = pipeline->free_pool_count < PIPELINE_MAX_FREE_POOLS;
+  if (*kept)
+    pipeline->free_pools[pipeline->free_pool_count++] = pool;
+
+  return SVN_NO_ERROR;
+}
+
+/* Release ITEM and everything it refers to, keeping its pool for reuse
+ * by later items of the same pipeline. */
+static void
+item_release(pipeline_item_t *item)
+{
+  pipeline_t *pipeline = item->pipeline;
+  apr_pool_t *pool = item->pool;
+  svn_boolean_t kept = FALSE;
+  svn_error_t *err;
+
+  svn_pool_clear(pool);
+
+  err = svn_mutex__lock(pipeline->free_pools_mutex);
+  if (!err)
+    err = svn_mutex__unlock(pipeline->free_pools_mutex,
+                            keep_free_pool_locked(&kept, pipeline, pool));
+
+  svn_error_clear(err);
+  if (!kept)
+    svn_pool_destroy(pool);
+}
+
+/* Initialize QUEUE, allocating the synchronization objects in POOL. */
+static svn_error_t *
+queue_init(item_queue_t *queue,
+           apr_pool_t *pool)
+{
+  apr_status_t status;
+
+  memset(queue, 0, sizeof(*queue));
+  SVN_ERR(svn_mutex__init(&queue->mutex, TRUE, pool));
+
+  status = apr_thread_cond_create(&queue->not_empty, pool);
+  if (!status)
+    status = apr_thread_cond_create(&queue->not_full, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for CONDITION to be signaled for QUEUE, whose mutex must be held
+ * by the caller. */
+static svn_error_t *
+queue_wait(item_queue_t *queue,
+           apr_thread_cond_t *condition)
+{
+  apr_status_t status = apr_thread_cond_wait(condition,
+                                             svn_mutex__get(queue->mutex));
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't wait for condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Signal CONDITION of QUEUE. */
+static svn_error_t *
+queue_signal(apr_thread_cond_t *condition)
+{
+  apr_status_t status = apr_thread_cond_broadcast(condition);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't broadcast condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement queue_push() while holding the QUEUE mutex. */
+static svn_error_t *
+queue_push_locked(item_queue_t *queue,
+                  pipeline_item_t *item)
+{
+  while (queue->count == PIPELINE_QUEUE_SIZE && !queue->aborted)
+    SVN_ERR(queue_wait(queue, queue->not_full));
+
+  if (queue->aborted)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL,
+                            _("Dumpstream processing has been aborted"));
+
+  queue->items[(queue->first + queue->count) % PIPELINE_QUEUE_SIZE] = item;
+  queue->count++;
+
+  return svn_error_trace(queue_signal(queue->not_empty));
+}
+
+/* Append ITEM to QUEUE, waiting for space to become available.  Transfer
+ * the ownership of ITEM to the queue.  If the consumer has aborted the
+ * queue, release ITEM and return SVN_ERR_CANCELLED. */
+static svn_error_t *
+queue_push(item_queue_t *queue,
+           pipeline_item_t *item)
+{
+  svn_error_t *err;
+
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  err = svn_mutex__unlock(queue->mutex, queue_push_locked(queue, item));
+  if (err)
+    item_release(item);
+
+  return svn_error_trace(err);
+}
+
+/* Implement queue_pop() while holding the QUEUE mutex. */
+static svn_error_t *
+queue_pop_locked(pipeline_item_t **item,
+                 item_queue_t *queue)
+{
+  while (queue->count == 0 && !queue->closed)
+    SVN_ERR(queue_wait(queue, queue->not_empty));
+
+  if (queue->count == 0)
+    {
+      *item = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  *item = queue->items[queue->first];
+  queue->first = (queue->first + 1) % PIPELINE_QUEUE_SIZE;
+  queue->count--;
+
+  return svn_error_trace(queue_signal(queue->not_full));
+}
+
+/* Remove the oldest item from QUEUE and return it in *ITEM, waiting for
+ * the producer to add one.  Set *ITEM to NULL if the producer closed
+ * the queue and all items have been taken.  The caller takes over the
+ * ownership of *ITEM. */
+static svn_error_t *
+queue_pop(pipeline_item_t **item,
+          item_queue_t *queue)
+{
+  SVN_MUTEX__WITH_LOCK(queue->mutex, queue_pop_locked(item, queue));
+  return SVN_NO_ERROR;
+}
+
+/* Tell the consumer of QUEUE that no further items will be added. */
+static svn_error_t *
+queue_close(item_queue_t *queue)
+{
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  queue->closed = TRUE;
+  SVN_ERR(svn_mutex__unlock(queue->mutex,
+                            queue_signal(queue->not_empty)));
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell the producer of QUEUE that no further items will be taken. */
+static svn_error_t *
+queue_abort(item_queue_t *queue)
+{
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  queue->aborted = TRUE;
+  SVN_ERR(svn_mutex__unlock(queue->mutex,
+                            queue_signal(queue->not_full)));
+
+  return SVN_NO_ERROR;
+}
+
+/* Release all items remaining in QUEUE.  Both stages connected by QUEUE
+ * must have terminated. */
+static void
+queue_clear(item_queue_t *queue)
+{
+  for (; queue->count; queue->count--)
+    {
+      item_release(queue->items[queue->first]);
+      queue->first = (queue->first + 1) % PIPELINE_QUEUE_SIZE;
+    }
+}
+
+/* Return a deep copy of HEADERS allocated in POOL. */
+static apr_hash_t *
+headers_dup(apr_hash_t *headers,
+            apr_pool_t *pool)
+{
+  apr_hash_t *copy = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(pool, headers); hi; hi = apr_hash_next(hi))
+    svn_hash_sets(copy, apr_pstrdup(pool, apr_hash_this_key(hi)),
+                  apr_pstrdup(pool, apr_hash_this_val(hi)));
+
+  return copy;
+}
+
+/* Shorthand for pushing ITEM to the queue of parsed records of the
+ * pipeline_t PIPELINE. */
+static svn_error_t *
+push_parsed(pipeline_t *pipeline,
+            pipeline_item_t *item)
+{
+  return svn_error_trace(queue_push(&pipeline->parsed, item));
+}
+
+/* The parser stage: a svn_repos_parse_fns3_t implementation that queues
+ * every call for the next stage.  The parse baton is the pipeline_t,
+ * the record batons are pipeline_record_t. */
+
+static svn_error_t *
+record_magic_header_record(int version,
+                           void *parse_baton,
+                           apr_pool_t *pool)
+{
+  pipeline_item_t *item = item_create(parse_baton, item_magic_header);
+  item->version = version;
+
+  return svn_error_trace(push_parsed(parse_baton, item));
+}
+
+static svn_error_t *
+record_uuid_record(const char *uuid,
+                   void *parse_baton,
+                   apr_pool_t *pool)
+{
+  pipeline_item_t *item = item_create(parse_baton, item_uuid);
+  item->value = apr_pstrdup(item->pool, uuid);
+
+  return svn_error_trace(push_parsed(parse_baton, item));
+}
+
+/* Common implementation of record_new_revision_record and
+ * record_new_node_record. */
+static svn_error_t *
+record_new_record(void **record_baton,
+                  item_kind_t kind,
+                  apr_hash_t *headers,
+                  pipeline_t *pipeline,
+                  apr_pool_t *pool)
+{
+  pipeline_record_t *record = apr_pcalloc(pool, sizeof(*record));
+  pipeline_item_t *item = item_create(pipeline, kind);
+  item->headers = headers_dup(headers, item->pool);
+
+  record->pipeline = pipeline;
+  record->headers = headers;
+  record->is_node = kind == item_new_node;
+  *record_baton = record;
+
+  return svn_error_trace(push_parsed(pipeline, item));
+}
+
+static svn_error_t *
+record_new_revision_record(void **revision_baton,
+                           apr_hash_t *headers,
+                           void *parse_baton,
+                           apr_pool_t *pool)
+{
+  return svn_error_trace(record_new_record(revision_baton,
+                                           item_new_revision, headers,
+                                           parse_baton, pool));
+}
+
+static svn_error_t *
+record_new_node_record(void **node_baton,
+                       apr_hash_t *headers,
+                       void *revision_baton,
+                       apr_pool_t *pool)
+{
+  pipeline_record_t *revision = revision_baton;
+
+  return svn_error_trace(record_new_record(node_baton, item_new_node,
+                                           headers, revision->pipeline,
+                                           pool));
+}
+
+/* Queue a property change of KIND for RECORD.  VALUE may be NULL. */
+static svn_error_t *
+record_property(pipeline_record_t *record,
+                item_kind_t kind,
+                const char *name,
+                const svn_string_t *value)
+{
+  pipeline_item_t *item = item_create(record->pipeline, kind);
+  item->name = apr_pstrdup(item->pool, name);
+  item->prop_value = value ? svn_string_dup(value, item->pool) : NULL;
+
+  return svn_error_trace(push_parsed(record->pipeline, item));
+}
+
+static svn_error_t *
+record_set_revision_property(void *revision_baton,
+                             const char *name,
+                             const svn_string_t *value)
+{
+  return svn_error_trace(record_property(revision_baton,
+                                         item_set_revision_property,
+                                         name, value));
+}
+
+static svn_error_t *
+record_set_node_property(void *node_baton,
+                         const char *name,
+                         const svn_string_t *value)
+{
+  return svn_error_trace(record_property(node_baton,
+                                         item_set_node_property,
+                                         name, value));
+}
+
+static svn_error_t *
+record_delete_node_property(void *node_baton,
+                            const char *name)
+{
+  return svn_error_trace(record_property(node_baton,
+                                         item_delete_node_property,
+                                         name, NULL));
+}
+
+static svn_error_t *
+record_remove_node_props(void *node_baton)
+{
+  pipeline_record_t *record = node_baton;
+
+  return svn_error_trace(push_parsed(record->pipeline,
+                                     item_create(record->pipeline,
+                                                 item_remove_node_props)));
+}
+
+/* Implements svn_write_fn_t for the text stream returned by
+ * record_set_fulltext.  BATON is the pipeline_t. */
+static svn_error_t *
+record_text_write(void *baton,
+                  const char *data,
+                  apr_size_t *len)
+{
+  pipeline_item_t *item = item_create(baton, item_text_data);
+  item->data = apr_pmemdup(item->pool, data, *len);
+  item->len = *len;
+
+  return svn_error_trace(push_parsed(baton, item));
+}
+
+/* Implements svn_close_fn_t for the text stream returned by
+ * record_set_fulltext.  BATON is the pipeline_t. */
+static svn_error_t *
+record_text_close(void *baton)
+{
+  return svn_error_trace(push_parsed(baton,
+                                     item_create(baton, item_text_end)));
+}
+
+/* The parser stage runs with DELTAS_ARE_TEXT set, so this receives the
+ * raw svndiff data for text deltas as well.  We tell both apart by the
+ * record headers and leave the decoding to the next stage. */
+static svn_error_t *
+record_set_fulltext(svn_stream_t **stream,
+                    void *record_baton)
+{
+  pipeline_record_t *record = record_baton;
+  const char *delta = svn_hash_gets(record->headers,
+                                    SVN_REPOS_DUMPFILE_TEXT_DELTA);
+  pipeline_item_t *item
+    = item_create(record->pipeline,
+                  delta && strcmp(delta, "true") == 0 ? item_textdelta
+                                                      : item_fulltext);
+  item->for_node = record->is_node;
+
+  SVN_ERR(push_parsed(record->pipeline, item));
+
+  /* The stream only lives as long as the record. */
+  *stream = svn_stream_create(record->pipeline,
+                              apr_hash_pool_get(record->headers));
+  svn_stream_set_write(*stream, record_text_write);
+  svn_stream_set_close(*stream, record_text_close);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_close_node(void *node_baton)
+{
+  pipeline_record_t *record = node_baton;
+
+  return svn_error_trace(push_parsed(record->pipeline,
+                                     item_create(record->pipeline,
+                                                 item_close_node)));
+}
+
+static svn_error_t *
+record_close_revision(void *revision_baton)
+{
+  pipeline_record_t *record = revision_baton;
+
+  return svn_error_trace(push_parsed(record->pipeline,
+                                     item_create(record->pipeline,
+                                                 item_close_revision)));
+}
+
+/* Vtable of the parser stage. */
+static const svn_repos_parse_fns3_t record_vtable =
+{
+  record_magic_header_record,
+  record_uuid_record,
+  record_new_revision_record,
+  record_new_node_record,
+  record_set_revision_property,
+  record_set_node_property,
+  record_delete_node_property,
+  record_remove_node_props,
+  record_set_fulltext,
+  NULL,
+  record_close_node,
+  record_close_revision
+};
+
+/* Thread function of the parser stage.  DATA is the pipeline_t. */
+static void * APR_THREAD_FUNC
+parser_thread(apr_thread_t *thread,
+              void *data)
+{
+  pipeline_t *pipeline = data;
+
+  pipeline->parser_err
+    = svn_repos_parse_dumpstream3(pipeline->stream, &record_vtable,
+                                  pipeline, TRUE,
+                                  pipeline->cancel_func,
+                                  pipeline->cancel_baton,
+                                  pipeline->parser_pool);
+  pipeline->parser_err = svn_error_compose_create(pipeline->parser_err,
+                                        queue_close(&pipeline->parsed));
+
+  return NULL;
+}
+
+/* Implements svn_txdelta_window_handler_t for the svndiff parser of the
+ * decoder stage.  BATON is the pipeline_t.  Queue a copy of WINDOW. */
+static svn_error_t *
+decoded_window_handler(svn_txdelta_window_t *window,
+                       void *baton)
+{
+  pipeline_t *pipeline = baton;
+  pipeline_item_t *item;
+
+  /* The end of the delta is marked by the item_text_end that follows. */
+  if (window == NULL)
+    return SVN_NO_ERROR;
+
+  item = item_create(pipeline, item_text_window);
+  item->window = svn_txdelta_window_dup(window, item->pool);
+
+  return svn_error_trace(queue_push(&pipeline->decoded, item));
+}
+
+/* Body of the decoder stage: Pass all items from the PIPELINE's parsed
+ * queue on to its decoded queue, replacing svndiff data with the delta
+ * windows encoded in it. */
+static svn_error_t *
+decode_items(pipeline_t *pipeline)
+{
+  apr_pool_t *delta_pool = svn_pool_create(pipeline->decoder_pool);
+  svn_stream_t *svndiff = NULL;
+
+  while (TRUE)
+    {
+      pipeline_item_t *item;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      SVN_ERR(queue_pop(&item, &pipeline->parsed));
+      if (item == NULL)
+        break;
+
+      if (item->kind == item_textdelta)
+        {
+          svndiff = svn_txdelta_parse_svndiff(decoded_window_handler,
+                                              pipeline, TRUE, delta_pool);
+        }
+      else if (item->kind == item_text_data && svndiff)
+        {
+          apr_size_t len = item->len;
+          err = svn_stream_write(svndiff, item->data, &len);
+          item_release(item);
+          SVN_ERR(err);
+
+          continue;
+        }
+      else if (item->kind == item_text_end && svndiff)
+        {
+          err = svn_stream_close(svndiff);
+          svndiff = NULL;
+          svn_pool_clear(delta_pool);
+
+          if (err)
+            item_release(item);
+          SVN_ERR(err);
+        }
+
+      SVN_ERR(queue_push(&pipeline->decoded, item));
+    }
+
+  svn_pool_destroy(delta_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function of the decoder stage.  DATA is the pipeline_t. */
+static void * APR_THREAD_FUNC
+decoder_thread(apr_thread_t *thread,
+               void *data)
+{
+  pipeline_t *pipeline = data;
+
+  pipeline->decoder_err = decode_items(pipeline);
+
+  /* Unblock the parser stage if we give up early. */
+  if (pipeline->decoder_err)
+    pipeline->decoder_err = svn_error_compose_create(pipeline->decoder_err,
+                                          queue_abort(&pipeline->parsed));
+
+  pipeline->decoder_err = svn_error_compose_create(pipeline->decoder_err,
+                                        queue_close(&pipeline->decoded));
+
+  return NULL;
+}
+
+/* The final stage: Take all items from the PIPELINE's decoded queue and
+ * invoke the respective PARSE_FNS callbacks with PARSE_BATON.  Use the
+ * same pool structure as svn_repos_parse_dumpstream3() does, with POOL
+ * taking the role of its pool parameter. */
+static svn_error_t *
+replay_items(pipeline_t *pipeline,
+             const svn_repos_parse_fns3_t *parse_fns,
+             void *parse_baton,
+             apr_pool_t *pool)
+{
+  apr_pool_t *linepool = svn_pool_create(pool);
+  apr_pool_t *revpool = svn_pool_create(pool);
+  apr_pool_t *nodepool = svn_pool_create(pool);
+  void *rev_baton = NULL;
+  void *node_baton = NULL;
+  svn_stream_t *text_stream = NULL;
+  svn_txdelta_window_handler_t handler = NULL;
+  void *handler_baton = NULL;
+
+  /* Make sure we can blindly invoke callbacks. */
+  parse_fns = complete_vtable(parse_fns, pool);
+
+  while (TRUE)
+    {
+      pipeline_item_t *item;
+      svn_error_t *err = SVN_NO_ERROR;
+      apr_size_t len;
+
+      SVN_ERR(queue_pop(&item, &pipeline->decoded));
+      if (item == NULL)
+        break;
+
+      switch (item->kind)
+        {
+          case item_magic_header:
+            err = parse_fns->magic_header_record(item->version, parse_baton,
+                                                 pool);
+            break;
+
+          case item_uuid:
+            svn_pool_clear(linepool);
+            err = parse_fns->uuid_record(apr_pstrdup(linepool, item->value),
+                                         parse_baton, pool);
+            break;
+
+          case item_new_revision:
+            svn_pool_clear(linepool);
+            err = parse_fns->new_revision_record(&rev_baton,
+                                                 headers_dup(item->headers,
+                                                             linepool),
+                                                 parse_baton, revpool);
+            break;
+
+          case item_new_node:
+            svn_pool_clear(linepool);
+            err = parse_fns->new_node_record(&node_baton,
+                                             headers_dup(item->headers,
+                                                         linepool),
+                                             rev_baton, nodepool);
+            break;
+
+          case item_set_revision_property:
+            err = parse_fns->set_revision_property(rev_baton, item->name,
+                                                   item->prop_value);
+            break;
+
+          case item_set_node_property:
+            err = parse_fns->set_node_property(node_baton, item->name,
+                                               item->prop_value);
+            break;
+
+          case item_delete_node_property:
+            err = parse_fns->delete_node_property(node_baton, item->name);
+            break;
+
+          case item_remove_node_props:
+            err = parse_fns->remove_node_props(node_baton);
+            break;
+
+          case item_fulltext:
+            err = parse_fns->set_fulltext(&text_stream,
+                                          item->for_node ? node_baton
+                                                         : rev_baton);
+            break;
+
+          case item_textdelta:
+            err = parse_fns->apply_textdelta(&handler, &handler_baton,
+                                             item->for_node ? node_baton
+                                                            : rev_baton);
+            break;
+
+          case item_text_data:
+            if (text_stream)
+              {
+                len = item->len;
+                err = svn_stream_write(text_stream, item->data, &len);
+                if (!err && len != item->len)
+                  err = svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                         _("Unexpected EOF writing "
+                                           "contents"));
+              }
+            break;
+
+          case item_text_window:
+            if (handler)
+              err = handler(item->window, handler_baton);
+            break;
+
+          case item_text_end:
+            if (handler)
+              err = handler(NULL, handler_baton);
+            else if (text_stream)
+              err = svn_stream_close(text_stream);
+
+            handler = NULL;
+            text_stream = NULL;
+            break;
+
+          case item_close_node:
+            err = parse_fns->close_node(node_baton);
+            svn_pool_clear(nodepool);
+            break;
+
+          case item_close_revision:
+            err = parse_fns->close_revision(rev_baton);
+            svn_pool_clear(revpool);
+            rev_baton = NULL;
+            break;
+        }
+
+      item_release(item);
+      SVN_ERR(err);
+    }
+
+  svn_pool_destroy(linepool);
+  svn_pool_destroy(revpool);
+  svn_pool_destroy(nodepool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  pipeline_t *pipeline = apr_pcalloc(pool, sizeof(*pipeline));
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status, retval;
+
+  SVN_ERR(queue_init(&pipeline->parsed, pool));
+  SVN_ERR(queue_init(&pipeline->decoded, pool));
+  SVN_ERR(svn_mutex__init(&pipeline->free_pools_mutex, TRUE, pool));
+  pipeline->stream = stream;
+  pipeline->cancel_func = cancel_func;
+  pipeline->cancel_baton = cancel_baton;
+
+  /* The stages must not allocate from POOL, which is not thread-safe. */
+  pipeline->parser_pool = svn_pool_create(NULL);
+  pipeline->decoder_pool = svn_pool_create(NULL);
+
+  status = apr_thread_create(&pipeline->decoder_thread, NULL,
+                             decoder_thread, pipeline,
+                             pipeline->decoder_pool);
+  if (status)
+    {
+      svn_pool_destroy(pipeline->parser_pool);
+      svn_pool_destroy(pipeline->decoder_pool);
+      return svn_error_wrap_apr(status, _("Can't create thread"));
+    }
+
+  status = apr_thread_create(&pipeline->parser_thread, NULL,
+                             parser_thread, pipeline,
+                             pipeline->parser_pool);
+  if (status)
+    {
+      /* Let the decoder stage run dry. */
+      err = svn_error_wrap_apr(status, _("Can't create thread"));
+      err = svn_error_compose_create(err, queue_close(&pipeline->parsed));
+      pipeline->parser_thread = NULL;
+    }
+  else
+    {
+      err = replay_items(pipeline, parse_fns, parse_baton, pool);
+    }
+
+  /* If we failed, make the other stages terminate as soon as possible.
+   * Aborting the decoded queue makes the decoder stage fail, which will
+   * then abort the parsed queue. */
+  if (err)
+    err = svn_error_compose_create(err, queue_abort(&pipeline->decoded));
+
+  if (pipeline->parser_thread)
+    {
+      status = apr_thread_join(&retval, pipeline->parser_thread);
+      if (status)
+        err = svn_error_compose_create(err,
+                svn_error_wrap_apr(status, _("Can't join thread")));
+    }
+
+  status = apr_thread_join(&retval, pipeline->decoder_thread);
+  if (status)
+    err = svn_error_compose_create(err,
+            svn_error_wrap_apr(status, _("Can't join thread")));
+
+  /* Errors in the later stages take precedence since they make the
+   * earlier stages fail as well. */
+  if (err)
+    {
+      svn_error_clear(pipeline->decoder_err);
+      svn_error_clear(pipeline->parser_err);
+    }
+  else if (pipeline->decoder_err)
+    {
+      err = pipeline->decoder_err;
+      svn_error_clear(pipeline->parser_err);
+    }
+  else
+    {
+      err = pipeline->parser_err;
+    }
+
+  queue_clear(&pipeline->parsed);
+  queue_clear(&pipeline->decoded);
+  while (pipeline->free_pool_count)
+    svn_pool_destroy(pipeline->free_pools[--pipeline->free_pool_count]);
+
+  svn_pool_destroy(pipeline->parser_pool);
+  svn_pool_destroy(pipeline->decoder_pool);
+
+  return svn_error_trace(err);
+#else
+  return svn_error_trace(svn_repos_parse_dumpstream3(stream, parse_fns,
+                                                     parse_baton, FALSE,
+                                                     cancel_func,
+                                                     cancel_baton, pool));
+#endif
+}
@@ -0,0 +1,104 @@
+/* log-index-db.sql -- schema for the changed-paths index of a repository
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* The index can always be rebuilt from the repository, so older formats
+   are simply replaced. */
+DROP TABLE IF EXISTS changes;
+DROP TABLE IF EXISTS touched;
+DROP TABLE IF EXISTS indexed;
+
+/* One row per changed path and revision, as reported by
+   svn_fs_paths_changed2().  ADDED is 1 if the node at PATH was added or
+   replaced in REVISION, in which case COPYFROM_PATH and COPYFROM_REV
+   give the copy source, if any. */
+CREATE TABLE changes (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  added INTEGER NOT NULL,
+  copyfrom_path TEXT,
+  copyfrom_rev INTEGER,
+  PRIMARY KEY (path, revision)
+  );
+
+/* One row per revision and path that was changed in that revision or has
+   a changed path below it, including the root.  This turns the log of a
+   directory into a simple range scan. */
+CREATE TABLE touched (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  PRIMARY KEY (path, revision)
+  );
+
+/* The youngest revision covered by the CHANGES and TOUCHED tables and
+   the UUID of the repository that they have been read from.  There is at
+   most one row, with ID 0. */
+CREATE TABLE indexed (
+  id INTEGER NOT NULL PRIMARY KEY,
+  youngest INTEGER NOT NULL,
+  uuid TEXT NOT NULL
+  );
+
+PRAGMA USER_VERSION = 3;
+
+
+-- STMT_GET_YOUNGEST
+SELECT youngest, uuid
+FROM indexed
+WHERE id = 0
+
+-- STMT_SET_YOUNGEST
+INSERT OR REPLACE INTO indexed (id, youngest, uuid)
+VALUES (0, ?1, ?2)
+
+-- STMT_INSERT_CHANGE
+INSERT OR REPLACE INTO changes (path, revision, added, copyfrom_path,
+                                copyfrom_rev)
+VALUES (?1, ?2, ?3, ?4, ?5)
+
+-- STMT_INSERT_TOUCHED
+INSERT OR IGNORE INTO touched (path, revision)
+VALUES (?1, ?2)
+
+-- STMT_CLEAR_INDEX
+DELETE FROM changes;
+DELETE FROM touched;
+DELETE FROM indexed;
+
+/* Return the youngest revision not after ?2 in which the node at ?1 has
+   been added or replaced, together with its copy source. */
+-- STMT_GET_LAST_ADDITION
+SELECT revision, copyfrom_path, copyfrom_rev
+FROM changes
+WHERE path = ?1 AND revision <= ?2 AND added = 1
+ORDER BY revision DESC
+LIMIT 1
+
+/* Return the revisions in [?2, ?3] that changed ?1 or any path below it,
+   youngest first and at most ?4 of them. */
+-- STMT_GET_CHANGED_REVISIONS
+SELECT revision
+FROM touched
+WHERE path = ?1 AND revision >= ?2 AND revision <= ?3
+ORDER BY revision DESC
+LIMIT ?4
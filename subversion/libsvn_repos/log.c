@@ -412,8 +412,58 @@ struct path_info
   svn_fs_history_t *hist;
   apr_pool_t *newpool;
   apr_pool_t *oldpool;
+
+  /* If not NULL, we read the history from the changed-paths index instead
+     and the three pointers above will be NULL. */
+  svn_repos__log_index_history_t *index_hist;
 };
 
+/* Like get_history() but for histories read from the changed-paths
+ * index, i.e. with INFO->INDEX_HIST set.
+ */
+static svn_error_t *
+get_index_history(struct path_info *info,
+                  svn_fs_t *fs,
+                  svn_repos_authz_func_t authz_read_func,
+                  void *authz_read_baton,
+                  svn_revnum_t start,
+                  apr_pool_t *scratch_pool)
+{
+  const char *path;
+
+  SVN_ERR(svn_repos__log_index_history_prev(&path, &info->history_rev,
+                                            info->index_hist,
+                                            scratch_pool));
+
+  /* No more history or this history item predates our START revision? */
+  if (!path || info->history_rev < start)
+    {
+      info->done = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  svn_stringbuf_set(info->path, path);
+
+  /* Is the history item readable?  If not, done with path. */
+  if (authz_read_func)
+    {
+      svn_boolean_t readable;
+      svn_fs_root_t *history_root;
+
+      SVN_ERR(svn_fs_revision_root(&history_root, fs,
+                                   info->history_rev,
+                                   scratch_pool));
+      SVN_ERR(authz_read_func(&readable, history_root,
+                              info->path->data,
+                              authz_read_baton,
+                              scratch_pool));
+      if (! readable)
+        info->done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Advance to the next history for the path.
  *
  * If INFO->HIST is not NULL we do this using that existing history object,
@@ -445,6 +495,11 @@ get_history(struct path_info *info,
   apr_pool_t *subpool;
   const char *path;
 
+  if (info->index_hist)
+    return svn_error_trace(get_index_history(info, fs, authz_read_func,
+                                             authz_read_baton, start,
+                                             scratch_pool));
+
   if (info->hist)
     {
       subpool = info->newpool;
@@ -1368,11 +1423,15 @@ send_log(svn_revnum_t rev,
 
 /* Get the histories for PATHS, and store them in *HISTORIES.
 
+   If LOG_INDEX is not NULL, read the histories of all paths but the root
+   from that changed-paths index instead of walking their node histories.
+
    If IGNORE_MISSING_LOCATIONS is set, don't treat requests for bogus
    repository locations as fatal -- just ignore them.  */
 static svn_error_t *
 get_path_histories(apr_array_header_t **histories,
                    svn_fs_t *fs,
+                   svn_repos__log_index_t *log_index,
                    const apr_array_header_t *paths,
                    svn_revnum_t hist_start,
                    svn_revnum_t hist_end,
@@ -1421,8 +1480,30 @@ get_path_histories(apr_array_header_t **histories,
       info->done = FALSE;
       info->history_rev = hist_end;
       info->first_time = TRUE;
+      info->index_hist = NULL;
+
+      /* Missing locations are left to the code below to deal with. */
+      if (log_index && !svn_fspath__is_root(info->path->data,
+                                            info->path->len))
+        {
+          svn_node_kind_t kind;
+
+          SVN_ERR(svn_fs_check_path(&kind, root, this_path, iterpool));
+          if (kind != svn_node_none)
+            SVN_ERR(svn_repos__log_index_history(&info->index_hist,
+                                                 log_index, this_path,
+                                                 hist_end,
+                                                 strict_node_history,
+                                                 pool, iterpool));
+        }
 
-      if (i < MAX_OPEN_HISTORIES)
+      if (info->index_hist)
+        {
+          info->hist = NULL;
+          info->oldpool = NULL;
+          info->newpool = NULL;
+        }
+      else if (i < MAX_OPEN_HISTORIES)
         {
           err = svn_fs_node_history2(&info->hist, root, this_path, pool,
                                      iterpool);
@@ -1695,6 +1776,7 @@ combine_mergeinfo_path_lists(apr_array_header_t **combined_list,
 /* Pity that C is so ... linear. */
 static svn_error_t *
 do_logs(svn_fs_t *fs,
+        svn_repos__log_index_t *log_index,
         const apr_array_header_t *paths,
         svn_mergeinfo_t log_target_history_as_mergeinfo,
         svn_mergeinfo_t processed,
@@ -1750,6 +1832,7 @@ compare_path_list_range(const void *a, const void *b)
 static svn_error_t *
 handle_merged_revisions(svn_revnum_t rev,
                         svn_fs_t *fs,
+                        svn_repos__log_index_t *log_index,
                         svn_mergeinfo_t log_target_history_as_mergeinfo,
                         svn_bit_array__t *nested_merges,
                         svn_mergeinfo_t processed,
@@ -1793,7 +1876,8 @@ handle_merged_revisions(svn_revnum_t rev,
         = APR_ARRAY_IDX(combined_list, i, struct path_list_range *);
 
       svn_pool_clear(iterpool);
-      SVN_ERR(do_logs(fs, pl_range->paths, log_target_history_as_mergeinfo,
+      SVN_ERR(do_logs(fs, log_index, pl_range->paths,
+                      log_target_history_as_mergeinfo,
                       processed, nested_merges,
                       pl_range->range.start, pl_range->range.end, 0,
                       discover_changed_paths, strict_node_history,
@@ -1951,10 +2035,14 @@ store_search(svn_mergeinfo_t processed,
    revisions that have already been searched.  Allocated like
    NESTED_MERGES above.
 
+   LOG_INDEX is the changed-paths index to use for finding the revisions
+   that changed PATHS.  May be NULL.
+
    All other parameters are the same as svn_repos_get_logs4().
  */
 static svn_error_t *
 do_logs(svn_fs_t *fs,
+        svn_repos__log_index_t *log_index,
         const apr_array_header_t *paths,
         svn_mergeinfo_t log_target_history_as_mergeinfo,
         svn_mergeinfo_t processed,
@@ -2004,7 +2092,8 @@ do_logs(svn_fs_t *fs,
      about all the revisions in the range -- only the ones in which
      one of our paths was changed.  So let's go figure out which
      revisions contain real changes to at least one of our paths.  */
-  SVN_ERR(get_path_histories(&histories, fs, paths, hist_start, hist_end,
+  SVN_ERR(get_path_histories(&histories, fs, log_index, paths,
+                             hist_start, hist_end,
                              strict_node_history, ignore_missing_locations,
                              authz_read_func, authz_read_baton, pool));
 
@@ -2100,7 +2189,7 @@ do_logs(svn_fs_t *fs,
                     }
 
                   SVN_ERR(handle_merged_revisions(
-                    current, fs,
+                    current, fs, log_index,
                     log_target_history_as_mergeinfo, nested_merges,
                     processed,
                     added_mergeinfo, deleted_mergeinfo,
@@ -2199,7 +2288,7 @@ do_logs(svn_fs_t *fs,
                   nested_merges = svn_bit_array__create(current, subpool);
                 }
 
-              SVN_ERR(handle_merged_revisions(current, fs,
+              SVN_ERR(handle_merged_revisions(current, fs, log_index,
                                               log_target_history_as_mergeinfo,
                                               nested_merges,
                                               processed,
@@ -2328,6 +2417,7 @@ svn_repos_get_logs4(svn_repos_t *repos,
   svn_fs_t *fs = repos->fs;
   svn_boolean_t descending_order;
   svn_mergeinfo_t paths_history_mergeinfo = NULL;
+  svn_repos__log_index_t *log_index;
 
   if (revprops)
     {
@@ -2454,7 +2544,12 @@ svn_repos_get_logs4(svn_repos_t *repos,
       svn_pool_destroy(subpool);
     }
 
-  return do_logs(repos->fs, paths, paths_history_mergeinfo, NULL, NULL, start, end,
+  /* Find the revisions that changed PATHS through the changed-paths
+     index, if there is one. */
+  SVN_ERR(svn_repos__log_index_open(&log_index, repos, head, pool));
+
+  return do_logs(repos->fs, log_index, paths, paths_history_mergeinfo,
+                 NULL, NULL, start, end,
                  limit, discover_changed_paths, strict_node_history,
                  include_merged_revisions, FALSE, FALSE, FALSE,
                  revprops, descending_order, receiver, receiver_baton,
@@ -0,0 +1,742 @@
+/* log_index.c : maintaining and querying the changed-paths index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "svn_sorts.h"
+#include "svn_private_config.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_sqlite.h"
+
+#include "repos.h"
+#include "log-index-db.h"
+
+/* The changed-paths index lives in a SQLite database next to the
+ * filesystem.  It records every changed path of every revision together
+ * with the copy source of added nodes.  That is enough to reconstruct the
+ * node history of any path without opening node revisions: the history
+ * of PATH@REV consists of the revisions that changed PATH or anything
+ * below it, up to the youngest addition of PATH or one of its parents.
+ * If that addition was a copy, the history continues at the respective
+ * location of the copy source.
+ *
+ * To find the changes at or below a directory quickly, every changed path
+ * also marks all its parents as "touched" in the respective revision.
+ * The history of any path then is a range scan over a single key.
+ *
+ * Revisions are immutable, so the index only ever grows.  It remembers
+ * the youngest revision that it covers.  Commits and loads through the
+ * repos layer add their revision right away and readers add a few missing
+ * revisions on demand.  Readers will not index larger ranges, though, but
+ * rather fall back to walking node histories until the index got updated.
+ * Writers catch up on larger ranges in limited steps, so that no commit
+ * gets delayed for long.
+ *
+ * The repository may get replaced behind our back, e.g. restored from a
+ * backup or re-created from a dump file, while the index file stays.  The
+ * index therefore also remembers the UUID of its repository.  If that
+ * does not match or the index covers revisions that the repository does
+ * not have, readers ignore the index and writers start it over.
+ */
+
+/* The latest schema version of the index database. */
+#define LOG_INDEX_SCHEMA_FORMAT 3
+
+LOG_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* Number of revisions to add per SQLite transaction.  This limits the
+ * work lost when the indexing process gets interrupted. */
+#define REVISIONS_PER_TXN 1000
+
+/* Number of history revisions to fetch per query. */
+#define REVISIONS_PER_QUERY 256
+
+/* Readers will index at most this many missing revisions before using
+ * the index.  Indexing takes the database write lock and may take long
+ * for larger ranges, while walking node histories will still be fast
+ * enough for a few revisions. */
+#define MAX_READER_CATCH_UP 16
+
+/* Commits and loads will index at most this many missing revisions.
+ * Larger ranges, e.g. after the index has been started over, get indexed
+ * over the course of several commits. */
+#define MAX_WRITER_CATCH_UP 64
+
+struct svn_repos__log_index_t
+{
+  /* The index database. */
+  svn_sqlite__db_t *db;
+
+  /* The filesystem being indexed and its UUID. */
+  svn_fs_t *fs;
+  const char *uuid;
+};
+
+struct svn_repos__log_index_history_t
+{
+  /* The index that we read from. */
+  svn_repos__log_index_t *index;
+
+  /* Whether to stop at copies. */
+  svn_boolean_t strict;
+
+  /* Set once all history has been reported. */
+  svn_boolean_t done;
+
+  /* The current section of history starts with the addition of the node
+   * (or one of its parents) in revision LOWER.  PATH is the path of the
+   * node in that section.  If the addition was a copy, COPYFROM_PATH and
+   * COPYFROM_REV give the node's location in the copy source.
+   * COPYFROM_PATH is NULL otherwise. */
+  const char *path;
+  svn_revnum_t lower;
+  const char *copyfrom_path;
+  svn_revnum_t copyfrom_rev;
+
+  /* Youngest revision in the current section that we did not fetch from
+   * the index, yet.  Smaller than LOWER once all have been fetched. */
+  svn_revnum_t cursor;
+
+  /* Revision reported last within the current section.  Invalid if none
+   * has been reported, yet. */
+  svn_revnum_t last_reported;
+
+  /* Revisions fetched from the index but not reported yet, youngest first,
+   * starting at index NEXT. */
+  apr_array_header_t *revisions;
+  int next;
+
+  /* Everything that must live as long as this iterator. */
+  apr_pool_t *pool;
+};
+
+/* Set *INDEX_P to the changed-paths index of REPOS and cache it in REPOS.
+ * If CREATE is set, create the database if necessary.  Otherwise, set
+ * *INDEX_P to NULL if there is no usable database.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+open_index(svn_repos__log_index_t **index_p,
+           svn_repos_t *repos,
+           svn_boolean_t create,
+           apr_pool_t *scratch_pool)
+{
+  svn_repos__log_index_t *index;
+  svn_sqlite__db_t *db;
+  const char *db_path;
+  const char *uuid;
+  svn_node_kind_t kind;
+  int version;
+
+  *index_p = repos->log_index;
+  if (repos->log_index)
+    return SVN_NO_ERROR;
+
+  db_path = svn_dirent_join(repos->path, SVN_REPOS__LOG_INDEX, scratch_pool);
+  SVN_ERR(svn_io_check_path(db_path, &kind, scratch_pool));
+  if (kind == svn_node_none)
+    {
+      if (!create)
+        return SVN_NO_ERROR;
+
+      /* Inherit the permissions that apply to the repository as a whole
+         instead of simply defaulting to umask. */
+      SVN_ERR(svn_io_file_create_empty(db_path, scratch_pool));
+      SVN_ERR(svn_io_copy_perms(svn_dirent_join(repos->path,
+                                                SVN_REPOS__FORMAT,
+                                                scratch_pool),
+                                db_path, scratch_pool));
+    }
+
+  /* The database will be closed automatically when repos->pool is
+     destroyed. */
+  SVN_ERR(svn_sqlite__open(&db, db_path, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 0, repos->pool,
+                           scratch_pool));
+
+  SVN_ERR(svn_sqlite__read_schema_version(&version, db, scratch_pool));
+  if (version < LOG_INDEX_SCHEMA_FORMAT && create)
+    {
+      SVN_SQLITE__WITH_TXN(svn_sqlite__exec_statements(db,
+                                                       STMT_CREATE_SCHEMA),
+                           db);
+    }
+  else if (version != LOG_INDEX_SCHEMA_FORMAT)
+    {
+      /* Not populated or written by some newer version. */
+      if (!create)
+        return svn_error_trace(svn_sqlite__close(db));
+
+      SVN_ERR(svn_sqlite__close(db));
+      return svn_error_createf(SVN_ERR_REPOS_UNSUPPORTED_VERSION, NULL,
+                               _("Unsupported changed-paths index format "
+                                 "%d in '%s'"),
+                               version,
+                               svn_dirent_local_style(db_path,
+                                                      scratch_pool));
+    }
+
+  SVN_ERR(svn_fs_get_uuid(repos->fs, &uuid, scratch_pool));
+
+  index = apr_pcalloc(repos->pool, sizeof(*index));
+  index->db = db;
+  index->fs = repos->fs;
+  index->uuid = apr_pstrdup(repos->pool, uuid);
+
+  repos->log_index = index;
+  *index_p = index;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *YOUNGEST to the youngest revision covered by INDEX.  That will be
+ * SVN_INVALID_REVNUM for an empty index.
+ */
+static svn_error_t *
+get_youngest(svn_revnum_t *youngest,
+             svn_repos__log_index_t *index)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->db, STMT_GET_YOUNGEST));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *youngest = have_row ? svn_sqlite__column_revnum(stmt, 0)
+                       : SVN_INVALID_REVNUM;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Set *VALID to FALSE, if INDEX has been built for a different repository
+ * than the one it belongs to now, i.e. if the UUIDs don't match or if
+ * INDEX covers revisions beyond YOUNGEST, the youngest revision in the
+ * repository.  Set it to TRUE otherwise.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+check_index(svn_boolean_t *valid,
+            svn_repos__log_index_t *index,
+            svn_revnum_t youngest,
+            apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->db, STMT_GET_YOUNGEST));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  /* An empty index is valid for any repository. */
+  *valid = !have_row
+        || (   svn_sqlite__column_revnum(stmt, 0) <= youngest
+            && strcmp(svn_sqlite__column_text(stmt, 1, scratch_pool),
+                      index->uuid) == 0);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Remove all contents from INDEX. */
+static svn_error_t *
+clear_index(svn_repos__log_index_t *index)
+{
+  SVN_SQLITE__WITH_IMMEDIATE_TXN(svn_sqlite__exec_statements(index->db,
+                                                             STMT_CLEAR_INDEX),
+                                 index->db);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the changed paths of REVISION to INDEX.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+add_revision(svn_repos__log_index_t *index,
+             svn_revnum_t revision,
+             apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  apr_hash_t *changes;
+  apr_hash_t *touched = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_revision_root(&root, index->fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_paths_changed2(&changes, root, scratch_pool));
+
+  for (hi = apr_hash_first(scratch_pool, changes); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      svn_fs_path_change2_t *change = apr_hash_this_val(hi);
+      const char *copyfrom_path = NULL;
+      svn_revnum_t copyfrom_rev = SVN_INVALID_REVNUM;
+      svn_boolean_t added;
+      svn_sqlite__stmt_t *stmt;
+
+      svn_pool_clear(iterpool);
+
+      if (change->change_kind == svn_fs_path_change_reset)
+        continue;
+
+      added = (   change->change_kind == svn_fs_path_change_add
+               || change->change_kind == svn_fs_path_change_replace);
+      if (added)
+        {
+          if (change->copyfrom_known)
+            {
+              copyfrom_path = change->copyfrom_path;
+              copyfrom_rev = change->copyfrom_rev;
+            }
+          else
+            {
+              SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                         root, path, iterpool));
+            }
+        }
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, index->db,
+                                        STMT_INSERT_CHANGE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "srdsr", path, revision, (int)added,
+                                copyfrom_path, copyfrom_rev));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+
+      /* Mark PATH and its parents as touched.  Stop at the first parent
+         that has been marked for some earlier change. */
+      while (!svn_hash_gets(touched, path))
+        {
+          path = apr_pstrdup(scratch_pool, path);
+          svn_hash_sets(touched, path, path);
+
+          SVN_ERR(svn_sqlite__get_statement(&stmt, index->db,
+                                            STMT_INSERT_TOUCHED));
+          SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, revision));
+          SVN_ERR(svn_sqlite__insert(NULL, stmt));
+
+          if (svn_fspath__is_root(path, strlen(path)))
+            break;
+
+          path = svn_fspath__dirname(path, iterpool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the next batch of revisions up to YOUNGEST that are missing from
+ * INDEX to it and set *INDEXED to the youngest revision covered now.
+ * Send notifications through the optional NOTIFY_FUNC with NOTIFY_BATON
+ * and check for cancellation through the optional CANCEL_FUNC with
+ * CANCEL_BATON.  This must be called within a SQLite transaction.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+add_revision_batch(svn_revnum_t *indexed,
+                   svn_repos__log_index_t *index,
+                   svn_revnum_t youngest,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  svn_revnum_t revision, last;
+  svn_sqlite__stmt_t *stmt;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  /* Someone else may have added revisions in the meantime. */
+  SVN_ERR(get_youngest(indexed, index));
+  last = MIN(youngest, *indexed + REVISIONS_PER_TXN);
+
+  for (revision = *indexed + 1; revision <= last; ++revision)
+    {
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(add_revision(index, revision, iterpool));
+
+      if (notify_func)
+        {
+          svn_repos_notify_t *notify
+            = svn_repos_notify_create(svn_repos_notify_log_index_rev,
+                                      iterpool);
+          notify->revision = revision;
+          notify_func(notify_baton, notify, iterpool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  if (last > *indexed)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, index->db,
+                                        STMT_SET_YOUNGEST));
+      SVN_ERR(svn_sqlite__bindf(stmt, "rs", last, index->uuid));
+      SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+      *indexed = last;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add all revisions up to YOUNGEST that are missing from INDEX to it.
+ * NOTIFY_FUNC, NOTIFY_BATON, CANCEL_FUNC and CANCEL_BATON are the same as
+ * for add_revision_batch().  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+add_revisions(svn_repos__log_index_t *index,
+              svn_revnum_t youngest,
+              svn_repos_notify_func_t notify_func,
+              void *notify_baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool)
+{
+  svn_revnum_t indexed;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(get_youngest(&indexed, index));
+  while (indexed < youngest)
+    {
+      svn_pool_clear(iterpool);
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(add_revision_batch(&indexed, index,
+                                                        youngest,
+                                                        notify_func,
+                                                        notify_baton,
+                                                        cancel_func,
+                                                        cancel_baton,
+                                                        iterpool),
+                                     index->db);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_open(svn_repos__log_index_t **index_p,
+                          svn_repos_t *repos,
+                          svn_revnum_t revision,
+                          apr_pool_t *scratch_pool)
+{
+  svn_repos__log_index_t *index;
+  svn_revnum_t indexed;
+  svn_boolean_t valid;
+  svn_error_t *err;
+
+  *index_p = NULL;
+
+  /* The index is merely an accelerator.  Problems with it must never
+     keep the caller from getting its data the traditional way. */
+  err = open_index(&index, repos, FALSE, scratch_pool);
+  if (err || !index)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* Never trust an index of some other repository.  The next commit will
+     start it over. */
+  err = check_index(&valid, index, revision, scratch_pool);
+  if (!err && !valid)
+    return SVN_NO_ERROR;
+
+  if (!err)
+    err = get_youngest(&indexed, index);
+  if (!err && indexed < revision)
+    {
+      /* Don't keep the reader waiting for a larger catch-up. */
+      if (revision - indexed > MAX_READER_CATCH_UP)
+        return SVN_NO_ERROR;
+
+      err = add_revisions(index, revision, NULL, NULL, NULL, NULL,
+                          scratch_pool);
+    }
+
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  *index_p = index;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_update(svn_repos_t *repos,
+                            apr_pool_t *scratch_pool)
+{
+  svn_repos__log_index_t *index;
+  svn_revnum_t youngest, indexed;
+  svn_boolean_t valid;
+
+  SVN_ERR(open_index(&index, repos, FALSE, scratch_pool));
+  if (!index)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, scratch_pool));
+
+  /* Start over if the index belongs to some other repository. */
+  SVN_ERR(check_index(&valid, index, youngest, scratch_pool));
+  if (!valid)
+    SVN_ERR(clear_index(index));
+
+  /* Don't delay the caller for long. */
+  SVN_ERR(get_youngest(&indexed, index));
+  youngest = MIN(youngest, indexed + MAX_WRITER_CATCH_UP);
+
+  return svn_error_trace(add_revisions(index, youngest,
+                                       NULL, NULL, NULL, NULL,
+                                       scratch_pool));
+}
+
+svn_error_t *
+svn_repos__log_index_youngest(svn_revnum_t *indexed,
+                              svn_repos_t *repos,
+                              apr_pool_t *scratch_pool)
+{
+  svn_repos__log_index_t *index;
+  svn_revnum_t youngest;
+  svn_boolean_t valid;
+
+  *indexed = SVN_INVALID_REVNUM;
+
+  SVN_ERR(open_index(&index, repos, FALSE, scratch_pool));
+  if (!index)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, scratch_pool));
+  SVN_ERR(check_index(&valid, index, youngest, scratch_pool));
+  if (valid)
+    SVN_ERR(get_youngest(indexed, index));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_build_log_index(svn_repos_t *repos,
+                          svn_repos_notify_func_t notify_func,
+                          void *notify_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  svn_repos__log_index_t *index;
+  svn_revnum_t youngest;
+
+  SVN_ERR(open_index(&index, repos, TRUE, scratch_pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, scratch_pool));
+
+  /* Start from scratch. */
+  SVN_ERR(clear_index(index));
+
+  return svn_error_trace(add_revisions(index, youngest,
+                                       notify_func, notify_baton,
+                                       cancel_func, cancel_baton,
+                                       scratch_pool));
+}
+
+/* Make HISTORY continue with the section of history that contains
+ * PATH@UPPER.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+start_section(svn_repos__log_index_history_t *history,
+              const char *path,
+              svn_revnum_t upper,
+              apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *db = history->index->db;
+  const char *parent = path;
+  const char *added_path = NULL;
+  const char *copyfrom_path = NULL;
+  svn_revnum_t copyfrom_rev = SVN_INVALID_REVNUM;
+  svn_revnum_t lower = SVN_INVALID_REVNUM;
+
+  /* Find the youngest addition of PATH or any of its parents.  If there
+     are several in the same revision, the innermost one wins.  Only the
+     root has never been added; its history goes back to r0. */
+  while (!svn_fspath__is_root(parent, strlen(parent)))
+    {
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_GET_LAST_ADDITION));
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", parent, upper));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      if (have_row)
+        {
+          svn_revnum_t revision = svn_sqlite__column_revnum(stmt, 0);
+          if (!SVN_IS_VALID_REVNUM(lower) || revision > lower)
+            {
+              lower = revision;
+              added_path = parent;
+              copyfrom_path = svn_sqlite__column_text(stmt, 1, scratch_pool);
+              copyfrom_rev = svn_sqlite__column_revnum(stmt, 2);
+            }
+        }
+
+      SVN_ERR(svn_sqlite__reset(stmt));
+      parent = svn_fspath__dirname(parent, scratch_pool);
+    }
+
+  history->path = apr_pstrdup(history->pool, path);
+  history->lower = SVN_IS_VALID_REVNUM(lower) ? lower : 0;
+  history->copyfrom_path
+    = copyfrom_path
+    ? svn_fspath__join(copyfrom_path,
+                       svn_fspath__skip_ancestor(added_path, path),
+                       history->pool)
+    : NULL;
+  history->copyfrom_rev = copyfrom_rev;
+  history->cursor = upper;
+  history->last_reported = SVN_INVALID_REVNUM;
+
+  apr_array_clear(history->revisions);
+  history->next = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch the next batch of revisions of the current section of HISTORY
+ * from the index.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+fetch_revisions(svn_repos__log_index_history_t *history,
+                apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  apr_array_clear(history->revisions);
+  history->next = 0;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, history->index->db,
+                                    STMT_GET_CHANGED_REVISIONS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srrd", history->path, history->lower,
+                            history->cursor, REVISIONS_PER_QUERY));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      APR_ARRAY_PUSH(history->revisions, svn_revnum_t)
+        = svn_sqlite__column_revnum(stmt, 0);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* Continue below the last revision fetched, if there may be more. */
+  if (history->revisions->nelts < REVISIONS_PER_QUERY)
+    history->cursor = history->lower - 1;
+  else
+    history->cursor = APR_ARRAY_IDX(history->revisions,
+                                    history->revisions->nelts - 1,
+                                    svn_revnum_t) - 1;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_history(svn_repos__log_index_history_t **history_p,
+                             svn_repos__log_index_t *index,
+                             const char *path,
+                             svn_revnum_t revision,
+                             svn_boolean_t strict,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  svn_repos__log_index_history_t *history
+    = apr_pcalloc(result_pool, sizeof(*history));
+
+  history->index = index;
+  history->strict = strict;
+  history->done = FALSE;
+  history->revisions = apr_array_make(result_pool, REVISIONS_PER_QUERY,
+                                      sizeof(svn_revnum_t));
+  history->pool = result_pool;
+
+  SVN_ERR(start_section(history,
+                        svn_fspath__canonicalize(path, scratch_pool),
+                        revision, scratch_pool));
+
+  *history_p = history;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_history_prev(const char **path,
+                                  svn_revnum_t *revision,
+                                  svn_repos__log_index_history_t *history,
+                                  apr_pool_t *scratch_pool)
+{
+  while (!history->done)
+    {
+      /* Report all changes at or below PATH within the current section. */
+      if (   history->next == history->revisions->nelts
+          && history->cursor >= history->lower)
+        SVN_ERR(fetch_revisions(history, scratch_pool));
+
+      if (history->next < history->revisions->nelts)
+        {
+          *path = history->path;
+          *revision = APR_ARRAY_IDX(history->revisions, history->next++,
+                                    svn_revnum_t);
+          history->last_reported = *revision;
+
+          return SVN_NO_ERROR;
+        }
+
+      /* The section starts with the addition of PATH or one of its
+         parents.  That counts as a change of PATH, too. */
+      if (history->last_reported != history->lower)
+        {
+          *path = history->path;
+          *revision = history->lower;
+          history->last_reported = history->lower;
+
+          return SVN_NO_ERROR;
+        }
+
+      /* Continue at the copy source, if any. */
+      if (history->copyfrom_path && !history->strict)
+        SVN_ERR(start_section(history, history->copyfrom_path,
+                              history->copyfrom_rev, scratch_pool));
+      else
+        history->done = TRUE;
+    }
+
+  *path = NULL;
+  *revision = SVN_INVALID_REVNUM;
+
+  return SVN_NO_ERROR;
+}
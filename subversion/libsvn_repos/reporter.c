@@ -104,7 +104,7 @@ typedef struct revision_info_t
    driven by the client as it describes its working copy revisions. */
 typedef struct report_baton_t
 {
-  /* Parameters remembered from svn_repos_begin_report3 */
+  /* Parameters remembered from svn_repos_begin_report4 */
   svn_repos_t *repos;
   const char *fs_base;         /* fspath corresponding to wc anchor */
   const char *s_operand;       /* anchor-relative wc target (may be empty) */
@@ -126,8 +126,14 @@ typedef struct report_baton_t
   const svn_delta_editor_t *editor;
   void *edit_baton;
   svn_repos_authz_func_t authz_read_func;
+  svn_repos_authz_subtree_func_t authz_subtree_func;
   void *authz_read_baton;
 
+  /* Target path of the innermost directory being processed that is
+     readable as a whole, as reported by AUTHZ_SUBTREE_FUNC.  NULL if
+     there is none.  Paths below it need no individual authz checks. */
+  const char *readable_subtree;
+
   /* The spill-buffer holding the report. */
   svn_spillbuf_reader_t *reader;
 
@@ -748,13 +754,39 @@ static svn_error_t *
 check_auth(report_baton_t *b, svn_boolean_t *allowed, const char *path,
            apr_pool_t *pool)
 {
-  if (b->authz_read_func)
+  if (b->authz_read_func
+      && !(b->readable_subtree
+           && svn_fspath__skip_ancestor(b->readable_subtree, path)))
     return svn_error_trace(b->authz_read_func(allowed, b->t_root, path,
                                               b->authz_read_baton, pool));
   *allowed = TRUE;
   return SVN_NO_ERROR;
 }
 
+/* If B->t_root/PATH is a directory that is readable as a whole but not
+   yet covered by B->readable_subtree, make it the new B->readable_subtree,
+   allocated in POOL.  Set *PREVIOUS to the previous value, which the
+   caller must restore once it is done with PATH. */
+static svn_error_t *
+enter_subtree(report_baton_t *b, const char **previous, const char *path,
+              apr_pool_t *pool)
+{
+  svn_boolean_t readable;
+
+  *previous = b->readable_subtree;
+  if (!b->authz_subtree_func
+      || (b->readable_subtree
+          && svn_fspath__skip_ancestor(b->readable_subtree, path)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(b->authz_subtree_func(&readable, b->t_root, path,
+                                b->authz_read_baton, pool));
+  if (readable)
+    b->readable_subtree = apr_pstrdup(pool, path);
+
+  return SVN_NO_ERROR;
+}
+
 /* Create a dirent in *ENTRY for the given ROOT and PATH.  We use this to
    replace the source or target dirent when a report pathinfo tells us to
    change paths or revisions. */
@@ -1028,6 +1060,8 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 
   if (t_entry->kind == svn_node_dir)
     {
+      const char *readable_subtree;
+
       if (related)
         SVN_ERR(b->editor->open_directory(e_path, dir_baton, s_rev, pool,
                                           &new_baton));
@@ -1036,9 +1070,12 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                                          SVN_INVALID_REVNUM, pool,
                                          &new_baton));
 
+      SVN_ERR(enter_subtree(b, &readable_subtree, t_path, pool));
       SVN_ERR(delta_dirs(b, s_rev, s_path, t_path, new_baton, e_path,
                          info ? info->start_empty : FALSE,
                          wc_depth, requested_depth, pool));
+      b->readable_subtree = readable_subtree;
+
       return svn_error_trace(b->editor->close_directory(new_baton, pool));
     }
   else
@@ -1389,9 +1426,15 @@ drive(report_baton_t *b, svn_revnum_t s_rev, path_info_t *info,
   /* If the anchor is the operand, diff the two directories; otherwise
      update the operand within the anchor directory. */
   if (!*b->s_operand)
-    SVN_ERR(delta_dirs(b, s_rev, s_fullpath, b->t_path, root_baton,
-                       "", info->start_empty, info->depth, b->requested_depth,
-                       pool));
+    {
+      const char *readable_subtree;
+
+      SVN_ERR(enter_subtree(b, &readable_subtree, b->t_path, pool));
+      SVN_ERR(delta_dirs(b, s_rev, s_fullpath, b->t_path, root_baton,
+                         "", info->start_empty, info->depth,
+                         b->requested_depth, pool));
+      b->readable_subtree = readable_subtree;
+    }
   else
     SVN_ERR(update_entry(b, s_rev, s_fullpath, s_entry, b->t_path,
                          t_entry, root_baton, b->s_operand, info,
@@ -1564,7 +1607,7 @@ svn_repos_abort_report(void *baton, apr_pool_t *pool)
 
 
 svn_error_t *
-svn_repos_begin_report3(void **report_baton,
+svn_repos_begin_report4(void **report_baton,
                         svn_revnum_t revnum,
                         svn_repos_t *repos,
                         const char *fs_base,
@@ -1577,6 +1620,7 @@ svn_repos_begin_report3(void **report_baton,
                         const svn_delta_editor_t *editor,
                         void *edit_baton,
                         svn_repos_authz_func_t authz_read_func,
+                        svn_repos_authz_subtree_func_t authz_subtree_func,
                         void *authz_read_baton,
                         apr_size_t zero_copy_limit,
                         apr_pool_t *pool)
@@ -1608,7 +1652,9 @@ svn_repos_begin_report3(void **report_baton,
   b->editor = editor;
   b->edit_baton = edit_baton;
   b->authz_read_func = authz_read_func;
+  b->authz_subtree_func = authz_read_func ? authz_subtree_func : NULL;
   b->authz_read_baton = authz_read_baton;
+  b->readable_subtree = NULL;
   b->revision_infos = apr_hash_make(pool);
   b->pool = pool;
   b->reader = svn_spillbuf__reader_create(1000 /* blocksize */,
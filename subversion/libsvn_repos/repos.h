@@ -27,6 +27,7 @@
 #include <apr_hash.h>
 
 #include "svn_fs.h"
+#include "svn_config.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -64,6 +65,7 @@ extern "C" {
 #define SVN_REPOS__LOCK_DIR    "locks"      /* Lock files live here. */
 #define SVN_REPOS__HOOK_DIR    "hooks"      /* Hook programs. */
 #define SVN_REPOS__CONF_DIR    "conf"       /* Configuration files. */
+#define SVN_REPOS__LOG_INDEX   "log-index.db" /* Changed-paths index. */
 
 /* Things for which we keep lockfiles. */
 #define SVN_REPOS__DB_LOCKFILE "db.lock" /* Our Berkeley lockfile. */
@@ -102,6 +104,13 @@ extern "C" {
 #define SVN_REPOS__CONF_AUTHZ "authz"
 #define SVN_REPOS__CONF_GROUPS "groups"
 
+/* An open changed-paths index, see log_index.c. */
+typedef struct svn_repos__log_index_t svn_repos__log_index_t;
+
+/* Iterator over the history of a path as recorded in the changed-paths
+   index, see svn_repos__log_index_history(). */
+typedef struct svn_repos__log_index_history_t svn_repos__log_index_history_t;
+
 /* The Repository object, created by svn_repos_open2() and
    svn_repos_create(). */
 struct svn_repos_t
@@ -152,6 +161,10 @@ struct svn_repos_t
      those constants' addresses, therefore). */
   apr_hash_t *repository_capabilities;
 
+  /* The changed-paths index, opened on demand.  NULL if it has not been
+     opened, yet. */
+  svn_repos__log_index_t *log_index;
+
   /* Pool from which this structure was allocated.  Also used for
      auxiliary repository-related data that requires a matching
      lifespan.  (As the svn_repos_t structure tends to be relatively
@@ -382,12 +395,86 @@ svn_repos__authz_read(svn_authz_t **authz_p,
                       svn_boolean_t accept_urls,
                       apr_pool_t *pool);
 
-/* Walk the configuration in AUTHZ looking for any errors. */
+/* Validate the authz rules in CFG and compile them into *AUTHZ_P,
+   allocated in POOL.  Access checks against *AUTHZ_P will no longer
+   consult CFG.  If THREAD_SAFE is set, *AUTHZ_P may be used concurrently
+   by multiple threads.
+
+   If CFG is not a valid authz rule file, return
+   SVN_AUTHZ_INVALID_CONFIG. */
 svn_error_t *
-svn_repos__authz_validate(svn_authz_t *authz,
-                          apr_pool_t *pool);
+svn_repos__authz_compile(svn_authz_t **authz_p,
+                         svn_config_t *cfg,
+                         svn_boolean_t thread_safe,
+                         apr_pool_t *pool);
 
 
+/*** Changed-paths Index Functions ***/
+
+/* Set *INDEX to the changed-paths index of REPOS, covering at least all
+   revisions up to REVISION.  Add a few missing revisions to the index
+   first, if necessary.  Set *INDEX to NULL if REPOS has no index, if it
+   lags too far behind or if it could not be updated; callers shall then
+   fall back to walking node histories.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_repos__log_index_open(svn_repos__log_index_t **index,
+                          svn_repos_t *repos,
+                          svn_revnum_t revision,
+                          apr_pool_t *scratch_pool);
+
+/* Add revisions of REPOS that are missing from its changed-paths index to
+   it, but not more than a limited number per call.  Start the index over if
+   it does not belong to REPOS.  Do nothing if REPOS has no index.  Use
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__log_index_update(svn_repos_t *repos,
+                            apr_pool_t *scratch_pool);
+
+/* Set *HISTORY to a new iterator over the history of PATH@REVISION as
+   recorded in INDEX.  Follow copies unless STRICT is set.  PATH must
+   exist in REVISION and must not be the root.  Allocate *HISTORY in
+   RESULT_POOL; use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__log_index_history(svn_repos__log_index_history_t **history,
+                             svn_repos__log_index_t *index,
+                             const char *path,
+                             svn_revnum_t revision,
+                             svn_boolean_t strict,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+/* Set *PATH and *REVISION to the next older location in HISTORY, i.e.
+   the same locations that svn_fs_history_prev2() would report, in the
+   same order.  Set *PATH to NULL if there is no further history.
+   *PATH will be allocated in HISTORY's result pool.  Use SCRATCH_POOL
+   for temporary allocations. */
+svn_error_t *
+svn_repos__log_index_history_prev(const char **path,
+                                  svn_revnum_t *revision,
+                                  svn_repos__log_index_history_t *history,
+                                  apr_pool_t *scratch_pool);
+
+
+/*** Dumpstream Parsing Functions ***/
+
+/* Like svn_repos_parse_dumpstream3() with DELTAS_ARE_TEXT set to FALSE,
+   but read and parse STREAM in one thread and decode its text deltas in
+   another one while the callbacks in PARSE_FNS get invoked from the
+   calling thread.  The stages are connected by bounded queues, i.e. the
+   callbacks see exactly the same sequence of calls as in a sequential
+   parse.  CANCEL_FUNC must be thread-safe.
+
+   Without thread support, this is the same as a sequential parse. */
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool);
+
+
 /*** Utility Functions ***/
 
 /* Set *CHANGED_P to TRUE if ROOT1/PATH1 and ROOT2/PATH2 have
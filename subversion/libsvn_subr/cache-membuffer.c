@@ -23,14 +23,23 @@
 
 #include <assert.h>
 #include <apr_md5.h>
+#include <apr_shm.h>
 #include <apr_thread_rwlock.h>
 
+#if APR_HAS_FORK
+#include <errno.h>
+#include <signal.h>     /* for kill() */
+#include <unistd.h>     /* for getpid() */
+#endif
+
 #include "svn_pools.h"
 #include "svn_checksum.h"
 #include "svn_private_config.h"
 #include "svn_hash.h"
 #include "svn_string.h"
 #include "svn_sorts.h"  /* get the MIN macro */
+#include "svn_io.h"
+#include "svn_version.h"
 
 #include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
@@ -63,8 +72,16 @@
  * Only the start address of these two data parts are given as a native
  * pointer. All other references are expressed as offsets to these pointers.
  * With that design, it is relatively easy to share the same data structure
- * between different processes and / or to persist them on disk. These
- * out-of-process features have not been implemented, yet.
+ * between different processes and / or to persist them on disk.
+ *
+ * Sharing between processes is supported for processes forked from the
+ * one that created the cache (see svn_cache__membuffer_cache_create_shared).
+ * In that case, the segments, directories and data buffers all live in a
+ * shared memory region that gets mapped at the same address in every
+ * process.  Segment locking then uses a spin lock in the segment header
+ * because APR's thread locks do not work across process boundaries.  The
+ * lock records the ID of the process holding it, so a lock left behind by
+ * a process that died can be broken (see shared_lock_recover).
  *
  * Superficially, cache levels are being used as usual: insertion happens
  * into L1 and evictions will promote items to L2.  But their whole point
@@ -125,10 +142,19 @@
  * is then unique, too, and can never conflict.  No full key construction,
  * storage and comparison is needed in that case.
  *
- * All access to the cached data needs to be serialized. Because we want
- * to scale well despite that bottleneck, we simply segment the cache into
- * a number of independent caches (segments). Items will be multiplexed based
- * on their hash key.
+ * All modifications to the cached data need to be serialized. Because we
+ * want to scale well despite that bottleneck, we simply segment the cache
+ * into a number of independent caches (segments). Items will be multiplexed
+ * based on their hash key.
+ *
+ * Reads, which are by far the most frequent operation, don't need to take
+ * the segment lock in the common case.  Every segment has a sequence
+ * counter (seqlock) that writers bump to an odd value before they start
+ * modifying the segment and back to an even value when they are done.
+ * Readers look up the entry and copy its serialized data without holding
+ * the lock and only accept the result if the counter was even and did not
+ * change in the meantime.  Otherwise, they retry with the read lock held.
+ * See membuffer_cache_get_optimistic() for details.
  */
 
 /* APR's read-write lock implementation on Windows is horribly inefficient.
@@ -146,6 +172,29 @@
 #  define USE_SIMPLE_MUTEX 0
 #endif
 
+/* Lock-free, optimistic reads only make sense if there are multiple threads
+ * contending for the segment locks.  In debug mode, the getters perform
+ * extra consistency checks on the cache contents that require a stable
+ * view on the segment, so we always take the lock there.
+ */
+#if APR_HAS_THREADS && !defined(SVN_DEBUG_CACHE_MEMBUFFER)
+#  define USE_OPTIMISTIC_READS 1
+#else
+#  define USE_OPTIMISTIC_READS 0
+#endif
+
+/* Number of lock-free lookup attempts before falling back to taking the
+ * read lock.  Conflicts with concurrent writers to the same segment are
+ * rare, so a single retry is usually enough.
+ */
+#define MAX_OPTIMISTIC_READ_ATTEMPTS 2
+
+/* Route every this many reads of a segment through the read lock, even
+ * if they could be served lock-free.  Only those reads update the hit
+ * counters of the cache entries, which drive our eviction decisions.
+ */
+#define OPTIMISTIC_READ_SAMPLING 16
+
 /* For more efficient copy operations, let's align all data items properly.
  * Must be a power of 2.
  */
@@ -239,11 +288,21 @@ typedef struct full_key_t
 /* A limited capacity, thread-safe pool of unique C strings.  Operations on
  * this data structure are defined by prefix_pool_* functions.  The only
  * "public" member is VALUES (r/o access only).
+ *
+ * Lookups are lock-free: MAP is an open-addressing hash table whose slots
+ * are only ever written once, from empty to their final value, and VALUES
+ * entries are filled in before the slot referencing them gets published.
+ * Only insertions need to be serialized.
  */
 typedef struct prefix_pool_t
 {
-  /* Map C string to a pointer into VALUES with the same contents. */
-  apr_hash_t *map;
+  /* Hash table mapping C strings to their index in VALUES.  Each slot is
+   * either 0 (empty) or 1 + the index.  MAP_SIZE elements, which is a
+   * power of two larger than VALUES_MAX.  May be NULL if VALUES_MAX is 0. */
+  volatile svn_atomic_t *map;
+
+  /* Number of slots in MAP. */
+  apr_uint32_t map_size;
 
   /* Pointer to an array of strings. These are the contents of this pool
    * and each one of them is referenced by MAP.  Valid indexes are 0 to
@@ -263,13 +322,16 @@ typedef struct prefix_pool_t
    * the implementation may . */
   apr_size_t bytes_used;
 
-  /* The serialization object. */
+  /* Pool to allocate the VALUES strings from. */
+  apr_pool_t *pool;
+
+  /* The serialization object for insertions. */
   svn_mutex__t *mutex;
 } prefix_pool_t;
 
 /* Set *PREFIX_POOL to a new instance that tries to limit allocation to
  * BYTES_MAX bytes.  If MUTEX_REQUIRED is set and multi-threading is
- * supported, serialize all access to the new instance.  Allocate the
+ * supported, serialize all insertions into the new instance.  Allocate the
  * object from *RESULT_POOL. */
 static svn_error_t *
 prefix_pool_create(prefix_pool_t **prefix_pool,
@@ -286,13 +348,22 @@ prefix_pool_create(prefix_pool_t **prefix_pool,
       ESTIMATED_BYTES_PER_ENTRY = 120,
     };
 
-  /* Number of entries we are going to support. */
-  apr_size_t capacity = MIN(APR_UINT32_MAX,
+  /* Number of entries we are going to support.  Leave room for the
+   * hash table to be at most half full. */
+  apr_size_t capacity = MIN(APR_UINT32_MAX / 4,
                             bytes_max / ESTIMATED_BYTES_PER_ENTRY);
+  apr_uint32_t map_size = 1;
 
   /* Construct the result struct. */
   prefix_pool_t *result = apr_pcalloc(result_pool, sizeof(*result));
-  result->map = svn_hash__make(result_pool);
+
+  while (capacity && map_size < 2 * capacity)
+    map_size *= 2;
+
+  result->map = capacity
+              ? apr_pcalloc(result_pool, map_size * sizeof(*result->map))
+              : NULL;
+  result->map_size = capacity ? map_size : 0;
 
   result->values = capacity
                  ? apr_pcalloc(result_pool, capacity * sizeof(const char *))
@@ -301,7 +372,9 @@ prefix_pool_create(prefix_pool_t **prefix_pool,
   result->values_used = 0;
 
   result->bytes_max = bytes_max;
-  result->bytes_used = capacity * sizeof(svn_membuf_t);
+  result->bytes_used = capacity * sizeof(const char *)
+                     + result->map_size * sizeof(*result->map);
+  result->pool = result_pool;
 
   SVN_ERR(svn_mutex__init(&result->mutex, mutex_required, result_pool));
 
@@ -310,79 +383,137 @@ prefix_pool_create(prefix_pool_t **prefix_pool,
   return SVN_NO_ERROR;
 }
 
+/* Look for PREFIX of PREFIX_LEN bytes with hash value HASH in PREFIX_POOL
+ * without any locking.  If found, return the index of its VALUES entry.
+ * Otherwise, return NO_INDEX and set *SLOT to the first empty slot in the
+ * probing sequence.  *SLOT may be NULL if the hash table is full.
+ *
+ * This is safe to call concurrently with prefix_pool_get_internal because
+ * slots never change once they have been filled.  We read every slot with
+ * acquire semantics, pairing with the CAS that publishes it.  Hence, once
+ * we see a filled slot, the VALUES entry it refers to is complete. */
+static apr_uint32_t
+prefix_pool_lookup(volatile svn_atomic_t **slot,
+                   prefix_pool_t *prefix_pool,
+                   const char *prefix,
+                   apr_size_t prefix_len,
+                   apr_uint32_t hash)
+{
+  apr_uint32_t mask = prefix_pool->map_size - 1;
+  apr_uint32_t i;
+
+  *slot = NULL;
+  for (i = 0; i < prefix_pool->map_size; ++i)
+    {
+      volatile svn_atomic_t *current
+        = &prefix_pool->map[(hash + i) & mask];
+      apr_uint32_t value = svn_atomic__read_acquire(current);
+      const char *candidate;
+
+      /* End of probing sequence. */
+      if (value == 0)
+        {
+          *slot = current;
+          return NO_INDEX;
+        }
+
+      /* VALUES[VALUE-1] has been set before the slot got published. */
+      candidate = prefix_pool->values[value - 1];
+      if (strcmp(candidate, prefix) == 0)
+        return value - 1;
+    }
+
+  return NO_INDEX;
+}
+
 /* Set *PREFIX_IDX to the offset in PREFIX_POOL->VALUES that contains the
  * value PREFIX.  If none exists, auto-insert it.  If we can't due to
- * capacity exhaustion, set *PREFIX_IDX to NO_INDEX.
- * To be called by prefix_pool_get() only. */
+ * capacity exhaustion, set *PREFIX_IDX to NO_INDEX.  PREFIX_LEN and HASH
+ * are the length and hash value of PREFIX, respectively.
+ * To be called by prefix_pool_get() with the mutex held only. */
 static svn_error_t *
 prefix_pool_get_internal(apr_uint32_t *prefix_idx,
                          prefix_pool_t *prefix_pool,
-                         const char *prefix)
+                         const char *prefix,
+                         apr_size_t prefix_len,
+                         apr_uint32_t hash)
 {
   enum
     {
-      /* Size of an hash entry plus (max.) APR alignment loss.
+      /* Max. APR alignment loss per string.
        *
        * This may be slightly off if e.g. APR changes its internal data
        * structures but that will translate in just a few percent (~10%)
        * over-allocation.  Memory consumption will still be capped.
        */
-      OVERHEAD = 40 + 8
+      OVERHEAD = 8
     };
 
-  const char **value;
-  apr_size_t prefix_len = strlen(prefix);
+  volatile svn_atomic_t *slot;
   apr_size_t bytes_needed;
-  apr_pool_t *pool;
+  apr_uint32_t idx;
 
-  /* Lookup.  If we already know that prefix, return its index. */
-  value = apr_hash_get(prefix_pool->map, prefix, prefix_len);
-  if (value != NULL)
-    {
-      const apr_size_t idx = value - prefix_pool->values;
-      SVN_ERR_ASSERT(idx < prefix_pool->values_used);
-      *prefix_idx = (apr_uint32_t) idx;
-      return SVN_NO_ERROR;
-    }
+  /* Lookup again.  Someone might have added PREFIX while we were waiting
+   * for the mutex. */
+  *prefix_idx = prefix_pool_lookup(&slot, prefix_pool, prefix, prefix_len,
+                                   hash);
+  if (*prefix_idx != NO_INDEX)
+    return SVN_NO_ERROR;
 
   /* Capacity checks. */
-  if (prefix_pool->values_used == prefix_pool->values_max)
-    {
-      *prefix_idx = NO_INDEX;
-      return SVN_NO_ERROR;
-    }
+  if (slot == NULL || prefix_pool->values_used == prefix_pool->values_max)
+    return SVN_NO_ERROR;
 
   bytes_needed = prefix_len + 1 + OVERHEAD;
   assert(prefix_pool->bytes_max >= prefix_pool->bytes_used);
-  if (prefix_pool->bytes_max - prefix_pool->bytes_used > bytes_needed)
-    {
-      *prefix_idx = NO_INDEX;
-      return SVN_NO_ERROR;
-    }
-
-  /* Add new entry. */
-  pool = apr_hash_pool_get(prefix_pool->map);
+  if (prefix_pool->bytes_max - prefix_pool->bytes_used < bytes_needed)
+    return SVN_NO_ERROR;
 
-  value = &prefix_pool->values[prefix_pool->values_used];
-  *value = apr_pstrndup(pool, prefix, prefix_len + 1);
-  apr_hash_set(prefix_pool->map, *value, prefix_len, value);
+  /* Add new entry.  Fill in the value before publishing it in the map
+   * such that lock-free readers will never see incomplete entries.
+   * The CAS implies a full memory barrier and pairs with the acquire
+   * load in prefix_pool_lookup. */
+  idx = prefix_pool->values_used;
+  prefix_pool->values[idx] = apr_pstrmemdup(prefix_pool->pool, prefix,
+                                            prefix_len);
+  svn_atomic_cas(slot, idx + 1, 0);
 
-  *prefix_idx = prefix_pool->values_used;
+  *prefix_idx = idx;
   ++prefix_pool->values_used;
   prefix_pool->bytes_used += bytes_needed;
 
   return SVN_NO_ERROR;
 }
 
-/* Thread-safe wrapper around prefix_pool_get_internal. */
+/* Set *PREFIX_IDX to the offset in PREFIX_POOL->VALUES that contains the
+ * value PREFIX.  If none exists, auto-insert it.  If we can't due to
+ * capacity exhaustion, set *PREFIX_IDX to NO_INDEX.
+ *
+ * Prefixes that are already known will be found without locking.  Only
+ * insertions get serialized. */
 static svn_error_t *
 prefix_pool_get(apr_uint32_t *prefix_idx,
                 prefix_pool_t *prefix_pool,
                 const char *prefix)
 {
+  volatile svn_atomic_t *slot;
+  apr_size_t prefix_len = strlen(prefix);
+  apr_uint32_t hash = svn__fnv1a_32(prefix, prefix_len);
+
+  /* Empty pool? */
+  *prefix_idx = NO_INDEX;
+  if (prefix_pool->map_size == 0)
+    return SVN_NO_ERROR;
+
+  /* Fast path.  This should be the common case. */
+  *prefix_idx = prefix_pool_lookup(&slot, prefix_pool, prefix, prefix_len,
+                                   hash);
+  if (*prefix_idx != NO_INDEX || slot == NULL)
+    return SVN_NO_ERROR;
+
   SVN_MUTEX__WITH_LOCK(prefix_pool->mutex,
                        prefix_pool_get_internal(prefix_idx, prefix_pool,
-                                                prefix));
+                                                prefix, prefix_len, hash));
 
   return SVN_NO_ERROR;
 }
@@ -792,6 +923,76 @@ struct svn_membuffer_t
    */
   apr_uint64_t total_hits;
 
+  /* Number of hits on entries in L2.
+   * Purely statistical information that may be used for profiling only.
+   */
+  apr_uint64_t total_l2_hits;
+
+  /* Number of entries evicted from L1 that got promoted to L2 and those
+   * that got dropped instead, respectively.
+   * Purely statistical information that may be used for profiling only.
+   */
+  apr_uint64_t total_promotions;
+  apr_uint64_t total_rejections;
+
+  /* Count-min sketch of recent access frequencies used by the TinyLFU
+   * admission policy.  SKETCH_DEPTH rows of SKETCH_MASK+1 saturating
+   * counters each.  NULL unless that policy has been selected.
+   * Updates are not synchronized; we only need estimates.
+   */
+  unsigned char *frequency_sketch;
+
+  /* Number of counters per FREQUENCY_SKETCH row minus 1.
+   * The row length is a power of two.
+   */
+  apr_uint32_t sketch_mask;
+
+  /* Number of accesses recorded in FREQUENCY_SKETCH since it has last
+   * been aged.  See sketch_record_access().
+   */
+  volatile svn_atomic_t sketch_samples;
+
+  /* Sequence counter for optimistic, lock-free reads.  It is odd while a
+   * writer is modifying this segment and gets incremented again once the
+   * modification is complete.  Only ever changed while holding the write
+   * lock; see begin_modification() and end_modification().
+   */
+  volatile svn_atomic_t write_sequence;
+
+  /* Statistics collected by optimistic readers.  Those don't hold the
+   * segment lock and must not touch the TOTAL_* counters above.  Instead,
+   * they update these and the next writer folds them into TOTAL_READS,
+   * TOTAL_HITS and TOTAL_L2_HITS, respectively.  The updates are not
+   * atomic, so concurrent readers may lose some counts.  That is fine for
+   * statistics and much cheaper than contended atomic operations.
+   * See fold_optimistic_stats().
+   */
+  volatile apr_uint32_t optimistic_reads;
+  volatile apr_uint32_t optimistic_hits;
+  volatile apr_uint32_t optimistic_l2_hits;
+
+  /* Number of reads from this segment that considered the lock-free path.
+   * Not updated atomically either.  See optimistic_read_allowed().
+   */
+  volatile apr_uint32_t optimistic_samples;
+
+  /* If set, this segment lives in shared memory and may be accessed by
+   * multiple processes.  SHARED_LOCK will then be used instead of LOCK.
+   */
+  svn_boolean_t is_shared;
+
+  /* Cross-process spin lock.  SHARED_LOCK_FREE or the ID of the process
+   * that holds it.  Readers and writers both take it exclusively; most
+   * reads don't need it anyway.  Only used if IS_SHARED is set.
+   */
+  volatile svn_atomic_t shared_lock;
+
+  /* If set, write access will wait until they get exclusive access.
+   * Otherwise, they will become no-ops if the segment is currently
+   * read-locked.  Only used when LOCK is an r/w lock or for SHARED_LOCK.
+   */
+  svn_boolean_t allow_blocking_writes;
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   /* A lock for intra-process synchronization to the cache, or NULL if
    * the cache's creator doesn't feel the cache needs to be
@@ -801,15 +1002,25 @@ struct svn_membuffer_t
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
   /* Same for read-write lock. */
   apr_thread_rwlock_t *lock;
-
-  /* If set, write access will wait until they get exclusive access.
-   * Otherwise, they will become no-ops if the segment is currently
-   * read-locked.  Only used when LOCK is an r/w lock.
-   */
-  svn_boolean_t allow_blocking_writes;
 #endif
 };
 
+/* Number of rows, i.e. independent hash functions, in the frequency
+ * sketch used by the TinyLFU admission policy.  Must not exceed 4 as we
+ * derive the hashes from the 128 bit key fingerprint.
+ */
+#define SKETCH_DEPTH 4
+
+/* Frequency sketch counters saturate at this value.
+ */
+#define SKETCH_MAX_COUNT 15
+
+/* Halve all frequency sketch counters after recording this many accesses
+ * per counter in a row.  This lets the sketch forget about items that
+ * used to be popular a long time ago.
+ */
+#define SKETCH_SAMPLE_FACTOR 10
+
 /* Align integer VALUE to the next ITEM_ALIGNMENT boundary.
  */
 #define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
@@ -818,11 +1029,132 @@ struct svn_membuffer_t
  */
 #define ALIGN_POINTER(pointer) ((void*)ALIGN_VALUE((apr_size_t)(char*)(pointer)))
 
+/* Value of svn_membuffer_t.SHARED_LOCK while nobody holds it.
+ */
+#define SHARED_LOCK_FREE 0
+
+/* Number of times we spin on a busy SHARED_LOCK before yielding the CPU
+ * and checking whether its owner is still alive.
+ */
+#define SHARED_LOCK_SPIN_COUNT 100
+
+/* Return the value to store in svn_membuffer_t.SHARED_LOCK while the
+ * current process holds it.  Never returns SHARED_LOCK_FREE.
+ */
+static apr_uint32_t
+shared_lock_owner_id(void)
+{
+#if APR_HAS_FORK
+  return (apr_uint32_t)getpid();
+#else
+  /* Only processes created by fork() may share a cache. */
+  return 1;
+#endif
+}
+
+/* Return TRUE if the process identified by OWNER, as returned by its
+ * shared_lock_owner_id(), does not exist anymore.
+ */
+static svn_boolean_t
+shared_lock_owner_died(apr_uint32_t owner)
+{
+#if APR_HAS_FORK
+  return kill((pid_t)owner, 0) != 0 && errno == ESRCH;
+#else
+  return FALSE;
+#endif
+}
+
+static void clear_segment(svn_membuffer_t *segment);
+static APR_INLINE svn_error_t *end_modification(svn_membuffer_t *cache,
+                                                svn_error_t *err);
+
+/* The shared CACHE segment has been found locked by OWNER.  If that
+ * process has died, take over the lock on behalf of process SELF and
+ * return TRUE.  Return FALSE otherwise.
+ *
+ * If the owner died while modifying the segment, its contents may be
+ * inconsistent.  Clear the segment in that case.
+ */
+static svn_boolean_t
+shared_lock_recover(svn_membuffer_t *cache,
+                    apr_uint32_t owner,
+                    apr_uint32_t self)
+{
+  /* Another thread of ours or a live process holds the lock. */
+  if (owner == self || !shared_lock_owner_died(owner))
+    return FALSE;
+
+  /* Only one process may break the lock. */
+  if (svn_atomic_cas(&cache->shared_lock, self, owner) != owner)
+    return FALSE;
+
+  /* Same condition as in membuffer_cache_get_optimistic. */
+  if (svn_atomic__read_acquire(&cache->write_sequence) & 1)
+    {
+      clear_segment(cache);
+      svn_error_clear(end_modification(cache, SVN_NO_ERROR));
+    }
+
+  return TRUE;
+}
+
+/* Try to acquire the lock on the shared CACHE segment.  Wait for it if
+ * BLOCKING is set.  Return TRUE upon success.
+ */
+static svn_boolean_t
+shared_lock(svn_membuffer_t *cache,
+            svn_boolean_t blocking)
+{
+  apr_uint32_t self = shared_lock_owner_id();
+  int spins = 0;
+
+  while (TRUE)
+    {
+      apr_uint32_t owner = svn_atomic_cas(&cache->shared_lock, self,
+                                          SHARED_LOCK_FREE);
+      if (owner == SHARED_LOCK_FREE)
+        return TRUE;
+
+      if (!blocking)
+        return FALSE;
+
+      if (++spins < SHARED_LOCK_SPIN_COUNT)
+        continue;
+
+      /* Don't waste CPU on a lock that might be held for a while or
+       * whose owner might have died. */
+      spins = 0;
+      if (shared_lock_recover(cache, owner, self))
+        return TRUE;
+
+#if APR_HAS_THREADS
+      apr_thread_yield();
+#else
+      apr_sleep(0);
+#endif
+    }
+}
+
+/* Release the lock that the caller holds on the shared CACHE segment.
+ */
+static void
+shared_unlock(svn_membuffer_t *cache)
+{
+  svn_atomic_set(&cache->shared_lock, SHARED_LOCK_FREE);
+}
+
 /* If locking is supported for CACHE, acquire a read lock for it.
  */
 static svn_error_t *
 read_lock_cache(svn_membuffer_t *cache)
 {
+  if (cache->is_shared)
+    {
+      shared_lock(cache, TRUE);
+      return SVN_NO_ERROR;
+    }
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -846,6 +1178,14 @@ read_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 {
+  if (cache->is_shared)
+    {
+      if (!shared_lock(cache, cache->allow_blocking_writes))
+        *success = FALSE;
+
+      return SVN_NO_ERROR;
+    }
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -883,6 +1223,12 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 static svn_error_t *
 force_write_lock_cache(svn_membuffer_t *cache)
 {
+  if (cache->is_shared)
+    {
+      shared_lock(cache, TRUE);
+      return SVN_NO_ERROR;
+    }
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -903,6 +1249,12 @@ force_write_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 {
+  if (cache->is_shared)
+    {
+      shared_unlock(cache);
+      return err;
+    }
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__unlock(cache->lock, err);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -922,6 +1274,71 @@ unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 #endif
 }
 
+/* Tell optimistic readers that the write-locked CACHE segment is about to
+ * be modified, i.e. that any data they read from it may be inconsistent.
+ */
+static APR_INLINE void
+begin_modification(svn_membuffer_t *cache)
+{
+  svn_atomic_inc(&cache->write_sequence);
+}
+
+/* Reset *COUNTER to 0 and add its previous value to *TOTAL.  Increments
+ * that race with this call may get lost.
+ */
+static void
+fold_counter(apr_uint64_t *total, volatile apr_uint32_t *counter)
+{
+  apr_uint32_t value = *counter;
+  if (value)
+    {
+      *counter = 0;
+      *total += value;
+    }
+}
+
+/* Add the statistics gathered by optimistic readers to the totals of
+ * CACHE.  The caller must hold the write lock.
+ */
+static void
+fold_optimistic_stats(svn_membuffer_t *cache)
+{
+  fold_counter(&cache->total_reads, &cache->optimistic_reads);
+  fold_counter(&cache->total_hits, &cache->optimistic_hits);
+  fold_counter(&cache->total_l2_hits, &cache->optimistic_l2_hits);
+}
+
+/* Tell optimistic readers that the modification of the write-locked CACHE
+ * segment has been completed.  Return ERR.
+ */
+static APR_INLINE svn_error_t *
+end_modification(svn_membuffer_t *cache, svn_error_t *err)
+{
+  svn_atomic_inc(&cache->write_sequence);
+  fold_optimistic_stats(cache);
+  return err;
+}
+
+/* Return the current value of CACHE's sequence counter before reading
+ * any segment data optimistically.  No later memory access will be moved
+ * before this call by either the compiler or the CPU.
+ */
+static APR_INLINE apr_uint32_t
+read_write_sequence(svn_membuffer_t *cache)
+{
+  return svn_atomic__read_acquire(&cache->write_sequence);
+}
+
+/* Return the current value of CACHE's sequence counter after reading
+ * segment data optimistically.  All earlier reads will have completed
+ * before the counter gets read.
+ */
+static APR_INLINE apr_uint32_t
+reread_write_sequence(svn_membuffer_t *cache)
+{
+  return svn_atomic__read_fenced(&cache->write_sequence);
+}
+
 /* If supported, guard the execution of EXPR with a read lock to CACHE.
  * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
  */
@@ -954,7 +1371,8 @@ do {                                                            \
       else                                                      \
         break;                                                  \
     }                                                           \
-  SVN_ERR(unlock_cache(cache, (expr)));                         \
+  begin_modification(cache);                                    \
+  SVN_ERR(unlock_cache(cache, end_modification(cache, (expr))));\
 } while (0)
 
 /* Returns 0 if the entry group identified by GROUP_INDEX in CACHE has not
@@ -1342,6 +1760,79 @@ get_group_index(svn_membuffer_t **cache,
   return (key0 % APR_UINT64_C(5030895599)) % segment0->group_count;
 }
 
+/* Return the counter for KEY in row ROW of CACHE's frequency sketch.
+ * Each row uses a different 32 bit slice of the key's fingerprint.
+ */
+static APR_INLINE unsigned char *
+sketch_counter(svn_membuffer_t *cache,
+               const entry_key_t *key,
+               int row)
+{
+  apr_uint32_t hash
+    = (apr_uint32_t)(key->fingerprint[row / 2] >> (32 * (row % 2)));
+
+  return cache->frequency_sketch
+       + (apr_size_t)row * (cache->sketch_mask + 1)
+       + (hash & cache->sketch_mask);
+}
+
+/* Record an access to the item identified by KEY in CACHE's frequency
+ * sketch.  No-op unless the TinyLFU admission policy is active.
+ *
+ * This may be called with only a read lock or even no lock at all
+ * because lost or duplicate updates only affect the estimates.
+ */
+static void
+sketch_record_access(svn_membuffer_t *cache,
+                     const entry_key_t *key)
+{
+  int row;
+  apr_size_t i, count;
+
+  if (cache->frequency_sketch == NULL)
+    return;
+
+  for (row = 0; row < SKETCH_DEPTH; ++row)
+    {
+      unsigned char *counter = sketch_counter(cache, key, row);
+      if (*counter < SKETCH_MAX_COUNT)
+        ++*counter;
+    }
+
+  /* Periodically age all counters such that items that are no longer
+   * being accessed lose their high frequency estimates.  Only the thread
+   * that reaches the limit will do that. */
+  count = (apr_size_t)SKETCH_DEPTH * (cache->sketch_mask + 1);
+  if (svn_atomic_inc(&cache->sketch_samples)
+      == SKETCH_SAMPLE_FACTOR * (cache->sketch_mask + 1) - 1)
+    {
+      for (i = 0; i < count; ++i)
+        cache->frequency_sketch[i] >>= 1;
+
+      svn_atomic_set(&cache->sketch_samples, 0);
+    }
+}
+
+/* Return the estimated number of recent accesses to the item identified
+ * by KEY in CACHE.  Returns 0 unless the TinyLFU admission policy is
+ * active.
+ */
+static apr_uint32_t
+sketch_estimate(svn_membuffer_t *cache,
+                const entry_key_t *key)
+{
+  int row;
+  apr_uint32_t result = SKETCH_MAX_COUNT;
+
+  if (cache->frequency_sketch == NULL)
+    return 0;
+
+  for (row = 0; row < SKETCH_DEPTH; ++row)
+    result = MIN(result, *sketch_counter(cache, key, row));
+
+  return result;
+}
+
 /* Reduce the hit count of ENTRY and update the accumulated hit info
  * in CACHE accordingly.
  */
@@ -1645,6 +2136,9 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
   apr_uint64_t drop_hits_limit = (to_fit_in->hit_count + 1)
                                * (apr_uint64_t)to_fit_in->priority;
 
+  /* estimated recent access frequency of the new entry */
+  apr_uint32_t frequency = sketch_estimate(cache, &to_fit_in->key);
+
   /* This loop will eventually terminate because every cache entry
    * would get dropped eventually:
    *
@@ -1748,7 +2242,19 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                * provide the same data but in a further stage of processing.
                */
               if (entry->priority > SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
-                drop_hits += entry->hit_count * (apr_uint64_t)entry->priority;
+                {
+                  /* TinyLFU: Only admit the new entry if it has recently
+                   * been accessed more often than the one it would evict.
+                   * Items read only once, e.g. during a full scan of the
+                   * repository, will not flush the frequently used ones.
+                   */
+                  if (   cache->frequency_sketch
+                      && sketch_estimate(cache, &entry->key)
+                           >= frequency)
+                    return FALSE;
+
+                  drop_hits += entry->hit_count * (apr_uint64_t)entry->priority;
+                }
 
               drop_entry(cache, entry);
             }
@@ -1816,9 +2322,15 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
           if (entry_index == cache->l1.next)
             {
               if (keep)
-                promote_entry(cache, entry);
+                {
+                  promote_entry(cache, entry);
+                  cache->total_promotions++;
+                }
               else
-                drop_entry(cache, entry);
+                {
+                  drop_entry(cache, entry);
+                  cache->total_rejections++;
+                }
             }
         }
     }
@@ -1849,17 +2361,54 @@ static void* secure_aligned_alloc(apr_pool_t *pool,
   return memory;
 }
 
-svn_error_t *
-svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
-                                  apr_size_t total_size,
-                                  apr_size_t directory_size,
-                                  apr_size_t segment_count,
-                                  svn_boolean_t thread_safe,
-                                  svn_boolean_t allow_blocking_writes,
-                                  apr_pool_t *pool)
+/* Allocate SIZE bytes for the cache structures, aligned to ITEM_ALIGNMENT
+ * and zeroed if ZERO is set.  If *SHARED_NEXT is NULL, allocate from POOL.
+ * Otherwise, take the memory from the shared memory region between
+ * *SHARED_NEXT and SHARED_END and update *SHARED_NEXT accordingly.
+ * Return NULL upon failed allocations.
+ */
+static void *
+cache_alloc(apr_pool_t *pool,
+            char **shared_next,
+            char *shared_end,
+            apr_size_t size,
+            svn_boolean_t zero)
+{
+  char *memory;
+  if (*shared_next == NULL)
+    return secure_aligned_alloc(pool, size, zero);
+
+  memory = ALIGN_POINTER(*shared_next);
+  if (memory > shared_end || shared_end - memory < (apr_ssize_t)size)
+    return NULL;
+
+  *shared_next = memory + size;
+  if (zero)
+    memset(memory, 0, size);
+
+  return memory;
+}
+
+/* Implement svn_cache__membuffer_cache_create and
+ * svn_cache__membuffer_cache_create_shared.  If SHARED is set, allocate
+ * all cache structures in a new shared memory region, backed by SHM_FILE
+ * unless that is NULL.  In that case, THREAD_SAFE is implied.
+ */
+static svn_error_t *
+membuffer_cache_create(svn_membuffer_t **cache,
+                       apr_size_t total_size,
+                       apr_size_t directory_size,
+                       apr_size_t segment_count,
+                       svn_boolean_t thread_safe,
+                       svn_boolean_t allow_blocking_writes,
+                       svn_boolean_t shared,
+                       const char *shm_file,
+                       apr_pool_t *pool)
 {
   svn_membuffer_t *c;
   prefix_pool_t *prefix_pool;
+  char *shared_next = NULL;
+  char *shared_end = NULL;
 
   apr_uint32_t seg;
   apr_uint32_t group_count;
@@ -1870,9 +2419,12 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   apr_uint64_t max_entry_size;
 
   /* Allocate 1% of the cache capacity to the prefix string pool.
+   *
+   * Shared caches can't use the prefix pool because the prefix indexes
+   * are process-specific.  Their keys will always be stored in full.
    */
-  SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
-                             pool));
+  SVN_ERR(prefix_pool_create(&prefix_pool, shared ? 0 : total_size / 100,
+                             thread_safe, pool));
   total_size -= total_size / 100;
 
   /* Limit the total size (only relevant if we can address > 4GB)
@@ -1927,9 +2479,6 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
          && segment_count < MAX_SEGMENT_COUNT)
     segment_count *= 2;
 
-  /* allocate cache as an array of segments / cache objects */
-  c = apr_palloc(pool, segment_count * sizeof(*c));
-
   /* Split total cache size into segments of equal size
    */
   total_size /= segment_count;
@@ -1980,6 +2529,36 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   assert(spare_group_count > 0 && main_group_count > 0);
 
   group_init_size = 1 + group_count / (8 * GROUP_INIT_GRANULARITY);
+
+  /* For shared caches, get a memory region large enough for all segments
+   * including their directories and data buffers.  There is no way to
+   * ever release it, i.e. it lives as long as POOL. */
+  if (shared)
+    {
+      apr_shm_t *shm;
+      apr_status_t status;
+      apr_size_t shm_size
+        = segment_count * sizeof(*c)
+        + segment_count * (group_count * sizeof(entry_group_t)
+                           + group_init_size
+                           + (apr_size_t)data_size)
+        + (3 * segment_count + 1) * ITEM_ALIGNMENT;
+
+      status = apr_shm_create(&shm, shm_size, shm_file, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create shared memory for cache"));
+
+      shared_next = apr_shm_baseaddr_get(shm);
+      shared_end = shared_next + apr_shm_size_get(shm);
+    }
+
+  /* allocate cache as an array of segments / cache objects */
+  c = cache_alloc(pool, &shared_next, shared_end,
+                  segment_count * sizeof(*c), FALSE);
+  if (c == NULL)
+    return svn_error_wrap_apr(APR_ENOMEM, "OOM");
+
   for (seg = 0; seg < segment_count; ++seg)
     {
       /* allocate buffers and initialize cache members
@@ -1995,12 +2574,14 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* Allocate but don't clear / zero the directory because it would add
          significantly to the server start-up time if the caches are large.
          Group initialization will take care of that in stead. */
-      c[seg].directory = apr_palloc(pool,
-                                    group_count * sizeof(entry_group_t));
+      c[seg].directory = cache_alloc(pool, &shared_next, shared_end,
+                                     group_count * sizeof(entry_group_t),
+                                     FALSE);
 
       /* Allocate and initialize directory entries as "not initialized",
          hence "unused" */
-      c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+      c[seg].group_initialized = cache_alloc(pool, &shared_next, shared_end,
+                                             group_init_size, TRUE);
 
       /* Allocate 1/4th of the data buffer to L1
        */
@@ -2020,7 +2601,8 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].l2.size = data_size - c[seg].l1.size;
       c[seg].l2.current_data = c[seg].l2.start_offset;
 
-      c[seg].data = secure_aligned_alloc(pool, (apr_size_t)data_size, FALSE);
+      c[seg].data = cache_alloc(pool, &shared_next, shared_end,
+                                (apr_size_t)data_size, FALSE);
       c[seg].data_used = 0;
       c[seg].max_entry_size = max_entry_size;
 
@@ -2028,37 +2610,58 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].total_reads = 0;
       c[seg].total_writes = 0;
       c[seg].total_hits = 0;
+      c[seg].total_l2_hits = 0;
+      c[seg].total_promotions = 0;
+      c[seg].total_rejections = 0;
+      c[seg].write_sequence = 0;
+      c[seg].optimistic_reads = 0;
+      c[seg].optimistic_hits = 0;
+      c[seg].optimistic_l2_hits = 0;
+      c[seg].optimistic_samples = 0;
+
+      /* No frequency sketch unless the TinyLFU policy gets selected. */
+      c[seg].frequency_sketch = NULL;
+      c[seg].sketch_mask = 0;
+      c[seg].sketch_samples = 0;
 
       /* were allocations successful?
        * If not, initialize a minimal cache structure.
        */
-      if (c[seg].data == NULL || c[seg].directory == NULL)
+      if (   c[seg].data == NULL
+          || c[seg].directory == NULL
+          || c[seg].group_initialized == NULL)
         {
           /* We are OOM. There is no need to proceed with "half a cache".
            */
           return svn_error_wrap_apr(APR_ENOMEM, "OOM");
         }
 
+      /* Shared segments use the spin lock in their header for
+       * synchronization among threads as well as processes.
+       */
+      c[seg].is_shared = shared;
+      c[seg].shared_lock = 0;
+
+      /* Select the behavior of write operations.
+       */
+      c[seg].allow_blocking_writes = allow_blocking_writes;
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
       /* A lock for intra-process synchronization to the cache, or NULL if
        * the cache's creator doesn't feel the cache needs to be
        * thread-safe.
        */
-      SVN_ERR(svn_mutex__init(&c[seg].lock, thread_safe, pool));
+      SVN_ERR(svn_mutex__init(&c[seg].lock, thread_safe && !shared, pool));
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
       /* Same for read-write lock. */
       c[seg].lock = NULL;
-      if (thread_safe)
+      if (thread_safe && !shared)
         {
           apr_status_t status =
               apr_thread_rwlock_create(&(c[seg].lock), pool);
           if (status)
             return svn_error_wrap_apr(status, _("Can't create cache mutex"));
         }
-
-      /* Select the behavior of write operations.
-       */
-      c[seg].allow_blocking_writes = allow_blocking_writes;
 #endif
     }
 
@@ -2068,18 +2671,137 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
+                                  apr_size_t total_size,
+                                  apr_size_t directory_size,
+                                  apr_size_t segment_count,
+                                  svn_boolean_t thread_safe,
+                                  svn_boolean_t allow_blocking_writes,
+                                  apr_pool_t *pool)
+{
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count, thread_safe,
+                                                allow_blocking_writes,
+                                                FALSE, NULL, pool));
+}
+
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         svn_boolean_t allow_blocking_writes,
+                                         const char *shm_file,
+                                         apr_pool_t *pool)
+{
+#if APR_HAS_SHARED_MEMORY
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count, TRUE,
+                                                allow_blocking_writes,
+                                                TRUE, shm_file, pool));
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Shared memory caches are not supported "
+                            "on this platform"));
+#endif
+}
+
+svn_error_t *
+svn_cache__membuffer_set_admission_policy(
+  svn_membuffer_t *cache,
+  svn_cache__admission_policy_t policy,
+  apr_pool_t *result_pool)
+{
+  apr_uint32_t seg;
+  for (seg = 0; seg < cache->segment_count; ++seg)
+    {
+      svn_membuffer_t *segment = &cache[seg];
+      apr_uint64_t entry_count;
+      apr_uint32_t width = 1;
+      unsigned char *sketch;
+
+      if (policy != svn_cache__admission_tinylfu)
+        {
+          /* Readers may still be using the old sketch.  Since it has
+           * been allocated in a pool, it remains valid. */
+          segment->frequency_sketch = NULL;
+          continue;
+        }
+
+      /* Already active? */
+      if (segment->frequency_sketch)
+        continue;
+
+      /* One counter per row for each entry that fits into the segment.
+       * This makes hash collisions rare enough for the estimates to be
+       * meaningful. */
+      entry_count = (apr_uint64_t)(segment->group_count
+                                   + segment->spare_group_count)
+                  * GROUP_SIZE;
+      while (width < entry_count && width < APR_UINT32_MAX / 2)
+        width *= 2;
+
+      sketch = apr_pcalloc(result_pool, (apr_size_t)SKETCH_DEPTH * width);
+
+      /* Publish the sketch only after it is complete. */
+      SVN_ERR(force_write_lock_cache(segment));
+      segment->sketch_mask = width - 1;
+      segment->sketch_samples = 0;
+      segment->frequency_sketch = sketch;
+      SVN_ERR(unlock_cache(segment, SVN_NO_ERROR));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the length of the group_initialized array of CACHE in bytes.
+ * See also membuffer_cache_create().
+ */
+static apr_size_t
+get_group_init_size(svn_membuffer_t *cache)
+{
+  return 1 + (cache->group_count + cache->spare_group_count)
+               / (8 * GROUP_INIT_GRANULARITY);
+}
+
+/* Remove all contents from the cache SEGMENT.  The caller must hold the
+ * write lock.
+ */
+static void
+clear_segment(svn_membuffer_t *segment)
+{
+  /* Mark all groups as "not initialized", which implies "empty". */
+  segment->first_spare_group = NO_INDEX;
+  segment->max_spare_used = 0;
+
+  memset(segment->group_initialized, 0, get_group_init_size(segment));
+
+  /* Unlink L1 contents. */
+  segment->l1.first = NO_INDEX;
+  segment->l1.last = NO_INDEX;
+  segment->l1.next = NO_INDEX;
+  segment->l1.current_data = segment->l1.start_offset;
+
+  /* Unlink L2 contents. */
+  segment->l2.first = NO_INDEX;
+  segment->l2.last = NO_INDEX;
+  segment->l2.next = NO_INDEX;
+  segment->l2.current_data = segment->l2.start_offset;
+
+  /* Reset content counters. */
+  segment->data_used = 0;
+  segment->used_entries = 0;
+}
+
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache)
 {
   apr_size_t seg;
   apr_size_t segment_count = cache->segment_count;
 
-  /* Length of the group_initialized array in bytes.
-     See also svn_cache__membuffer_cache_create(). */
-  apr_size_t group_init_size
-    = 1 + (cache->group_count + cache->spare_group_count)
-            / (8 * GROUP_INIT_GRANULARITY);
-
   /* Clear segment by segment.  This implies that other thread may read
      and write to other segments after we cleared them and before the
      last segment is done.
@@ -2092,34 +2814,375 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
     {
       /* Unconditionally acquire the write lock. */
       SVN_ERR(force_write_lock_cache(&cache[seg]));
+      begin_modification(&cache[seg]);
+
+      clear_segment(&cache[seg]);
+
+      /* Segment may be used again. */
+      SVN_ERR(unlock_cache(&cache[seg],
+                           end_modification(&cache[seg], SVN_NO_ERROR)));
+    }
 
-      /* Mark all groups as "not initialized", which implies "empty". */
-      cache[seg].first_spare_group = NO_INDEX;
-      cache[seg].max_spare_used = 0;
+  /* done here */
+  return SVN_NO_ERROR;
+}
 
-      memset(cache[seg].group_initialized, 0, group_init_size);
+/* Identifies membuffer cache files.  See svn_cache__membuffer_cache_save.
+ */
+#define CACHE_FILE_MAGIC "SVN membuffer cache\n"
 
-      /* Unlink L1 contents. */
-      cache[seg].l1.first = NO_INDEX;
-      cache[seg].l1.last = NO_INDEX;
-      cache[seg].l1.next = NO_INDEX;
-      cache[seg].l1.current_data = cache[seg].l1.start_offset;
+/* Current format of membuffer cache files.
+ */
+#define CACHE_FILE_FORMAT 1
 
-      /* Unlink L2 contents. */
-      cache[seg].l2.first = NO_INDEX;
-      cache[seg].l2.last = NO_INDEX;
-      cache[seg].l2.next = NO_INDEX;
-      cache[seg].l2.current_data = cache[seg].l2.start_offset;
+/* Header of a membuffer cache file.  It is followed by the PREFIX_COUNT
+ * prefix pool entries, each stored as a 32 bit length plus the string
+ * without terminating NUL.  Then, SEGMENT_COUNT segments follow, each
+ * consisting of a segment_file_state_t, the group_initialized array,
+ * the directory, the data buffer and a 32 bit checksum over all of these.
+ *
+ * Everything is written in native byte order and alignment.  The header
+ * contains enough information to reject files from other platforms,
+ * incompatible builds or caches of different geometry.
+ */
+typedef struct cache_file_header_t
+{
+  /* Must be CACHE_FILE_MAGIC. */
+  char magic[sizeof(CACHE_FILE_MAGIC)];
 
-      /* Reset content counters. */
-      cache[seg].data_used = 0;
-      cache[seg].used_entries = 0;
+  /* Must be SVN_VERSION.  The serialized item formats may change between
+   * releases, so we never accept files written by a different version. */
+  char version[64];
 
-      /* Segment may be used again. */
-      SVN_ERR(unlock_cache(&cache[seg], SVN_NO_ERROR));
+  /* Must be CACHE_FILE_FORMAT. */
+  apr_uint32_t format;
+
+  /* Must be 0x01020304 to detect byte order mismatches. */
+  apr_uint32_t byte_order;
+
+  /* sizeof(entry_group_t) of the writer. */
+  apr_uint32_t group_struct_size;
+
+  /* Cache geometry.  Must match the cache that we load into. */
+  apr_uint32_t segment_count;
+  apr_uint32_t group_count;
+  apr_uint32_t spare_group_count;
+  apr_uint64_t l1_size;
+  apr_uint64_t l2_size;
+
+  /* Number of prefix pool entries that follow this header. */
+  apr_uint32_t prefix_count;
+} cache_file_header_t;
+
+/* Mutable per-segment state as written to membuffer cache files.
+ */
+typedef struct segment_file_state_t
+{
+  apr_uint32_t first_spare_group;
+  apr_uint32_t max_spare_used;
+  apr_uint32_t used_entries;
+  apr_uint64_t data_used;
+  cache_level_t l1;
+  cache_level_t l2;
+} segment_file_state_t;
+
+/* Initialize *HEADER for CACHE.
+ */
+static void
+init_cache_file_header(cache_file_header_t *header,
+                       svn_membuffer_t *cache)
+{
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, CACHE_FILE_MAGIC, sizeof(header->magic));
+  apr_cpystrn(header->version, SVN_VERSION, sizeof(header->version));
+  header->format = CACHE_FILE_FORMAT;
+  header->byte_order = 0x01020304;
+  header->group_struct_size = sizeof(entry_group_t);
+  header->segment_count = cache->segment_count;
+  header->group_count = cache->group_count;
+  header->spare_group_count = cache->spare_group_count;
+  header->l1_size = cache->l1.size;
+  header->l2_size = cache->l2.size;
+  header->prefix_count = cache->prefix_pool->values_used;
+}
+
+/* Write the contents of cache SEGMENT to FILE.  The caller must hold a
+ * read lock.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+save_segment(apr_file_t *file,
+             svn_membuffer_t *segment,
+             apr_pool_t *scratch_pool)
+{
+  svn_fnv1a_32x4__context_t *context
+    = svn_fnv1a_32x4__context_create(scratch_pool);
+  segment_file_state_t state = { 0 };
+  apr_uint32_t checksum;
+  apr_size_t i;
+
+  const void *parts[4];
+  apr_size_t sizes[4];
+
+  state.first_spare_group = segment->first_spare_group;
+  state.max_spare_used = segment->max_spare_used;
+  state.used_entries = segment->used_entries;
+  state.data_used = segment->data_used;
+  state.l1 = segment->l1;
+  state.l2 = segment->l2;
+
+  parts[0] = &state;
+  sizes[0] = sizeof(state);
+  parts[1] = segment->group_initialized;
+  sizes[1] = get_group_init_size(segment);
+  parts[2] = segment->directory;
+  sizes[2] = (segment->group_count + segment->spare_group_count)
+           * sizeof(entry_group_t);
+  parts[3] = segment->data;
+  sizes[3] = (apr_size_t)(segment->l1.size + segment->l2.size);
+
+  for (i = 0; i < sizeof(parts) / sizeof(parts[0]); ++i)
+    {
+      svn_fnv1a_32x4__update(context, parts[i], sizes[i]);
+      SVN_ERR(svn_io_file_write_full(file, parts[i], sizes[i], NULL,
+                                     scratch_pool));
     }
 
-  /* done here */
+  checksum = svn_fnv1a_32x4__finalize(context);
+  SVN_ERR(svn_io_file_write_full(file, &checksum, sizeof(checksum), NULL,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_cache_save(svn_membuffer_t *cache,
+                                const char *path,
+                                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  const char *tmp_path = apr_pstrcat(scratch_pool, path, ".tmp",
+                                     SVN_VA_NULL);
+  cache_file_header_t header;
+  apr_file_t *file;
+  apr_uint32_t i;
+
+  SVN_ERR(svn_io_file_open(&file, tmp_path,
+                           APR_WRITE | APR_CREATE | APR_TRUNCATE
+                           | APR_BUFFERED,
+                           APR_OS_DEFAULT, scratch_pool));
+
+  /* Prefixes only get added but never removed.  Entries added after we
+   * took the snapshot of the count will simply not be saved and all
+   * segment contents referring to them will be dropped upon load. */
+  init_cache_file_header(&header, cache);
+  SVN_ERR(svn_io_file_write_full(file, &header, sizeof(header), NULL,
+                                 scratch_pool));
+
+  for (i = 0; i < header.prefix_count; ++i)
+    {
+      const char *prefix = cache->prefix_pool->values[i];
+      apr_uint32_t len = (apr_uint32_t)strlen(prefix);
+
+      SVN_ERR(svn_io_file_write_full(file, &len, sizeof(len), NULL,
+                                     scratch_pool));
+      SVN_ERR(svn_io_file_write_full(file, prefix, len, NULL,
+                                     scratch_pool));
+    }
+
+  /* Segment by segment.  Each one will be self-consistent but the cache
+   * may change between segments, which is fine since there are no
+   * dependencies between segments. */
+  for (i = 0; i < header.segment_count; ++i)
+    {
+      svn_pool_clear(iterpool);
+      WITH_READ_LOCK(&cache[i], save_segment(file, &cache[i], iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Atomically replace any previous cache file. */
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+  SVN_ERR(svn_io_file_rename2(tmp_path, path, FALSE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read SIZE bytes from FILE into BUFFER and update the checksum CONTEXT.
+ * Set *COMPLETE to FALSE if the file ended prematurely.  Use SCRATCH_POOL
+ * for temporary allocations.
+ */
+static svn_error_t *
+read_segment_part(apr_file_t *file,
+                  void *buffer,
+                  apr_size_t size,
+                  svn_fnv1a_32x4__context_t *context,
+                  svn_boolean_t *complete,
+                  apr_pool_t *scratch_pool)
+{
+  apr_size_t bytes_read;
+  svn_boolean_t eof;
+
+  SVN_ERR(svn_io_file_read_full2(file, buffer, size, &bytes_read, &eof,
+                                 scratch_pool));
+  if (bytes_read != size)
+    *complete = FALSE;
+  else if (context)
+    svn_fnv1a_32x4__update(context, buffer, size);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the contents of cache SEGMENT from FILE.  The caller must hold the
+ * write lock.  If the contents is incomplete or corrupt, leave SEGMENT
+ * empty.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+load_segment(apr_file_t *file,
+             svn_membuffer_t *segment,
+             apr_pool_t *scratch_pool)
+{
+  svn_fnv1a_32x4__context_t *context
+    = svn_fnv1a_32x4__context_create(scratch_pool);
+  segment_file_state_t state;
+  svn_boolean_t complete = TRUE;
+  apr_uint32_t checksum = 0;
+  apr_uint64_t data_size = segment->l1.size + segment->l2.size;
+  svn_error_t *err;
+
+  /* Read directly into the segment.  We will wipe it in case of any
+   * inconsistency. */
+  err = read_segment_part(file, &state, sizeof(state), context, &complete,
+                          scratch_pool);
+  if (!err && complete)
+    err = read_segment_part(file, segment->group_initialized,
+                            get_group_init_size(segment), context,
+                            &complete, scratch_pool);
+  if (!err && complete)
+    err = read_segment_part(file, segment->directory,
+                            (segment->group_count
+                               + segment->spare_group_count)
+                              * sizeof(entry_group_t),
+                            context, &complete, scratch_pool);
+  if (!err && complete)
+    err = read_segment_part(file, segment->data, (apr_size_t)data_size,
+                            context, &complete, scratch_pool);
+  if (!err && complete)
+    err = read_segment_part(file, &checksum, sizeof(checksum), NULL,
+                            &complete, scratch_pool);
+
+  /* Accept only consistent data. */
+  if (   err
+      || !complete
+      || checksum != svn_fnv1a_32x4__finalize(context)
+      || state.l1.start_offset != segment->l1.start_offset
+      || state.l1.size != segment->l1.size
+      || state.l1.current_data > segment->l1.start_offset
+                                 + segment->l1.size
+      || state.l2.start_offset != segment->l2.start_offset
+      || state.l2.size != segment->l2.size
+      || state.l2.current_data > segment->l2.start_offset
+                                 + segment->l2.size
+      || state.max_spare_used > segment->spare_group_count
+      || state.data_used > data_size)
+    {
+      clear_segment(segment);
+      return svn_error_trace(err);
+    }
+
+  segment->first_spare_group = state.first_spare_group;
+  segment->max_spare_used = state.max_spare_used;
+  segment->used_entries = state.used_entries;
+  segment->data_used = state.data_used;
+  segment->l1 = state.l1;
+  segment->l2 = state.l2;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_cache_load(svn_membuffer_t *cache,
+                                svn_boolean_t *loaded,
+                                const char *path,
+                                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  cache_file_header_t header, expected;
+  apr_file_t *file;
+  apr_size_t bytes_read;
+  svn_boolean_t eof;
+  apr_uint32_t i;
+  svn_error_t *err;
+
+  *loaded = FALSE;
+
+  /* Prefix indexes in the file must map to the same strings in our pool.
+   * That is only possible if we start with an empty pool. */
+  if (cache->prefix_pool->values_used)
+    return SVN_NO_ERROR;
+
+  err = svn_io_file_open(&file, path, APR_READ | APR_BUFFERED,
+                         APR_OS_DEFAULT, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Is this a file that we can use? */
+  init_cache_file_header(&expected, cache);
+  SVN_ERR(svn_io_file_read_full2(file, &header, sizeof(header), &bytes_read,
+                                 &eof, scratch_pool));
+  expected.prefix_count = header.prefix_count;
+  if (   bytes_read != sizeof(header)
+      || memcmp(&header, &expected, sizeof(header)))
+    return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+  /* Restore the prefix pool in the same order such that we get the same
+   * indexes.  Since we started with an empty pool, this can only fail if
+   * the file is corrupt. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < header.prefix_count; ++i)
+    {
+      apr_uint32_t len, idx;
+      char *prefix;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_file_read_full2(file, &len, sizeof(len), &bytes_read,
+                                     &eof, iterpool));
+      /* No valid prefix can exceed the pool's whole memory budget. */
+      if (   bytes_read != sizeof(len)
+          || len >= cache->prefix_pool->bytes_max)
+        return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+      prefix = apr_palloc(iterpool, len + 1);
+      SVN_ERR(svn_io_file_read_full2(file, prefix, len, &bytes_read,
+                                     &eof, iterpool));
+      if (bytes_read != len)
+        return svn_error_trace(svn_io_file_close(file, scratch_pool));
+
+      prefix[len] = '\0';
+      SVN_ERR(prefix_pool_get(&idx, cache->prefix_pool, prefix));
+      if (idx != i)
+        return svn_error_trace(svn_io_file_close(file, scratch_pool));
+    }
+
+  for (i = 0; i < header.segment_count; ++i)
+    {
+      svn_membuffer_t *segment = &cache[i];
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(force_write_lock_cache(segment));
+      begin_modification(segment);
+
+      err = load_segment(file, segment, iterpool);
+      SVN_ERR(unlock_cache(segment, end_modification(segment, err)));
+    }
+
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  *loaded = TRUE;
   return SVN_NO_ERROR;
 }
 
@@ -2374,8 +3437,10 @@ increment_hit_counters(svn_membuffer_t *cache, entry_t *entry)
    * few billion hits. */
   svn_atomic_inc(&entry->hit_count);
 
-  /* That one is for stats only. */
+  /* Those are for stats only. */
   cache->total_hits++;
+  if (entry->offset >= cache->l2.start_offset)
+    cache->total_l2_hits++;
 }
 
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
@@ -2441,6 +3506,202 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+#if USE_OPTIMISTIC_READS
+
+/* Lock-free variant of increment_hit_counters.  Count a hit for an entry
+ * at data OFFSET within CACHE in the segment statistics.
+ *
+ * Entries may be modified or moved by writers at any time, so we never
+ * touch ENTRY->HIT_COUNT here.  Instead, every OPTIMISTIC_READ_SAMPLING-th
+ * read of a segment gets routed through the read lock, where the hit
+ * counter will be updated.  Frequently read items still accumulate hits
+ * that way.  See optimistic_read_allowed().
+ */
+static void
+increment_hit_counters_optimistic(svn_membuffer_t *cache,
+                                  apr_uint64_t offset)
+{
+  ++cache->optimistic_hits;
+  if (offset >= cache->l2.start_offset)
+    ++cache->optimistic_l2_hits;
+}
+
+/* Return TRUE if the next read from CACHE may be attempted lock-free.
+ * If this returns FALSE, the read shall be done under the read lock such
+ * that the entry hit counters get updated.
+ */
+static APR_INLINE svn_boolean_t
+optimistic_read_allowed(svn_membuffer_t *cache)
+{
+  return (++cache->optimistic_samples % OPTIMISTIC_READ_SAMPLING) != 0;
+}
+
+/* Lock-free variant of find_entry for FIND_EMPTY==FALSE.  Look for the
+ * entry identified by TO_FIND in group GROUP_INDEX of CACHE and return it.
+ * Return NULL if it could not be found.  Store the entry's data offset
+ * and size in *OFFSET and *SIZE, respectively.
+ *
+ * Writers may modify the directory and the data buffer at any time while
+ * this function runs.  Therefore, we read every value only once and range-
+ * check all indexes and offsets before using them.  The result may still
+ * be garbage and only becomes valid if CACHE's sequence counter did not
+ * change between before and after the lookup.
+ */
+static entry_t *
+find_entry_optimistic(svn_membuffer_t *cache,
+                      apr_uint32_t group_index,
+                      const full_key_t *to_find,
+                      apr_uint64_t *offset,
+                      apr_size_t *size)
+{
+  apr_uint32_t group_total = cache->group_count + cache->spare_group_count;
+  apr_uint64_t data_size = cache->l2.start_offset + cache->l2.size;
+  apr_size_t key_len = to_find->entry_key.key_len;
+  entry_group_t *group = &cache->directory[group_index];
+  apr_uint32_t chain_length;
+
+  /* If the entry group has not been initialized, yet, there is no data.
+   */
+  if (! is_group_initialized(cache, group_index))
+    return NULL;
+
+  /* Walk the chain but never longer than any valid chain may be.
+   */
+  for (chain_length = 0;
+       chain_length < MAX_GROUP_CHAIN_LENGTH;
+       ++chain_length)
+    {
+      apr_uint32_t used = group->header.used;
+      apr_uint32_t next = group->header.next;
+      apr_uint32_t i;
+
+      for (i = 0; i < MIN(used, GROUP_SIZE); ++i)
+        if (entry_keys_match(&group->entries[i].key, &to_find->entry_key))
+          {
+            entry_t *entry = &group->entries[i];
+            *offset = entry->offset;
+            *size = entry->size;
+
+            /* Reject anything that would take us outside the data buffer
+             * or could not have been written by a consistent writer. */
+            if (   *offset > data_size
+                || *size > cache->max_entry_size
+                || ALIGN_VALUE(*size) > data_size - *offset
+                || *size < key_len)
+              return NULL;
+
+            /* Compare the full key, if it is not implied by the entry key.
+             * Upon mismatch, the entry cannot be anywhere else. */
+            if (   key_len
+                && memcmp(to_find->full_key.data, cache->data + *offset,
+                          key_len) != 0)
+              return NULL;
+
+            return entry;
+          }
+
+      /* end of chain? */
+      if (next == NO_INDEX || next >= group_total)
+        break;
+
+      group = &cache->directory[next];
+    }
+
+  return NULL;
+}
+
+/* Lock-free variant of membuffer_cache_get_internal.  If CACHE got
+ * modified during the lookup, set *SUCCESS to FALSE and leave the other
+ * outputs undefined.  Otherwise, set *SUCCESS to TRUE and *BUFFER and
+ * *ITEM_SIZE as membuffer_cache_get_internal would.
+ *
+ * The serialized item data gets copied into RESULT_POOL before we check
+ * for concurrent modifications.  Deserialization will only happen once
+ * we know the copy is consistent.
+ */
+static void
+membuffer_cache_get_optimistic(svn_membuffer_t *cache,
+                               apr_uint32_t group_index,
+                               const full_key_t *to_find,
+                               char **buffer,
+                               apr_size_t *item_size,
+                               svn_boolean_t *success,
+                               apr_pool_t *result_pool)
+{
+  entry_t *entry;
+  apr_uint64_t offset;
+  apr_size_t size;
+  apr_uint32_t sequence = read_write_sequence(cache);
+
+  /* Some writer is active. Don't bother. */
+  if (sequence & 1)
+    {
+      *success = FALSE;
+      return;
+    }
+
+  entry = find_entry_optimistic(cache, group_index, to_find,
+                                &offset, &size);
+  if (entry)
+    {
+      apr_size_t key_len = to_find->entry_key.key_len;
+      apr_size_t to_copy = ALIGN_VALUE(size) - key_len;
+
+      *buffer = ALIGN_POINTER(apr_palloc(result_pool,
+                                         to_copy + ITEM_ALIGNMENT-1));
+      memcpy(*buffer, cache->data + offset + key_len, to_copy);
+      *item_size = size - key_len;
+    }
+  else
+    {
+      *buffer = NULL;
+      *item_size = 0;
+    }
+
+  /* Is what we just read consistent? */
+  *success = reread_write_sequence(cache) == sequence;
+  if (*success)
+    {
+      ++cache->optimistic_reads;
+      if (entry)
+        increment_hit_counters_optimistic(cache, offset);
+    }
+}
+
+/* Lock-free variant of membuffer_cache_has_key_internal.  If CACHE got
+ * modified during the lookup, return FALSE and leave *FOUND undefined.
+ * Otherwise, return TRUE and set *FOUND.
+ */
+static svn_boolean_t
+membuffer_cache_has_key_optimistic(svn_membuffer_t *cache,
+                                   apr_uint32_t group_index,
+                                   const full_key_t *to_find,
+                                   svn_boolean_t *found)
+{
+  entry_t *entry;
+  apr_uint64_t offset;
+  apr_size_t size;
+  apr_uint32_t sequence = read_write_sequence(cache);
+
+  if (sequence & 1)
+    return FALSE;
+
+  entry = find_entry_optimistic(cache, group_index, to_find,
+                                &offset, &size);
+  if (reread_write_sequence(cache) != sequence)
+    return FALSE;
+
+  /* See membuffer_cache_has_key_internal for why we count this as a hit. */
+  ++cache->optimistic_reads;
+  if (entry)
+    increment_hit_counters_optimistic(cache, offset);
+
+  *found = entry != NULL;
+  return TRUE;
+}
+
+#endif /* USE_OPTIMISTIC_READS */
+
 /* Look for the *ITEM identified by KEY. If no item has been stored
  * for KEY, *ITEM will be NULL. Otherwise, the DESERIALIZER is called
  * to re-construct the proper object from the serialized data.
@@ -2458,17 +3719,33 @@ membuffer_cache_get(svn_membuffer_t *cache,
   char *buffer;
   apr_size_t size;
 
+  svn_boolean_t done = FALSE;
+
   /* find the entry group that will hold the key.
    */
   group_index = get_group_index(&cache, &key->entry_key);
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_get_internal(cache,
-                                              group_index,
-                                              key,
-                                              &buffer,
-                                              &size,
-                                              DEBUG_CACHE_MEMBUFFER_TAG
-                                              result_pool));
+  sketch_record_access(cache, &key->entry_key);
+
+#if USE_OPTIMISTIC_READS
+  if (optimistic_read_allowed(cache))
+    {
+      int i;
+      for (i = 0; i < MAX_OPTIMISTIC_READ_ATTEMPTS && !done; ++i)
+        membuffer_cache_get_optimistic(cache, group_index, key, &buffer,
+                                       &size, &done, result_pool);
+    }
+#endif
+
+  /* Contention with writers.  Get a consistent view using the lock. */
+  if (!done)
+    WITH_READ_LOCK(cache,
+                   membuffer_cache_get_internal(cache,
+                                                group_index,
+                                                key,
+                                                &buffer,
+                                                &size,
+                                                DEBUG_CACHE_MEMBUFFER_TAG
+                                                result_pool));
 
   /* re-construct the original data object from its serialized form.
    */
@@ -2523,8 +3800,14 @@ membuffer_cache_has_key(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
-  cache->total_reads++;
 
+#if USE_OPTIMISTIC_READS
+  if (   optimistic_read_allowed(cache)
+      && membuffer_cache_has_key_optimistic(cache, group_index, key, found))
+    return SVN_NO_ERROR;
+#endif
+
+  cache->total_reads++;
   WITH_READ_LOCK(cache,
                  membuffer_cache_has_key_internal(cache,
                                                   group_index,
@@ -2608,6 +3891,7 @@ membuffer_cache_get_partial(svn_membuffer_t *cache,
                             apr_pool_t *result_pool)
 {
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
+  sketch_record_access(cache, &key->entry_key);
 
   WITH_READ_LOCK(cache,
                  membuffer_cache_get_partial_internal
@@ -3456,9 +4740,15 @@ static svn_error_t *
 svn_membuffer_get_global_segment_info(svn_membuffer_t *segment,
                                       svn_cache__info_t *info)
 {
-  info->gets += segment->total_reads;
+  info->gets += segment->total_reads
+              + segment->optimistic_reads;
   info->sets += segment->total_writes;
-  info->hits += segment->total_hits;
+  info->hits += segment->total_hits
+              + segment->optimistic_hits;
+  info->l2_hits += segment->total_l2_hits
+                 + segment->optimistic_l2_hits;
+  info->promotions += segment->total_promotions;
+  info->rejections += segment->total_rejections;
 
   WITH_READ_LOCK(segment,
                   svn_membuffer_get_segment_info(segment, info, TRUE));
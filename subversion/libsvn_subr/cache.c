@@ -256,6 +256,11 @@ svn_cache__format_info(const svn_cache__info_t *info,
                          / (double)(info->data_size ? info->data_size : 1);
   double data_entry_rate = (100.0 * (double)info->used_entries)
                  / (double)(info->total_entries ? info->total_entries : 1);
+  double l2_hit_rate = (100.0 * (double)info->l2_hits)
+                     / (double)(info->hits ? info->hits : 1);
+  apr_uint64_t evictions = info->promotions + info->rejections;
+  double promotion_rate = (100.0 * (double)info->promotions)
+                        / (double)(evictions ? evictions : 1);
 
   const char *histogram = "";
   if (!access_only)
@@ -300,7 +305,10 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             " of %" APR_UINT64_T_FMT " MB data cache"
                             " / %" APR_UINT64_T_FMT " MB total cache memory\n"
                             "          %" APR_UINT64_T_FMT " entries (%5.2f%%)"
-                            " of %" APR_UINT64_T_FMT " total\n%s",
+                            " of %" APR_UINT64_T_FMT " total\n"
+                            "L2 hits : %" APR_UINT64_T_FMT " (%5.2f%% of hits)\n"
+                            "promoted: %" APR_UINT64_T_FMT
+                            " (%5.2f%% of L1 evictions)\n%s",
 
                             info->id,
 
@@ -315,5 +323,8 @@ svn_cache__format_info(const svn_cache__info_t *info,
 
                             info->used_entries, data_entry_rate,
                             info->total_entries,
+
+                            info->l2_hits, l2_hit_rate,
+                            info->promotions, promotion_rate,
                             histogram);
 }
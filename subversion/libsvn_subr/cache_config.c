@@ -64,6 +64,18 @@ static svn_cache_config_t cache_settings =
 #endif
 };
 
+/* If set, the global membuffer cache will be allocated in shared memory.
+ * See svn_cache__create_shared_global_membuffer_cache. */
+static svn_boolean_t use_shared_memory = FALSE;
+
+/* Backing file for the shared memory region.  May be NULL. */
+static const char *shared_memory_file = NULL;
+
+/* Admission policy to use with the global membuffer cache.
+ * See svn_cache__set_global_admission_policy. */
+static svn_cache__admission_policy_t admission_policy
+  = svn_cache__admission_hits;
+
 /* Get the current FSFS cache configuration. */
 const svn_cache_config_t *
 svn_cache_config_get(void)
@@ -120,14 +132,29 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
         return SVN_NO_ERROR;
       apr_allocator_owner_set(allocator, pool);
 
-      err = svn_cache__membuffer_cache_create(
-          &cache,
-          (apr_size_t)cache_size,
-          (apr_size_t)(cache_size / 5),
-          0,
-          ! svn_cache_config_get()->single_threaded,
-          FALSE,
-          pool);
+      if (use_shared_memory)
+        err = svn_cache__membuffer_cache_create_shared(
+            &cache,
+            (apr_size_t)cache_size,
+            (apr_size_t)(cache_size / 5),
+            0,
+            FALSE,
+            shared_memory_file,
+            pool);
+      else
+        err = svn_cache__membuffer_cache_create(
+            &cache,
+            (apr_size_t)cache_size,
+            (apr_size_t)(cache_size / 5),
+            0,
+            ! svn_cache_config_get()->single_threaded,
+            FALSE,
+            pool);
+
+      if (!err)
+        err = svn_cache__membuffer_set_admission_policy(cache,
+                                                        admission_policy,
+                                                        pool);
 
       /* Some error occurred. Most likely it's an OOM error but we don't
        * really care. Simply release all cache memory and disable caching
@@ -150,19 +177,23 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
   return SVN_NO_ERROR;
 }
 
+/* The process-global (singleton) membuffer cache and its init state.
+ */
+static svn_membuffer_t *global_membuffer_cache = NULL;
+static svn_atomic_t global_membuffer_initialized = 0;
+
 /* Access the process-global (singleton) membuffer cache. The first call
  * will automatically allocate the cache using the current cache config.
  * NULL will be returned if the desired cache size is 0 or if the cache
  * could not be created for some reason.
  */
+
 svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void)
 {
-  static svn_membuffer_t *cache = NULL;
-  static svn_atomic_t initialized = 0;
-
   svn_error_t *err
-    = svn_atomic__init_once(&initialized, initialize_cache, &cache, NULL);
+    = svn_atomic__init_once(&global_membuffer_initialized, initialize_cache,
+                            &global_membuffer_cache, NULL);
   if (err)
     {
       /* no caches today ... */
@@ -170,7 +201,60 @@ svn_cache__get_global_membuffer_cache(void)
       return NULL;
     }
 
-  return cache;
+  return global_membuffer_cache;
+}
+
+svn_error_t *
+svn_cache__create_shared_global_membuffer_cache(const char *shm_file)
+{
+  /* Too late? */
+  if (svn_atomic_read(&global_membuffer_initialized))
+    return SVN_NO_ERROR;
+
+  /* The name only needs to live until the cache got created. */
+  use_shared_memory = TRUE;
+  shared_memory_file = shm_file;
+
+  SVN_ERR(svn_atomic__init_once(&global_membuffer_initialized,
+                                initialize_cache, &global_membuffer_cache,
+                                NULL));
+  shared_memory_file = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_cache__set_global_admission_policy(svn_cache__admission_policy_t policy)
+{
+  admission_policy = policy;
+}
+
+svn_error_t *
+svn_cache__load_global_membuffer_cache(svn_boolean_t *loaded,
+                                       const char *path,
+                                       apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *cache = svn_cache__get_global_membuffer_cache();
+
+  *loaded = FALSE;
+  if (cache)
+    SVN_ERR(svn_cache__membuffer_cache_load(cache, loaded, path,
+                                            scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__save_global_membuffer_cache(const char *path,
+                                       apr_pool_t *scratch_pool)
+{
+  /* Don't create the cache just to save it. */
+  if (   svn_atomic_read(&global_membuffer_initialized)
+      && global_membuffer_cache)
+    SVN_ERR(svn_cache__membuffer_cache_save(global_membuffer_cache, path,
+                                            scratch_pool));
+
+  return SVN_NO_ERROR;
 }
 
 void
@@ -31,6 +31,10 @@
 
 #include "svn_private_config.h"
 
+#ifdef SVN_HAVE_LZ4
+#include <lz4.h>
+#endif
+
 const char *
 svn_zlib__compiled_version(void)
 {
@@ -45,6 +49,38 @@ svn_zlib__runtime_version(void)
   return zlibVersion();
 }
 
+svn_boolean_t
+svn__lz4_supported(void)
+{
+#ifdef SVN_HAVE_LZ4
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
+const char *
+svn_lz4__compiled_version(void)
+{
+#ifdef SVN_HAVE_LZ4
+  static const char lz4_version_str[] = LZ4_VERSION_STRING;
+
+  return lz4_version_str;
+#else
+  return NULL;
+#endif
+}
+
+const char *
+svn_lz4__runtime_version(void)
+{
+#ifdef SVN_HAVE_LZ4
+  return LZ4_versionString();
+#else
+  return NULL;
+#endif
+}
+
 
 /* The zlib compressBound function was not exported until 1.2.0. */
 #if ZLIB_VERNUM >= 0x1200
@@ -282,3 +318,141 @@ svn__decompress(const void *data, apr_size_t len,
 {
   return zlib_decode(data, len, out, limit);
 }
+
+#ifdef SVN_HAVE_LZ4
+
+/* For svndiff2, instruction and new data sections under this size will
+   be stored uncompressed.  LZ4 is cheap enough to be used on rather small
+   buffers but there is little to gain for the shortest ones. */
+#define MIN_LZ4_COMPRESS_SIZE 64
+
+svn_error_t *
+svn__compress_lz4(const void *data, apr_size_t len,
+                  svn_stringbuf_t *out)
+{
+  apr_size_t hdrlen;
+  unsigned char buf[SVN__MAX_ENCODED_UINT_LEN], *p;
+  int compressed_data_len;
+  int max_compressed_data_len;
+
+  assert(len <= LZ4_MAX_INPUT_SIZE);
+
+  p = svn__encode_uint(buf, (apr_uint64_t)len);
+  hdrlen = p - buf;
+  svn_stringbuf_setempty(out);
+  svn_stringbuf_appendbytes(out, (const char *)buf, hdrlen);
+
+  /* Just like with zlib, storing short buffers as-is is cheaper and
+     no larger than the compressed version. */
+  if (len < MIN_LZ4_COMPRESS_SIZE)
+    {
+      svn_stringbuf_appendbytes(out, data, len);
+      return SVN_NO_ERROR;
+    }
+
+  max_compressed_data_len = LZ4_compressBound((int)len);
+  if (!max_compressed_data_len)
+    return svn_error_create(SVN_ERR_LZ4_COMPRESSION_FAILED, NULL, NULL);
+
+  svn_stringbuf_ensure(out, max_compressed_data_len + hdrlen);
+  compressed_data_len = LZ4_compress_default(data, out->data + out->len,
+                                             (int)len,
+                                             max_compressed_data_len);
+  if (!compressed_data_len)
+    return svn_error_create(SVN_ERR_LZ4_COMPRESSION_FAILED, NULL, NULL);
+
+  /* Compression didn't help :(, just append the original text.
+     As with zlib, the decoder tells the two cases apart by comparing
+     the original length with the remaining section length. */
+  if (compressed_data_len >= (int)len)
+    {
+      svn_stringbuf_appendbytes(out, data, len);
+      return SVN_NO_ERROR;
+    }
+
+  out->len += compressed_data_len;
+  out->data[out->len] = 0;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn__decompress_lz4(const void *data, apr_size_t len,
+                    svn_stringbuf_t *out,
+                    apr_size_t limit)
+{
+  apr_size_t hdrlen;
+  int compressed_data_len;
+  int decompressed_data_len;
+  apr_uint64_t u64;
+  const unsigned char *p = data;
+  int rv;
+
+  assert(len <= LZ4_MAX_INPUT_SIZE);
+  assert(limit <= LZ4_MAX_INPUT_SIZE);
+
+  /* First thing in the string is the original length.  */
+  p = svn__decode_uint(&u64, p, p + len);
+  if (p == NULL)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of compressed data failed: "
+                              "no size"));
+  if (u64 > limit)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of compressed data failed: "
+                              "size too large"));
+  decompressed_data_len = (int)u64;
+  hdrlen = p - (const unsigned char *)data;
+  compressed_data_len = (int)(len - hdrlen);
+
+  svn_stringbuf_setempty(out);
+  svn_stringbuf_ensure(out, decompressed_data_len);
+
+  if (compressed_data_len == decompressed_data_len)
+    {
+      /* Data is in the original, uncompressed form. */
+      memcpy(out->data, p, decompressed_data_len);
+    }
+  else
+    {
+      rv = LZ4_decompress_safe((const char *)p, out->data,
+                               compressed_data_len,
+                               decompressed_data_len);
+      if (rv < 0)
+        return svn_error_create(SVN_ERR_LZ4_DECOMPRESSION_FAILED, NULL, NULL);
+
+      if (rv != decompressed_data_len)
+        return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA,
+                                NULL,
+                                _("Size of uncompressed data "
+                                  "does not match stored original length"));
+    }
+
+  out->data[decompressed_data_len] = 0;
+  out->len = decompressed_data_len;
+
+  return SVN_NO_ERROR;
+}
+
+#else /* !SVN_HAVE_LZ4 */
+
+svn_error_t *
+svn__compress_lz4(const void *data, apr_size_t len,
+                  svn_stringbuf_t *out)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("LZ4 compression (svndiff2) is not supported "
+                            "by this build of Subversion"));
+}
+
+svn_error_t *
+svn__decompress_lz4(const void *data, apr_size_t len,
+                    svn_stringbuf_t *out,
+                    apr_size_t limit)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("LZ4 decompression (svndiff2) is not supported "
+                            "by this build of Subversion"));
+}
+
+#endif /* SVN_HAVE_LZ4 */
@@ -51,6 +51,12 @@
 #include <fcntl.h>
 #endif
 
+#ifdef HAVE_LINUX_FS_H
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
 #include "svn_hash.h"
 #include "svn_types.h"
 #include "svn_dirent_uri.h"
@@ -824,8 +830,87 @@ svn_io_temp_dir(const char **dir,
 
 /*** Creating, copying and appending files. ***/
 
+/* Maximum number of bytes to copy in a single copy_file_range() call.
+ * Keeps the calls interruptible on slow (network) filesystems. */
+#define COPY_RANGE_CHUNK_SIZE 0x40000000
+
+/* Try to let the OS transfer the contents of FROM_FILE to the empty
+ * TO_FILE without passing them through user space.  On copy-on-write
+ * filesystems, this will share the data blocks (reflink); network
+ * filesystems may perform a server-side copy.  Both files must not have
+ * been read from or written to, yet.
+ *
+ * Set *DONE to TRUE if the OS copied all of the data.  Leave it untouched
+ * if the OS does not support this for the pair of files given, in which
+ * case the caller must copy the data itself.
+ */
+static apr_status_t
+copy_contents_in_kernel(svn_boolean_t *done,
+                        apr_file_t *from_file,
+                        apr_file_t *to_file)
+{
+#if defined(HAVE_COPY_FILE_RANGE) \
+    || (defined(HAVE_LINUX_FS_H) && defined(FICLONE))
+  apr_os_file_t from_fd, to_fd;
+  apr_status_t status;
+
+  status = apr_os_file_get(&from_fd, from_file);
+  if (status)
+    return status;
+
+  status = apr_os_file_get(&to_fd, to_file);
+  if (status)
+    return status;
+
+#if defined(HAVE_LINUX_FS_H) && defined(FICLONE)
+  /* Cheapest option: share all data blocks between the files. */
+  if (ioctl(to_fd, FICLONE, from_fd) == 0)
+    {
+      *done = TRUE;
+      return APR_SUCCESS;
+    }
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+  {
+    svn_boolean_t copied_any = FALSE;
+
+    while (1)
+      {
+        ssize_t copied = copy_file_range(from_fd, NULL, to_fd, NULL,
+                                         COPY_RANGE_CHUNK_SIZE, 0);
+        if (copied > 0)
+          {
+            copied_any = TRUE;
+          }
+        else if (copied == 0)
+          {
+            /* EOF.  Some file systems report that right away although
+               the source is not empty.  So, unless we copied anything,
+               let the caller do it - that is cheap for empty files. */
+            *done = copied_any;
+            return APR_SUCCESS;
+          }
+        else if (errno != EINTR)
+          {
+            /* Not supported for these files?  Let the caller do it. */
+            if (!copied_any
+                && (   errno == EXDEV || errno == ENOSYS || errno == EINVAL
+                    || errno == EOPNOTSUPP || errno == EBADF))
+              return APR_SUCCESS;
+
+            return apr_get_os_error();
+          }
+      }
+  }
+#endif
+#endif
+
+  return APR_SUCCESS;
+}
+
 /* Transfer the contents of FROM_FILE to TO_FILE, using POOL for temporary
- * allocations.
+ * allocations.  Let the OS do the copying, if possible.
  *
  * NOTE: We don't use apr_copy_file() for this, since it takes filenames
  * as parameters.  Since we want to copy to a temporary file
@@ -838,6 +923,11 @@ copy_contents(apr_file_t *from_file,
               apr_file_t *to_file,
               apr_pool_t *pool)
 {
+  svn_boolean_t done = FALSE;
+  apr_status_t status = copy_contents_in_kernel(&done, from_file, to_file);
+  if (status || done)
+    return status;
+
   /* Copy bytes till the cows come home. */
   while (1)
     {
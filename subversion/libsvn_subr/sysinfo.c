@@ -167,6 +167,14 @@ svn_sysinfo__linked_libs(apr_pool_t *pool)
   lib->compiled_version = apr_pstrdup(pool, svn_zlib__compiled_version());
   lib->runtime_version = apr_pstrdup(pool, svn_zlib__runtime_version());
 
+  if (svn__lz4_supported())
+    {
+      lib = &APR_ARRAY_PUSH(array, svn_version_ext_linked_lib_t);
+      lib->name = "LZ4";
+      lib->compiled_version = apr_pstrdup(pool, svn_lz4__compiled_version());
+      lib->runtime_version = apr_pstrdup(pool, svn_lz4__runtime_version());
+    }
+
   return array;
 }
 
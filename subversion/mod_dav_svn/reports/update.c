@@ -1267,7 +1267,7 @@ dav_svn__update_report(const dav_resource *resource,
   editor->close_file = upd_close_file;
   editor->absent_file = upd_absent_file;
   editor->close_edit = upd_close_edit;
-  if ((serr = svn_repos_begin_report3(&rbaton, revnum,
+  if ((serr = svn_repos_begin_report4(&rbaton, revnum,
                                       repos->repos,
                                       src_path, target,
                                       dst_path,
@@ -1277,6 +1277,9 @@ dav_svn__update_report(const dav_resource *resource,
                                       send_copyfrom_args,
                                       editor, &uc,
                                       dav_svn__authz_read_func(&arb),
+                                      /* Authz subrequests can't answer
+                                         for whole subtrees. */
+                                      NULL,
                                       &arb,
                                       0,  /* disable zero-copy for now */
                                       resource->pool)))
@@ -0,0 +1,59 @@
+/* bench-commit-cmd.c -- implements the bench-commit sub-command.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+#include "svnfsfs.h"
+
+/* Number of commits that each committer will make. */
+#define COMMIT_COUNT 100
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__bench_commit(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  svn_fs_fs__commit_benchmark_t results;
+  int jobs = MAX(opt_state->jobs, 1);
+  double seconds;
+  svn_fs_t *fs;
+
+  SVN_ERR(open_fs(&fs, opt_state->repository_path, NULL, pool));
+  SVN_ERR(svn_fs_fs__benchmark_commits(&results, fs, jobs, COMMIT_COUNT,
+                                       check_cancel, NULL, pool));
+
+  /* Avoid division by zero for very fast runs. */
+  seconds = MAX(results.duration, 1) / 1000000.0;
+
+  printf(_("%s commits by %d concurrent committers in %.2f s: "
+           "%.1f commits/s\n"),
+         apr_psprintf(pool, "%" APR_INT64_T_FMT, results.commits),
+         jobs, seconds, results.commits / seconds);
+  printf(_("%s prepared outside the write lock, %s rolled back\n"),
+         apr_psprintf(pool, "%" APR_INT64_T_FMT, results.prepared),
+         apr_psprintf(pool, "%" APR_INT64_T_FMT, results.rolled_back));
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,77 @@
+/* bench-read-cmd.c -- implements the bench-read sub-command.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+#include "svnfsfs.h"
+
+/* Number of blocks to read in each benchmark run. */
+#define READ_COUNT 4096
+
+/* Print the throughput figures for COUNT requests, reading BYTES bytes
+ * in DURATION, to console.  LABEL describes the run. */
+static void
+print_run(const char *label,
+          apr_int64_t count,
+          apr_int64_t bytes,
+          apr_interval_time_t duration)
+{
+  /* Avoid division by zero for very fast runs. */
+  double seconds = MAX(duration, 1) / 1000000.0;
+
+  printf(_("%-24s %10.1f reads/s %10.1f MB/s\n"),
+         label, count / seconds, bytes / seconds / 0x100000);
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__bench_read(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  svn_fs_fs__read_benchmark_t results;
+  svn_revnum_t revision;
+  svn_fs_t *fs;
+
+  SVN_ERR(open_fs(&fs, opt_state->repository_path, NULL, pool));
+
+  if (opt_state->start_revision.kind == svn_opt_revision_number)
+    revision = opt_state->start_revision.value.number;
+  else
+    SVN_ERR(svn_fs_youngest_rev(&revision, fs, pool));
+
+  SVN_ERR(svn_fs_fs__benchmark_reads(&results, fs, revision, READ_COUNT,
+                                     opt_state->jobs, check_cancel, NULL,
+                                     pool));
+
+  printf(_("Read %s blocks at random offsets of r%ld:\n"),
+         apr_psprintf(pool, "%" APR_INT64_T_FMT, results.requests),
+         revision);
+  print_run(_("sequential"), results.requests, results.bytes,
+            results.sync_time);
+  print_run(apr_psprintf(pool, _("%d in flight"), opt_state->jobs),
+            results.requests, results.bytes, results.async_time);
+
+  return SVN_NO_ERROR;
+}
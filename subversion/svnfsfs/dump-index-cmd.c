@@ -81,7 +81,7 @@ dump_index(const char *path,
   svn_fs_t *fs;
 
   /* Check repository type and open it. */
-  SVN_ERR(open_fs(&fs, path, pool));
+  SVN_ERR(open_fs(&fs, path, NULL, pool));
 
   /* Write header line. */
   printf("       Start       Length Type   Revision     Item Checksum\n");
@@ -137,7 +137,7 @@ load_index(const char *path,
   apr_pool_t *iterpool = svn_pool_create(pool);
 
   /* Check repository type and open it. */
-  SVN_ERR(open_fs(&fs, path, pool));
+  SVN_ERR(open_fs(&fs, path, NULL, pool));
 
   while (TRUE)
     {
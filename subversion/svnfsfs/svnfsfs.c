@@ -116,7 +116,9 @@ check_lib_versions(void)
 
 enum svnfsfs__cmdline_options_t
   {
-    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID
+    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID,
+    svnfsfs__jobs,
+    svnfsfs__snapshot_dir
   };
 
 /* Option codes and descriptions.
@@ -144,6 +146,14 @@ static const apr_getopt_option_t options_table[] =
      N_("size of the extra in-memory cache in MB used to\n"
         "                             minimize redundant operations. Default: 16.")},
 
+    {"jobs",          svnfsfs__jobs, 1,
+     N_("maximum number of concurrent operations (ARG).\n"
+        "                             Default: 1.")},
+
+    {"snapshot-dir",  svnfsfs__snapshot_dir, 1,
+     N_("store per-shard scan results in directory ARG\n"
+        "                             and reuse them in later runs.")},
+
     {NULL}
   };
 
@@ -158,6 +168,22 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "Describe the usage of this program or its subcommands.\n"),
    {0} },
 
+  {"bench-commit", subcommand__bench_commit, {0}, N_
+   ("usage: svnfsfs bench-commit REPOS_PATH [--jobs N]\n\n"
+    "Measure the sustained commit rate with N concurrent committers, each making\n"
+    "100 small commits to a file of its own.  This modifies the repository and\n"
+    "should only be used on scratch repositories.\n"),
+   {svnfsfs__jobs} },
+
+  {"bench-read", subcommand__bench_read, {0}, N_
+   ("usage: svnfsfs bench-read REPOS_PATH [-r REV] [--jobs N]\n\n"
+    "Measure the random read throughput for the revision / pack file containing\n"
+    "revision REV (default: HEAD).  The same set of blocks is read twice:  first\n"
+    "one at a time and then with up to N read requests in flight.  As the first\n"
+    "run will populate the OS file cache, run it on a cold cache for disk\n"
+    "throughput figures.\n"),
+   {'r', 'M', svnfsfs__jobs} },
+
   {"dump-index", subcommand__dump_index, {0}, N_
    ("usage: svnfsfs dump-index REPOS_PATH -r REV\n\n"
     "Dump the index contents for the revision / pack file containing revision REV\n"
@@ -193,9 +219,12 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
    {'M'} },
 
   {"stats", subcommand__stats, {0}, N_
-   ("usage: svnfsfs stats REPOS_PATH\n\n"
-    "Write object size statistics to console.\n"),
-   {'M'} },
+   ("usage: svnfsfs stats REPOS_PATH [--jobs N] [--snapshot-dir DIR]\n\n"
+    "Write object size statistics to console.  For FSFS format 7 (SVN 1.9+)\n"
+    "repositories, up to N revision / pack files are being scanned concurrently.\n"
+    "If DIR is given, the scan results for each pack file are stored in it and\n"
+    "later runs using the same DIR will only scan the remaining revisions.\n"),
+   {'M', svnfsfs__jobs, svnfsfs__snapshot_dir} },
 
   { NULL, NULL, {0}, NULL, {0} }
 };
@@ -204,6 +233,7 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
 svn_error_t *
 open_fs(svn_fs_t **fs,
         const char *path,
+        apr_hash_t *fs_config,
         apr_pool_t *pool)
 {
   const char *fs_type;
@@ -217,7 +247,7 @@ open_fs(svn_fs_t **fs,
                              fs_type);
 
   /* Now open it. */
-  SVN_ERR(svn_fs_open2(fs, path, NULL, pool, pool));
+  SVN_ERR(svn_fs_open2(fs, path, fs_config, pool, pool));
   svn_fs_set_warning_func(*fs, warning_func, NULL);
 
   return SVN_NO_ERROR;
@@ -287,6 +317,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -347,6 +378,18 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnfsfs__version:
         opt_state.version = TRUE;
         break;
+      case svnfsfs__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid number of jobs '%s'"),
+                                   opt_arg);
+        break;
+      case svnfsfs__snapshot_dir:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        opt_state.snapshot_dir = svn_dirent_internal_style(utf8_opt_arg,
+                                                           pool);
+        break;
       default:
         {
           SVN_ERR(subcommand__help(NULL, NULL, pool));
@@ -45,21 +45,27 @@ typedef struct svnfsfs__opt_state
   svn_boolean_t version;                            /* --version */
   svn_boolean_t quiet;                              /* --quiet */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
+  int jobs;                                         /* --jobs N */
+  const char *snapshot_dir;                         /* --snapshot-dir DIR */
 } svnfsfs__opt_state;
 
 /* Declare all the command procedures */
 svn_opt_subcommand_t
   subcommand__help,
+  subcommand__bench_commit,
+  subcommand__bench_read,
   subcommand__dump_index,
   subcommand__load_index,
   subcommand__stats;
 
 
-/* Check that the filesystem at PATH is an FSFS repository and then open it.
- * Return the filesystem in *FS, allocated in POOL. */
+/* Check that the filesystem at PATH is an FSFS repository and then open it
+ * with the optional FS_CONFIG.  Return the filesystem in *FS, allocated in
+ * POOL. */
 svn_error_t *
 open_fs(svn_fs_t **fs,
         const char *path,
+        apr_hash_t *fs_config,
         apr_pool_t *pool);
 
 /* Our cancellation callback. */
@@ -55,6 +55,7 @@
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_subr_private.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -417,12 +418,13 @@ static void convert_case(char *text, svn_boolean_t to_uppercase)
 /* Set *ALLOWED to TRUE if PATH is accessible in the REQUIRED mode to
    the user described in BATON according to the authz rules in BATON.
    Use POOL for temporary allocations only.  If no authz rules are
-   present in BATON, grant access by default. */
-static svn_error_t *authz_check_access(svn_boolean_t *allowed,
-                                       const char *path,
-                                       svn_repos_authz_access_t required,
-                                       server_baton_t *b,
-                                       apr_pool_t *pool)
+   present in BATON, grant access by default.  Unlike authz_check_access,
+   don't log denied access. */
+static svn_error_t *authz_lookup_access(svn_boolean_t *allowed,
+                                        const char *path,
+                                        svn_repos_authz_access_t required,
+                                        server_baton_t *b,
+                                        apr_pool_t *pool)
 {
   repository_t *repository = b->repository;
   client_info_t *client_info = b->client_info;
@@ -443,7 +445,7 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
      absolute path. Passing such a malformed path to the authz
      routines throws them into an infinite loop and makes them miss
      ACLs. */
-  if (path)
+  if (path && !svn_fspath__is_canonical(path))
     path = svn_fspath__canonicalize(path, pool);
 
   /* If we have a username, and we've not yet used it + any username
@@ -460,10 +462,24 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
       client_info->authz_user = authz_user;
     }
 
-  SVN_ERR(svn_repos_authz_check_access(repository->authzdb,
-                                       repository->authz_repos_name,
-                                       path, client_info->authz_user,
-                                       required, allowed, pool));
+  return svn_error_trace(
+           svn_repos_authz_check_access(repository->authzdb,
+                                        repository->authz_repos_name,
+                                        path, client_info->authz_user,
+                                        required, allowed, pool));
+}
+
+/* Set *ALLOWED to TRUE if PATH is accessible in the REQUIRED mode to
+   the user described in BATON according to the authz rules in BATON.
+   Use POOL for temporary allocations only.  If no authz rules are
+   present in BATON, grant access by default. */
+static svn_error_t *authz_check_access(svn_boolean_t *allowed,
+                                       const char *path,
+                                       svn_repos_authz_access_t required,
+                                       server_baton_t *b,
+                                       apr_pool_t *pool)
+{
+  SVN_ERR(authz_lookup_access(allowed, path, required, b, pool));
   if (!*allowed)
     SVN_ERR(log_authz_denied(path, required, b, pool));
 
@@ -495,6 +511,36 @@ static svn_repos_authz_func_t authz_check_access_cb_func(server_baton_t *baton)
   return NULL;
 }
 
+/* Set *READABLE to TRUE if PATH and everything below it is readable by
+ * the user described in BATON.  Use POOL for temporary allocations only.
+ * ROOT is not used.  Implements the svn_repos_authz_subtree_func_t
+ * interface.
+ */
+static svn_error_t *authz_check_subtree_cb(svn_boolean_t *readable,
+                                           svn_fs_root_t *root,
+                                           const char *path,
+                                           void *baton,
+                                           apr_pool_t *pool)
+{
+  authz_baton_t *sb = baton;
+
+  /* Parts of the subtree being unreadable is not an access violation
+     (yet), so don't log anything. */
+  return authz_lookup_access(readable, path,
+                             svn_authz_read | svn_authz_recursive,
+                             sb->server, pool);
+}
+
+/* If authz is enabled in the specified BATON, return a subtree read
+   authorization function. Otherwise, return NULL. */
+static svn_repos_authz_subtree_func_t
+authz_check_subtree_cb_func(server_baton_t *baton)
+{
+  if (baton->repository->authzdb)
+     return authz_check_subtree_cb;
+  return NULL;
+}
+
 /* Set *ALLOWED to TRUE if the REQUIRED access to PATH is granted,
  * according to the state in BATON.  Use POOL for temporary
  * allocations only.  ROOT is not used.  Implements the
@@ -977,13 +1023,14 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
   /* Make an svn_repos report baton.  Tell it to drive the network editor
    * when the report is complete. */
   svn_ra_svn_get_editor(&editor, &edit_baton, conn, pool, NULL, NULL);
-  SVN_CMD_ERR(svn_repos_begin_report3(&report_baton, rev,
+  SVN_CMD_ERR(svn_repos_begin_report4(&report_baton, rev,
                                       b->repository->repos,
                                       b->repository->fs_path->data, target,
                                       tgt_path, text_deltas, depth,
                                       ignore_ancestry, send_copyfrom_args,
                                       editor, edit_baton,
                                       authz_check_access_cb_func(b),
+                                      authz_check_subtree_cb_func(b),
                                       &ab, svn_ra_svn_zero_copy_limit(conn),
                                       pool));
 
@@ -2714,15 +2761,9 @@ static svn_error_t *file_rev_handler(void *baton, const char *path,
       svn_stream_set_write(stream, svndiff_handler);
       svn_stream_set_close(stream, svndiff_close_handler);
 
-      /* If the connection does not support SVNDIFF1 or if we don't want to use
-       * compression, use the non-compressing "version 0" implementation */
-      if (   svn_ra_svn_compression_level(frb->conn) > 0
-          && svn_ra_svn_has_capability(frb->conn, SVN_RA_SVN_CAP_SVNDIFF1))
-        svn_txdelta_to_svndiff3(d_handler, d_baton, stream, 1,
-                                svn_ra_svn_compression_level(frb->conn), pool);
-      else
-        svn_txdelta_to_svndiff3(d_handler, d_baton, stream, 0,
-                                svn_ra_svn_compression_level(frb->conn), pool);
+      svn_txdelta_to_svndiff3(d_handler, d_baton, stream,
+                              svn_ra_svn__svndiff_version(frb->conn),
+                              svn_ra_svn_compression_level(frb->conn), pool);
     }
   else
     SVN_ERR(svn_ra_svn__write_cstring(frb->conn, pool, ""));
@@ -3906,21 +3947,22 @@ construct_server_baton(server_baton_t **baton,
   /* Send greeting.  We don't support version 1 any more, so we can
    * send an empty mechlist. */
   if (params->compression_level > 0)
-    SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
-                                           (apr_uint64_t) 2, (apr_uint64_t) 2,
-                                           SVN_RA_SVN_CAP_EDIT_PIPELINE,
-                                           SVN_RA_SVN_CAP_SVNDIFF1,
-                                           SVN_RA_SVN_CAP_ABSENT_ENTRIES,
-                                           SVN_RA_SVN_CAP_COMMIT_REVPROPS,
-                                           SVN_RA_SVN_CAP_DEPTH,
-                                           SVN_RA_SVN_CAP_LOG_REVPROPS,
-                                           SVN_RA_SVN_CAP_ATOMIC_REVPROPS,
-                                           SVN_RA_SVN_CAP_PARTIAL_REPLAY,
-                                           SVN_RA_SVN_CAP_INHERITED_PROPS,
-                                           SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
-                                           SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE
-                                           ));
+    SVN_ERR(svn_ra_svn__write_cmd_response(
+              conn, scratch_pool, "nn()(wwwwwwwwwww?w)",
+              (apr_uint64_t) 2, (apr_uint64_t) 2,
+              SVN_RA_SVN_CAP_EDIT_PIPELINE,
+              SVN_RA_SVN_CAP_SVNDIFF1,
+              SVN_RA_SVN_CAP_ABSENT_ENTRIES,
+              SVN_RA_SVN_CAP_COMMIT_REVPROPS,
+              SVN_RA_SVN_CAP_DEPTH,
+              SVN_RA_SVN_CAP_LOG_REVPROPS,
+              SVN_RA_SVN_CAP_ATOMIC_REVPROPS,
+              SVN_RA_SVN_CAP_PARTIAL_REPLAY,
+              SVN_RA_SVN_CAP_INHERITED_PROPS,
+              SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
+              SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
+              /* Only offer svndiff2 if we can decode it. */
+              svn__lz4_supported() ? SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED : NULL));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
                                            "nn()(wwwwwwwwww)",
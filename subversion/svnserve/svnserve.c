@@ -55,6 +55,7 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 
@@ -164,6 +165,10 @@ enum run_mode {
  */
 #define MAX_REQUEST_SIZE 16
 
+/* Upper limit to the --parallel-windows and --async-reads values that
+ * the FSFS backend accepts. */
+#define FSFS_MAX_CONCURRENCY 64
+
 #ifdef WIN32
 static apr_os_sock_t winservice_svnserve_accept_socket = INVALID_SOCKET;
 
@@ -221,6 +226,12 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_BLOCK_READ      273
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
+#define SVNSERVE_OPT_SHARED_CACHE    276
+#define SVNSERVE_OPT_CACHE_FILE      277
+#define SVNSERVE_OPT_CACHE_POLICY    278
+#define SVNSERVE_OPT_PARALLEL_WINDOWS 279
+#define SVNSERVE_OPT_ASYNC_READS     280
+#define SVNSERVE_OPT_MMAP_PACKS      281
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -296,6 +307,36 @@ static const apr_getopt_option_t svnserve__options[] =
         "0 switches to dynamically sized caches.\n"
         "                             "
         "[used for FSFS and FSX repositories only]")},
+#if APR_HAS_FORK
+    {"memory-cache-shared", SVNSERVE_OPT_SHARED_CACHE, 0,
+     N_("put the in-memory cache into shared memory such\n"
+        "                             "
+        "that all connection processes use the same cache.\n"
+        "                             "
+        "The whole cache size is allocated at startup.\n"
+        "                             "
+        "[mode: daemon; not used with --threads]")},
+#endif
+    {"memory-cache-file", SVNSERVE_OPT_CACHE_FILE, 1,
+     N_("save the in-memory cache to file ARG upon SIGTERM\n"
+        "                             "
+        "or SIGINT and restore it from there at startup\n"
+        "                             "
+        "to avoid a cold cache after server restarts.\n"
+        "                             "
+        "[mode: daemon; only useful with --threads or\n"
+        "                             "
+        " --memory-cache-shared]")},
+    {"memory-cache-policy", SVNSERVE_OPT_CACHE_POLICY, 1,
+     N_("decide which data to keep in the in-memory cache.\n"
+        "                             "
+        "ARG is one of:\n"
+        "                             "
+        "   'hits'    prefer often used data (default)\n"
+        "                             "
+        "   'tinylfu' also protect frequently used data\n"
+        "                             "
+        "             against large scans, e.g. exports")},
     {"cache-txdeltas", SVNSERVE_OPT_CACHE_TXDELTAS, 1,
      N_("enable or disable caching of deltas between older\n"
         "                             "
@@ -334,6 +375,34 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is no.\n"
         "                             "
         "[used for FSFS repositories in 1.9 format only]")},
+    {"parallel-windows", SVNSERVE_OPT_PARALLEL_WINDOWS, 1,
+     N_("Reconstruct up to ARG delta windows of large\n"
+        "                             "
+        "files concurrently.\n"
+        "                             "
+        "Default is 0 (reconstruct sequentially).\n"
+        "                             "
+        "Maximum is " APR_STRINGIFY(FSFS_MAX_CONCURRENCY) ".\n"
+        "                             "
+        "[used for FSFS repositories only]")},
+    {"async-reads", SVNSERVE_OPT_ASYNC_READS, 1,
+     N_("Allow up to ARG concurrent read requests per\n"
+        "                             "
+        "revision or pack file.\n"
+        "                             "
+        "Default is 0 (read synchronously).\n"
+        "                             "
+        "Maximum is " APR_STRINGIFY(FSFS_MAX_CONCURRENCY) ".\n"
+        "                             "
+        "[used for FSFS repositories only]")},
+    {"mmap-packs", SVNSERVE_OPT_MMAP_PACKS, 1,
+     N_("Map packed shards into memory and read them\n"
+        "                             "
+        "in-place.\n"
+        "                             "
+        "Default is no.\n"
+        "                             "
+        "[used for FSFS repositories only]")},
 #ifdef CONNECTION_HAVE_THREAD_OPTION
     /* ### Making the assumption here that WIN32 never has fork and so
      * ### this option never exists when --service exists. */
@@ -485,6 +554,16 @@ static void sigchld_handler(int signo)
 }
 #endif
 
+/* Set by shutdown_handler() to make accept_connection() return without
+ * a new connection such that we can shut down gracefully. */
+static volatile sig_atomic_t shutdown_requested = FALSE;
+
+/* Request a graceful shutdown.  This will also interrupt the accept(). */
+static void shutdown_handler(int signo)
+{
+  shutdown_requested = TRUE;
+}
+
 /* Redirect stdout to stderr.  ARG is the pool.
  *
  * In tunnel or inetd mode, we don't want hook scripts corrupting the
@@ -508,7 +587,8 @@ static apr_status_t redirect_stdout(void *arg)
 
 /* Wait for the next client connection to come in from SOCK.  Allocate
  * the connection in a root pool from CONNECTION_POOLS and assign PARAMS.
- * Return the connection object in *CONNECTION.
+ * Return the connection object in *CONNECTION.  If a graceful shutdown
+ * has been requested, set *CONNECTION to NULL instead.
  *
  * Use HANDLING_MODE for proper internal cleanup.
  */
@@ -538,6 +618,13 @@ accept_connection(connection_t **connection,
         exit(0);
       #endif
 
+      if (shutdown_requested)
+        {
+          svn_pool_destroy(connection_pool);
+          *connection = NULL;
+          return SVN_NO_ERROR;
+        }
+
       status = apr_socket_accept(&(*connection)->usock, sock,
                                  connection_pool);
       if (handling_mode == connection_mode_fork)
@@ -671,6 +758,23 @@ static svn_error_t *write_pid_file(const char *filename, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Return an error if ARG, given for the command line option OPTION, is
+ * not a number between 0 and FSFS_MAX_CONCURRENCY. */
+static svn_error_t *
+check_fsfs_concurrency(const char *option,
+                       const char *arg)
+{
+  apr_int64_t val;
+  svn_error_t *err = svn_cstring_strtoi64(&val, arg, 0,
+                                          FSFS_MAX_CONCURRENCY, 10);
+  if (err)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                             _("Invalid value '%s' for option --%s"),
+                             arg, option);
+
+  return SVN_NO_ERROR;
+}
+
 /* Version compatibility check */
 static svn_error_t *
 check_lib_versions(void)
@@ -717,6 +821,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
   svn_boolean_t use_block_read = FALSE;
+  const char *parallel_windows = "0";
+  const char *async_reads = "0";
+  svn_boolean_t use_mmap = FALSE;
+  svn_boolean_t memory_cache_shared = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
   int family = APR_INET;
@@ -731,6 +839,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   const char *config_filename = NULL;
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
+  const char *cache_filename = NULL;
+  svn_cache__admission_policy_t admission_policy
+    = svn_cache__admission_hits;
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
@@ -894,6 +1005,27 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           params.memory_cache_size = 0x100000 * apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_SHARED_CACHE:
+          memory_cache_shared = TRUE;
+          break;
+
+        case SVNSERVE_OPT_CACHE_POLICY:
+          if (strcmp(arg, "hits") == 0)
+            admission_policy = svn_cache__admission_hits;
+          else if (strcmp(arg, "tinylfu") == 0)
+            admission_policy = svn_cache__admission_tinylfu;
+          else
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Invalid cache policy '%s'"), arg);
+          break;
+
+        case SVNSERVE_OPT_CACHE_FILE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&cache_filename, arg, pool));
+          cache_filename = svn_dirent_internal_style(cache_filename, pool);
+          SVN_ERR(svn_dirent_get_absolute(&cache_filename, cache_filename,
+                                          pool));
+          break;
+
         case SVNSERVE_OPT_CACHE_TXDELTAS:
           cache_txdeltas = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
@@ -910,6 +1042,20 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_PARALLEL_WINDOWS:
+          SVN_ERR(check_fsfs_concurrency("parallel-windows", arg));
+          parallel_windows = arg;
+          break;
+
+        case SVNSERVE_OPT_ASYNC_READS:
+          SVN_ERR(check_fsfs_concurrency("async-reads", arg));
+          async_reads = arg;
+          break;
+
+        case SVNSERVE_OPT_MMAP_PACKS:
+          use_mmap = svn_tristate__from_word(arg) == svn_tristate_true;
+          break;
+
         case SVNSERVE_OPT_CLIENT_SPEED:
           {
             apr_size_t bandwidth = (apr_size_t)apr_strtoi64(arg, NULL, 0);
@@ -1028,6 +1174,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                 cache_revprops ? "2" :"0");
   svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ,
                 use_block_read ? "1" :"0");
+  svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_PARALLEL_WINDOWS,
+                parallel_windows);
+  svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_ASYNC_READS,
+                async_reads);
+  svn_hash_sets(params.fs_config, SVN_FS_CONFIG_FSFS_MMAP,
+                use_mmap ? "1" :"0");
 
   SVN_ERR(svn_repos__config_pool_create(&params.config_pool,
                                         is_multi_threaded,
@@ -1279,6 +1431,29 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       }
 
     svn_cache_config_set(&settings);
+    svn_cache__set_global_admission_policy(admission_policy);
+
+    /* Connection processes can only share the cache if it has been
+     * created before they get forked. */
+    if (   memory_cache_shared
+        && run_mode == run_mode_daemon
+        && handling_mode == connection_mode_fork)
+      SVN_ERR(svn_cache__create_shared_global_membuffer_cache(NULL));
+
+    /* Warm up the cache with the contents saved by a previous instance.
+     * Failing to do so is not fatal. */
+    if (cache_filename)
+      {
+        svn_boolean_t loaded;
+
+        err = svn_cache__load_global_membuffer_cache(&loaded,
+                                                     cache_filename, pool);
+        if (err)
+          {
+            logger__log_error(params.logger, err, NULL, NULL);
+            svn_error_clear(err);
+          }
+      }
   }
 
 #if APR_HAS_THREADS
@@ -1314,11 +1489,31 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 #endif
 
+  /* Only the daemon's accept loop below shuts down gracefully and saves
+   * the cache.  Connection processes forked from it restore the default
+   * signal handling, see below. */
+  if (cache_filename && run_mode == run_mode_daemon)
+    {
+      apr_signal(SIGTERM, shutdown_handler);
+      apr_signal(SIGINT, shutdown_handler);
+    }
+
   while (1)
     {
       connection_t *connection = NULL;
       SVN_ERR(accept_connection(&connection, sock, &params, handling_mode,
                                 pool));
+      if (connection == NULL)
+        {
+          /* Graceful shutdown.  Connections still being served will
+           * continue to use the cache while we write it. */
+          err = svn_cache__save_global_membuffer_cache(cache_filename, pool);
+          if (err)
+            logger__log_error(params.logger, err, NULL, NULL);
+
+          return svn_error_trace(err);
+        }
+
       if (run_mode == run_mode_listen_once)
         {
           err = serve_socket(connection, connection->pool);
@@ -1336,6 +1531,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
               /* the child would't listen to the main server's socket */
               apr_socket_close(sock);
 
+              /* Graceful shutdown is the parent's business.  Let the
+               * child terminate upon SIGTERM / SIGINT as usual. */
+              apr_signal(SIGTERM, SIG_DFL);
+              apr_signal(SIGINT, SIG_DFL);
+
               /* serve_socket() logs any error it returns, so ignore it. */
               svn_error_clear(serve_socket(connection, connection->pool));
               close_connection(connection);
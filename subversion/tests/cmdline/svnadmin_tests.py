@@ -3293,6 +3293,72 @@ def dump_no_op_prop_change(sbox):
   svntest.actions.run_and_verify_svn(expected, [], 'log',  '-v',
                                      sbox2.repo_url + '/bar')
 
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+@SkipUnless(svntest.main.fs_has_pack)
+def fsfs_hotcopy_jobs(sbox):
+  "hotcopy with multiple jobs"
+
+  # The progress output can be affected by the --fsfs-packing
+  # option, so skip the test if that is the case.
+  if svntest.main.options.fsfs_packing:
+    raise svntest.Skip('fsfs packing set')
+
+  # Create a couple of packed shards with two revisions each, followed by
+  # a few non-packed revisions.
+  sbox.build(create_wc=False, empty=True)
+  patch_format(sbox.repo_dir, shard_size=2)
+
+  for i in range(1, 10):
+    svntest.actions.run_and_verify_svn(None, [], 'mkdir',
+                                       '-m', svntest.main.make_log_msg(),
+                                       sbox.repo_url + '/dir-%i' % i)
+  svntest.actions.run_and_verify_svnadmin(None, [], 'pack',
+                                          sbox.repo_dir)
+  for i in range(10, 13):
+    svntest.actions.run_and_verify_svn(None, [], 'mkdir',
+                                       '-m', svntest.main.make_log_msg(),
+                                       sbox.repo_url + '/dir-%i' % i)
+
+  # Progress must still be reported in revision order.
+  expected_full = [
+    "* Copied revisions from 0 to 1.\n",
+    "* Copied revisions from 2 to 3.\n",
+    "* Copied revisions from 4 to 5.\n",
+    "* Copied revisions from 6 to 7.\n",
+    "* Copied revisions from 8 to 9.\n",
+    "* Copied revision 10.\n",
+    "* Copied revision 11.\n",
+    "* Copied revision 12.\n",
+    ]
+
+  backup_dir, backup_url = sbox.add_repo_path('backup')
+  svntest.actions.run_and_verify_svnadmin(expected_full, [],
+                                          'hotcopy', '--jobs', '3',
+                                          sbox.repo_dir, backup_dir)
+  check_hotcopy_fsfs(sbox.repo_dir, backup_dir)
+
+  # Incremental hotcopy after packing a bit more.  r13 completes the
+  # shard of r12, so both remaining shards get packed.  r14 starts a new,
+  # non-packed shard.
+  svntest.actions.run_and_verify_svn(None, [], 'mkdir',
+                                     '-m', svntest.main.make_log_msg(),
+                                     sbox.repo_url + '/dir-13')
+  svntest.actions.run_and_verify_svnadmin(None, [], 'pack',
+                                          sbox.repo_dir)
+  svntest.actions.run_and_verify_svn(None, [], 'mkdir',
+                                     '-m', svntest.main.make_log_msg(),
+                                     sbox.repo_url + '/dir-14')
+  expected_incremental = [
+    "* Copied revisions from 10 to 11.\n",
+    "* Copied revisions from 12 to 13.\n",
+    "* Copied revision 14.\n",
+    ]
+  svntest.actions.run_and_verify_svnadmin(expected_incremental, [],
+                                          'hotcopy', '--incremental',
+                                          '--jobs', '3',
+                                          sbox.repo_dir, backup_dir)
+  check_hotcopy_fsfs(sbox.repo_dir, backup_dir)
+
 ########################################################################
 # Run the tests
 
@@ -3354,7 +3420,8 @@ test_list = [ None,
               load_revprops,
               dump_revprops,
               dump_no_op_change,
-              dump_no_op_prop_change
+              dump_no_op_prop_change,
+              fsfs_hotcopy_jobs
              ]
 
 if __name__ == '__main__':
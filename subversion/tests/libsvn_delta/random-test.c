@@ -36,6 +36,7 @@
 #include "svn_delta.h"
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "private/svn_subr_private.h"
 
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
@@ -280,9 +281,11 @@ copy_tempfile(apr_file_t *fp, apr_pool_t *pool)
 
 
 
-/* (Note: *LAST_SEED is an output parameter.) */
+/* Use svndiff format SVNDIFF_VERSION to transmit the deltas.
+   (Note: *LAST_SEED is an output parameter.) */
 static svn_error_t *
 do_random_test(apr_pool_t *pool,
+               int svndiff_version,
                apr_uint32_t *last_seed)
 {
   apr_uint32_t seed, maxlen;
@@ -330,8 +333,8 @@ do_random_test(apr_pool_t *pool,
 
       /* Make stage 2: encode the text delta in svndiff format using
                        varying compression levels. */
-      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, 1, i % 10,
-                              delta_pool);
+      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream,
+                              svndiff_version, i % 10, delta_pool);
 
       /* Make stage 1: create the text delta.  */
       svn_txdelta2(&txdelta_stream,
@@ -363,7 +366,24 @@ static svn_error_t *
 random_test(apr_pool_t *pool)
 {
   apr_uint32_t seed;
-  svn_error_t *err = do_random_test(pool, &seed);
+  svn_error_t *err = do_random_test(pool, 1, &seed);
+  if (err)
+    fprintf(stderr, "SEED: %lu\n", (unsigned long)seed);
+  return err;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_lz4_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed;
+  svn_error_t *err;
+
+  if (!svn__lz4_supported())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "LZ4 support not compiled in");
+
+  err = do_random_test(pool, 2, &seed);
   if (err)
     fprintf(stderr, "SEED: %lu\n", (unsigned long)seed);
   return err;
@@ -533,6 +553,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "random delta test"),
     SVN_TEST_PASS2(random_combine_test,
                    "random combine delta test"),
+    SVN_TEST_PASS2(random_lz4_test,
+                   "random svndiff2 (LZ4) delta test"),
 #ifdef SVN_RANGE_INDEX_TEST_H
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
@@ -26,9 +26,11 @@
 
 #include "../svn_test.h"
 
+#include "svn_dirent_uri.h"
 #include "svn_error.h"
 #include "svn_fs.h"
 #include "svn_hash.h"
+#include "svn_io.h"
 
 #include "../svn_test_fs.h"
 
@@ -1211,6 +1213,170 @@ parent_and_child_lock(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Set *KIND to the node kind of NAME within the repository at REPO_PATH.
+   Use POOL for allocations. */
+static svn_error_t *
+check_repo_path(svn_node_kind_t *kind,
+                const char *repo_path,
+                const char *name,
+                apr_pool_t *pool)
+{
+  return svn_error_trace(svn_io_check_path(svn_dirent_join(repo_path, name,
+                                                           pool),
+                                           kind, pool));
+}
+
+/* Open the filesystem at REPO_PATH as user "bubba" and return it in *FS.
+   Use POOL for allocations. */
+static svn_error_t *
+open_fs_as_bubba(svn_fs_t **fs,
+                 const char *repo_path,
+                 apr_pool_t *pool)
+{
+  svn_fs_access_t *access;
+
+  SVN_ERR(svn_fs_open2(fs, repo_path, NULL, pool, pool));
+  SVN_ERR(svn_fs_create_access(&access, "bubba", pool));
+  SVN_ERR(svn_fs_set_access(*fs, access));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+lock_store_upgrade(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  const char *repo_path = "test-lock-store-upgrade";
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t newrev;
+  svn_lock_t *lock;
+  svn_node_kind_t kind;
+  svn_test_opts_t opts_1_9 = *opts;
+  svn_fs_lock_target_t *target;
+  struct lock_many_baton_t baton;
+  struct get_locks_baton_t *get_locks_baton;
+  apr_hash_t *lock_paths, *unlock_paths;
+
+  /* The lock store is specific to FSFS. */
+  if (strcmp(opts->fs_type, SVN_FS_TYPE_FSFS) != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  /* Start with a format that keeps the locks in digest files. */
+  opts_1_9.server_minor_version = 9;
+  SVN_ERR(create_greek_fs(NULL, &newrev, repo_path, &opts_1_9, pool));
+  SVN_ERR(open_fs_as_bubba(&fs, repo_path, pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/iota", NULL, "digest", FALSE, 0, newrev,
+                      FALSE, pool));
+
+  SVN_ERR(check_repo_path(&kind, repo_path, "locks", pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+  SVN_ERR(check_repo_path(&kind, repo_path, "locks.db", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Upgrading moves the existing locks into the lock store. */
+  SVN_ERR(svn_fs_upgrade2(repo_path, NULL, NULL, NULL, NULL, pool));
+
+  SVN_ERR(check_repo_path(&kind, repo_path, "locks", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(check_repo_path(&kind, repo_path, "locks.db", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  SVN_ERR(open_fs_as_bubba(&fs, repo_path, pool));
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/iota", pool));
+  SVN_TEST_ASSERT(lock && strcmp(lock->comment, "digest") == 0
+                  && strcmp(lock->owner, "bubba") == 0);
+
+  /* Lock a batch of paths. */
+  baton.results = apr_hash_make(pool);
+  baton.pool = pool;
+  baton.count = 0;
+
+  target = svn_fs_lock_target_create(NULL, newrev, pool);
+  lock_paths = apr_hash_make(pool);
+  svn_hash_sets(lock_paths, "/A/mu", target);
+  svn_hash_sets(lock_paths, "/A/B/lambda", target);
+  svn_hash_sets(lock_paths, "/A/D/gamma", target);
+  svn_hash_sets(lock_paths, "/A/D/G/pi", target);
+  svn_hash_sets(lock_paths, "/A/D/G/rho", target);
+  svn_hash_sets(lock_paths, "/A/no-such-file", target);
+
+  SVN_ERR(svn_fs_lock_many(fs, lock_paths, "batch", FALSE, 0, FALSE,
+                           lock_many_cb, &baton, pool, pool));
+  SVN_ERR(expect_lock("/A/mu", baton.results, fs, pool));
+  SVN_ERR(expect_lock("/A/B/lambda", baton.results, fs, pool));
+  SVN_ERR(expect_lock("/A/D/gamma", baton.results, fs, pool));
+  SVN_ERR(expect_lock("/A/D/G/pi", baton.results, fs, pool));
+  SVN_ERR(expect_lock("/A/D/G/rho", baton.results, fs, pool));
+  SVN_ERR(expect_error("/A/no-such-file", baton.results, fs, pool));
+
+  /* Enumerate sub-trees at different depths. */
+  {
+    static const char *expected_paths[] = {
+      "/A/D/gamma",
+      "/A/D/G/pi",
+      "/A/D/G/rho",
+    };
+    get_locks_baton = make_get_locks_baton(pool);
+    SVN_ERR(svn_fs_get_locks2(fs, "/A/D", svn_depth_infinity,
+                              get_locks_callback, get_locks_baton, pool));
+    SVN_ERR(verify_matching_lock_paths(get_locks_baton, expected_paths,
+                                       3, pool));
+  }
+  {
+    static const char *expected_paths[] = {
+      "/A/D/gamma",
+    };
+    get_locks_baton = make_get_locks_baton(pool);
+    SVN_ERR(svn_fs_get_locks2(fs, "/A/D", svn_depth_files,
+                              get_locks_callback, get_locks_baton, pool));
+    SVN_ERR(verify_matching_lock_paths(get_locks_baton, expected_paths,
+                                       1, pool));
+  }
+  get_locks_baton = make_get_locks_baton(pool);
+  SVN_ERR(svn_fs_get_locks2(fs, "/A/B/E", svn_depth_infinity,
+                            get_locks_callback, get_locks_baton, pool));
+  SVN_TEST_ASSERT(apr_hash_count(get_locks_baton->locks) == 0);
+
+  /* Locked paths must still be protected from commits. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, newrev, SVN_FS_TXN_CHECK_LOCKS, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "/A/D", pool));
+  SVN_TEST_ASSERT_ERROR(svn_fs_commit_txn(NULL, &newrev, txn, pool),
+                        SVN_ERR_FS_BAD_LOCK_TOKEN);
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  /* Break a batch of locks. */
+  apr_hash_clear(baton.results);
+  unlock_paths = apr_hash_make(pool);
+  svn_hash_sets(unlock_paths, "/A/D/G/pi", "");
+  svn_hash_sets(unlock_paths, "/A/D/G/rho", "");
+  SVN_ERR(svn_fs_unlock_many(fs, unlock_paths, TRUE, lock_many_cb, &baton,
+                             pool, pool));
+  SVN_ERR(expect_unlock("/A/D/G/pi", baton.results, fs, pool));
+  SVN_ERR(expect_unlock("/A/D/G/rho", baton.results, fs, pool));
+
+  /* Everything persists across re-opens. */
+  SVN_ERR(open_fs_as_bubba(&fs, repo_path, pool));
+  {
+    static const char *expected_paths[] = {
+      "/iota",
+      "/A/mu",
+      "/A/B/lambda",
+      "/A/D/gamma",
+    };
+    get_locks_baton = make_get_locks_baton(pool);
+    SVN_ERR(svn_fs_get_locks2(fs, "/", svn_depth_infinity,
+                              get_locks_callback, get_locks_baton, pool));
+    SVN_ERR(verify_matching_lock_paths(get_locks_baton, expected_paths,
+                                       4, pool));
+  }
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -1250,6 +1416,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "lock/unlock when 'write-lock' couldn't be obtained"),
     SVN_TEST_OPTS_PASS(parent_and_child_lock,
                        "lock parent and it's child"),
+    SVN_TEST_OPTS_PASS(lock_store_upgrade,
+                       "upgrade to and use the FSFS lock store"),
     SVN_TEST_NULL
   };
 
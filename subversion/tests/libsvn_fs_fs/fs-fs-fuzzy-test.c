@@ -117,7 +117,7 @@ fuzzing_1_byte_1_rev(const char *repo_name,
       svn_fs_set_warning_func(svn_repos_fs(repos), dont_filter_warnings, NULL);
 
       /* This shall detect the corruption and return an error. */
-      err = svn_repos_verify_fs3(repos, revision, revision, FALSE, FALSE,
+      err = svn_repos_verify_fs4(repos, revision, revision, FALSE, FALSE, 1,
                                  NULL, NULL, NULL, NULL, NULL, NULL,
                                  iterpool);
 
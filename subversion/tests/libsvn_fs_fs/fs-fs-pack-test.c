@@ -169,7 +169,7 @@ create_packed_filesystem(const char *dir,
   /* Now pack the FS */
   pnb.expected_shard = 0;
   pnb.expected_action = svn_fs_pack_notify_start;
-  return svn_fs_pack(dir, pack_notify, &pnb, NULL, NULL, pool);
+  return svn_fs_pack2(dir, NULL, pack_notify, &pnb, NULL, NULL, pool);
 }
 
 /* Create a packed FSFS filesystem for revprop tests at REPO_NAME with
@@ -204,7 +204,7 @@ prepare_revprop_repo(svn_fs_t **fs,
   svn_pool_destroy(subpool);
 
   /* Pack the repository. */
-  SVN_ERR(svn_fs_pack(repo_name, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(repo_name, NULL, NULL, NULL, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
 }
@@ -641,7 +641,7 @@ recover_fully_packed(const svn_test_opts_t *opts,
   SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, subpool));
   SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(after_rev));
   svn_pool_destroy(subpool);
-  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(REPO_NAME, NULL, NULL, NULL, NULL, NULL, pool));
   SVN_ERR(svn_fs_recover(REPO_NAME, NULL, NULL, pool));
 
   /* Now, delete the youngest revprop file, and recover again.  This
@@ -980,7 +980,7 @@ upgrade_txns_to_log_addressing(const svn_test_opts_t *opts,
   /* Pack repo to verify that old and new shard get packed according to
      their respective addressing mode */
 
-  SVN_ERR(svn_fs_pack(repo_name, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(repo_name, NULL, NULL, NULL, NULL, NULL, pool));
 
   /* verify that our changes got in */
 
@@ -1740,6 +1740,442 @@ compare_0_length_rep(const svn_test_opts_t *opts,
 
 #undef REPO_NAME
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-pack_concurrently"
+#define SHARD_SIZE 4
+#define MAX_REV 37
+
+/* Implements svn_fs_pack_notify_t.  BATON is an int * counting the
+   start and end notifications received so far. */
+static svn_error_t *
+count_packed_shards(void *baton,
+                    apr_int64_t shard,
+                    svn_fs_pack_notify_action_t action,
+                    apr_pool_t *pool)
+{
+  int *count = baton;
+
+  /* Shards must be switched over in order and each start notification
+     must immediately be followed by the end notification of that shard. */
+  if (action == svn_fs_pack_notify_start)
+    SVN_TEST_ASSERT(*count % 2 == 0);
+  else if (action == svn_fs_pack_notify_end)
+    SVN_TEST_ASSERT(*count % 2 == 1);
+  else
+    return SVN_NO_ERROR;
+
+  SVN_TEST_ASSERT(shard == (*count)++ / 2);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+pack_concurrently(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  int notifications = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 6))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't support FSFS packing");
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+
+  /* r1 is the Greek tree, followed by changes to "iota". */
+  SVN_ERR(svn_test__add_iota_history(fs, MAX_REV, get_rev_contents, pool));
+
+  /* Pack with more workers than we have shards in the last batch. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_JOBS, "4");
+  SVN_ERR(svn_fs_pack2(REPO_NAME, fs_config, count_packed_shards,
+                       &notifications, NULL, NULL, pool));
+  SVN_TEST_ASSERT(notifications == 2 * ((MAX_REV + 1) / SHARD_SIZE));
+
+  /* Check the result. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  for (rev = 2; rev <= MAX_REV; ++rev)
+    {
+      svn_stringbuf_t *contents;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_test__get_file_contents(root, "iota", &contents,
+                                          iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             get_rev_contents(rev, iterpool));
+    }
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, SVN_INVALID_REVNUM,
+                        NULL, NULL, NULL, NULL, pool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-revprop_generation"
+#define SHARD_SIZE 4
+#define MAX_REV 8
+
+/* Set *GENERATION to the revprop generation stored in the filesystem
+   at REPO_NAME.  Use POOL for allocations. */
+static svn_error_t *
+read_revprop_generation_file(apr_int64_t *generation,
+                             apr_pool_t *pool)
+{
+  svn_stringbuf_t *content;
+
+  SVN_ERR(svn_stringbuf_from_file2(&content,
+                                   svn_dirent_join(REPO_NAME,
+                                                   PATH_REVPROP_GENERATION,
+                                                   pool),
+                                   pool));
+  svn_stringbuf_strip_whitespace(content);
+  SVN_ERR(svn_cstring_atoi64(generation, content->data));
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the non-packed revprops of REV in FS with a log message LOG,
+   bypassing FSFS and its revprop generation.  Use POOL for allocations. */
+static svn_error_t *
+overwrite_revprops(svn_fs_t *fs,
+                   svn_revnum_t rev,
+                   const char *log,
+                   apr_pool_t *pool)
+{
+  const char *contents = apr_psprintf(pool, "K %d\n%s\nV %d\n%s\nEND\n",
+                                      (int)strlen(SVN_PROP_REVISION_LOG),
+                                      SVN_PROP_REVISION_LOG,
+                                      (int)strlen(log), log);
+
+  SVN_ERR(svn_io_write_atomic2(svn_fs_fs__path_revprops(fs, rev, pool),
+                               contents, strlen(contents), NULL, FALSE,
+                               pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+revprop_generation(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs1;
+  svn_fs_t *fs2;
+  apr_hash_t *fs_config;
+  svn_string_t *value;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  apr_int64_t generation, old_generation;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 7))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.7 SVN doesn't support revprop packing");
+
+  /* Older servers don't maintain the revprop generation file, so we must
+   * not create it for formats that they may write to. */
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    {
+      SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+      SVN_ERR(svn_fs_open2(&fs1, REPO_NAME, NULL, pool, pool));
+      SVN_ERR(svn_fs_change_rev_prop(fs1, 2, SVN_PROP_REVISION_LOG,
+                                     default_log(2, pool), pool));
+      SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME,
+                                                PATH_REVPROP_GENERATION,
+                                                pool),
+                                &kind, pool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Create a packed filesystem and give each revision a log message. */
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs1, REPO_NAME, NULL, pool, pool));
+  for (rev = 1; rev <= MAX_REV; ++rev)
+    SVN_ERR(svn_fs_change_rev_prop(fs1, rev, SVN_PROP_REVISION_LOG,
+                                   default_log(rev, pool), pool));
+
+  SVN_ERR(read_revprop_generation_file(&old_generation, pool));
+  SVN_TEST_ASSERT(old_generation > 0 && (old_generation & 1) == 0);
+
+  /* Read all log messages through a caching filesystem object.
+   * As in 'svn log', these are reads across sync barriers. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_REVPROPS, "1");
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, fs_config, pool, pool));
+
+  for (rev = 1; rev <= MAX_REV; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_prop2(&value, fs2, rev, SVN_PROP_REVISION_LOG,
+                                    TRUE, iterpool, iterpool));
+      SVN_TEST_STRING_ASSERT(value->data,
+                             default_log(rev, iterpool)->data);
+    }
+
+  /* Modify the non-packed revprops of MAX_REV behind FSFS' back.  As long
+   * as the generation does not change, the caching object must keep using
+   * its cache across sync barriers. */
+  SVN_ERR(overwrite_revprops(fs1, MAX_REV, "tampered", pool));
+  SVN_ERR(svn_fs_refresh_revision_props(fs2, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, MAX_REV, SVN_PROP_REVISION_LOG,
+                                FALSE, pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, default_log(MAX_REV, pool)->data);
+
+  /* Change a packed revprop through the other object.  That must
+   * advance the generation by exactly one change. */
+  SVN_ERR(svn_fs_change_rev_prop2(fs1, 2, SVN_PROP_REVISION_LOG, NULL,
+                                  svn_string_create("changed", pool),
+                                  pool));
+  SVN_ERR(read_revprop_generation_file(&generation, pool));
+  SVN_TEST_ASSERT(generation == old_generation + 2);
+
+  /* After the next sync barrier, the caching object must not return the
+   * previous value. */
+  SVN_ERR(svn_fs_refresh_revision_props(fs2, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, 2, SVN_PROP_REVISION_LOG,
+                                FALSE, pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, "changed");
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, 3, SVN_PROP_REVISION_LOG,
+                                FALSE, pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, default_log(3, pool)->data);
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, MAX_REV, SVN_PROP_REVISION_LOG,
+                                FALSE, pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, "tampered");
+
+  /* Simulate an interrupted revprop change.  Readers must bypass their
+   * caches while the generation is odd. */
+  old_generation = generation + 1;
+  value = svn_string_createf(pool, "%" APR_INT64_T_FMT "\n", old_generation);
+  SVN_ERR(svn_io_write_atomic2(svn_dirent_join(REPO_NAME,
+                                               PATH_REVPROP_GENERATION,
+                                               pool),
+                               value->data, value->len, NULL, FALSE, pool));
+  SVN_ERR(overwrite_revprops(fs1, MAX_REV, "tampered again", pool));
+  SVN_ERR(svn_fs_refresh_revision_props(fs2, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, MAX_REV, SVN_PROP_REVISION_LOG,
+                                FALSE, pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, "tampered again");
+
+  /* Opening the repository must not take the write lock to repair the
+   * generation.  Recovery does that. */
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(read_revprop_generation_file(&generation, pool));
+  SVN_TEST_ASSERT(generation == old_generation);
+
+  SVN_ERR(svn_fs_recover(REPO_NAME, NULL, NULL, pool));
+  SVN_ERR(read_revprop_generation_file(&generation, pool));
+  SVN_TEST_ASSERT(generation == old_generation + 1);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsfs-batch-fsync"
+static svn_error_t *
+test_batch_fsync(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  const char *abspath;
+  svn_fs_fs__batch_fsync_t *batch;
+  int i;
+
+  /* Disable this test for non FSFS backends because it has no relevance to
+   * them. */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  /* Create an empty working directory and let it be cleaned up by the test
+   * harness. */
+  SVN_ERR(svn_dirent_get_absolute(&abspath, REPO_NAME, pool));
+
+  SVN_ERR(svn_io_remove_dir2(abspath, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_io_make_dir_recursively(abspath, pool));
+  svn_test_add_dir_cleanup(abspath);
+
+  /* We use and re-use the same batch object throughout this test. */
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, pool));
+
+  /* The working directory is new. */
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, abspath, pool));
+
+  /* 1st run: Has to fire up worker threads etc. */
+  for (i = 0; i < 10; ++i)
+    {
+      apr_file_t *file;
+      const char *path = svn_dirent_join(abspath,
+                                         apr_psprintf(pool, "file%i", i),
+                                         pool);
+      apr_size_t len = strlen(path);
+
+      SVN_ERR(svn_fs_fs__batch_fsync_open_file(&file, batch, path, pool));
+
+      SVN_ERR(svn_io_file_write(file, path, &len, pool));
+    }
+
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
+
+  /* 2nd run: Running a batch must leave the container in an empty,
+   * re-usable state. Hence, try to re-use it.  Opening the same file
+   * twice must return the same handle. */
+  for (i = 0; i < 10; ++i)
+    {
+      apr_file_t *file, *file2;
+      const char *path = svn_dirent_join(abspath,
+                                         apr_psprintf(pool, "new%i", i),
+                                         pool);
+      apr_size_t len = strlen(path);
+
+      SVN_ERR(svn_fs_fs__batch_fsync_open_file(&file, batch, path, pool));
+      SVN_ERR(svn_fs_fs__batch_fsync_open_file(&file2, batch, path, pool));
+      SVN_TEST_ASSERT(file == file2);
+
+      SVN_ERR(svn_io_file_write(file, path, &len, pool));
+    }
+
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
+
+  /* 3rd run: Schedule but don't execute. POOL cleanup shall not fail. */
+  for (i = 0; i < 10; ++i)
+    {
+      apr_file_t *file;
+      const char *path = svn_dirent_join(abspath,
+                                         apr_psprintf(pool, "another%i", i),
+                                         pool);
+      apr_size_t len = strlen(path);
+
+      SVN_ERR(svn_fs_fs__batch_fsync_open_file(&file, batch, path, pool));
+
+      SVN_ERR(svn_io_file_write(file, path, &len, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsfs-sync-current"
+
+/* Set *COUNT to the number of temporary files in the directory of FS. */
+static svn_error_t *
+count_tmp_files(int *count,
+                svn_fs_t *fs,
+                apr_pool_t *pool)
+{
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, fs->path, TRUE, pool, pool));
+
+  *count = 0;
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    if (strstr(apr_hash_this_key(hi), ".tmp"))
+      ++*count;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+sync_current(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_uint64_t next_node_id, next_copy_id;
+  const char *current_path;
+  int count;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Commits make their update of 'current' persistent. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 1);
+
+#ifdef SVN_ON_POSIX
+  {
+    fs_fs_data_t *ffd = fs->fsap_data;
+    SVN_TEST_ASSERT(ffd->shared->synced_revision == 1);
+
+    /* Updates that have already been synced are not synced again. */
+    SVN_ERR(svn_fs_fs__sync_current(fs, 0, pool));
+    SVN_TEST_ASSERT(ffd->shared->synced_revision == 1);
+  }
+#endif
+
+  /* Writing 'current' without syncing the directory must produce the
+   * same contents and must not leave any temporaries behind. */
+  SVN_ERR(svn_fs_fs__read_current(&rev, &next_node_id, &next_copy_id,
+                                  fs, pool));
+  SVN_ERR(svn_fs_fs__write_current2(fs, rev, next_node_id, next_copy_id,
+                                    FALSE, pool));
+  SVN_ERR(svn_fs_fs__sync_current(fs, rev, pool));
+  SVN_ERR(svn_fs_fs__read_current(&rev, &next_node_id, &next_copy_id,
+                                  fs, pool));
+  SVN_TEST_ASSERT(rev == 1);
+  SVN_ERR(count_tmp_files(&count, fs, pool));
+  SVN_TEST_ASSERT(count == 0);
+
+  /* If the update fails, the temporary file must be removed as well.
+   * Renaming a file onto a directory fails. */
+  current_path = svn_fs_fs__path_current(fs, pool);
+  SVN_ERR(svn_io_remove_file2(current_path, FALSE, pool));
+  SVN_ERR(svn_io_dir_make(current_path, APR_OS_DEFAULT, pool));
+
+  SVN_TEST_ASSERT_ANY_ERROR(svn_fs_fs__write_current2(fs, rev, next_node_id,
+                                                      next_copy_id, FALSE,
+                                                      pool));
+  SVN_ERR(count_tmp_files(&count, fs, pool));
+  SVN_TEST_ASSERT(count == 0);
+
+  /* Restore the repository. */
+  SVN_ERR(svn_io_dir_remove_nonrecursive(current_path, pool));
+  SVN_ERR(svn_fs_fs__write_current(fs, rev, next_node_id, next_copy_id,
+                                   pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+
 
 /* The test table.  */
 
@@ -1790,6 +2226,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "delta chains starting with PLAIN, issue #4577"),
     SVN_TEST_OPTS_PASS(compare_0_length_rep,
                        "compare empty PLAIN and non-existent reps"),
+    SVN_TEST_OPTS_PASS(pack_concurrently,
+                       "pack multiple shards concurrently"),
+    SVN_TEST_OPTS_PASS(revprop_generation,
+                       "revprop caching across revprop generations"),
+    SVN_TEST_OPTS_PASS(test_batch_fsync,
+                       "test the batch fsync feature"),
+    SVN_TEST_OPTS_PASS(sync_current,
+                       "test deferred syncing of 'current'"),
     SVN_TEST_NULL
   };
 
@@ -22,9 +22,11 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <apr_thread_proc.h>
 
 #include "../svn_test.h"
 
+#include "svn_checksum.h"
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_props.h"
@@ -34,7 +36,13 @@
 #include "private/svn_fs_fs_private.h"
 #include "private/svn_subr_private.h"
 
+#include "../../libsvn_fs/fs-loader.h"
+#include "../../libsvn_fs_fs/fs.h"
+#include "../../libsvn_fs_fs/fs_fs.h"
+#include "../../libsvn_fs_fs/cached_data.h"
 #include "../../libsvn_fs_fs/index.h"
+#include "../../libsvn_fs_fs/rep-cache.h"
+#include "../../libsvn_fs_fs/rev_file.h"
 
 #include "../svn_test_fs.h"
 
@@ -72,6 +80,61 @@ create_greek_repo(svn_repos_t **repos,
   return SVN_NO_ERROR;
 }
 
+/* Open the repository at REPO_NAME with FS_CONFIG (may be NULL) and a
+ * cache namespace of its own, such that no data from earlier FS instances
+ * will be found in the caches.  Return the FS in *FS_P.
+ * Use POOL for allocations. */
+static svn_error_t *
+open_uncached_fs(svn_fs_t **fs_p,
+                 const char *repo_name,
+                 apr_hash_t *fs_config,
+                 apr_pool_t *pool)
+{
+  fs_config = fs_config ? apr_hash_copy(pool, fs_config)
+                        : apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(fs_p, repo_name, fs_config, pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test__iota_contents_func_t. */
+static const char *
+iota_contents(svn_revnum_t rev,
+              apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "iota in r%ld\n", rev);
+}
+
+/* Implements svn_test__iota_contents_func_t. */
+static const char *
+rewritten_iota_contents(svn_revnum_t rev,
+                        apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "iota, rewritten in r%ld\n", rev);
+}
+
+/* Implements svn_test__iota_contents_func_t.  Return a few KB of text
+ * that gets a line appended in every revision, such that each
+ * representation is a small delta against its predecessor. */
+static const char *
+growing_contents(svn_revnum_t rev,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents = svn_stringbuf_create("Some text.\n", pool);
+  svn_revnum_t i;
+
+  for (i = 0; i < 8; ++i)
+    svn_stringbuf_appendstr(contents, contents);
+
+  for (i = 2; i <= rev; ++i)
+    svn_stringbuf_appendcstr(contents,
+                             apr_psprintf(pool, "Line %ld.\n", i));
+
+  return contents->data;
+}
+
 
 /* ------------------------------------------------------------------------ */
 
@@ -209,7 +272,7 @@ get_repo_stats(const svn_test_opts_t *opts,
   SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
 
   /* Gather statistics info on that repo. */
-  SVN_ERR(svn_fs_fs__get_stats(&stats, svn_repos_fs(repos), NULL, NULL,
+  SVN_ERR(svn_fs_fs__get_stats(&stats, svn_repos_fs(repos), NULL, NULL, NULL,
                                NULL, NULL, pool, pool));
 
   /* Check that the stats make sense. */
@@ -403,14 +466,14 @@ load_index(const svn_test_opts_t *opts, apr_pool_t *pool)
   APR_ARRAY_PUSH(alt_entries, svn_fs_fs__p2l_entry_t *) = &entry;
 
   SVN_ERR(svn_fs_fs__load_index(svn_repos_fs(repos), rev, alt_entries, pool));
-  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs3(repos, rev, rev, FALSE, FALSE,
-                                             NULL, NULL, NULL, NULL, NULL,
+  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs4(repos, rev, rev, FALSE, FALSE,
+                                             1, NULL, NULL, NULL, NULL, NULL,
                                              NULL, pool),
                         SVN_ERR_FS_INDEX_CORRUPTION);
 
   /* Restore the original index. */
   SVN_ERR(svn_fs_fs__load_index(svn_repos_fs(repos), rev, entries, pool));
-  SVN_ERR(svn_repos_verify_fs3(repos, rev, rev, FALSE, FALSE, NULL, NULL,
+  SVN_ERR(svn_repos_verify_fs4(repos, rev, rev, FALSE, FALSE, 1, NULL, NULL,
                                NULL, NULL, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
@@ -419,6 +482,1091 @@ load_index(const svn_test_opts_t *opts, apr_pool_t *pool)
 #undef REPO_NAME
 
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-async-reads-test"
+
+static svn_error_t *
+async_reads(const svn_test_opts_t *opts,
+            apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_revnum_t rev;
+  svn_fs_t *fs;
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__read_request_t *sync_requests, *async_requests;
+  svn_fs_fs__read_benchmark_t results;
+  svn_filesize_t filesize;
+  int i, count;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  /* Create a filesystem */
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, pool, pool));
+  SVN_ERR(svn_io_file_size_get(&filesize, rev_file->file, pool));
+
+  /* Cover the whole file with overlapping requests.  The last one will
+   * reach beyond EOF. */
+  count = (int)(filesize / 100) + 1;
+  sync_requests = apr_pcalloc(pool, count * sizeof(*sync_requests));
+  async_requests = apr_pcalloc(pool, count * sizeof(*async_requests));
+  for (i = 0; i < count; ++i)
+    {
+      sync_requests[i].offset = i * 100;
+      sync_requests[i].size = 150;
+      sync_requests[i].buffer = apr_palloc(pool, 150);
+
+      async_requests[i] = sync_requests[i];
+      async_requests[i].buffer = apr_palloc(pool, 150);
+    }
+
+  SVN_ERR(svn_fs_fs__rev_file_read_async(rev_file, sync_requests, count, 1,
+                                         pool));
+  SVN_ERR(svn_fs_fs__rev_file_read_async(rev_file, async_requests, count, 4,
+                                         pool));
+
+  /* Both must have read the same data. */
+  for (i = 0; i < count; ++i)
+    {
+      SVN_TEST_ASSERT(sync_requests[i].read == async_requests[i].read);
+      SVN_TEST_ASSERT(memcmp(sync_requests[i].buffer,
+                             async_requests[i].buffer,
+                             sync_requests[i].read) == 0);
+    }
+
+  SVN_TEST_ASSERT(sync_requests[0].read == 150);
+  SVN_TEST_ASSERT(sync_requests[count - 1].read < 150);
+
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* The benchmark must read something. */
+  SVN_ERR(svn_fs_fs__benchmark_reads(&results, fs, rev, 16, 4, NULL, NULL,
+                                     pool));
+  SVN_TEST_ASSERT(results.requests == 16);
+  SVN_TEST_ASSERT(results.bytes > 0);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-verify-concurrently-test"
+#define MAX_REV 40
+
+/* Implements svn_repos_notify_func_t.  Append a line describing NOTIFY
+ * to the svn_stringbuf_t BATON. */
+static void
+log_verify_notification(void *baton,
+                        const svn_repos_notify_t *notify,
+                        apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *log = baton;
+  svn_stringbuf_appendcstr(log,
+                           apr_psprintf(scratch_pool, "%d %ld %s\n",
+                                        (int)notify->action, notify->revision,
+                                        notify->warning_str
+                                          ? notify->warning_str : ""));
+}
+
+/* Implements svn_repos_verify_callback_t.  Append a line describing
+ * the failure to the svn_stringbuf_t BATON and continue. */
+static svn_error_t *
+log_verify_error(void *baton,
+                 svn_revnum_t revision,
+                 svn_error_t *verify_err,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *log = baton;
+  svn_stringbuf_appendcstr(log,
+                           apr_psprintf(scratch_pool, "error %ld %d\n",
+                                        revision, (int)verify_err->apr_err));
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify REPO_NAME, opening it with JOBS configured for the FS and using
+ * JOBS repository-level workers as well.  Return the log of all
+ * notifications and errors in *LOG. */
+static svn_error_t *
+verify_with_jobs(svn_stringbuf_t **log,
+                 int jobs,
+                 apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_JOBS, apr_itoa(pool, jobs));
+  SVN_ERR(svn_repos_open3(&repos, REPO_NAME, fs_config, pool, pool));
+
+  *log = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_repos_verify_fs4(repos, 0, SVN_INVALID_REVNUM, TRUE, FALSE,
+                               jobs, log_verify_notification, *log,
+                               log_verify_error, *log, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+verify_concurrently(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_revnum_t rev;
+  svn_fs_t *fs;
+  svn_stringbuf_t *sequential, *concurrent;
+  apr_array_header_t *entries = apr_array_make(pool, 41, sizeof(void *));
+  apr_array_header_t *alt_entries = apr_array_make(pool, 1, sizeof(void *));
+  svn_fs_fs__p2l_entry_t entry;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't have FSFS indexes");
+
+  /* Create a filesystem with a couple of revisions. */
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+  SVN_ERR(svn_test__add_iota_history(fs, MAX_REV, iota_contents, pool));
+
+  /* The concurrent verification must report the same as the sequential
+   * one. */
+  SVN_ERR(verify_with_jobs(&sequential, 1, pool));
+  SVN_ERR(verify_with_jobs(&concurrent, 4, pool));
+  SVN_TEST_STRING_ASSERT(concurrent->data, sequential->data);
+  SVN_TEST_ASSERT(strstr(sequential->data, "error") == NULL);
+
+  /* Corrupt the index of a revision in the middle.  Verification must
+   * continue and report the same failures, in the same order. */
+  rev = MAX_REV / 2;
+  SVN_ERR(svn_fs_fs__dump_index(fs, rev, receive_index, entries,
+                                NULL, NULL, pool));
+
+  entry = *APR_ARRAY_IDX(entries, entries->nelts-1, svn_fs_fs__p2l_entry_t *);
+  entry.size += entry.offset;
+  entry.offset = 0;
+  entry.type = SVN_FS_FS__ITEM_TYPE_UNUSED;
+  entry.item.number = SVN_FS_FS__ITEM_INDEX_UNUSED;
+  entry.item.revision = SVN_INVALID_REVNUM;
+  APR_ARRAY_PUSH(alt_entries, svn_fs_fs__p2l_entry_t *) = &entry;
+  SVN_ERR(svn_fs_fs__load_index(fs, rev, alt_entries, pool));
+
+  SVN_ERR(verify_with_jobs(&sequential, 1, pool));
+  SVN_ERR(verify_with_jobs(&concurrent, 4, pool));
+  SVN_TEST_STRING_ASSERT(concurrent->data, sequential->data);
+  SVN_TEST_ASSERT(strstr(sequential->data, "error") != NULL);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-item-offsets-test"
+
+static svn_error_t *
+item_offsets(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_revnum_t rev;
+  svn_fs_t *fs;
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_array_header_t *max_ids;
+  svn_fs_fs__id_part_t *items;
+  apr_off_t *offsets;
+  int i, count;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't have FSFS indexes");
+
+  /* Create a filesystem */
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, fs, rev, 1, pool, pool));
+  count = (int)APR_ARRAY_IDX(max_ids, 0, apr_uint64_t);
+  SVN_TEST_ASSERT(count > 2);
+
+  /* Request all items in reverse order, the last one twice. */
+  items = apr_pcalloc(pool, (count + 1) * sizeof(*items));
+  offsets = apr_pcalloc(pool, (count + 1) * sizeof(*offsets));
+  for (i = 0; i < count; ++i)
+    {
+      items[i].revision = rev;
+      items[i].number = count - i - 1;
+    }
+  items[count] = items[0];
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, pool, pool));
+  SVN_ERR(svn_fs_fs__item_offsets(offsets, fs, rev_file, items, count + 1,
+                                  pool));
+
+  /* The batch must give the same results as individual lookups. */
+  for (i = 0; i <= count; ++i)
+    {
+      apr_off_t offset;
+      SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, rev, NULL,
+                                     items[i].number, pool));
+      SVN_TEST_ASSERT(offsets[i] == offset);
+    }
+
+  /* Items must be in REV_FILE. */
+  items[1].revision = rev - 1;
+  SVN_TEST_ASSERT_ERROR(svn_fs_fs__item_offsets(offsets, fs, rev_file,
+                                                items, count, pool),
+                        SVN_ERR_FS_INDEX_REVISION);
+
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-concurrent-stats-test"
+#define SHARD_SIZE 4
+#define MAX_REV 21
+
+/* Create a packed FSFS repository at PATH with MAX_REV revisions, such
+ * that deltas reach across pack files.  Modify "iota" in each revision,
+ * using CONTENTS_FUNC for its contents.  Return the FS in *FS_P.
+ * Use OPTS and POOL as usual. */
+static svn_error_t *
+create_packed_stats_repo(svn_fs_t **fs_p,
+                         const char *path,
+                         svn_test__iota_contents_func_t contents_func,
+                         const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  SVN_ERR(svn_test__create_fs2(&fs, path, opts, fs_config, pool));
+  SVN_ERR(svn_test__add_iota_history(fs, MAX_REV, contents_func, pool));
+  SVN_ERR(svn_fs_pack2(path, NULL, NULL, NULL, NULL, NULL, pool));
+
+  *fs_p = fs;
+  return SVN_NO_ERROR;
+}
+
+/* Return statistics on the repository at PATH in *STATS, opening it with
+ * JOBS configured for the FS and using the optional SNAPSHOT_DIR.
+ * Use POOL for allocations. */
+static svn_error_t *
+get_stats_with_jobs(svn_fs_fs__stats_t **stats,
+                    const char *path,
+                    int jobs,
+                    const char *snapshot_dir,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_JOBS, apr_itoa(pool, jobs));
+  SVN_ERR(svn_fs_open2(&fs, path, fs_config, pool, pool));
+  SVN_ERR(svn_fs_fs__get_stats(stats, fs, snapshot_dir, NULL, NULL,
+                               NULL, NULL, pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that histograms LHS and RHS are identical. */
+static svn_error_t *
+compare_histograms(const svn_fs_fs__histogram_t *lhs,
+                   const svn_fs_fs__histogram_t *rhs)
+{
+  SVN_TEST_ASSERT(memcmp(lhs, rhs, sizeof(*lhs)) == 0);
+  return SVN_NO_ERROR;
+}
+
+/* Verify that LHS and RHS contain the same statistics. */
+static svn_error_t *
+compare_stats(const svn_fs_fs__stats_t *lhs,
+              const svn_fs_fs__stats_t *rhs)
+{
+  apr_hash_index_t *hi;
+  apr_size_t i;
+
+  SVN_TEST_ASSERT(lhs->total_size == rhs->total_size);
+  SVN_TEST_ASSERT(lhs->revision_count == rhs->revision_count);
+  SVN_TEST_ASSERT(lhs->change_count == rhs->change_count);
+  SVN_TEST_ASSERT(lhs->change_len == rhs->change_len);
+
+  SVN_TEST_ASSERT(memcmp(&lhs->total_rep_stats, &rhs->total_rep_stats,
+                         sizeof(lhs->total_rep_stats)) == 0);
+  SVN_TEST_ASSERT(memcmp(&lhs->file_rep_stats, &rhs->file_rep_stats,
+                         sizeof(lhs->file_rep_stats)) == 0);
+  SVN_TEST_ASSERT(memcmp(&lhs->dir_rep_stats, &rhs->dir_rep_stats,
+                         sizeof(lhs->dir_rep_stats)) == 0);
+  SVN_TEST_ASSERT(memcmp(&lhs->total_node_stats, &rhs->total_node_stats,
+                         sizeof(lhs->total_node_stats)) == 0);
+
+  SVN_ERR(compare_histograms(&lhs->rep_size_histogram,
+                             &rhs->rep_size_histogram));
+  SVN_ERR(compare_histograms(&lhs->node_size_histogram,
+                             &rhs->node_size_histogram));
+  SVN_ERR(compare_histograms(&lhs->added_rep_size_histogram,
+                             &rhs->added_rep_size_histogram));
+  SVN_ERR(compare_histograms(&lhs->unused_rep_histogram,
+                             &rhs->unused_rep_histogram));
+  SVN_ERR(compare_histograms(&lhs->file_histogram, &rhs->file_histogram));
+  SVN_ERR(compare_histograms(&lhs->dir_histogram, &rhs->dir_histogram));
+
+  SVN_TEST_ASSERT(lhs->largest_changes->count
+                  == rhs->largest_changes->count);
+  for (i = 0; i < lhs->largest_changes->count; ++i)
+    {
+      svn_fs_fs__large_change_info_t *lhs_info
+        = lhs->largest_changes->changes[i];
+      svn_fs_fs__large_change_info_t *rhs_info
+        = rhs->largest_changes->changes[i];
+
+      SVN_TEST_ASSERT(lhs_info->size == rhs_info->size);
+      SVN_TEST_ASSERT(lhs_info->revision == rhs_info->revision);
+      SVN_TEST_STRING_ASSERT(lhs_info->path->data, rhs_info->path->data);
+    }
+
+  SVN_TEST_ASSERT(apr_hash_count(lhs->by_extension)
+                  == apr_hash_count(rhs->by_extension));
+  for (hi = apr_hash_first(NULL, lhs->by_extension);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_fs_fs__extension_info_t *lhs_info = apr_hash_this_val(hi);
+      svn_fs_fs__extension_info_t *rhs_info
+        = svn_hash_gets(rhs->by_extension, apr_hash_this_key(hi));
+
+      SVN_TEST_ASSERT(rhs_info);
+      SVN_ERR(compare_histograms(&lhs_info->rep_histogram,
+                                 &rhs_info->rep_histogram));
+      SVN_ERR(compare_histograms(&lhs_info->node_histogram,
+                                 &rhs_info->node_histogram));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+concurrent_stats(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs, *other_fs;
+  const char *uuid;
+  const char *other_repo = REPO_NAME "-other";
+  svn_fs_fs__stats_t *sequential, *concurrent, *incremental;
+  svn_fs_fs__stats_t *rescanned;
+  svn_node_kind_t kind;
+  const char *snapshot_dir, *snapshot_path, *pack_path;
+  svn_stringbuf_t *contents;
+  apr_time_t mtime;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't have FSFS indexes");
+
+  SVN_ERR(create_packed_stats_repo(&fs, REPO_NAME, iota_contents,
+                                   opts, pool));
+
+  /* The concurrent scan must yield the same results as the sequential
+   * one, no matter whether pack files are being read from snapshots. */
+  snapshot_dir = svn_dirent_join(REPO_NAME, "stats-snapshots", pool);
+  SVN_ERR(get_stats_with_jobs(&sequential, REPO_NAME, 1, NULL, pool));
+  SVN_ERR(get_stats_with_jobs(&concurrent, REPO_NAME, 4, snapshot_dir,
+                              pool));
+  SVN_ERR(compare_stats(sequential, concurrent));
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(snapshot_dir, "0.stats", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  SVN_ERR(get_stats_with_jobs(&incremental, REPO_NAME, 4, snapshot_dir,
+                              pool));
+  SVN_ERR(compare_stats(sequential, incremental));
+
+  SVN_ERR(get_stats_with_jobs(&incremental, REPO_NAME, 1, snapshot_dir,
+                              pool));
+  SVN_ERR(compare_stats(sequential, incremental));
+
+  /* Truncated snapshots must be ignored and get replaced. */
+  snapshot_path = svn_dirent_join(snapshot_dir, "0.stats", pool);
+  SVN_ERR(svn_stringbuf_from_file2(&contents, snapshot_path, pool));
+  SVN_ERR(svn_io_write_atomic2(snapshot_path, contents->data,
+                               contents->len / 2, NULL, FALSE, pool));
+  SVN_ERR(get_stats_with_jobs(&incremental, REPO_NAME, 4, snapshot_dir,
+                              pool));
+  SVN_ERR(compare_stats(sequential, incremental));
+
+  /* Prove that the snapshot is being used:  Wipe the first pack file but
+   * keep its size and timestamp.  Scanning it would fail. */
+  pack_path = svn_dirent_join_many(pool, REPO_NAME, PATH_REVS_DIR,
+                                   "0" PATH_EXT_PACKED_SHARD, PATH_PACKED,
+                                   SVN_VA_NULL);
+  SVN_ERR(svn_io_file_affected_time(&mtime, pack_path, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&contents, pack_path, pool));
+  memset(contents->data, 0, contents->len);
+  SVN_ERR(svn_io_set_file_read_write(pack_path, FALSE, pool));
+  SVN_ERR(svn_io_write_atomic2(pack_path, contents->data, contents->len,
+                               NULL, FALSE, pool));
+  SVN_ERR(svn_io_set_file_affected_time(mtime, pack_path, pool));
+
+  SVN_ERR(get_stats_with_jobs(&incremental, REPO_NAME, 4, snapshot_dir,
+                              pool));
+  SVN_ERR(compare_stats(sequential, incremental));
+
+  /* A repository with the same UUID and revision range but different
+   * pack files must not pick up the snapshots of the first one.  The
+   * results must match those of a full rescan. */
+  SVN_ERR(create_packed_stats_repo(&other_fs, other_repo,
+                                   rewritten_iota_contents,
+                                   opts, pool));
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
+  SVN_ERR(svn_fs_set_uuid(other_fs, uuid, pool));
+
+  SVN_ERR(get_stats_with_jobs(&rescanned, other_repo, 1, NULL, pool));
+  SVN_ERR(get_stats_with_jobs(&incremental, other_repo, 4, snapshot_dir,
+                              pool));
+  SVN_ERR(compare_stats(rescanned, incremental));
+  SVN_TEST_ASSERT(rescanned->total_size != sequential->total_size);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-delta-chain-prefetch-test"
+#define SHARD_SIZE 16
+#define MAX_REV 15
+
+/* Open the repository at REPO_NAME with FS_CONFIG and empty caches, read
+ * the contents of "iota" in MAX_REV and return the number of I/O round
+ * trips that this took in *ROUND_TRIPS.  Use POOL for allocations. */
+static svn_error_t *
+count_iota_round_trips(apr_uint64_t *round_trips,
+                       apr_hash_t *fs_config,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *retrieved;
+  svn_filesize_t length;
+  const char *contents = growing_contents(MAX_REV, pool);
+
+  SVN_ERR(open_uncached_fs(&fs, REPO_NAME, fs_config, pool));
+
+  /* Resolve the path first such that we only count the I/O for the
+   * file contents. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, MAX_REV, pool));
+  SVN_ERR(svn_fs_file_length(&length, root, "iota", pool));
+  SVN_TEST_ASSERT(length == strlen(contents));
+
+  svn_fs_fs__reset_rep_read_round_trips(fs);
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &retrieved, pool));
+  *round_trips = svn_fs_fs__reset_rep_read_round_trips(fs);
+
+  SVN_TEST_STRING_ASSERT(retrieved->data, contents);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delta_chain_prefetch(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_uint64_t round_trips, unprefetched_round_trips;
+  apr_hash_t *fs_config;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't have FSFS indexes");
+
+  /* Build a delta chain for "iota" and put all reps of it into the same
+   * pack file. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+  SVN_ERR(svn_test__add_iota_history(fs, MAX_REV, growing_contents, pool));
+  SVN_ERR(svn_fs_pack2(REPO_NAME, NULL, NULL, NULL, NULL, NULL, pool));
+
+  /* Prefetched windows go into the delta window caches.  Without those,
+   * every rep in the chain must be read individually. */
+  SVN_ERR(count_iota_round_trips(&round_trips, NULL, pool));
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS, "0");
+  SVN_ERR(count_iota_round_trips(&unprefetched_round_trips, fs_config,
+                                 pool));
+
+  SVN_TEST_ASSERT(round_trips > 0);
+  SVN_TEST_ASSERT(round_trips < unprefetched_round_trips);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-parallel-window-reconstruction-test"
+#define MAX_REV 5
+
+/* Implements svn_test__iota_contents_func_t.  Return about 1MB of text
+ * that spans many delta windows, with a few bytes in the middle of various
+ * windows being modified in each revision. */
+static const char *
+large_contents(svn_revnum_t rev,
+               apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents = svn_stringbuf_create_ensure(1000000, pool);
+  apr_uint32_t seed = 0;
+  svn_revnum_t i;
+
+  while (contents->len < 1000000)
+    {
+      char line[10];
+
+      seed = seed * 1103515245 + 12345;
+      apr_snprintf(line, sizeof(line), "%08x\n", seed);
+      svn_stringbuf_appendbytes(contents, line, 9);
+    }
+
+  for (i = 2; i <= rev; ++i)
+    {
+      apr_size_t pos;
+      for (pos = 50000 + i * 9; pos < contents->len; pos += 150000)
+        contents->data[pos] = 'a' + (char)i;
+    }
+
+  return contents->data;
+}
+
+static svn_error_t *
+parallel_window_reconstruction(const svn_test_opts_t *opts,
+                               apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *retrieved;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  /* Modify a large "iota" a few times, such that each window needs to
+   * be combined across a delta chain. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_test__add_iota_history(fs, MAX_REV, large_contents, pool));
+
+  /* Read the file back with parallel reconstruction enabled. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_PARALLEL_WINDOWS, "4");
+  SVN_ERR(open_uncached_fs(&fs, REPO_NAME, fs_config, pool));
+  SVN_TEST_ASSERT(((fs_fs_data_t *)fs->fsap_data)->parallel_windows == 4);
+
+  /* Compare all revisions, starting with the longest delta chain. */
+  for (rev = MAX_REV; rev >= 2; --rev)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_test__get_file_contents(root, "iota", &retrieved,
+                                          iterpool));
+      SVN_TEST_STRING_ASSERT(retrieved->data,
+                             large_contents(rev, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Concurrent verification reconstructs windows from within tasks.
+   * That must not starve the task pool. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_JOBS, "4");
+  SVN_ERR(svn_fs_verify(REPO_NAME, fs_config, 0, SVN_INVALID_REVNUM,
+                        NULL, NULL, NULL, NULL, pool));
+
+  /* Invalid settings must be rejected. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_PARALLEL_WINDOWS, "-1");
+  SVN_TEST_ASSERT_ANY_ERROR(svn_fs_open2(&fs, REPO_NAME, fs_config,
+                                         pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-read-mapped-packs-test"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+
+static svn_error_t *
+read_mapped_packs(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *retrieved;
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_hash_t *fs_config;
+  apr_hash_t *changes;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't have FSFS indexes");
+
+  /* Create a few revisions with deltified file contents, properties and
+   * changed path lists.  Pack all but the last few of them. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+  SVN_ERR(svn_test__add_iota_history(fs, MAX_REV, growing_contents, pool));
+  SVN_ERR(svn_fs_pack2(REPO_NAME, NULL, NULL, NULL, NULL, NULL, pool));
+
+  /* Open the repository with mapping enabled and disjoint caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ, "1");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_MMAP, "1");
+  SVN_ERR(open_uncached_fs(&fs, REPO_NAME, fs_config, pool));
+
+#if APR_HAS_MMAP
+  /* Packed shards get mapped, the non-packed tail does not. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 1, pool, pool));
+  SVN_TEST_ASSERT(rev_file->mapped_data != NULL);
+  SVN_TEST_ASSERT(svn_fs_fs__rev_file_mapped(rev_file, 0, 1) != NULL);
+  SVN_TEST_ASSERT(svn_fs_fs__rev_file_mapped(rev_file,
+                                             rev_file->mapped_size,
+                                             1) == NULL);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+  SVN_TEST_ASSERT(rev_file->mapped_data == NULL);
+#endif
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, MAX_REV,
+                                           pool, pool));
+  SVN_TEST_ASSERT(rev_file->mapped_data == NULL);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Read everything back. */
+  for (rev = 2; rev <= MAX_REV; ++rev)
+    {
+      svn_string_t *value;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_test__get_file_contents(root, "iota", &retrieved,
+                                          iterpool));
+      SVN_TEST_STRING_ASSERT(retrieved->data,
+                             growing_contents(rev, iterpool));
+
+      SVN_ERR(svn_fs_node_prop(&value, root, "iota", "rev", iterpool));
+      SVN_TEST_STRING_ASSERT(value->data,
+                             apr_psprintf(iterpool, "%ld", rev));
+
+      SVN_ERR(svn_fs_paths_changed2(&changes, root, iterpool));
+      SVN_TEST_ASSERT(apr_hash_count(changes) == 1);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-concurrent-commits-test"
+#define THREAD_COUNT 4
+#define COMMIT_COUNT 10
+
+static svn_error_t *
+concurrent_commits(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_revnum_t youngest;
+  svn_fs_fs__commit_benchmark_t results;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Commits will race for the write lock and some of them may have
+   * their prepared proto-rev files rolled back. */
+  SVN_ERR(svn_fs_fs__benchmark_commits(&results, fs, THREAD_COUNT,
+                                       COMMIT_COUNT, NULL, NULL, pool));
+  SVN_TEST_ASSERT(results.commits == THREAD_COUNT * COMMIT_COUNT);
+  SVN_TEST_ASSERT(results.prepared - results.rolled_back <= results.commits);
+
+  /* All commits must have made it into the repository. */
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_ASSERT(youngest == THREAD_COUNT * COMMIT_COUNT);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, youngest, pool));
+  for (i = 0; i < THREAD_COUNT; ++i)
+    {
+      svn_stringbuf_t *contents;
+      SVN_ERR(svn_test__get_file_contents(root,
+                                          apr_psprintf(pool,
+                                                       "/bench-commit-%d",
+                                                       i),
+                                          &contents, pool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             apr_psprintf(pool, "committer %d, commit %d\n",
+                                          i, COMMIT_COUNT - 1));
+    }
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, SVN_INVALID_REVNUM,
+                        NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef THREAD_COUNT
+#undef COMMIT_COUNT
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-commit-rollback-test"
+
+/* Baton for committer_thread and hold_write_lock. */
+typedef struct rollback_baton_t
+{
+  /* Repository to commit to. */
+  svn_fs_t *fs;
+
+  /* The committer thread, allocated in POOL.  NULL if not started. */
+  apr_thread_t *thread;
+  apr_pool_t *pool;
+
+  /* Outcome of the committer thread. */
+  svn_fs_fs__commit_benchmark_t results;
+  svn_error_t *err;
+} rollback_baton_t;
+
+#if APR_HAS_THREADS
+/* Thread function making one commit each for two concurrent committers
+ * to the repository in the rollback_baton_t DATA. */
+static void *
+APR_THREAD_FUNC committer_thread(apr_thread_t *tid, void *data)
+{
+  rollback_baton_t *baton = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  baton->err = svn_fs_fs__benchmark_commits(&baton->results, baton->fs,
+                                            2, 1, NULL, NULL, pool);
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Implements the svn_fs_fs__with_write_lock() 'body' callback type.
+ * While holding the repository write lock, start two committers for the
+ * rollback_baton_t BATON and wait until both of them have prepared their
+ * commits for the same revision. */
+static svn_error_t *
+hold_write_lock(void *baton,
+                apr_pool_t *pool)
+{
+  rollback_baton_t *rb = baton;
+  fs_fs_data_t *ffd = rb->fs->fsap_data;
+  svn_atomic_t prepared = svn_atomic_read(&ffd->shared->prepared_commits);
+  apr_status_t status;
+  int i;
+
+  status = apr_thread_create(&rb->thread, NULL, committer_thread, rb,
+                             rb->pool);
+  if (status)
+    return svn_error_wrap_apr(status, NULL);
+
+  /* Give up after 60s.  The commits will still complete. */
+  for (i = 0; i < 6000; ++i)
+    {
+      if (svn_atomic_read(&ffd->shared->prepared_commits) - prepared >= 2)
+        return SVN_NO_ERROR;
+
+      apr_sleep(10000);
+    }
+
+  return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                          "Commits did not get prepared");
+}
+#endif
+
+static svn_error_t *
+commit_rollback(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_fs_t *fs;
+  svn_fs_root_t *root;
+  svn_revnum_t youngest;
+  svn_stringbuf_t *contents;
+  rollback_baton_t baton = { 0 };
+  svn_error_t *err;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  if (((fs_fs_data_t *)fs->fsap_data)->format
+        < SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "commits can't be prepared in this format");
+
+  /* Both committers prepare r1 while we hold the write lock.  Only one
+   * of them can get it;  the other one must roll back its proto-rev
+   * file, merge against the new youngest revision and prepare again. */
+  baton.fs = fs;
+  baton.pool = pool;
+  err = svn_fs_fs__with_write_lock(fs, hold_write_lock, &baton, pool);
+  if (baton.thread)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, baton.thread);
+    }
+
+  SVN_ERR(svn_error_compose_create(err, baton.err));
+  SVN_TEST_ASSERT(baton.results.commits == 2);
+  SVN_TEST_ASSERT(baton.results.rolled_back == 1);
+  SVN_TEST_ASSERT(baton.results.prepared == 3);
+
+  /* The merged commit must not have lost any changes. */
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_ASSERT(youngest == 2);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, youngest, pool));
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(svn_test__get_file_contents(root,
+                                          apr_psprintf(pool,
+                                                       "/bench-commit-%d",
+                                                       i),
+                                          &contents, pool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             apr_psprintf(pool, "committer %d, commit 0\n",
+                                          i));
+    }
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "this test requires threads");
+#endif
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-rep-cache-filter-test"
+
+/* Implements svn_test__iota_contents_func_t.  Return contents that are
+ * large enough to be eligible for rep-sharing. */
+static const char *
+shareable_contents(svn_revnum_t rev,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents
+    = svn_stringbuf_createf(pool, "iota in r%ld\n", rev);
+  int i;
+
+  for (i = 0; i < 7; ++i)
+    svn_stringbuf_appendstr(contents, contents);
+
+  return contents->data;
+}
+
+/* Set *REP to the rep-cache entry of FS for the contents that
+ * shareable_contents() returns for REV, or to NULL if there is none.
+ * Use POOL for allocations. */
+static svn_error_t *
+get_shareable_rep(representation_t **rep,
+                  svn_fs_t *fs,
+                  svn_revnum_t rev,
+                  apr_pool_t *pool)
+{
+  svn_checksum_t *checksum;
+  const char *contents = shareable_contents(rev, pool);
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, contents,
+                       strlen(contents), pool));
+  SVN_ERR(svn_fs_fs__get_rep_reference(rep, fs, checksum, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Append the SHA1 checksum of the contents that shareable_contents()
+ * returns for REV to CHECKSUMS.  Use POOL for allocations. */
+static svn_error_t *
+push_shareable_sha1(apr_array_header_t *checksums,
+                    svn_revnum_t rev,
+                    apr_pool_t *pool)
+{
+  svn_checksum_t *checksum;
+  const char *contents = shareable_contents(rev, pool);
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, contents,
+                       strlen(contents), pool));
+  APR_ARRAY_PUSH(checksums, svn_checksum_t *) = checksum;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+rep_cache_filter(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  fs_fs_data_t *ffd;
+  fs_fs_shared_data_t *other_shared;
+  representation_t *rep;
+  apr_array_header_t *checksums;
+  apr_hash_t *reps;
+  svn_revnum_t youngest;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  ffd->rep_sharing_allowed = TRUE;
+
+  /* Look up existing plus some unknown content. */
+  SVN_ERR(svn_test__add_iota_history(fs, 3, shareable_contents, pool));
+  SVN_ERR(get_shareable_rep(&rep, fs, 2, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 2);
+  SVN_ERR(get_shareable_rep(&rep, fs, 3, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 3);
+  SVN_ERR(get_shareable_rep(&rep, fs, 4, pool));
+  SVN_TEST_ASSERT(rep == NULL);
+
+  /* The same as a batch. */
+  checksums = apr_array_make(pool, 3, sizeof(svn_checksum_t *));
+  SVN_ERR(push_shareable_sha1(checksums, 2, pool));
+  SVN_ERR(push_shareable_sha1(checksums, 3, pool));
+  SVN_ERR(push_shareable_sha1(checksums, 4, pool));
+  SVN_ERR(svn_fs_fs__get_rep_references(&reps, fs, checksums, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(reps) == 2);
+  rep = apr_hash_get(reps,
+                     APR_ARRAY_IDX(checksums, 1, svn_checksum_t *)->digest,
+                     APR_SHA1_DIGESTSIZE);
+  SVN_TEST_ASSERT(rep && rep->revision == 3);
+
+  /* Entries added after the rep-cache filter has been created must be
+     found as well. */
+  SVN_ERR(svn_test__add_iota_history(fs, 4, shareable_contents, pool));
+  SVN_ERR(get_shareable_rep(&rep, fs, 4, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 4);
+  SVN_ERR(get_shareable_rep(&rep, fs, 2, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 2);
+  SVN_ERR(svn_fs_fs__get_rep_references(&reps, fs, checksums, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(reps) == 3);
+
+  /* Let another "process" remove the latest entries, as recovery does,
+     and add new ones.  Those reuse the ROWIDs of the removed rows, which
+     the incremental filter refresh must not miss. */
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  ffd = fs2->fsap_data;
+  ffd->rep_sharing_allowed = TRUE;
+  other_shared = apr_pmemdup(pool, ffd->shared, sizeof(*other_shared));
+  other_shared->rep_cache_filter = NULL;
+  ffd->shared = other_shared;
+
+  SVN_ERR(svn_fs_fs__del_rep_reference(fs2, 2, pool));
+  SVN_ERR(svn_test__add_iota_history(fs2, 5, shareable_contents, pool));
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_ASSERT(youngest == 5);
+  SVN_ERR(get_shareable_rep(&rep, fs, 5, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 5);
+  SVN_ERR(get_shareable_rep(&rep, fs, 4, pool));
+  SVN_TEST_ASSERT(rep == NULL);
+  SVN_ERR(get_shareable_rep(&rep, fs, 2, pool));
+  SVN_TEST_ASSERT(rep && rep->revision == 2);
+
+  /* Removing entries in this process drops the filter right away. */
+  SVN_ERR(svn_fs_fs__del_rep_reference(fs, 2, pool));
+  SVN_ERR(get_shareable_rep(&rep, fs, 5, pool));
+  SVN_TEST_ASSERT(rep == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
 
 /* The test table.  */
 
@@ -433,6 +1581,26 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "dump the P2L index"),
     SVN_TEST_OPTS_PASS(load_index,
                        "load the P2L index"),
+    SVN_TEST_OPTS_PASS(async_reads,
+                       "concurrent reads from a rev file"),
+    SVN_TEST_OPTS_PASS(verify_concurrently,
+                       "verify revisions concurrently"),
+    SVN_TEST_OPTS_PASS(item_offsets,
+                       "batched l2p index lookups"),
+    SVN_TEST_OPTS_PASS(concurrent_stats,
+                       "concurrent and incremental statistics"),
+    SVN_TEST_OPTS_PASS(delta_chain_prefetch,
+                       "prefetch delta chains from packed shards"),
+    SVN_TEST_OPTS_PASS(parallel_window_reconstruction,
+                       "reconstruct delta windows in parallel"),
+    SVN_TEST_OPTS_PASS(read_mapped_packs,
+                       "read from memory-mapped pack files"),
+    SVN_TEST_OPTS_PASS(concurrent_commits,
+                       "concurrent commits with pipelining"),
+    SVN_TEST_OPTS_PASS(commit_rollback,
+                       "roll back and retry a prepared commit"),
+    SVN_TEST_OPTS_PASS(rep_cache_filter,
+                       "rep-cache lookups through the filter"),
     SVN_TEST_NULL
   };
 
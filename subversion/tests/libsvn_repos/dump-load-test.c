@@ -77,7 +77,7 @@ test_dump_bad_props(svn_stringbuf_t **dump_data_p,
 
   /* Test that a dump completes without error. */
   SVN_ERR(svn_repos_dump_fs4(repos, stream, start_rev, end_rev,
-                             FALSE, FALSE, TRUE, TRUE,
+                             FALSE, FALSE, TRUE, TRUE, 1,
                              notify_func, notify_baton,
                              NULL, NULL,
                              pool));
@@ -120,13 +120,14 @@ test_load_bad_props(svn_stringbuf_t *dump_data,
   svn_revnum_t youngest_rev;
   svn_string_t *loaded_prop_val;
 
-  SVN_ERR(svn_repos_load_fs5(repos, stream,
+  SVN_ERR(svn_repos_load_fs6(repos, stream,
                              SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
                              svn_repos_load_uuid_default,
                              parent_fspath,
                              FALSE, FALSE, /*use_*_commit_hook*/
                              validate_props,
                              FALSE /*ignore_dates*/,
+                             1 /*jobs*/,
                              notify_func, notify_baton,
                              NULL, NULL, /*cancellation*/
                              pool));
@@ -272,6 +273,391 @@ test_load_r0_mergeinfo(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_repos_notify_func_t.  Append a line describing NOTIFY
+ * to the svn_stringbuf_t * BATON. */
+static void
+record_notify_func(void *baton,
+                   const svn_repos_notify_t *notify,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *notifications = baton;
+
+  svn_stringbuf_appendcstr(notifications,
+                           apr_psprintf(scratch_pool, "%d r%ld %d %s\n",
+                                        (int)notify->action,
+                                        notify->revision,
+                                        (int)notify->warning,
+                                        notify->warning_str
+                                          ? notify->warning_str
+                                          : "-"));
+}
+
+/* Implements svn_repos_notify_func_t.  Append a line describing the
+ * load notification NOTIFY to the svn_stringbuf_t * BATON. */
+static void
+record_load_notify_func(void *baton,
+                        const svn_repos_notify_t *notify,
+                        apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *notifications = baton;
+
+  svn_stringbuf_appendcstr(notifications,
+                           apr_psprintf(scratch_pool, "%d r%ld r%ld %d %s\n",
+                                        (int)notify->action,
+                                        notify->new_revision,
+                                        notify->old_revision,
+                                        (int)notify->node_action,
+                                        notify->path ? notify->path : "-"));
+}
+
+/* Load DUMP_DATA into a new repository named NAME using JOBS threads and
+ * return a description of all notifications in *NOTIFICATIONS_P.
+ * Use OPTS to create the repository and POOL for all allocations. */
+static svn_error_t *
+load_with_jobs(svn_stringbuf_t **notifications_p,
+               const char *name,
+               svn_stringbuf_t *dump_data,
+               int jobs,
+               const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_stringbuf_t *notifications = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(dump_data, pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, name, opts, pool));
+  SVN_ERR(svn_repos_load_fs6(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_default, NULL,
+                             FALSE, FALSE, TRUE, FALSE, jobs,
+                             record_load_notify_func, notifications,
+                             NULL, NULL, pool));
+
+  *notifications_p = notifications;
+  return SVN_NO_ERROR;
+}
+
+/* Load DUMP_DATA sequentially and with JOBS threads into new repositories
+ * whose names start with NAME and verify that both produce the same
+ * notifications.  Use OPTS to create the repositories and POOL for
+ * temporary allocations. */
+static svn_error_t *
+compare_loads(const char *name,
+              svn_stringbuf_t *dump_data,
+              int jobs,
+              const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *expected, *actual;
+
+  SVN_ERR(load_with_jobs(&expected,
+                         apr_pstrcat(pool, name, "-sequential", SVN_VA_NULL),
+                         dump_data, 1, opts, pool));
+  SVN_ERR(load_with_jobs(&actual,
+                         apr_pstrcat(pool, name, "-pipelined", SVN_VA_NULL),
+                         dump_data, jobs, opts, pool));
+
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Load the greek tree, followed by a few changes to it, from a dump
+ * with text deltas using a pipelined loader. */
+static svn_error_t *
+test_load_pipelined(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *dump_data = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  svn_string_t *prop_val;
+  svn_stringbuf_t *truncated;
+  const char *props_end;
+  static svn_test__txn_script_command_t script_entries[] = {
+    { 'e', "iota",      "Changed file 'iota'.\n" },
+    { 'e', "A/D/G/pi",  "Changed file 'pi'.\n" },
+    { 'a', "A/D/foo",   "New file 'foo'.\n" },
+    { 'd', "A/D/H",     NULL },
+    { 'd', "A/B/E/beta", NULL }
+  };
+  static svn_test__tree_entry_t expected_entries[] = {
+    { "iota",        "Changed file 'iota'.\n" },
+    { "A",           0 },
+    { "A/mu",        "This is the file 'mu'.\n" },
+    { "A/B",         0 },
+    { "A/B/lambda",  "This is the file 'lambda'.\n" },
+    { "A/B/E",       0 },
+    { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+    { "A/B/F",       0 },
+    { "A/C",         0 },
+    { "A/D",         0 },
+    { "A/D/foo",     "New file 'foo'.\n" },
+    { "A/D/gamma",   "This is the file 'gamma'.\n" },
+    { "A/D/G",       0 },
+    { "A/D/G/pi",    "Changed file 'pi'.\n" },
+    { "A/D/G/rho",   "This is the file 'rho'.\n" },
+    { "A/D/G/tau",   "This is the file 'tau'.\n" },
+  };
+
+  /* Create the source repository and dump it with text deltas. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-pipelined-1",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__txn_script_exec(root, script_entries,
+                                    sizeof(script_entries)
+                                      / sizeof(script_entries[0]),
+                                    pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "/A/mu", "test-prop",
+                                  svn_string_create("value", pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  stream = svn_stream_from_stringbuf(dump_data, pool);
+  SVN_ERR(svn_repos_dump_fs4(repos, stream, SVN_INVALID_REVNUM,
+                             SVN_INVALID_REVNUM, FALSE, TRUE, TRUE, TRUE,
+                             1, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* Load it into an empty repository and compare the results. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-pipelined-2",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  stream = svn_stream_from_stringbuf(dump_data, pool);
+  SVN_ERR(svn_repos_load_fs6(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_default, NULL,
+                             FALSE, FALSE, TRUE, FALSE, 3,
+                             NULL, NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, fs, pool));
+  SVN_TEST_INT_ASSERT(youngest_rev, 2);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, youngest_rev, pool));
+  SVN_ERR(svn_test__validate_tree(root, expected_entries,
+                                  sizeof(expected_entries)
+                                    / sizeof(expected_entries[0]),
+                                  pool));
+  SVN_ERR(svn_fs_node_prop(&prop_val, root, "/A/mu", "test-prop", pool));
+  SVN_TEST_STRING_ASSERT(prop_val ? prop_val->data : NULL, "value");
+
+  /* The pipelined loader must report the same as the sequential one. */
+  SVN_ERR(compare_loads("test-repo-load-pipelined-4", dump_data, 3, opts,
+                        pool));
+
+  /* A dump truncated within a property block must be reported as such. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-pipelined-3",
+                                 opts, pool));
+  for (props_end = strstr(dump_data->data, "PROPS-END");
+       props_end && strstr(props_end + 1, "PROPS-END");
+       props_end = strstr(props_end + 1, "PROPS-END"))
+    ;
+  SVN_TEST_ASSERT(props_end);
+  truncated = svn_stringbuf_ncreate(dump_data->data,
+                                    props_end - dump_data->data, pool);
+  stream = svn_stream_from_stringbuf(truncated, pool);
+  SVN_TEST_ASSERT_ANY_ERROR(svn_repos_load_fs6(repos, stream,
+                                               SVN_INVALID_REVNUM,
+                                               SVN_INVALID_REVNUM,
+                                               svn_repos_load_uuid_default,
+                                               NULL, FALSE, FALSE, TRUE,
+                                               FALSE, 3, NULL, NULL,
+                                               NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Dump revisions START_REV to END_REV of REPOS using JOBS threads and
+ * return the dump data in *DUMP_DATA_P and a description of all
+ * notifications in *NOTIFICATIONS_P, both allocated in POOL. */
+static svn_error_t *
+dump_with_jobs(svn_stringbuf_t **dump_data_p,
+               svn_stringbuf_t **notifications_p,
+               svn_repos_t *repos,
+               svn_revnum_t start_rev,
+               svn_revnum_t end_rev,
+               svn_boolean_t incremental,
+               int jobs,
+               apr_pool_t *pool)
+{
+  svn_stringbuf_t *dump_data = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *notifications = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(dump_data, pool);
+
+  SVN_ERR(svn_repos_dump_fs4(repos, stream, start_rev, end_rev,
+                             incremental, TRUE, TRUE, TRUE, jobs,
+                             record_notify_func, notifications,
+                             NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  *dump_data_p = dump_data;
+  *notifications_p = notifications;
+  return SVN_NO_ERROR;
+}
+
+/* Dump revisions START_REV to END_REV of REPOS sequentially and with
+ * JOBS threads and verify that both produce the same dump data and
+ * notifications.  Use POOL for temporary allocations. */
+static svn_error_t *
+compare_dumps(svn_repos_t *repos,
+              svn_revnum_t start_rev,
+              svn_revnum_t end_rev,
+              svn_boolean_t incremental,
+              int jobs,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *expected, *actual;
+  svn_stringbuf_t *expected_notifications, *actual_notifications;
+
+  SVN_ERR(dump_with_jobs(&expected, &expected_notifications, repos,
+                         start_rev, end_rev, incremental, 1, pool));
+  SVN_ERR(dump_with_jobs(&actual, &actual_notifications, repos,
+                         start_rev, end_rev, incremental, jobs, pool));
+
+  SVN_TEST_ASSERT(svn_stringbuf_compare(expected, actual));
+  SVN_TEST_STRING_ASSERT(actual_notifications->data,
+                         expected_notifications->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of revisions in the repository of test_dump_concurrently().
+ * This must exceed the number of revisions that the concurrent dump
+ * buffers at any time. */
+#define CONCURRENT_DUMP_REVS 80
+
+/* Size of the large file in test_dump_concurrently().  Its dump data
+ * must not fit into the per-revision memory buffer of the concurrent
+ * dump. */
+#define CONCURRENT_DUMP_LARGE_FILE (3 * 1024 * 1024)
+
+/* Test that dumping revisions concurrently produces the same output as
+ * a sequential dump. */
+static svn_error_t *
+test_dump_concurrently(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *large;
+  svn_stringbuf_t *dump_data, *notifications;
+  apr_uint32_t seed = 1;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dump-concurrently",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Add a few revisions that modify, copy and delete nodes.  Some copies
+     are from r1, i.e. from before the start of partial dumps. */
+  for (i = 0; youngest_rev < CONCURRENT_DUMP_REVS; ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "/A/file%d", i);
+
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "/iota",
+                                          apr_psprintf(iterpool,
+                                                       "iota %d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, path, path, iterpool));
+      if (i % 5 == 4)
+        {
+          svn_fs_root_t *rev_root;
+          SVN_ERR(svn_fs_revision_root(&rev_root, fs,
+                                       i % 10 == 9 ? 1 : youngest_rev,
+                                       iterpool));
+          SVN_ERR(svn_fs_copy(rev_root, "/A/B",
+                              root, apr_psprintf(iterpool, "/B%d", i),
+                              iterpool));
+          SVN_ERR(svn_fs_delete(root,
+                                apr_psprintf(iterpool, "/A/file%d", i - 1),
+                                iterpool));
+        }
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      iterpool));
+
+      /* A revision whose dump data gets spilled to disk.  Its contents
+         must not compress well. */
+      if (youngest_rev == CONCURRENT_DUMP_REVS / 2)
+        {
+          large = svn_stringbuf_create_ensure(CONCURRENT_DUMP_LARGE_FILE,
+                                              iterpool);
+          while (large->len < CONCURRENT_DUMP_LARGE_FILE)
+            {
+              seed = seed * 1103515245 + 12345;
+              svn_stringbuf_appendbyte(large, (char)('a' + (seed >> 16) % 26));
+            }
+
+          SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, iterpool));
+          SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+          SVN_ERR(svn_fs_make_file(root, "/large", iterpool));
+          SVN_ERR(svn_test__set_file_contents(root, "/large", large->data,
+                                              iterpool));
+          SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                          iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Full dump, covering many more revisions than the lanes may get
+     ahead of the output. */
+  SVN_ERR(compare_dumps(repos, SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                        FALSE, 4, pool));
+  SVN_ERR(compare_dumps(repos, SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                        FALSE, 2, pool));
+
+  /* Partial, non-incremental dump starting with a full tree. */
+  SVN_ERR(compare_dumps(repos, 7, youngest_rev, FALSE, 3, pool));
+
+  /* Incremental dump.  This references data from before r7. */
+  SVN_ERR(compare_dumps(repos, 7, youngest_rev, TRUE, 2, pool));
+  SVN_ERR(dump_with_jobs(&dump_data, &notifications, repos, 7,
+                         youngest_rev, TRUE, 2, pool));
+  SVN_TEST_ASSERT(strstr(notifications->data,
+                         "older than the oldest dumped revision"));
+
+  /* Loading the full dump reports the same, pipelined or not. */
+  SVN_ERR(dump_with_jobs(&dump_data, &notifications, repos,
+                         SVN_INVALID_REVNUM, SVN_INVALID_REVNUM, FALSE, 1,
+                         pool));
+  SVN_ERR(compare_loads("test-repo-dump-concurrently-load", dump_data, 3,
+                        opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef CONCURRENT_DUMP_REVS
+#undef CONCURRENT_DUMP_LARGE_FILE
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -283,6 +669,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test dumping with r0 mergeinfo"),
     SVN_TEST_OPTS_PASS(test_load_r0_mergeinfo,
                        "test loading with r0 mergeinfo"),
+    SVN_TEST_OPTS_PASS(test_load_pipelined,
+                       "test pipelined loading of deltas"),
+    SVN_TEST_OPTS_PASS(test_dump_concurrently,
+                       "test dumping revisions concurrently"),
     SVN_TEST_NULL
   };
 
@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
 
 #include "../svn_test.h"
 
@@ -33,12 +34,14 @@
 #include "svn_repos.h"
 #include "svn_path.h"
 #include "svn_delta.h"
+#include "svn_dirent_uri.h"
 #include "svn_config.h"
 #include "svn_props.h"
 #include "svn_sorts.h"
 #include "svn_version.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_fspath.h"
 
 /* be able to look into svn_config_t */
 #include "../../libsvn_subr/config_impl.h"
@@ -1091,10 +1094,10 @@ rmlocks(const svn_test_opts_t *opts,
     SVN_ERR(create_rmlocks_editor(&editor, &edit_baton, &removed, subpool));
 
     /* Report what we have. */
-    SVN_ERR(svn_repos_begin_report3(&report_baton, 1, repos, "/", "", NULL,
+    SVN_ERR(svn_repos_begin_report4(&report_baton, 1, repos, "/", "", NULL,
                                     FALSE, svn_depth_infinity, FALSE, FALSE,
-                                    editor, edit_baton, NULL, NULL, 1024,
-                                    subpool));
+                                    editor, edit_baton, NULL, NULL, NULL,
+                                    1024, subpool));
     SVN_ERR(svn_repos_set_path3(report_baton, "", 1,
                                 svn_depth_infinity,
                                 FALSE, NULL, subpool));
@@ -1893,6 +1896,234 @@ groups_authz(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Test authz lookups for many users, nested groups, aliases and
+   repository-specific sections. */
+static svn_error_t *
+authz_many_users(apr_pool_t *pool)
+{
+  svn_authz_t *authz_cfg;
+  const char *contents;
+  svn_boolean_t access_granted;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  struct check_access_tests test_set[] = {
+    /* global rules apply unless a repository-specific one does */
+    { "/trunk/a/b/c", "greek", "alice", svn_authz_write, TRUE },
+    { "/trunk/a", "greek", "bob", svn_authz_write, FALSE },
+    { "/trunk/a", "other", "bob", svn_authz_write, TRUE },
+    /* aliases within groups */
+    { "/trunk/a", "greek", "carol", svn_authz_write, TRUE },
+    { "/trunk/secret/x", "greek", "carol", svn_authz_read, FALSE },
+    { "/trunk/secret/x", "greek", "alice", svn_authz_read, TRUE },
+    { "/trunk/secretive", "greek", "dave", svn_authz_read, TRUE },
+    /* recursive lookups only consider rules for the same repository */
+    { "/trunk", "greek", "alice", svn_authz_read | svn_authz_recursive,
+      TRUE },
+    { "/trunk", "other", "alice", svn_authz_read | svn_authz_recursive,
+      FALSE },
+    { "/", "greek", "dave", svn_authz_read | svn_authz_recursive, FALSE },
+    { "/trunk/secretive", "greek", "dave",
+      svn_authz_read | svn_authz_recursive, TRUE },
+    /* anonymous access */
+    { "/x", "greek", NULL, svn_authz_read, TRUE },
+    { "/x", "greek", NULL, svn_authz_write, FALSE },
+    /* access to any path */
+    { NULL, "greek", "dave", svn_authz_write, FALSE },
+    { NULL, "greek", "alice", svn_authz_write, TRUE },
+    { NULL, "greek", NULL, svn_authz_read, TRUE },
+    /* no rule is conclusive without read or write access being asked for */
+    { "/trunk", "greek", "alice", svn_authz_none, FALSE },
+    { "/trunk", "greek", "alice", svn_authz_recursive, FALSE },
+    { NULL, "greek", "alice", svn_authz_recursive, FALSE },
+    /* Sentinel */
+    { NULL, NULL, NULL, svn_authz_none, FALSE }
+  };
+
+  contents =
+    "[groups]"                                                               NL
+    "staff = &admin, @devs"                                                  NL
+    "devs = alice, bob"                                                      NL
+    ""                                                                       NL
+    "[aliases]"                                                              NL
+    "admin = carol"                                                          NL
+    ""                                                                       NL
+    "[/]"                                                                    NL
+    "* = r"                                                                  NL
+    ""                                                                       NL
+    "[/trunk]"                                                               NL
+    "@staff = rw"                                                            NL
+    ""                                                                       NL
+    "[greek:/trunk]"                                                         NL
+    "bob = r"                                                                NL
+    ""                                                                       NL
+    "[/trunk/secret]"                                                        NL
+    "* ="                                                                    NL
+    "@devs = r"                                                              NL
+    ""                                                                       NL
+    "[other:/trunk/secret/deep]"                                             NL
+    "alice ="                                                                NL
+    ""                                                                       NL;
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+  SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+
+  /* Lots of different users, more than we keep filtered rules for.
+     Repeat the lookups to use the rules filtered for each user. */
+  for (i = 0; i < 3000; i++)
+    {
+      const char *user;
+
+      svn_pool_clear(iterpool);
+      user = apr_psprintf(iterpool, "user%d", i / 2);
+
+      SVN_ERR(svn_repos_authz_check_access(authz_cfg, "greek", "/trunk/x",
+                                           user, svn_authz_read,
+                                           &access_granted, iterpool));
+      SVN_TEST_ASSERT(access_granted);
+
+      SVN_ERR(svn_repos_authz_check_access(authz_cfg, "greek", "/trunk/x",
+                                           user, svn_authz_write,
+                                           &access_granted, iterpool));
+      SVN_TEST_ASSERT(!access_granted);
+    }
+
+  /* Nothing changes for the users we saw first. */
+  SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+/* Baton for authz_checker_thread(). */
+typedef struct authz_checker_t
+{
+  /* The shared authz rules. */
+  svn_authz_t *authz;
+
+  /* Number of this checker.  Determines the users that it checks for. */
+  int id;
+
+  /* The first error that the checker encountered, if any. */
+  svn_error_t *err;
+} authz_checker_t;
+
+/* Check access for a sequence of users that overlaps with the users of
+   other checkers, as described by CHECKER. */
+static svn_error_t *
+authz_check_users(authz_checker_t *checker)
+{
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_boolean_t access_granted;
+  int i;
+
+  for (i = 0; i < 3000; i++)
+    {
+      const char *user;
+
+      svn_pool_clear(iterpool);
+      user = apr_psprintf(iterpool, "user%d", (i + checker->id * 500) % 2000);
+
+      SVN_ERR(svn_repos_authz_check_access(checker->authz, "greek",
+                                           "/trunk/x", user, svn_authz_write,
+                                           &access_granted, iterpool));
+      SVN_TEST_ASSERT(access_granted);
+
+      SVN_ERR(svn_repos_authz_check_access(checker->authz, "greek",
+                                           "/trunk/secret/x", user,
+                                           svn_authz_read,
+                                           &access_granted, iterpool));
+      SVN_TEST_ASSERT(!access_granted);
+
+      SVN_ERR(svn_repos_authz_check_access(checker->authz, "greek",
+                                           "/trunk/secret/x", "alice",
+                                           svn_authz_read,
+                                           &access_granted, iterpool));
+      SVN_TEST_ASSERT(access_granted);
+    }
+
+  svn_pool_destroy(pool);
+  return SVN_NO_ERROR;
+}
+
+/* Thread function running authz_check_users() for the authz_checker_t
+   given as DATA. */
+static void * APR_THREAD_FUNC
+authz_checker_thread(apr_thread_t *tid, void *data)
+{
+  authz_checker_t *checker = data;
+
+  checker->err = authz_check_users(checker);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+#endif
+
+/* Test authz lookups from several threads sharing the same rules, with
+   more users than we keep filtered rules for. */
+static svn_error_t *
+authz_concurrent_users(apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  enum { THREAD_COUNT = 4 };
+  svn_authz_t *authz_cfg;
+  authz_checker_t checkers[THREAD_COUNT];
+  apr_thread_t *threads[THREAD_COUNT];
+  svn_error_t *err = SVN_NO_ERROR;
+  const char *contents;
+  int i;
+
+  contents =
+    "[groups]"                                                               NL
+    "admins = alice"                                                         NL
+    ""                                                                       NL
+    "[/trunk]"                                                               NL
+    "* = rw"                                                                 NL
+    ""                                                                       NL
+    "[/trunk/secret]"                                                        NL
+    "* ="                                                                    NL
+    "@admins = r"                                                            NL
+    ""                                                                       NL;
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+
+  for (i = 0; i < THREAD_COUNT; ++i)
+    {
+      apr_status_t status;
+
+      checkers[i].authz = authz_cfg;
+      checkers[i].id = i;
+      checkers[i].err = SVN_NO_ERROR;
+
+      status = apr_thread_create(&threads[i], NULL, authz_checker_thread,
+                                 &checkers[i], pool);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't create thread");
+    }
+
+  for (i = 0; i < THREAD_COUNT; ++i)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, threads[i]);
+
+      if (status)
+        return svn_error_wrap_apr(status, "Can't join thread");
+
+      err = svn_error_compose_create(err, checkers[i].err);
+    }
+
+  return svn_error_trace(err);
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "this test requires thread support");
+#endif
+}
+
 /* Callback for the commit editor tests that relays requests to
    authz. */
 static svn_error_t *
@@ -2626,9 +2857,9 @@ reporter_depth_exclude(const svn_test_opts_t *opts,
   SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
                                txn_root, "", subpool));
 
-  SVN_ERR(svn_repos_begin_report3(&report_baton, 2, repos, "/", "", NULL,
+  SVN_ERR(svn_repos_begin_report4(&report_baton, 2, repos, "/", "", NULL,
                                   TRUE, svn_depth_infinity, FALSE, FALSE,
-                                  editor, edit_baton, NULL, NULL, 0,
+                                  editor, edit_baton, NULL, NULL, NULL, 0,
                                   subpool));
   SVN_ERR(svn_repos_set_path3(report_baton, "", 1,
                               svn_depth_infinity,
@@ -2684,9 +2915,9 @@ reporter_depth_exclude(const svn_test_opts_t *opts,
   SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
                                txn_root, "", subpool));
 
-  SVN_ERR(svn_repos_begin_report3(&report_baton, 2, repos, "/", "", NULL,
+  SVN_ERR(svn_repos_begin_report4(&report_baton, 2, repos, "/", "", NULL,
                                   TRUE, svn_depth_infinity, FALSE, FALSE,
-                                  editor, edit_baton, NULL, NULL, 0,
+                                  editor, edit_baton, NULL, NULL, NULL, 0,
                                   subpool));
   SVN_ERR(svn_repos_set_path3(report_baton, "", 1,
                               svn_depth_infinity,
@@ -2735,6 +2966,144 @@ reporter_depth_exclude(const svn_test_opts_t *opts,
 
 
 
+/* Baton for the reporter_subtree_authz test's authz callbacks. */
+struct subtree_authz_baton_t
+{
+  /* Fspath of the only unreadable subtree. */
+  const char *deny;
+
+  /* Number of per-path checks made so far. */
+  int path_checks;
+};
+
+/* Implements svn_repos_authz_func_t, denying BATON->deny and everything
+   below it. */
+static svn_error_t *
+subtree_authz_read_func(svn_boolean_t *allowed,
+                        svn_fs_root_t *root,
+                        const char *path,
+                        void *baton,
+                        apr_pool_t *pool)
+{
+  struct subtree_authz_baton_t *b = baton;
+
+  b->path_checks++;
+  *allowed = svn_fspath__skip_ancestor(b->deny, path) == NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_authz_subtree_func_t for the same rules as
+   subtree_authz_read_func. */
+static svn_error_t *
+subtree_authz_subtree_func(svn_boolean_t *readable,
+                           svn_fs_root_t *root,
+                           const char *path,
+                           void *baton,
+                           apr_pool_t *pool)
+{
+  struct subtree_authz_baton_t *b = baton;
+
+  *readable = svn_fspath__skip_ancestor(b->deny, path) == NULL
+              && svn_fspath__skip_ancestor(path, b->deny) == NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run an update from r0 to r1 of the greek tree in REPOS with /A/D/G
+   being unreadable, recording the editor drive in a txn and validating
+   its contents.  Pass SUBTREE_FUNC to the reporter and return the number
+   of per-path authz checks in *PATH_CHECKS. */
+static svn_error_t *
+update_with_subtree_authz(int *path_checks,
+                          svn_repos_t *repos,
+                          svn_repos_authz_subtree_func_t subtree_func,
+                          apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  struct subtree_authz_baton_t baton = { "/A/D/G", 0 };
+  static svn_test__tree_entry_t entries[] = {
+    { "iota",        "This is the file 'iota'.\n" },
+    { "A",           0 },
+    { "A/mu",        "This is the file 'mu'.\n" },
+    { "A/B",         0 },
+    { "A/B/lambda",  "This is the file 'lambda'.\n" },
+    { "A/B/E",       0 },
+    { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+    { "A/B/E/beta",  "This is the file 'beta'.\n" },
+    { "A/B/F",       0 },
+    { "A/C",         0 },
+    { "A/D",         0 },
+    { "A/D/gamma",   "This is the file 'gamma'.\n" },
+    { "A/D/H",       0 },
+    { "A/D/H/chi",   "This is the file 'chi'.\n" },
+    { "A/D/H/psi",   "This is the file 'psi'.\n" },
+    { "A/D/H/omega", "This is the file 'omega'.\n" }
+  };
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", pool));
+
+  SVN_ERR(svn_repos_begin_report4(&report_baton, 1, repos, "/", "", NULL,
+                                  TRUE, svn_depth_infinity, FALSE, FALSE,
+                                  editor, edit_baton,
+                                  subtree_authz_read_func, subtree_func,
+                                  &baton, 0, pool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "", 0, svn_depth_infinity,
+                              FALSE, NULL, pool));
+  SVN_ERR(svn_repos_finish_report(report_baton, pool));
+
+  /* Everything but the unreadable A/D/G must have been sent. */
+  SVN_ERR(svn_test__validate_tree(txn_root, entries,
+                                  sizeof(entries)/sizeof(entries[0]),
+                                  pool));
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  *path_checks = baton.path_checks;
+  return SVN_NO_ERROR;
+}
+
+/* Test that the reporter skips per-path authz checks inside subtrees
+   that are readable as a whole, without changing what gets sent. */
+static svn_error_t *
+reporter_subtree_authz(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  int path_checks, subtree_path_checks;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-reporter-subtree-authz",
+                                 opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, svn_repos_fs(repos), 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  SVN_ERR(update_with_subtree_authz(&path_checks, repos, NULL, pool));
+  SVN_ERR(update_with_subtree_authz(&subtree_path_checks, repos,
+                                    subtree_authz_subtree_func, pool));
+
+  /* Only the anchor, the entries of "/", "/A" and "/A/D" need
+     individual checks once whole subtrees are known to be readable. */
+  SVN_TEST_INT_ASSERT(path_checks, 18);
+  SVN_TEST_INT_ASSERT(subtree_path_checks, 10);
+
+  return SVN_NO_ERROR;
+}
+
+
+
 /* Test if prop values received by the server are validated.
  * These tests "send" property values to the server and diagnose the
  * behaviour.
@@ -2972,6 +3341,368 @@ get_logs(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Log receiver which appends the revision numbers to the
+   svn_stringbuf_t * in BATON. */
+static svn_error_t *
+log_revs_receiver(void *baton,
+                  svn_log_entry_t *log_entry,
+                  apr_pool_t *pool)
+{
+  svn_stringbuf_t *revs = baton;
+
+  svn_stringbuf_appendcstr(revs, apr_psprintf(pool, " %ld",
+                                              log_entry->revision));
+  return SVN_NO_ERROR;
+}
+
+/* Return the logs of a number of paths in REPOS as a single string,
+   allocated in RESULT_POOL. */
+static svn_error_t *
+get_path_logs(const char **logs,
+              svn_repos_t *repos,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  static const char *const paths[] =
+    {
+      "A", "A/mu", "A/B", "A/B/E", "A/B/E/alpha", "A/B2", "A/B2/E",
+      "A/B2/E/alpha", "A/B2/E/beta", "A/B3", "A/B3/E", "A/B3/E/alpha",
+      "A/D", "A/D/G", "A/D/G/new", "iota2", "iota3",
+      NULL
+    };
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(result_pool);
+  svn_revnum_t youngest_rev;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i, strict;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, svn_repos_fs(repos),
+                              scratch_pool));
+
+  for (i = 0; paths[i]; i++)
+    for (strict = 0; strict < 2; strict++)
+      {
+        apr_array_header_t *targets;
+
+        svn_pool_clear(iterpool);
+        targets = apr_array_make(iterpool, 1, sizeof(const char *));
+        APR_ARRAY_PUSH(targets, const char *) = paths[i];
+
+        svn_stringbuf_appendcstr(result, apr_psprintf(iterpool, "\n%s%s:",
+                                                      paths[i],
+                                                      strict ? "!" : ""));
+        SVN_ERR(svn_repos_get_logs4(repos, targets, youngest_rev, 0, 0,
+                                    FALSE, strict, FALSE, NULL, NULL, NULL,
+                                    log_revs_receiver, result, iterpool));
+
+        /* With a limit and a lower bound that is not 0. */
+        svn_stringbuf_appendcstr(result, " /");
+        SVN_ERR(svn_repos_get_logs4(repos, targets, youngest_rev, 2, 3,
+                                    FALSE, strict, FALSE, NULL, NULL, NULL,
+                                    log_revs_receiver, result, iterpool));
+      }
+
+  svn_pool_destroy(iterpool);
+  *logs = result->data;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_logs_with_index(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_repos_t *other_repos;
+  svn_revnum_t youngest_rev = 0, other_youngest;
+  svn_revnum_t indexed, previous;
+  const char *expected, *actual, *other_path, *uuid;
+  svn_stringbuf_t *dump;
+  int i;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  apr_pool_t *other_pool;
+
+  /* Create a filesystem and repository. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-get-logs-with-index",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Revision 2:  Tweak A/mu and A/B/E/alpha. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                      "Revision 2", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/alpha",
+                                      "Revision 2", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Revision 3:  Copy A/B to A/B2 and modify the copy. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/B", txn_root, "A/B2", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B2/E/beta",
+                                      "Revision 3", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Revision 4:  Rename iota to iota2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_copy(rev_root, "iota", txn_root, "iota2", subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "iota", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Revision 5:  Replace A/D/G with a new directory. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D/G", subpool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A/D/G", subpool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/D/G/new", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Revision 6:  Modify both copies and the replacement. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/alpha",
+                                      "Revision 6", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B2/E/alpha",
+                                      "Revision 6", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/new",
+                                      "Revision 6", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota2",
+                                      "Revision 6", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Revision 7:  Copy A/B and iota from older revisions and modify the
+     copied directory. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 2, subpool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/B", txn_root, "A/B3", subpool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 3, subpool));
+  SVN_ERR(svn_fs_copy(rev_root, "iota", txn_root, "iota3", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B3/E/alpha",
+                                      "Revision 7", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Logs as reported by walking the node history. */
+  SVN_ERR(get_path_logs(&expected, repos, pool, subpool));
+
+  /* The index must produce the same logs. */
+  SVN_ERR(svn_repos_build_log_index(repos, NULL, NULL, NULL, NULL, subpool));
+  SVN_ERR(get_path_logs(&actual, repos, pool, subpool));
+  SVN_TEST_STRING_ASSERT(actual, expected);
+
+  /* Revision 8:  Committing through the repos layer updates the index. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B2/E/alpha",
+                                      "Revision 8", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Revision 9:  Committing to the FS directly leaves the index behind,
+     readers must catch up. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/new",
+                                      "Revision 9", subpool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  SVN_ERR(get_path_logs(&actual, repos, pool, subpool));
+
+  /* Compare with a fresh repository handle, once without the index. */
+  SVN_ERR(svn_io_remove_file2(svn_dirent_join(svn_repos_path(repos, pool),
+                                              "log-index.db", pool),
+                              FALSE, pool));
+  SVN_ERR(svn_repos_open3(&repos, svn_repos_path(repos, pool), NULL,
+                          pool, subpool));
+  SVN_ERR(get_path_logs(&expected, repos, pool, subpool));
+  SVN_TEST_STRING_ASSERT(actual, expected);
+
+  /* Revisions 10 to 29:  If the index lags too far behind, readers fall
+     back to walking node histories. */
+  SVN_ERR(svn_repos_build_log_index(repos, NULL, NULL, NULL, NULL, subpool));
+  fs = svn_repos_fs(repos);
+  for (i = 0; i < 20; ++i)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/new",
+                                          apr_psprintf(subpool,
+                                                       "Revision %ld",
+                                                       youngest_rev + 1),
+                                          subpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, subpool));
+      svn_pool_clear(subpool);
+    }
+
+  SVN_ERR(get_path_logs(&actual, repos, pool, subpool));
+
+  /* Revision 30:  The next commit through the repos layer catches up.
+     It does not touch any of the paths that we log. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_make_file(txn_root, "unrelated", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  SVN_ERR(get_path_logs(&expected, repos, pool, subpool));
+  SVN_TEST_STRING_ASSERT(actual, expected);
+
+  SVN_ERR(svn_io_remove_file2(svn_dirent_join(svn_repos_path(repos, pool),
+                                              "log-index.db", pool),
+                              FALSE, pool));
+  SVN_ERR(svn_repos_open3(&repos, svn_repos_path(repos, pool), NULL,
+                          pool, subpool));
+  SVN_ERR(get_path_logs(&expected, repos, pool, subpool));
+  SVN_TEST_STRING_ASSERT(actual, expected);
+
+  /* Revisions 31 to 100:  Commits through the repos layer catch up on
+     larger ranges in several steps. */
+  SVN_ERR(svn_repos_build_log_index(repos, NULL, NULL, NULL, NULL, subpool));
+  SVN_ERR(svn_repos__log_index_youngest(&indexed, repos, subpool));
+  SVN_TEST_ASSERT(indexed == youngest_rev);
+
+  fs = svn_repos_fs(repos);
+  for (i = 0; i < 70; ++i)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/new",
+                                          apr_psprintf(subpool,
+                                                       "Revision %ld",
+                                                       youngest_rev + 1),
+                                          subpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, subpool));
+      svn_pool_clear(subpool);
+    }
+
+  /* Revisions 101 and 102:  Two commits catch up with everything. */
+  previous = indexed;
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "unrelated",
+                                          apr_psprintf(subpool,
+                                                       "Revision %ld",
+                                                       youngest_rev + 1),
+                                          subpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      subpool));
+      svn_pool_clear(subpool);
+
+      SVN_ERR(svn_repos__log_index_youngest(&indexed, repos, subpool));
+      SVN_TEST_ASSERT(indexed > previous);
+      SVN_TEST_ASSERT(i == 0 ? indexed < youngest_rev
+                             : indexed == youngest_rev);
+      previous = indexed;
+    }
+
+  SVN_ERR(get_path_logs(&expected, repos, pool, subpool));
+
+  /* Loading into a repository updates its index as well. */
+  dump = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_repos_dump_fs4(repos, svn_stream_from_stringbuf(dump, subpool),
+                             0, youngest_rev, FALSE, FALSE, TRUE, TRUE, 1,
+                             NULL, NULL, NULL, NULL, subpool));
+  svn_pool_clear(subpool);
+
+  other_pool = svn_pool_create(pool);
+  SVN_ERR(svn_test__create_repos(&other_repos,
+                                 "test-repo-get-logs-with-index-loaded",
+                                 opts, other_pool));
+  other_path = svn_repos_path(other_repos, pool);
+  SVN_ERR(svn_repos_build_log_index(other_repos, NULL, NULL, NULL, NULL,
+                                    subpool));
+  SVN_ERR(svn_repos_load_fs6(other_repos,
+                             svn_stream_from_stringbuf(dump, subpool),
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_ignore, NULL,
+                             FALSE, FALSE, FALSE, FALSE, 1,
+                             NULL, NULL, NULL, NULL, subpool));
+  svn_pool_clear(subpool);
+
+  SVN_ERR(svn_repos__log_index_youngest(&indexed, other_repos, subpool));
+  SVN_TEST_ASSERT(indexed == youngest_rev);
+  SVN_ERR(get_path_logs(&actual, other_repos, pool, subpool));
+  SVN_TEST_STRING_ASSERT(actual, expected);
+  svn_pool_destroy(other_pool);
+
+  /* An index copied over from a repository with the same history but a
+     different UUID gets ignored and started over by the next commit. */
+  SVN_ERR(svn_io_copy_file(svn_dirent_join(svn_repos_path(repos, pool),
+                                           "log-index.db", pool),
+                           svn_dirent_join(other_path, "log-index.db", pool),
+                           FALSE, pool));
+
+  other_pool = svn_pool_create(pool);
+  SVN_ERR(svn_repos_open3(&other_repos, other_path, NULL, other_pool,
+                          subpool));
+  SVN_ERR(svn_repos__log_index_youngest(&indexed, other_repos, subpool));
+  SVN_TEST_ASSERT(indexed == SVN_INVALID_REVNUM);
+  SVN_ERR(get_path_logs(&actual, other_repos, pool, subpool));
+  SVN_TEST_STRING_ASSERT(actual, expected);
+
+  fs = svn_repos_fs(other_repos);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_make_file(txn_root, "unrelated2", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, other_repos, &other_youngest, txn,
+                                  subpool));
+  svn_pool_clear(subpool);
+
+  SVN_ERR(svn_repos__log_index_youngest(&indexed, other_repos, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(indexed));
+  SVN_TEST_ASSERT(indexed < other_youngest);
+  svn_pool_destroy(other_pool);
+
+  /* An index that covers revisions which the repository does not have
+     gets ignored, even if the UUIDs match. */
+  other_pool = svn_pool_create(pool);
+  SVN_ERR(svn_test__create_repos(&other_repos,
+                                 "test-repo-get-logs-with-index-empty",
+                                 opts, other_pool));
+  other_path = svn_repos_path(other_repos, pool);
+  SVN_ERR(svn_fs_get_uuid(svn_repos_fs(repos), &uuid, pool));
+  SVN_ERR(svn_fs_set_uuid(svn_repos_fs(other_repos), uuid, subpool));
+  svn_pool_destroy(other_pool);
+
+  SVN_ERR(svn_io_copy_file(svn_dirent_join(svn_repos_path(repos, pool),
+                                           "log-index.db", pool),
+                           svn_dirent_join(other_path, "log-index.db", pool),
+                           FALSE, pool));
+
+  other_pool = svn_pool_create(pool);
+  SVN_ERR(svn_repos_open3(&other_repos, other_path, NULL, other_pool,
+                          subpool));
+  SVN_ERR(svn_repos__log_index_youngest(&indexed, other_repos, subpool));
+  SVN_TEST_ASSERT(indexed == SVN_INVALID_REVNUM);
+  svn_pool_destroy(other_pool);
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+
 
 /* Tests for svn_repos_get_file_revsN() */
 
@@ -3909,6 +4640,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test authz and global groups stored in the repo"),
     SVN_TEST_OPTS_PASS(groups_authz,
                        "test authz with global groups"),
+    SVN_TEST_PASS2(authz_many_users,
+                   "test authz for many users"),
+    SVN_TEST_PASS2(authz_concurrent_users,
+                   "test authz for many users from several threads"),
     SVN_TEST_OPTS_PASS(commit_editor_authz,
                        "test authz in the commit editor"),
     SVN_TEST_OPTS_PASS(commit_continue_txn,
@@ -3917,10 +4652,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_repos_node_location_segments"),
     SVN_TEST_OPTS_PASS(reporter_depth_exclude,
                        "test reporter and svn_depth_exclude"),
+    SVN_TEST_OPTS_PASS(reporter_subtree_authz,
+                       "test reporter with readable subtrees"),
     SVN_TEST_OPTS_PASS(prop_validation,
                        "test if revprops are validated by repos"),
     SVN_TEST_OPTS_PASS(get_logs,
                        "test svn_repos_get_logs ranges and limits"),
+    SVN_TEST_OPTS_PASS(get_logs_with_index,
+                       "test svn_repos_get_logs4 with a changed-paths index"),
     SVN_TEST_OPTS_PASS(test_get_file_revs,
                        "test svn_repos_get_file_revsN"),
     SVN_TEST_OPTS_PASS(issue_4060,
@@ -22,13 +22,17 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_time.h>
+#include <apr_thread_proc.h>
 
 #include "svn_pools.h"
 
+#include "private/svn_atomic.h"
+
 #include "private/svn_cache.h"
 #include "svn_private_config.h"
 
@@ -590,6 +594,670 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* Number of distinct items that the concurrency test reads. */
+#define CONCURRENT_KEY_COUNT 256
+
+/* Number of cache lookups per reader thread in the concurrency test. */
+#define CONCURRENT_READ_COUNT 100000
+
+/* Return the value that the concurrency test stores under KEY in its
+ * GENERATION-th write.  Length and contents depend on both, so data
+ * mixed from different writes or partially copied can be detected. */
+static svn_stringbuf_t *
+concurrent_value(const char *key,
+                 apr_uint64_t generation,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *value
+    = svn_stringbuf_createf(pool, "%s:%" APR_UINT64_T_FMT ":",
+                            key, generation);
+  svn_stringbuf_appendfill(value, (char)('a' + generation % 26),
+                           (apr_size_t)(generation % 61) * 7);
+  svn_stringbuf_appendcstr(value, key);
+
+  return value;
+}
+
+/* Verify that VALUE has been produced by concurrent_value for KEY. */
+static svn_error_t *
+verify_concurrent_value(const char *key,
+                        const svn_stringbuf_t *value,
+                        apr_pool_t *pool)
+{
+  apr_size_t key_len = strlen(key);
+  apr_uint64_t generation;
+
+  if (   value->len <= key_len
+      || memcmp(value->data, key, key_len) != 0
+      || value->data[key_len] != ':')
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "unexpected value '%s' for key '%s'",
+                             value->data, key);
+
+  generation = apr_strtoi64(value->data + key_len + 1, NULL, 10);
+  if (!svn_stringbuf_compare(value,
+                             concurrent_value(key, generation, pool)))
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "inconsistent value '%s' for key '%s'",
+                             value->data, key);
+
+  return SVN_NO_ERROR;
+}
+
+/* Shared state and per-thread result of the concurrency test. */
+typedef struct concurrent_baton_t
+{
+  /* The shared cache to access. */
+  svn_membuffer_t *membuffer;
+
+  /* If set, keep overwriting cache items until *STOP becomes non-zero.
+   * Otherwise, do CONCURRENT_READ_COUNT lookups. */
+  svn_boolean_t is_writer;
+
+  /* Tells the writer to terminate. */
+  volatile svn_atomic_t *stop;
+
+  /* Number of lookups that found a value.  Only set for readers. */
+  int hits;
+
+  /* Result of this thread's run. */
+  svn_error_t *err;
+} concurrent_baton_t;
+
+/* Access the cache items as described by BATON.  The writer stores a new
+ * value produced by concurrent_value with every write, so readers can
+ * detect torn or otherwise inconsistent data. */
+static svn_error_t *
+access_cache_concurrently(concurrent_baton_t *baton,
+                          apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Each thread gets its own front-end instance, just like multiple
+   * repositories or connections would in a server process. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            baton->membuffer,
+                                            NULL, NULL,
+                                            APR_HASH_KEY_STRING,
+                                            "concurrent:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  for (i = 0;
+       baton->is_writer ? !svn_atomic_read(baton->stop)
+                        : i < CONCURRENT_READ_COUNT;
+       ++i)
+    {
+      int k = (i * 7) % CONCURRENT_KEY_COUNT;
+      const char *key;
+
+      if ((i % 100) == 0)
+        svn_pool_clear(iterpool);
+
+      key = apr_psprintf(iterpool, "k%d", k);
+      if (baton->is_writer)
+        {
+          SVN_ERR(svn_cache__set(cache, key,
+                                 concurrent_value(key, i, iterpool),
+                                 iterpool));
+        }
+      else
+        {
+          svn_stringbuf_t *value;
+          svn_boolean_t found;
+
+          SVN_ERR(svn_cache__get((void **) &value, &found, cache, key,
+                                 iterpool));
+          if (found)
+            {
+              SVN_ERR(verify_concurrent_value(key, value, iterpool));
+              ++baton->hits;
+            }
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static void *
+APR_THREAD_FUNC concurrent_thread_func(apr_thread_t *tid, void *data)
+{
+  concurrent_baton_t *baton = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  baton->err = access_cache_concurrently(baton, pool);
+  svn_pool_destroy(pool);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Run THREAD_COUNT reader threads plus one writer thread against
+ * MEMBUFFER and return the number of seconds the readers took in
+ * *SECONDS. */
+static svn_error_t *
+run_concurrent_readers(double *seconds,
+                       svn_membuffer_t *membuffer,
+                       int thread_count,
+                       apr_pool_t *pool)
+{
+  apr_thread_t **threads = apr_pcalloc(pool, thread_count * sizeof(*threads));
+  concurrent_baton_t *batons = apr_pcalloc(pool,
+                                           thread_count * sizeof(*batons));
+  concurrent_baton_t writer_baton = { 0 };
+  apr_thread_t *writer;
+  volatile svn_atomic_t stop = 0;
+  apr_status_t status, retval;
+  apr_time_t start;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  writer_baton.membuffer = membuffer;
+  writer_baton.is_writer = TRUE;
+  writer_baton.stop = &stop;
+  status = apr_thread_create(&writer, NULL, concurrent_thread_func,
+                             &writer_baton, pool);
+  if (status)
+    return svn_error_wrap_apr(status, "Can't create thread");
+
+  start = apr_time_now();
+  for (i = 0; i < thread_count; ++i)
+    {
+      batons[i].membuffer = membuffer;
+      status = apr_thread_create(&threads[i], NULL, concurrent_thread_func,
+                                 &batons[i], pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, "Can't create thread");
+          thread_count = i;
+          break;
+        }
+    }
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_thread_join(&retval, threads[i]);
+      err = svn_error_compose_create(err, batons[i].err);
+
+      /* All keys are in the cache and get replaced in-place.  Lookups
+       * only miss after the writer had to drop an entry that it could
+       * not overwrite while readers held the lock.  So, readers that
+       * find nothing at all mean that the lookups are broken. */
+      if (!err && batons[i].hits == 0)
+        err = svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                "reader %d found none of %d values",
+                                i, CONCURRENT_READ_COUNT);
+    }
+
+  *seconds = (double)(apr_time_now() - start) / APR_USEC_PER_SEC;
+
+  svn_atomic_set(&stop, 1);
+  apr_thread_join(&retval, writer);
+
+  return svn_error_compose_create(err, writer_baton.err);
+}
+
+#endif
+
+static svn_error_t *
+test_membuffer_cache_concurrent_reads(const svn_test_opts_t *opts,
+                                      apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_cache__info_t info;
+  int thread_count;
+  int k;
+
+  /* Use a single segment to maximize contention between readers and
+   * the writer. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 0, 1,
+                                            TRUE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            NULL, NULL,
+                                            APR_HASH_KEY_STRING,
+                                            "concurrent:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  for (k = 0; k < CONCURRENT_KEY_COUNT; ++k)
+    {
+      const char *key = apr_psprintf(pool, "k%d", k);
+      SVN_ERR(svn_cache__set(cache, key, concurrent_value(key, 0, pool),
+                             pool));
+    }
+
+  /* Hit throughput should scale with the number of reader threads as
+   * long as there are enough cores. */
+  for (thread_count = 1; thread_count <= 8; thread_count *= 2)
+    {
+      double seconds;
+      SVN_ERR(run_concurrent_readers(&seconds, membuffer, thread_count,
+                                     pool));
+
+      if (opts->verbose)
+        printf("%d reader thread(s): %.0f lookups/s\n", thread_count,
+               thread_count * CONCURRENT_READ_COUNT
+                 / (seconds > 0 ? seconds : 1e-6));
+    }
+
+  /* Hits on the lock-free path must show up in the statistics as well. */
+  SVN_ERR(svn_cache__get_info(cache, &info, TRUE, pool));
+  SVN_TEST_ASSERT(info.gets > CONCURRENT_READ_COUNT);
+  SVN_TEST_ASSERT(info.hits > 0 && info.hits <= info.gets);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Number of distinct key prefixes used by the cache creation test. */
+#define CREATION_PREFIX_COUNT 16
+
+/* Number of cache front-end instances that each thread creates. */
+#define CREATION_COUNT 20000
+
+static void *
+APR_THREAD_FUNC creation_thread_func(apr_thread_t *tid, void *data)
+{
+  concurrent_baton_t *baton = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < CREATION_COUNT && !baton->err; ++i)
+    {
+      svn_cache__t *cache;
+      const char *prefix;
+
+      svn_pool_clear(iterpool);
+      prefix = apr_psprintf(iterpool, "creation:%d",
+                            i % CREATION_PREFIX_COUNT);
+
+      /* Short, fixed-size keys make the front-end intern its prefix. */
+      baton->err = svn_cache__create_membuffer_cache(
+                       &cache, baton->membuffer,
+                       serialize_revnum, deserialize_revnum,
+                       sizeof(svn_revnum_t), prefix,
+                       SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+                       iterpool, iterpool);
+    }
+
+  svn_pool_destroy(pool);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+#endif
+
+static svn_error_t *
+test_membuffer_cache_concurrent_creation(const svn_test_opts_t *opts,
+                                         apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache1, *cache2;
+  svn_revnum_t key = 42, value = 4711, *answer;
+  svn_boolean_t found;
+  int thread_count;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 0, 0,
+                                            TRUE, FALSE, pool));
+
+  for (thread_count = 1; thread_count <= 8; thread_count *= 2)
+    {
+      apr_thread_t **threads = apr_pcalloc(pool,
+                                           thread_count * sizeof(*threads));
+      concurrent_baton_t *batons = apr_pcalloc(pool,
+                                               thread_count * sizeof(*batons));
+      apr_time_t start = apr_time_now();
+      svn_error_t *err = SVN_NO_ERROR;
+      apr_status_t status, retval;
+      int i, started;
+
+      for (started = 0; started < thread_count; ++started)
+        {
+          batons[started].membuffer = membuffer;
+          status = apr_thread_create(&threads[started], NULL,
+                                     creation_thread_func, &batons[started],
+                                     pool);
+          if (status)
+            {
+              err = svn_error_wrap_apr(status, "Can't create thread");
+              break;
+            }
+        }
+
+      for (i = 0; i < started; ++i)
+        {
+          apr_thread_join(&retval, threads[i]);
+          err = svn_error_compose_create(err, batons[i].err);
+        }
+
+      SVN_ERR(err);
+
+      if (opts->verbose)
+        printf("%d thread(s): %.0f cache instances/s\n", thread_count,
+               thread_count * CREATION_COUNT
+                 / ((double)(apr_time_now() - start) / APR_USEC_PER_SEC
+                    + 1e-6));
+    }
+
+  /* Instances with the same prefix must still share their contents. */
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &cache1, membuffer, serialize_revnum, deserialize_revnum,
+            sizeof(key), "creation:0", SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &cache2, membuffer, serialize_revnum, deserialize_revnum,
+            sizeof(key), "creation:0", SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+            FALSE, FALSE, pool, pool));
+
+  SVN_ERR(svn_cache__set(cache1, &key, &value, pool));
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache2, &key, pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*answer == value);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_shared(apr_pool_t *pool)
+{
+#if APR_HAS_SHARED_MEMORY
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+#if APR_HAS_FORK
+  apr_proc_t proc;
+  apr_status_t status;
+  int exitcode;
+  apr_exit_why_e exitwhy;
+  svn_revnum_t *answer;
+  svn_boolean_t found;
+  svn_revnum_t rev = 4711;
+#endif
+
+  SVN_ERR(svn_cache__membuffer_cache_create_shared(&membuffer, 1024*1024,
+                                                   0, 0, TRUE, NULL, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "shared:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+#if APR_HAS_FORK
+  /* Items written by a child process must be visible to the parent. */
+  status = apr_proc_fork(&proc, pool);
+  if (status == APR_INCHILD)
+    {
+      svn_error_t *err = svn_cache__set(cache, "child", &rev, pool);
+      exit(err ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+  else if (status != APR_INPARENT)
+    return svn_error_wrap_apr(status, "Can't fork");
+
+  status = apr_proc_wait(&proc, &exitcode, &exitwhy, APR_WAIT);
+  if (status != APR_CHILD_DONE)
+    return svn_error_wrap_apr(status, "Can't wait for child process");
+  SVN_TEST_ASSERT(APR_PROC_CHECK_EXIT(exitwhy) && exitcode == EXIT_SUCCESS);
+
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "child", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*answer == rev);
+#endif
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_SHARED_MEMORY && APR_HAS_FORK
+/* Implements svn_cache__partial_setter_func_t.  Terminate the current
+ * process, i.e. while it holds the cache segment's write lock. */
+static svn_error_t *
+die_while_locked(void **data,
+                 apr_size_t *data_len,
+                 void *baton,
+                 apr_pool_t *result_pool)
+{
+  exit(EXIT_SUCCESS);
+}
+#endif
+
+static svn_error_t *
+test_membuffer_cache_shared_dead_owner(apr_pool_t *pool)
+{
+#if APR_HAS_SHARED_MEMORY && APR_HAS_FORK
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  apr_proc_t proc;
+  apr_status_t status;
+  int exitcode;
+  apr_exit_why_e exitwhy;
+  svn_revnum_t *answer;
+  svn_boolean_t found;
+  svn_revnum_t rev = 4711;
+
+  /* Use a single segment, so the child locks the one we will access. */
+  SVN_ERR(svn_cache__membuffer_cache_create_shared(&membuffer, 1024*1024,
+                                                   0, 1, TRUE, NULL, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "shared:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+  SVN_ERR(svn_cache__set(cache, "victim", &rev, pool));
+
+  /* Let a child process die in the middle of modifying the segment. */
+  status = apr_proc_fork(&proc, pool);
+  if (status == APR_INCHILD)
+    {
+      svn_error_clear(svn_cache__set_partial(cache, "victim",
+                                             die_while_locked, NULL,
+                                             pool));
+      exit(EXIT_FAILURE);
+    }
+  else if (status != APR_INPARENT)
+    return svn_error_wrap_apr(status, "Can't fork");
+
+  status = apr_proc_wait(&proc, &exitcode, &exitwhy, APR_WAIT);
+  if (status != APR_CHILD_DONE)
+    return svn_error_wrap_apr(status, "Can't wait for child process");
+  SVN_TEST_ASSERT(APR_PROC_CHECK_EXIT(exitwhy) && exitcode == EXIT_SUCCESS);
+
+  /* The lock is still taken.  We must break it instead of spinning
+   * forever and must not see the partially modified segment. */
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "victim", pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* The segment must be usable again. */
+  SVN_ERR(svn_cache__set(cache, "victim", &rev, pool));
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "victim", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*answer == rev);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Create a string-keyed revnum cache using MEMBUFFER in *CACHE.
+ * Allocate it in POOL. */
+static svn_error_t *
+create_persistence_test_cache(svn_cache__t **cache,
+                              svn_membuffer_t *membuffer,
+                              apr_pool_t *pool)
+{
+  SVN_ERR(svn_cache__create_membuffer_cache(cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "persistent:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_save_load(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_revnum_t twenty = 20, thirty = 30, *answer;
+  svn_boolean_t found, loaded;
+  const char *path;
+
+  SVN_ERR(svn_io_open_unique_file3(NULL, &path, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, pool));
+
+  /* Save a cache with some contents. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024 * 1024, 0, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(create_persistence_test_cache(&cache, membuffer, pool));
+  SVN_ERR(svn_cache__set(cache, "twenty", &twenty, pool));
+  SVN_ERR(svn_cache__set(cache, "thirty", &thirty, pool));
+  SVN_ERR(svn_cache__membuffer_cache_save(membuffer, path, pool));
+
+  /* A fresh cache of the same size shall restore the contents. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024 * 1024, 0, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__membuffer_cache_load(membuffer, &loaded, path, pool));
+  SVN_TEST_ASSERT(loaded);
+
+  SVN_ERR(create_persistence_test_cache(&cache, membuffer, pool));
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "twenty", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*answer == 20);
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "thirty", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*answer == 30);
+
+  /* A cache with a different layout must ignore the file. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 2 * 1024 * 1024,
+                                            0, 0, TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__membuffer_cache_load(membuffer, &loaded, path, pool));
+  SVN_TEST_ASSERT(!loaded);
+
+  /* So does an already used cache. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024 * 1024, 0, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(create_persistence_test_cache(&cache, membuffer, pool));
+  SVN_ERR(svn_cache__membuffer_cache_load(membuffer, &loaded, path, pool));
+  SVN_TEST_ASSERT(!loaded);
+
+  /* Missing files are not an error. */
+  SVN_ERR(svn_cache__membuffer_cache_load(membuffer, &loaded,
+                                          apr_pstrcat(pool, path, ".missing",
+                                                      SVN_VA_NULL),
+                                          pool));
+  SVN_TEST_ASSERT(!loaded);
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+test_membuffer_cache_tinylfu(apr_pool_t *pool)
+{
+  enum { HOT_COUNT = 50, HOT_ACCESSES = 10, SCAN_COUNT = 5000 };
+
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_stringbuf_t *value = svn_stringbuf_create_ensure(1000, pool);
+  svn_stringbuf_t *answer;
+  svn_boolean_t found;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, k;
+
+  /* Items of about 1kB in a 1MB cache.  L2 can hold about twice as many
+   * items as there are in our hot set. */
+  value->len = 1000;
+  memset(value->data, 'x', value->len);
+  value->data[value->len] = '\0';
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024 * 1024,
+                                            256 * 1024, 1, TRUE, TRUE,
+                                            pool));
+  SVN_ERR(svn_cache__membuffer_set_admission_policy(
+              membuffer, svn_cache__admission_tinylfu, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer, NULL, NULL,
+                                            APR_HASH_KEY_STRING, "lfu:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+
+  /* Establish the hot set, i.e. look the items up frequently. */
+  for (i = 0; i < HOT_COUNT; ++i)
+    {
+      const char *key;
+      svn_pool_clear(iterpool);
+      key = apr_psprintf(iterpool, "hot-%d", i);
+
+      SVN_ERR(svn_cache__get((void **) &answer, &found, cache, key,
+                             iterpool));
+      SVN_ERR(svn_cache__set(cache, key, value, iterpool));
+      for (k = 0; k < HOT_ACCESSES; ++k)
+        SVN_ERR(svn_cache__get((void **) &answer, &found, cache, key,
+                               iterpool));
+    }
+
+  /* Scan lots of data that gets accessed only once. */
+  for (i = 0; i < SCAN_COUNT; ++i)
+    {
+      const char *key;
+      svn_pool_clear(iterpool);
+      key = apr_psprintf(iterpool, "scan-%d", i);
+
+      SVN_ERR(svn_cache__get((void **) &answer, &found, cache, key,
+                             iterpool));
+      SVN_ERR(svn_cache__set(cache, key, value, iterpool));
+    }
+
+  /* The hot set must have survived the scan. */
+  for (i = 0; i < HOT_COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__has_key(&found, cache,
+                                 apr_psprintf(iterpool, "hot-%d", i),
+                                 iterpool));
+      SVN_TEST_ASSERT(found);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -616,6 +1284,22 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test membuffer cache with unaligned string keys"),
     SVN_TEST_PASS2(test_membuffer_unaligned_fixed_keys,
                    "test membuffer cache with unaligned fixed keys"),
+    SVN_TEST_OPTS_SKIP(test_membuffer_cache_concurrent_reads,
+                       ! APR_HAS_THREADS,
+                       "test concurrent membuffer cache reads"),
+    SVN_TEST_SKIP2(test_membuffer_cache_shared,
+                   ! APR_HAS_SHARED_MEMORY,
+                   "basic shared memory membuffer svn_cache test"),
+    SVN_TEST_SKIP2(test_membuffer_cache_shared_dead_owner,
+                   ! (APR_HAS_SHARED_MEMORY && APR_HAS_FORK),
+                   "break shared cache locks held by dead processes"),
+    SVN_TEST_OPTS_SKIP(test_membuffer_cache_concurrent_creation,
+                       ! APR_HAS_THREADS,
+                       "test concurrent membuffer cache creation"),
+    SVN_TEST_PASS2(test_membuffer_cache_save_load,
+                   "save and restore membuffer cache contents"),
+    SVN_TEST_PASS2(test_membuffer_cache_tinylfu,
+                   "membuffer cache with TinyLFU admission policy"),
     SVN_TEST_NULL
   };
 
@@ -953,3 +953,46 @@ svn_test__create_blame_repository(svn_repos_t **out_repos,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_test__add_iota_history(svn_fs_t *fs,
+                           svn_revnum_t max_rev,
+                           svn_test__iota_contents_func_t contents_func,
+                           apr_pool_t *pool)
+{
+  svn_revnum_t rev;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+  while (rev < max_rev)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *root;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (rev == 0)
+        {
+          SVN_ERR(svn_test__create_greek_tree(root, iterpool));
+        }
+      else
+        {
+          SVN_ERR(svn_test__set_file_contents(root, "iota",
+                                              contents_func(rev + 1,
+                                                            iterpool),
+                                              iterpool));
+          SVN_ERR(svn_fs_change_node_prop(root, "iota", "rev",
+                                          svn_string_createf(iterpool, "%ld",
+                                                             rev + 1),
+                                          iterpool));
+        }
+
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
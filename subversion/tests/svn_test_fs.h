@@ -196,6 +196,21 @@ svn_test__create_blame_repository(svn_repos_t **out_repos,
                                   const svn_test_opts_t *opts,
                                   apr_pool_t *pool);
 
+/* Return the contents of /iota in revision REV of a history created by
+   svn_test__add_iota_history().  Allocate the result in POOL. */
+typedef const char *(*svn_test__iota_contents_func_t)(svn_revnum_t rev,
+                                                       apr_pool_t *pool);
+
+/* Add revisions to FS until its youngest revision is MAX_REV.  If FS is
+   still empty, the first new revision adds the Greek tree.  Every other
+   new revision REV replaces the contents of /iota with what CONTENTS_FUNC
+   returns for REV and sets the "rev" property on /iota to REV. */
+svn_error_t *
+svn_test__add_iota_history(svn_fs_t *fs,
+                           svn_revnum_t max_rev,
+                           svn_test__iota_contents_func_t contents_func,
+                           apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,121 @@
+#!/bin/sh
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# Measure 'svn log' on deep paths with and without the changed-paths
+# index created by 'svnadmin build-log-index'.
+#
+# usage: run this script from the root of your working copy
+#        and / or adjust the path settings below as needed
+
+# set SVNPATH to the 'subversion' folder of your SVN source code w/c
+
+SVNPATH="$('pwd')/subversion"
+
+SVN=${SVNPATH}/svn/svn
+SVNADMIN=${SVNPATH}/svnadmin/svnadmin
+SVNMUCC=${SVNPATH}/../tools/client-side/svnmucc/svnmucc
+# VALGRIND="valgrind --tool=callgrind"
+
+# set your data paths here
+
+REPOROOT=/dev/shm
+
+# DEPTH is the nesting level of the files whose log we request.
+# Every round commits BRANCHES branches of the whole tree and
+# NOISE changes to unrelated paths.  Only a few revisions touch
+# the deep paths, so a full history walk has to skip most of
+# the repository.
+
+DEPTH=20
+ROUNDS=50
+BRANCHES=2
+NOISE=40
+
+# from here on, we should be good
+
+TIMEFORMAT='%3R  %3U  %3S'
+REPONAME=logindex
+URL=file://${REPOROOT}/$REPONAME
+
+DEEPDIR=trunk
+i=1
+while [ $i -le $DEPTH ]; do
+  DEEPDIR=$DEEPDIR/d$i
+  i=$((i+1))
+done
+
+# create repository
+
+rm -rf $REPOROOT/$REPONAME
+${SVNADMIN} create $REPOROOT/$REPONAME
+
+${SVNMUCC} -U $URL -m "create tree" --parents \
+  mkdir $DEEPDIR mkdir noise mkdir branches > /dev/null
+echo "initial" | ${SVNMUCC} -U $URL -m "add file" \
+  put - $DEEPDIR/file > /dev/null
+
+# populate the history
+
+round=1
+while [ $round -le $ROUNDS ]; do
+  n=1
+  while [ $n -le $NOISE ]; do
+    echo "$round $n" | ${SVNMUCC} -U $URL -m "noise" \
+      put - noise/f$n > /dev/null
+    n=$((n+1))
+  done
+
+  b=1
+  while [ $b -le $BRANCHES ]; do
+    ${SVNMUCC} -U $URL -m "branch" \
+      cp HEAD trunk branches/b$round.$b > /dev/null
+    b=$((b+1))
+  done
+
+  echo "round $round" | ${SVNMUCC} -U $URL -m "change deep file" \
+    put - $DEEPDIR/file > /dev/null
+  round=$((round+1))
+done
+
+BRANCHFILE=branches/b$ROUNDS.1/${DEEPDIR#trunk/}/file
+
+run_logs ( ) {
+  echo "log on trunk file:"
+  time ${VALGRIND} ${SVN} log -q $URL/$DEEPDIR/file > /dev/null
+  echo "log on trunk file, --stop-on-copy:"
+  time ${VALGRIND} ${SVN} log -q --stop-on-copy $URL/$DEEPDIR/file > /dev/null
+  echo "log on branch file:"
+  time ${VALGRIND} ${SVN} log -q $URL/$BRANCHFILE > /dev/null
+}
+
+echo "revisions: $( ${SVN} info --show-item revision $URL )"
+echo
+echo "real      user     sys"
+echo "=== without index ==="
+run_logs
+
+echo "=== building index ==="
+time ${SVNADMIN} build-log-index -q $REPOROOT/$REPONAME
+
+echo "=== with index ==="
+run_logs
+
+# tidy up
+
+rm -rf $REPOROOT/$REPONAME